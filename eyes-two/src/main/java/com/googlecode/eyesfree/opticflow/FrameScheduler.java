@@ -0,0 +1,133 @@
+/*
+ * Copyright 2017 Robert Theis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package com.googlecode.eyesfree.opticflow;
+
+/**
+ * Interface to the native frame scheduler, which decides which preview frames,
+ * and which parts of them, need to be recognized.
+ * <p>
+ * Every frame is scored for motion, blur and change, and the words recognized
+ * so far are moved along with the camera using optical flow instead of being
+ * recognized again. Only the parts of a frame that are new or changed are
+ * handed to the {@link Recognizer}, on a background thread, and only while
+ * the camera is steady and the area is sharp.
+ * <p>
+ * Except for the recognizer, instances should only be used from one thread.
+ */
+public class FrameScheduler {
+    static {
+        System.loadLibrary("jpgt");
+        System.loadLibrary("pngt");
+        System.loadLibrary("lept");
+        System.loadLibrary("opticalflow");
+    }
+
+    /** Part of the frame was sent to the recognizer. */
+    public static final int DISPATCHED = 0;
+
+    /** Nothing in the frame needs to be recognized. */
+    public static final int UNCHANGED = 1;
+
+    /** The camera moves too fast to recognize the frame. */
+    public static final int MOVING = 2;
+
+    /** The part of the frame to recognize is blurred. */
+    public static final int BLURRED = 3;
+
+    /** The recognizer is still busy with an earlier frame. */
+    public static final int BUSY = 4;
+
+    /** Number of floats each region returned by {@link #getRegions} takes up. */
+    public static final int REGION_STEP = 6;
+
+    /**
+     * Recognizes parts of frames, e.g. using TessBaseAPI.
+     */
+    public interface Recognizer {
+        /**
+         * Recognizes part of a frame. Called on the background thread of the
+         * scheduler, one request at a time.
+         *
+         * @param pixels The luminance of the part, one byte per pixel.
+         * @param left The left edge of the part in the frame.
+         * @param top The top edge of the part in the frame.
+         * @param width The width of the part.
+         * @param height The height of the part.
+         * @return Five floats for each word found: its left, top, right and
+         *         bottom edges in frame coordinates, and a tag that is
+         *         returned with its region by {@link #getRegions}.
+         */
+        float[] recognize(byte[] pixels, int left, int top, int width, int height);
+    }
+
+    private long mNativeScheduler;
+
+    public FrameScheduler(int width, int height, int downsampleFactor, Recognizer recognizer) {
+        mNativeScheduler = createNative(width, height, downsampleFactor, recognizer);
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        try {
+            release();
+        } finally {
+            super.finalize();
+        }
+    }
+
+    /**
+     * Adds a preview frame and dispatches the parts of it that need
+     * recognition.
+     *
+     * @param data The luminance of the frame, one byte per pixel.
+     * @param timestamp The time of the frame in milliseconds.
+     * @return What was done with the frame, e.g. {@link #DISPATCHED}.
+     */
+    public int processFrame(byte[] data, long timestamp) {
+        return processFrameNative(mNativeScheduler, data, timestamp);
+    }
+
+    /**
+     * Returns the recognized words as of the last frame, moved along with the
+     * camera. Their format is [id tag left top right bottom] repeated for
+     * each word, where tag is the one returned by the {@link Recognizer}.
+     */
+    public float[] getRegions() {
+        return getRegionsNative(mNativeScheduler);
+    }
+
+    /**
+     * Stops the background thread and frees the native scheduler.
+     */
+    public void release() {
+        if (mNativeScheduler != 0) {
+            destroyNative(mNativeScheduler);
+            mNativeScheduler = 0;
+        }
+    }
+
+    /*********************** NATIVE METHODS *************************************/
+
+    private native long createNative(
+            int width, int height, int downsampleFactor, Recognizer recognizer);
+
+    private native int processFrameNative(long nativeScheduler, byte[] data, long timestamp);
+
+    private native float[] getRegionsNative(long nativeScheduler);
+
+    private native void destroyNative(long nativeScheduler);
+}
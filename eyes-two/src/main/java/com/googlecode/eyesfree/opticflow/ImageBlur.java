@@ -38,6 +38,33 @@ public class ImageBlur {
      */
     public static native boolean isBlurred(byte[] input, int width, int height);
 
+    /**
+     * Tests if a region of interest of a given image is blurred or not.
+     *
+     * @param input An array of input pixels in YUV420SP format.
+     * @param width The width of the input image.
+     * @param height The height of the input image.
+     * @param left The left edge of the region.
+     * @param top The top edge of the region.
+     * @param regionWidth The width of the region.
+     * @param regionHeight The height of the region.
+     * @return true when the region is blurred.
+     */
+    public static native boolean isBlurredRegion(byte[] input, int width,
+            int height, int left, int top, int regionWidth, int regionHeight);
+
+    /**
+     * Tests if each of a few images of the same size, such as a short history
+     * of frames, is blurred or not. The images are checked in parallel.
+     *
+     * @param inputs Arrays of input pixels in YUV420SP format.
+     * @param width The width of the input images.
+     * @param height The height of the input images.
+     * @return An array whose i-th element is true when inputs[i] is blurred.
+     */
+    public static native boolean[] isBlurredBatch(
+            byte[][] inputs, int width, int height);
+
     /**
      * Computes signature of a given image.
      *
@@ -55,6 +82,27 @@ public class ImageBlur {
     public static native int[] computeSignature(
             byte[] input, int width, int height, int[] signatureBuffer);
 
+    /**
+     * Computes signature of a region of interest of a given image, sampling
+     * every step-th pixel of every step-th row. Only signatures computed with
+     * the same step should be compared.
+     *
+     * @param input An array of input pixels in YUV420SP format.
+     * @param width The width of the input image.
+     * @param height The height of the input image.
+     * @param left The left edge of the region.
+     * @param top The top edge of the region.
+     * @param regionWidth The width of the region.
+     * @param regionHeight The height of the region.
+     * @param step The distance between sampled pixels, 1 for all of them.
+     * @param signatureBuffer A buffer for output signature, as for
+     *            {@link #computeSignature}.
+     * @return Signature of the region of the input image.
+     */
+    public static native int[] computeSignatureRegion(byte[] input, int width,
+            int height, int left, int top, int regionWidth, int regionHeight,
+            int step, int[] signatureBuffer);
+
     /**
      * Computes how similar of two given images represented by their signatures.
      *
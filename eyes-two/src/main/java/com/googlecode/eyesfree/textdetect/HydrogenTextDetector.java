@@ -134,6 +134,8 @@ public class HydrogenTextDetector {
 
         public int edge_avg_thresh;
 
+        public int edge_num_threads;
+
         // Skew angle correction
         public boolean skew_enabled;
 
@@ -196,6 +198,7 @@ public class HydrogenTextDetector {
             edge_tile_y = 64;
             edge_thresh = 64;
             edge_avg_thresh = 4;
+            edge_num_threads = 0;
 
             // Skew angle correction
             skew_enabled = true;
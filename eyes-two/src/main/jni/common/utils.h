@@ -4,12 +4,26 @@
 #ifndef JAVA_COM_GOOGLE_ANDROID_APPS_UNVEIL_JNI_COMMON_UTILS_H_
 #define JAVA_COM_GOOGLE_ANDROID_APPS_UNVEIL_JNI_COMMON_UTILS_H_
 
+#ifdef __ANDROID__
 #include <android/log.h>
+#else
+#include <stdio.h>
+#endif
 #include <stdlib.h>
 
+// HAVE_NEON: NEON intrinsics are available, but on armeabi-v7a must still be
+// checked for at runtime with supportsNeon().
+// HAVE_SSE2: SSE2 intrinsics are available (x86 and x86_64).
 #ifdef HAVE_ARMEABI_V7A
 #include <cpu-features.h>
 #include <arm_neon.h>
+#define HAVE_NEON 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
 #endif
 
 #include <math.h>
@@ -25,16 +39,28 @@
   }\
 }
 
+#ifdef __ANDROID__
+#define LOG_PRINT(LEVEL, ...) \
+  __android_log_print(ANDROID_LOG_##LEVEL, LOG_TAG, __VA_ARGS__)
+#else
+// Off Android (e.g. when benchmarking on Linux), log to stderr.
+#define LOG_PRINT(LEVEL, ...) {\
+  fprintf(stderr, "%s/" #LEVEL ": ", LOG_TAG);\
+  fprintf(stderr, __VA_ARGS__);\
+  fprintf(stderr, "\n");\
+}
+#endif
+
 #ifdef VERBOSE_LOGGING
-#define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, LOG_TAG, __VA_ARGS__)
+#define LOGV(...) LOG_PRINT(VERBOSE, __VA_ARGS__)
 #else
 #define LOGV(...) {}
 #endif
 
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) LOG_PRINT(DEBUG, __VA_ARGS__)
+#define LOGI(...) LOG_PRINT(INFO, __VA_ARGS__)
+#define LOGW(...) LOG_PRINT(WARN, __VA_ARGS__)
+#define LOGE(...) LOG_PRINT(ERROR, __VA_ARGS__)
 #define LOG_TAG "goggles"
 
 #ifdef SANITY_CHECKS
@@ -55,6 +81,11 @@
 inline bool supportsNeon() {
   return (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0;
 }
+#elif defined(HAVE_NEON)
+// NEON is mandatory on arm64-v8a.
+inline bool supportsNeon() {
+  return true;
+}
 #endif
 
 #ifndef max
@@ -98,6 +98,7 @@ void Java_com_googlecode_eyesfree_textdetect_HydrogenTextDetector_nativeSetParam
   myParams->edge_tile_y = getIntField(env, paramClass, params, "edge_tile_y");
   myParams->edge_thresh = getIntField(env, paramClass, params, "edge_thresh");
   myParams->edge_avg_thresh = getIntField(env, paramClass, params, "edge_avg_thresh");
+  myParams->edge_num_threads = getIntField(env, paramClass, params, "edge_num_threads");
 
   myParams->skew_enabled = getBoolField(env, paramClass, params, "skew_enabled");
   myParams->skew_min_angle = getFloatField(env, paramClass, params, "skew_min_angle");
@@ -47,7 +47,7 @@ jlong Java_com_googlecode_eyesfree_textdetect_Thresholder_nativeEdgeAdaptiveThre
   PIX *pixd;
 
   if (pixEdgeAdaptiveThreshold(pixs, &pixd, (l_int32) tileX, (l_int32) tileY, (l_int32) threshold,
-                               (l_int32) average)) {
+                               (l_int32) average, 1)) {
     return (jlong) 0;
   }
 
@@ -67,7 +67,7 @@ jlong Java_com_googlecode_eyesfree_textdetect_Thresholder_nativeFisherAdaptiveTh
   PIX *pixd;
 
   if (pixFisherAdaptiveThreshold(pixs, &pixd, (l_int32) tileX, (l_int32) tileY,
-                                 (l_float32) scoreFract, (l_float32) thresh)) {
+                                 (l_float32) scoreFract, (l_float32) thresh, 1)) {
     return (jlong) 0;
   }
 
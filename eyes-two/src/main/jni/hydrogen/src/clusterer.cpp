@@ -15,6 +15,7 @@
  */
 
 #include <malloc.h>
+#include <math.h>
 #include "leptonica.h"
 #include "clusterer.h"
 #include "validator.h"
@@ -22,17 +23,128 @@
 /* Type of connected components: 4 is up/down/left/right. 8 includes diagonals */
 #define CONN_COMP 8
 
+/* Minimum height of a band of the pairing grid */
+#define MIN_BAND_HEIGHT 8
+
+/* Horizontal bands of the image, each listing the components that may pair
+ * with a component in it. Pairs must overlap vertically, so two partners
+ * always share a band, and only the components in the bands of a component
+ * need to be checked instead of all components.
+ */
+struct BandGrid {
+  l_int32 band_h;
+  l_int32 num_bands;
+  l_int32 *start;  // band b lists index[start[b]] ... index[start[b + 1] - 1]
+  l_int32 *index;  // component indices, increasing within each band
+};
+
+/* Returns the bottom row of the band extent of box, which covers the rows
+ * y ... y + h * extent with one row to spare for rounding.
+ */
+static l_int32 BandGridBottom(BOX *box, l_float32 extent) {
+  return L_MAX(box->y, (l_int32) floor(box->y + box->h * extent) + 1);
+}
+
+/**
+ * Lists the components of pixa that are not removed in the bands covered by
+ * their extent. Components of pixa must be sorted by x, so that each band
+ * is too.
+ */
+static BandGrid *CreateBandGrid(PIXA *pixa, l_uint8 *remove, l_float32 extent) {
+  l_int32 i, b, n, num, total_h, bottom, count;
+  BOX *box;
+  BandGrid *grid;
+
+  n = pixaGetCount(pixa);
+  grid = (BandGrid *) calloc(1, sizeof(BandGrid));
+
+  /* Make bands about as tall as the average component */
+  num = 0;
+  total_h = 0;
+  bottom = 0;
+  for (i = 0; i < n; i++) {
+    if (remove[i])
+      continue;
+    box = pixaGetBox(pixa, i, L_CLONE);
+    num++;
+    total_h += box->h;
+    bottom = L_MAX(bottom, BandGridBottom(box, extent));
+    boxDestroy(&box);
+  }
+  grid->band_h = L_MAX(MIN_BAND_HEIGHT, total_h / L_MAX(1, num));
+  grid->num_bands = bottom / grid->band_h + 1;
+  grid->start = (l_int32 *) calloc(grid->num_bands + 1, sizeof(l_int32));
+
+  /* Count the components in each band, then fill the bands in order */
+  for (i = 0; i < n; i++) {
+    if (remove[i])
+      continue;
+    box = pixaGetBox(pixa, i, L_CLONE);
+    for (b = box->y / grid->band_h; b <= BandGridBottom(box, extent) / grid->band_h; b++)
+      grid->start[b + 1]++;
+    boxDestroy(&box);
+  }
+  for (b = 0; b < grid->num_bands; b++)
+    grid->start[b + 1] += grid->start[b];
+
+  grid->index = (l_int32 *) malloc(L_MAX(1, grid->start[grid->num_bands]) * sizeof(l_int32));
+  for (i = 0; i < n; i++) {
+    if (remove[i])
+      continue;
+    box = pixaGetBox(pixa, i, L_CLONE);
+    for (b = box->y / grid->band_h; b <= BandGridBottom(box, extent) / grid->band_h; b++) {
+      count = grid->start[b];
+      grid->index[count] = i;
+      grid->start[b] = count + 1;
+    }
+    boxDestroy(&box);
+  }
+
+  /* Filling advanced each start to the next band's; shift them back */
+  for (b = grid->num_bands; b > 0; b--)
+    grid->start[b] = grid->start[b - 1];
+  grid->start[0] = 0;
+
+  return grid;
+}
+
+static void DestroyBandGrid(BandGrid **pgrid) {
+  BandGrid *grid = *pgrid;
+
+  if (!grid)
+    return;
+
+  free(grid->start);
+  free(grid->index);
+  free(grid);
+  *pgrid = NULL;
+}
+
+/* Returns the position of the first component after i in band b */
+static l_int32 BandGridFirstAfter(BandGrid *grid, l_int32 b, l_int32 i) {
+  l_int32 lo = grid->start[b];
+  l_int32 hi = grid->start[b + 1];
+
+  while (lo < hi) {
+    l_int32 mid = (lo + hi) / 2;
+    if (grid->index[mid] <= i)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
 l_int32 ConnCompValidPixa(PIX *pix8, PIX *pix, PIXA **ppixa, NUMA **pconfs,
                           HydrogenTextDetector::TextDetectorParameters &params) {
-  l_int32 h, iszero;
-  l_int32 x, y, xstart, ystart;
+  l_int32 i, n, iszero;
   l_float32 singleton_conf;
-  PIX *pixt1, *pixt2, *pixt3, *pixt4, *pixt5;
-  PIXA *pixa, *pixasort;
+  PIX *pixt3, *pixt5;
+  PIXA *pixa, *pixacc, *pixasort;
   NUMA *confs, *confsort;
   BOX *box;
-  BOXA *boxa;
-  L_STACK *lstack, *auxstack;
+  BOXA *boxa, *boxacc;
 
   PROCNAME("pixConnCompValidPixa");
 
@@ -45,45 +157,25 @@ l_int32 ConnCompValidPixa(PIX *pix8, PIX *pix, PIXA **ppixa, NUMA **pconfs,
   if (!pix || pixGetDepth(pix) != 1)
     return ERROR_INT("pixs undefined or not 1 bpp", procName, 1);
 
-  pixa = pixaCreate(0);
-  confs = numaCreate(0);
-
   pixZero(pix, &iszero);
   if (iszero) {
-    *ppixa = pixa;
+    *ppixa = pixaCreate(0);
     return 0;
   }
 
-  if ((pixt1 = pixCopy(NULL, pix)) == NULL)
-    return ERROR_INT("pixt1 not made", procName, 1);
-  if ((pixt2 = pixCopy(NULL, pix)) == NULL)
-    return ERROR_INT("pixt2 not made", procName, 1);
-
-  h = pixGetHeight(pix);
-  if ((lstack = lstackCreate(h)) == NULL)
-    return ERROR_INT("lstack not made", procName, 1);
-  if ((auxstack = lstackCreate(0)) == NULL)
-    return ERROR_INT("auxstack not made", procName, 1);
-  lstack->auxstack = auxstack;
-  if ((boxa = boxaCreate(0)) == NULL)
-    return ERROR_INT("boxa not made", procName, 1);
-
-  xstart = 0;
-  ystart = 0;
-  while (1) {
-    if (!nextOnPixelInRaster(pixt1, xstart, ystart, &x, &y))
-      break;
-
-    if ((box = pixSeedfillBB(pixt1, lstack, x, y, CONN_COMP)) == NULL)
-      return ERROR_INT("box not made", procName, 1);
-
-    /* Save the c.c. and remove from pixt2 as well */
-    pixt3 = pixClipRectangle(pixt1, box, NULL);
-    pixt4 = pixClipRectangle(pixt2, box, NULL);
+  /* Label all components in one pass over the runs of the image */
+  if ((boxacc = pixConnCompRuns(pix, &pixacc, NULL, CONN_COMP)) == NULL)
+    return ERROR_INT("components not found", procName, 1);
+
+  n = boxaGetCount(boxacc);
+  pixa = pixaCreate(n);
+  confs = numaCreate(n);
+  boxa = boxaCreate(n);
+
+  for (i = 0; i < n; i++) {
+    box = boxaGetBox(boxacc, i, L_CLONE);
+    pixt3 = pixaGetPix(pixacc, i, L_CLONE);
     pixt5 = pixClipRectangle(pix8, box, NULL);
-    pixXor(pixt3, pixt3, pixt4);
-    pixRasterop(pixt2, box->x, box->y, box->w, box->h, PIX_SRC ^ PIX_DST, pixt3, 0, 0);
-    pixDestroy(&pixt4);
 
     if (ValidateSingleton(pixt3, box, pixt5, &singleton_conf, params)) {
       boxaAddBox(boxa, box, L_INSERT);
@@ -95,9 +187,6 @@ l_int32 ConnCompValidPixa(PIX *pix8, PIX *pix, PIXA **ppixa, NUMA **pconfs,
     }
 
     pixDestroy(&pixt5);
-
-    xstart = x;
-    ystart = y;
   }
 
   /* Remove old boxa of pixa and replace with a clone copy */
@@ -110,12 +199,12 @@ l_int32 ConnCompValidPixa(PIX *pix8, PIX *pix, PIXA **ppixa, NUMA **pconfs,
     return ERROR_INT("pixasort not made", procName, 1);
   confsort = numaSortByIndex(confs, naindex);
 
-  /* Cleanup, freeing the fillsegs on each stack */
-  lstackDestroy(&lstack, TRUE);
-  pixDestroy(&pixt1);
-  pixDestroy(&pixt2);
+  boxaDestroy(&boxacc);
+  pixaDestroy(&pixacc);
   boxaDestroy(&boxa);
   pixaDestroy(&pixa);
+  numaDestroy(&confs);
+  numaDestroy(&naindex);
 
   *ppixa = pixasort;
   *pconfs = confsort;
@@ -255,12 +344,18 @@ l_int32 MergePairFragments(PIX *pix8, PIXA *clusters, PIXA *pixa, l_uint8 *remov
   return count;
 }
 
+/**
+ * Marks the components of pixa without a valid pair partner as removed and
+ * returns their number. Components of pixa must be sorted by x.
+ */
 l_int32 RemoveInvalidPairs(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *remove,
                            HydrogenTextDetector::TextDetectorParameters &params) {
-  l_int32 i, j, n, count;
-  l_float32 pair_conf;
+  l_int32 i, j, k, b, n, count, partner, bottom;
+  l_float32 pair_conf, max_h, max_x;
   l_uint8 *has_partner;
+  bool valid, too_far;
   BOX *b1, *b2;
+  BandGrid *grid;
 
   PROCNAME("pixRemoveInvalidPairs");
 
@@ -277,6 +372,7 @@ l_int32 RemoveInvalidPairs(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *remove,
   }
 
   has_partner = (l_uint8 *) calloc(n, sizeof(l_uint8));
+  grid = CreateBandGrid(pixa, remove, 1.0);
   count = 0;
 
   for (i = 0; i < n; i++) {
@@ -285,27 +381,46 @@ l_int32 RemoveInvalidPairs(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *remove,
 
     b1 = pixaGetBox(pixa, i, L_CLONE);
 
-    /* Search right for a partner for i */
-    for (j = i + 1; j < n; j++) {
-      if (remove[j])
-        continue;
+    /* A partner is at most pair_h_dist_ratio times the tallest height that
+     * passes the height ratio test to the right of i. */
+    max_x = 1e30;
+    if (params.pair_h_ratio >= 0 && params.pair_h_dist_ratio >= 0) {
+      max_h = b1->h + params.pair_h_ratio * (b1->h + 1.0);
+      max_x = b1->x + b1->w + params.pair_h_dist_ratio * max_h + 1;
+    }
+
+    /* Search right for the first partner for i */
+    partner = -1;
+    bottom = BandGridBottom(b1, 1.0) / grid->band_h;
+    for (b = b1->y / grid->band_h; b <= bottom; b++) {
+      for (k = BandGridFirstAfter(grid, b, i); k < grid->start[b + 1]; k++) {
+        j = grid->index[k];
+        if (partner >= 0 && j >= partner)
+          break;
 
-      b2 = pixaGetBox(pixa, j, L_CLONE);
+        b2 = pixaGetBox(pixa, j, L_CLONE);
+
+        /* Check whether this is a valid pair */
+        too_far = b2->x > max_x;
+        valid = !too_far && ValidatePair(b1, b2, &pair_conf, params);
 
-      /* Check whether this is a valid pair */
-      if (!ValidatePair(b1, b2, &pair_conf, params)) {
         boxDestroy(&b2);
-        continue;
-      }
 
-      // We don't need to adjust confidence values here, since we'll
-      // generate cluster pairs and use those later.
+        if (too_far)
+          break;
 
-      boxDestroy(&b2);
+        // We don't need to adjust confidence values here, since we'll
+        // generate cluster pairs and use those later.
+        if (valid) {
+          partner = j;
+          break;
+        }
+      }
+    }
 
+    if (partner >= 0) {
       has_partner[i] = 1;
-      has_partner[j] = 1;
-      break;
+      has_partner[partner] = 1;
     }
 
     boxDestroy(&b1);
@@ -319,6 +434,7 @@ l_int32 RemoveInvalidPairs(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *remove,
     }
   }
 
+  DestroyBandGrid(&grid);
   free(has_partner);
 
   return count;
@@ -328,14 +444,15 @@ l_int32 RemoveInvalidPairs(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *remove,
 
 l_int32 GenerateClusterPartners(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *remove, l_int32 **pleft,
                                 l_int32 **pright, HydrogenTextDetector::TextDetectorParameters &params) {
-  l_int32 n, i, j;
+  l_int32 n, i, j, k, b, bottom;
   l_int32 xi, yi, wi, hi, maxd;
   l_int32 xj, yj, wj, hj;
   l_int32 dx, dy, d, mind, minj;
   l_int32 *left, *right;
   l_float32 clusterpair_conf, minconf;
   BOX *b1, *b2;
-  bool too_far;
+  BandGrid *grid;
+  bool valid, too_far;
 
   PROCNAME("GenerateClusterPartners");
 
@@ -368,6 +485,8 @@ l_int32 GenerateClusterPartners(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *rem
     right[i] = -2;
   }
 
+  grid = CreateBandGrid(pixa, remove, params.cluster_shared_edge);
+
   /* For each component, check all possible neighbors to find the most likely
    * right neighbor. If that right neighbor already has a left neighbor, insert
    * the component to the right of the existing neighbor and the left of the
@@ -384,36 +503,45 @@ l_int32 GenerateClusterPartners(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *rem
     maxd = L_MAX(wi, hi);
     minconf = 0.0;
 
-    /* Search for closest right neighbor */
-    for (j = i + 1; j < n; j++) {
-      if (remove[j])
-        continue;
-
-      pixaGetBoxGeometry(pixa, j, &xj, &yj, &wj, &hj);
-      b2 = pixaGetBox(pixa, j, L_CLONE);
+    /* Search for closest right neighbor among the components sharing a
+     * band with i. Ties go to the first neighbor, as j is seen in several
+     * bands out of order.
+     */
+    bottom = BandGridBottom(b1, params.cluster_shared_edge) / grid->band_h;
+    for (b = yi / grid->band_h; b <= bottom; b++) {
+      for (k = BandGridFirstAfter(grid, b, i); k < grid->start[b + 1]; k++) {
+        j = grid->index[k];
+
+        pixaGetBoxGeometry(pixa, j, &xj, &yj, &wj, &hj);
+        b2 = pixaGetBox(pixa, j, L_CLONE);
+        valid = ValidateClusterPair(b1, b2, &too_far, &clusterpair_conf, params);
+        boxDestroy(&b2);
 
-      if (!ValidateClusterPair(b1, b2, &too_far, &clusterpair_conf, params)) {
-        if (too_far)
-          break;
-        else
-          continue;
-      }
+        if (!valid) {
+          if (too_far)
+            break;
+          else
+            continue;
+        }
 
-      /* calculate spacing between i and j */
-      dx = xj - (xi + wi);
-      dy = (yj + hj) - (yi + hi);
-      d = dx * dx + dy * dy;
-
-      /* If we haven't found a neighbor OR we're the closest neighbor, update
-       * i's record for most likely neighbor.
-       */
-      if (mind < 0 || d < mind) {
-        mind = d;
-        minj = j;
-        minconf = clusterpair_conf;
+        /* calculate spacing between i and j */
+        dx = xj - (xi + wi);
+        dy = (yj + hj) - (yi + hi);
+        d = dx * dx + dy * dy;
+
+        /* If we haven't found a neighbor OR we're the closest neighbor, update
+         * i's record for most likely neighbor.
+         */
+        if (mind < 0 || d < mind || (d == mind && j < minj)) {
+          mind = d;
+          minj = j;
+          minconf = clusterpair_conf;
+        }
       }
     }
 
+    boxDestroy(&b1);
+
     /* If we found a valid neighbor, go ahead and use it. */
     if (mind >= 0) {
       j = left[minj];
@@ -436,6 +564,8 @@ l_int32 GenerateClusterPartners(PIX *pix8, PIXA *pixa, NUMA *confs, l_uint8 *rem
     }
   }
 
+  DestroyBandGrid(&grid);
+
   *pleft = left;
   *pright = right;
 
@@ -160,7 +160,8 @@ void HydrogenTextDetector::DetectText() {
 
   PIX *edges;
   pixEdgeAdaptiveThreshold(pix8, &edges, parameters_.edge_tile_x, parameters_.edge_tile_y,
-                           parameters_.edge_thresh, parameters_.edge_avg_thresh);
+                           parameters_.edge_thresh, parameters_.edge_avg_thresh,
+                           parameters_.edge_num_threads);
 
   if (parameters_.debug && parameters_.out_dir[0] != '\0') {
     char filename[255];
@@ -34,6 +34,8 @@ public:
     l_int32 edge_tile_y;
     l_int32 edge_thresh;
     l_int32 edge_avg_thresh;
+    // Threads for rows of tiles; 0 for one per processor
+    l_int32 edge_num_threads;
 
     // Skew angle correction
     bool skew_enabled;
@@ -75,6 +77,7 @@ public:
           edge_tile_y(64),
           edge_thresh(64),
           edge_avg_thresh(4),
+          edge_num_threads(0),
           skew_enabled(true),
           skew_min_angle(1.0),
           skew_sweep_range(30.0),
@@ -15,10 +15,52 @@
  */
 
 #include <math.h>
+#include <stdlib.h>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HYDROGEN_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HYDROGEN_USE_SSE2 1
+#endif
 
 #include "leptonica.h"
 #include "thresholder.h"
 
+/*
+ *  Rows of tiles cover disjoint rows of the image, so the tasks that
+ *  l_runTasks() runs for each row may paint their tiles into a shared
+ *  destination without locking.
+ */
+
+struct FisherThresholdTiles {
+  PIXTILING *pt;
+  PIX *pixd;
+  l_int32 nx;
+  l_float32 score_fract;
+  l_float32 thresh;
+};
+
+static void FisherThresholdTileRow(void *data, l_int32 y) {
+  FisherThresholdTiles *tiles = (FisherThresholdTiles *) data;
+  l_float32 fdr = 0.0;
+  l_int32 t = 0;
+  PIX *pixb, *pixt;
+
+  for (l_int32 x = 0; x < tiles->nx; x++) {
+    pixt = pixTilingGetTile(tiles->pt, y, x);
+    pixGetFisherThresh(pixt, tiles->score_fract, &fdr, &t);
+
+    if (fdr > tiles->thresh) {
+      pixb = pixThresholdToBinary(pixt, t);
+      pixTilingPaintTile(tiles->pixd, y, x, pixb, tiles->pt);
+      pixDestroy(&pixb);
+    }
+
+    pixDestroy(&pixt);
+  }
+}
+
 /*!
  *  pixFisherAdaptiveThreshold()
  *
@@ -27,14 +69,16 @@
  *              sx, sy (desired tile dimensions; actual size may vary)
  *              scorefract (fraction of the max Otsu score; typ. 0.1)
  *              fdrthresh (threshold for Fisher's Discriminant Rate; typ. 5.0)
+ *              nthreads (max threads for rows of tiles; 0 for one per
+ *                        processor; the result does not depend on it)
  *      Return: 0 if OK, 1 on error
  */
 l_int32 pixFisherAdaptiveThreshold(PIX *pixs, PIX **ppixd, l_int32 tile_x, l_int32 tile_y,
-                                l_float32 score_fract, l_float32 thresh) {
-  l_float32 fdr;
-  l_int32 w, h, d, nx, ny, x, y, t;
-  PIX *pixb, *pixd, *pixt;
+                                l_float32 score_fract, l_float32 thresh, l_int32 nthreads) {
+  l_int32 w, h, d, nx, ny;
+  PIX *pixd;
   PIXTILING *pt;
+  FisherThresholdTiles tiles;
 
   PROCNAME("pixFisherAdaptiveThreshold");
 
@@ -53,20 +97,13 @@ l_int32 pixFisherAdaptiveThreshold(PIX *pixs, PIX **ppixd, l_int32 tile_x, l_int
   ny = L_MAX(1, h / tile_y);
   pt = pixTilingCreate(pixs, nx, ny, 0, 0, 0, 0);
   pixd = pixCreate(w, h, 1);
-  for (y = 0; y < ny; y++) {
-    for (x = 0; x < nx; x++) {
-      pixt = pixTilingGetTile(pt, y, x);
-      pixGetFisherThresh(pixt, score_fract, &fdr, &t);
-
-      if (fdr > thresh) {
-        pixb = pixThresholdToBinary(pixt, t);
-        pixTilingPaintTile(pixd, y, x, pixb, pt);
-        pixDestroy(&pixb);
-      }
 
-      pixDestroy(&pixt);
-    }
-  }
+  tiles.pt = pt;
+  tiles.pixd = pixd;
+  tiles.nx = nx;
+  tiles.score_fract = score_fract;
+  tiles.thresh = thresh;
+  l_runTasks(FisherThresholdTileRow, &tiles, ny, nthreads);
 
   pixTilingDestroy(&pt);
 
@@ -135,11 +172,132 @@ l_int32 pixGetFisherThresh(PIX *pixs, l_float32 scorefract, l_float32 *pfdr, l_i
   return 0;
 }
 
+/* Copies row line of an 8 bpp pix into row in raster order, followed by a
+ * copy of its last pixel so that the filter can read one pixel past it.
+ */
+static void SobelLoadRow(l_uint32 *line, l_int32 w, l_uint8 *row) {
+  for (l_int32 j = 0; j < w; j++)
+    row[j] = GET_DATA_BYTE(line, j);
+  row[w] = GET_DATA_BYTE(line, w - 1);
+}
+
+#if defined(HYDROGEN_USE_NEON)
+static const l_uint8 kSobelBitWeights[16] = {
+  128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1
+};
+
+/* Returns 0xffff where the filter output for the 8 pixels at r1 + 1
+ * reaches threshold.
+ */
+static inline uint16x8_t SobelMask8(const l_uint8 *r0, const l_uint8 *r1, const l_uint8 *r2,
+                                    int16x8_t threshold) {
+  int16x8_t a0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0)));
+  int16x8_t a1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0 + 1)));
+  int16x8_t a2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0 + 2)));
+  int16x8_t b0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r1)));
+  int16x8_t b2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r1 + 2)));
+  int16x8_t c0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2)));
+  int16x8_t c1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2 + 1)));
+  int16x8_t c2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2 + 2)));
+  int16x8_t gx = vsubq_s16(vaddq_s16(vaddq_s16(a0, c0), vshlq_n_s16(b0, 1)),
+                           vaddq_s16(vaddq_s16(a2, c2), vshlq_n_s16(b2, 1)));
+  int16x8_t gy = vsubq_s16(vaddq_s16(vaddq_s16(a0, a2), vshlq_n_s16(a1, 1)),
+                           vaddq_s16(vaddq_s16(c0, c2), vshlq_n_s16(c1, 1)));
+  int16x8_t mag = vminq_s16(vaddq_s16(vabsq_s16(gx), vabsq_s16(gy)), vdupq_n_s16(255));
+
+  return vcgeq_s16(mag, threshold);
+}
+#elif defined(HYDROGEN_USE_SSE2)
+static inline __m128i SobelLoad8(const l_uint8 *p) {
+  return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) p), _mm_setzero_si128());
+}
+
+static inline __m128i SobelAbs16(__m128i v) {
+  return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+/* Returns 0xffff where the filter output for the 8 pixels at r1 + 1
+ * exceeds threshold_minus_1.
+ */
+static inline __m128i SobelMask8(const l_uint8 *r0, const l_uint8 *r1, const l_uint8 *r2,
+                                 __m128i threshold_minus_1) {
+  __m128i a0 = SobelLoad8(r0);
+  __m128i a1 = SobelLoad8(r0 + 1);
+  __m128i a2 = SobelLoad8(r0 + 2);
+  __m128i b0 = SobelLoad8(r1);
+  __m128i b2 = SobelLoad8(r1 + 2);
+  __m128i c0 = SobelLoad8(r2);
+  __m128i c1 = SobelLoad8(r2 + 1);
+  __m128i c2 = SobelLoad8(r2 + 2);
+  __m128i gx = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(a0, c0), _mm_slli_epi16(b0, 1)),
+                             _mm_add_epi16(_mm_add_epi16(a2, c2), _mm_slli_epi16(b2, 1)));
+  __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(a0, a2), _mm_slli_epi16(a1, 1)),
+                             _mm_add_epi16(_mm_add_epi16(c0, c2), _mm_slli_epi16(c1, 1)));
+  __m128i mag = _mm_min_epi16(_mm_add_epi16(SobelAbs16(gx), SobelAbs16(gy)),
+                              _mm_set1_epi16(255));
+
+  return _mm_cmpgt_epi16(mag, threshold_minus_1);
+}
+#endif
+
+/* Thresholds the filter output for the first pixels of a row into lined,
+ * 16 at a time, and returns the number of pixels done.
+ */
+static l_int32 SobelThresholdRowLow(const l_uint8 *r0, const l_uint8 *r1, const l_uint8 *r2,
+                                    l_int32 n, l_int32 threshold, l_uint32 *lined) {
+  l_int32 j = 0;
+
+  /* Clamping leaves the comparisons unchanged, as the output is in [0, 255] */
+  threshold = L_MIN(256, L_MAX(0, threshold));
+
+#if defined(HYDROGEN_USE_NEON)
+  int16x8_t vthresh = vdupq_n_s16(threshold);
+  uint8x16_t weights = vld1q_u8(kSobelBitWeights);
+
+  for (; j + 16 <= n; j += 16) {
+    uint8x16_t mask = vcombine_u8(vmovn_u16(SobelMask8(r0 + j, r1 + j, r2 + j, vthresh)),
+                                  vmovn_u16(SobelMask8(r0 + j + 8, r1 + j + 8, r2 + j + 8,
+                                                       vthresh)));
+    uint64x2_t bytes = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vandq_u8(mask, weights))));
+
+    SET_DATA_BYTE(lined, j >> 3, (l_int32) vgetq_lane_u64(bytes, 0));
+    SET_DATA_BYTE(lined, (j >> 3) + 1, (l_int32) vgetq_lane_u64(bytes, 1));
+  }
+#elif defined(HYDROGEN_USE_SSE2)
+  __m128i vthresh = _mm_set1_epi16((short) (threshold - 1));
+  __m128i weights = _mm_setr_epi8((char) 128, 64, 32, 16, 8, 4, 2, 1,
+                                  (char) 128, 64, 32, 16, 8, 4, 2, 1);
+
+  for (; j + 16 <= n; j += 16) {
+    __m128i mask = _mm_packs_epi16(SobelMask8(r0 + j, r1 + j, r2 + j, vthresh),
+                                   SobelMask8(r0 + j + 8, r1 + j + 8, r2 + j + 8, vthresh));
+    __m128i bytes = _mm_sad_epu8(_mm_and_si128(mask, weights), _mm_setzero_si128());
+
+    SET_DATA_BYTE(lined, j >> 3, _mm_cvtsi128_si32(bytes));
+    SET_DATA_BYTE(lined, (j >> 3) + 1, _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)));
+  }
+#endif
+
+  return j;
+}
+
+/*!
+ *  pixThreshedSobelEdgeFilter()
+ *
+ *      Input:  pixs (8 bpp)
+ *              threshold (minimum filter output for an edge pixel)
+ *      Return: pixd (1 bpp edges), or null on error
+ *
+ *  The output at (j, i) is the Sobel filter centered on (j + 1, i + 1);
+ *  pixels past the last row and column are copies of it. The last row
+ *  and column of pixd are left empty.
+ */
 PIX *pixThreshedSobelEdgeFilter(PIX *pixs, l_int32 threshold) {
-  l_uint8 bval, bidx;
-  l_int32 w, h, d, i, j, wplt, wpld, gx, gy, vald;
-  l_int32 val1, val2, val3, val4, val5, val6, val7, val8, val9;
-  l_uint32 *datat, *linet, *datad, *lined;
+  l_uint8 bval;
+  l_int32 w, h, d, i, j, n, wplt, wpld, gx, gy, vald;
+  l_int32 val1, val2, val3, val4, val6, val7, val8, val9;
+  l_uint8 *buf, *row0, *row1, *row2, *rowt;
+  l_uint32 *datat, *datad, *lined;
   PIX *pixd;
 
   PROCNAME("pixThreshedSobelEdgeFilter");
@@ -150,71 +308,92 @@ PIX *pixThreshedSobelEdgeFilter(PIX *pixs, l_int32 threshold) {
   if (d != 8)
     return (PIX *) ERROR_PTR("pixs not 8 bpp", procName, NULL);
 
+  if ((pixd = pixCreate(w, h, 1)) == NULL)
+    return (PIX *) ERROR_PTR("pixd not made", procName, NULL);
+  if (w < 2 || h < 2)
+    return pixd;
+
+  /* Keep three source rows in raster order, so that the filter can read
+   * neighboring pixels without regard to byte order. */
+  if ((buf = (l_uint8 *) malloc(3 * (w + 1))) == NULL) {
+    pixDestroy(&pixd);
+    return (PIX *) ERROR_PTR("buf not made", procName, NULL);
+  }
+  row0 = buf;
+  row1 = buf + (w + 1);
+  row2 = buf + 2 * (w + 1);
+
   /* Compute filter output at each location. */
-  pixd = pixCreateNoInit(w, h, 1);
   datat = pixGetData(pixs);
   wplt = pixGetWpl(pixs);
   datad = pixGetData(pixd);
   wpld = pixGetWpl(pixd);
-  val1 = val2 = val3 = val4 = val5 = 0;
-  val6 = val7 = val8 = val9 = 0;
-  bval = bidx = 0;
+  n = w - 1;
+  SobelLoadRow(datat, w, row0);
+  SobelLoadRow(datat + wplt, w, row1);
   for (i = 0; i < h - 1; i++) {
-    linet = datat + i * wplt;
+    SobelLoadRow(datat + L_MIN(i + 2, h - 1) * wplt, w, row2);
     lined = datad + i * wpld;
-    for (j = 0; j < w - 1; j++) {
-      if (j == 0) { /* start a new row */
-        val1 = GET_DATA_BYTE(linet, j);
-        val2 = GET_DATA_BYTE(linet + wplt, j);
-        val3 = GET_DATA_BYTE(linet + (wplt << 1), j);
-        val4 = GET_DATA_BYTE(linet, j + 1);
-        val5 = GET_DATA_BYTE(linet + wplt, j + 1);
-        val6 = GET_DATA_BYTE(linet + (wplt << 1), j + 1);
-        val7 = GET_DATA_BYTE(linet, j + 2);
-        val8 = GET_DATA_BYTE(linet + wplt, j + 2);
-        val9 = GET_DATA_BYTE(linet + (wplt << 1), j + 2);
-        bval = 0;
-        bidx = 0x80;
-      } else { /* shift right by 1 pixel; update incrementally */
-        val1 = val4;
-        val2 = val5;
-        val3 = val6;
-        val4 = val7;
-        val5 = val8;
-        val6 = val9;
-        val7 = GET_DATA_BYTE(linet, j + 2);
-        val8 = GET_DATA_BYTE(linet + wplt, j + 2);
-        val9 = GET_DATA_BYTE(linet + (wplt << 1), j + 2);
-      }
 
-      bval <<= 1;
-      bidx >>= 1;
+    j = SobelThresholdRowLow(row0, row1, row2, n, threshold, lined);
+
+    bval = 0;
+    for (; j < n; j++) {
+      val1 = row0[j];
+      val2 = row1[j];
+      val3 = row2[j];
+      val4 = row0[j + 1];
+      val6 = row2[j + 1];
+      val7 = row0[j + 2];
+      val8 = row1[j + 2];
+      val9 = row2[j + 2];
 
       gx = val1 + (val2 << 1) + val3 - val7 - (val8 << 1) - val9;
       gy = val1 + (val4 << 1) + val7 - val3 - (val6 << 1) - val9;
       vald = L_MIN(255, L_ABS(gx) + L_ABS(gy));
 
       /* Flip high bit if value exceeds threshold */
+      bval <<= 1;
       if (vald >= threshold) {
         bval |= 1;
       }
 
-      if (bidx == 0) {
-        SET_DATA_BYTE(lined, j / 8, bval);
-
+      if ((j & 7) == 7) {
+        SET_DATA_BYTE(lined, j >> 3, bval);
         bval = 0;
-        bidx = 0x80;
       }
     }
+
+    if (n & 7) {
+      SET_DATA_BYTE(lined, n >> 3, bval << (8 - (n & 7)));
+    }
+
+    rowt = row0;
+    row0 = row1;
+    row1 = row2;
+    row2 = rowt;
   }
 
+  free(buf);
+
   return pixd;
 }
 
+/*!
+ *  pixGradientEnergy()
+ *
+ *      Input:  pixs (8 bpp)
+ *              mask (1 bpp, same size as pixs)
+ *              &energy (<return> average gradient across mask edges)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Horizontal edges of the mask are found a word at a time, so only the
+ *  pixels on an edge are read from pixs.
+ */
 l_uint8 pixGradientEnergy(PIX *pixs, PIX *mask, l_float32 *penergy) {
-  l_int32 w, h, d;
+  l_int32 w, h, d, x, y, k, nbits;
   l_uint8 val1, val2;
-  l_uint32 mask1, mask2;
+  l_uint32 edges, next;
   l_int32 wpls, wplm;
   l_uint32 *datas, *lines;
   l_uint32 *datam, *linem;
@@ -224,6 +403,8 @@ l_uint8 pixGradientEnergy(PIX *pixs, PIX *mask, l_float32 *penergy) {
 
   if (!pixs)
     return ERROR_INT("pixs not defined", procName, -1);
+  if (!mask)
+    return ERROR_INT("mask not defined", procName, -1);
   pixGetDimensions(pixs, &w, &h, &d);
   if (d != 8)
     return ERROR_INT("pixs not 8 bpp", procName, -1);
@@ -235,28 +416,27 @@ l_uint8 pixGradientEnergy(PIX *pixs, PIX *mask, l_float32 *penergy) {
   wplm = pixGetWpl(mask);
   total = 0;
   count = 1;
-  mask1 = mask2 = 0;
-  val1 = val2 = 0;
-  for (int y = 0; y < h; y++) {
+  for (y = 0; y < h; y++) {
     lines = datas + y * wpls;
     linem = datam + y * wplm;
-    for (int x = 0; x < w - 1; x++) {
-      if (x == 0) { /* start a new row */
-        mask1 = GET_DATA_BIT(linem, x);
-        mask2 = GET_DATA_BIT(linem, x + 1);
-        val1 = GET_DATA_BYTE(lines, x);
-        val2 = GET_DATA_BYTE(lines, x + 1);
-      } else { /* shift right by 1 pixel; update incrementally */
-        val1 = val2;
-        val2 = GET_DATA_BYTE(lines, x + 1);
-        mask1 = mask2;
-        mask2 = GET_DATA_BIT(linem, x + 1);
-      }
+
+    /* Bit b of edges is set where pixel 32k + b differs from its right
+     * neighbor in the mask, for the pixels 0 ... w - 2. */
+    for (k = 0; 32 * k < w - 1; k++) {
+      next = (k + 1 < wplm) ? linem[k + 1] : 0;
+      edges = linem[k] ^ ((linem[k] << 1) | (next >> 31));
+      nbits = w - 1 - 32 * k;
+      if (nbits < 32)
+        edges &= ~(0xffffffff >> nbits);
 
       /* If we're on an edge, add the gradient value and increment */
-      if (mask1 != mask2) {
+      while (edges) {
+        x = 32 * k + 31 - __builtin_ctz(edges);
+        val1 = GET_DATA_BYTE(lines, x);
+        val2 = GET_DATA_BYTE(lines, x + 1);
         total += L_ABS(val1 - val2);
         count += 1;
+        edges &= edges - 1;
       }
     }
   }
@@ -266,9 +446,81 @@ l_uint8 pixGradientEnergy(PIX *pixs, PIX *mask, l_float32 *penergy) {
   return 0;
 }
 
+/* Adds |pixel(x) - pixel(x + 4)| over the first pixels x of an 8 bpp
+ * line to *ptotal and raises *pmax to their maximum, and returns the
+ * number of pixels done. Pixels four apart are a word apart in memory
+ * in either byte order, so whole words are compared without unpacking.
+ */
+static l_int32 EdgeMaxRowLow(l_uint32 *line, l_int32 n, l_int32 *pmax, l_int32 *ptotal) {
+  l_int32 x = 0;
+
+#if defined(HYDROGEN_USE_NEON)
+  const l_uint8 *bytes = (const l_uint8 *) line;
+  uint8x16_t vmax = vdupq_n_u8(0);
+  uint32x4_t vsum = vdupq_n_u32(0);
+  uint8x8_t max8;
+  uint64x2_t sum64;
+
+  for (; x + 16 <= n; x += 16) {
+    uint8x16_t diff = vabdq_u8(vld1q_u8(bytes + x), vld1q_u8(bytes + x + 4));
+    vmax = vmaxq_u8(vmax, diff);
+    vsum = vpadalq_u16(vsum, vpaddlq_u8(diff));
+  }
+  if (x + 8 <= n) {
+    uint8x8_t diff = vabd_u8(vld1_u8(bytes + x), vld1_u8(bytes + x + 4));
+    vmax = vmaxq_u8(vmax, vcombine_u8(diff, vdup_n_u8(0)));
+    vsum = vpadalq_u16(vsum, vcombine_u16(vpaddl_u8(diff), vdup_n_u16(0)));
+    x += 8;
+  }
+  if (x == 0)
+    return 0;
+
+  max8 = vpmax_u8(vget_low_u8(vmax), vget_high_u8(vmax));
+  max8 = vpmax_u8(max8, max8);
+  max8 = vpmax_u8(max8, max8);
+  max8 = vpmax_u8(max8, max8);
+  *pmax = L_MAX(*pmax, (l_int32) vget_lane_u8(max8, 0));
+  sum64 = vpaddlq_u32(vsum);
+  *ptotal += (l_int32) (vgetq_lane_u64(sum64, 0) + vgetq_lane_u64(sum64, 1));
+#elif defined(HYDROGEN_USE_SSE2)
+  const l_uint8 *bytes = (const l_uint8 *) line;
+  __m128i zero = _mm_setzero_si128();
+  __m128i vmax = zero;
+  __m128i vsum = zero;
+  __m128i a, b, diff;
+
+  for (; x + 16 <= n; x += 16) {
+    a = _mm_loadu_si128((const __m128i *) (bytes + x));
+    b = _mm_loadu_si128((const __m128i *) (bytes + x + 4));
+    diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+    vmax = _mm_max_epu8(vmax, diff);
+    vsum = _mm_add_epi32(vsum, _mm_sad_epu8(diff, zero));
+  }
+  if (x + 8 <= n) {
+    a = _mm_loadl_epi64((const __m128i *) (bytes + x));
+    b = _mm_loadl_epi64((const __m128i *) (bytes + x + 4));
+    diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+    vmax = _mm_max_epu8(vmax, diff);
+    vsum = _mm_add_epi32(vsum, _mm_sad_epu8(diff, zero));
+    x += 8;
+  }
+  if (x == 0)
+    return 0;
+
+  vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 8));
+  vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 4));
+  vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 2));
+  vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 1));
+  *pmax = L_MAX(*pmax, _mm_cvtsi128_si32(vmax) & 0xff);
+  *ptotal += _mm_cvtsi128_si32(vsum) + _mm_cvtsi128_si32(_mm_srli_si128(vsum, 8));
+#endif
+
+  return x;
+}
+
 l_uint8 pixEdgeMax(PIX *pixs, l_int32 *pmax, l_int32 *pavg) {
   l_int32 w, h, d, wplt, vald;
-  l_uint8 val1, val2, val3, val4, val5;
+  l_uint8 val1, val5;
   l_uint32 *datat, *linet;
   l_int32 max, total;
 
@@ -285,23 +537,11 @@ l_uint8 pixEdgeMax(PIX *pixs, l_int32 *pmax, l_int32 *pavg) {
   wplt = pixGetWpl(pixs);
   max = 0;
   total = 0;
-  val1 = val2 = val3 = val4 = val5 = 0;
   for (int y = 0; y < h; y++) {
     linet = datat + y * wplt;
-    for (int x = 0; x < w - 5; x++) {
-      if (x == 0) { /* start a new row */
-        val1 = GET_DATA_BYTE(linet, x);
-        val2 = GET_DATA_BYTE(linet, x + 1);
-        val3 = GET_DATA_BYTE(linet, x + 2);
-        val4 = GET_DATA_BYTE(linet, x + 3);
-        val5 = GET_DATA_BYTE(linet, x + 4);
-      } else { /* shift right by 1 pixel; update incrementally */
-        val1 = val2;
-        val2 = val3;
-        val3 = val4;
-        val4 = val5;
-        val5 = GET_DATA_BYTE(linet, x + 4);
-      }
+    for (int x = EdgeMaxRowLow(linet, w - 5, &max, &total); x < w - 5; x++) {
+      val1 = GET_DATA_BYTE(linet, x);
+      val5 = GET_DATA_BYTE(linet, x + 4);
 
       //maxd = L_MAX(val5, L_MAX(val4, L_MAX(val3, L_MAX(val2, val1))));
       //mind = L_MIN(val5, L_MIN(val4, L_MIN(val3, L_MIN(val2, val1))));
@@ -321,6 +561,34 @@ l_uint8 pixEdgeMax(PIX *pixs, l_int32 *pmax, l_int32 *pavg) {
   return 0;
 }
 
+struct EdgeThresholdTiles {
+  PIXTILING *pt;
+  PIX *pixd;
+  l_int32 nx;
+  l_int32 thresh;
+  l_int32 avg_thresh;
+};
+
+static void EdgeThresholdTileRow(void *data, l_int32 y) {
+  EdgeThresholdTiles *tiles = (EdgeThresholdTiles *) data;
+  l_int32 t, max, avg;
+  PIX *pixb, *pixt;
+
+  for (l_int32 x = 0; x < tiles->nx; x++) {
+    pixt = pixTilingGetTile(tiles->pt, y, x);
+    pixEdgeMax(pixt, &max, &avg);
+
+    if (max > tiles->thresh && avg > tiles->avg_thresh) {
+      pixSplitDistributionFgBg(pixt, 0.0, 1, &t, NULL, NULL, 0);
+      pixb = pixThresholdToBinary(pixt, t);
+      pixTilingPaintTile(tiles->pixd, y, x, pixb, tiles->pt);
+      pixDestroy(&pixb);
+    }
+
+    pixDestroy(&pixt);
+  }
+}
+
 /*!
  *  pixEdgeAdaptiveThreshold()
  *
@@ -329,13 +597,16 @@ l_uint8 pixEdgeMax(PIX *pixs, l_int32 *pmax, l_int32 *pavg) {
  *              tile_x, tile_y (desired tile dimensions; actual size may vary)
  *              thresh
  *              avg_thresh
+ *              nthreads (max threads for rows of tiles; 0 for one per
+ *                        processor; the result does not depend on it)
  *      Return: 0 if OK, 1 on error
  */
 l_uint8 pixEdgeAdaptiveThreshold(PIX *pixs, PIX **ppixd, l_int32 tile_x, l_int32 tile_y,
-                                  l_int32 thresh, l_int32 avg_thresh) {
-  l_int32 w, h, d, nx, ny, x, y, t, max, avg;
-  PIX *pixb, *pixd, *pixt;
+                                  l_int32 thresh, l_int32 avg_thresh, l_int32 nthreads) {
+  l_int32 w, h, d, nx, ny;
+  PIX *pixd;
   PIXTILING *pt;
+  EdgeThresholdTiles tiles;
 
   PROCNAME("pixEdgeAdaptiveThreshold");
 
@@ -349,26 +620,18 @@ l_uint8 pixEdgeAdaptiveThreshold(PIX *pixs, PIX **ppixd, l_int32 tile_x, l_int32
   if (tile_x < 8 || tile_y < 8)
     return ERROR_INT("sx and sy must be >= 8", procName, 1);
 
-  /* Compute FDR & threshold for individual tiles */
+  /* Compute edge statistics & threshold for individual tiles */
   nx = L_MAX(1, w / tile_x);
   ny = L_MAX(1, h / tile_y);
   pt = pixTilingCreate(pixs, nx, ny, 0, 0, 0, 0);
   pixd = pixCreate(w, h, 1);
-  for (y = 0; y < ny; y++) {
-    for (x = 0; x < nx; x++) {
-      pixt = pixTilingGetTile(pt, y, x);
-      pixEdgeMax(pixt, &max, &avg);
-
-      if (max > thresh && avg > avg_thresh) {
-        pixSplitDistributionFgBg(pixt, 0.0, 1, &t, NULL, NULL, 0);
-        pixb = pixThresholdToBinary(pixt, t);
-        pixTilingPaintTile(pixd, y, x, pixb, pt);
-        pixDestroy(&pixb);
-      }
 
-      pixDestroy(&pixt);
-    }
-  }
+  tiles.pt = pt;
+  tiles.pixd = pixd;
+  tiles.nx = nx;
+  tiles.thresh = thresh;
+  tiles.avg_thresh = avg_thresh;
+  l_runTasks(EdgeThresholdTileRow, &tiles, ny, nthreads);
 
   pixTilingDestroy(&pt);
 
@@ -6,7 +6,10 @@ LOCAL_MODULE := imageutils$(LIB_SUFFIX)
 LOCAL_SRC_FILES := blur-jni.cpp \
 		               similar-jni.cpp \
                    blur.cpp \
-		               similar.cpp
+		               similar.cpp \
+                   parallel.cpp
+
+LOCAL_CFLAGS += -DHAVE_PTHREAD
 
 ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
   LOCAL_CFLAGS += -DHAVE_ARMEABI_V7A=1 -mfloat-abi=softfp -mfpu=neon
@@ -32,6 +32,15 @@ JNIEXPORT jboolean JNICALL
 Java_com_googlecode_eyesfree_opticflow_ImageBlur_isBlurred(
     JNIEnv* env, jclass clazz, jbyteArray input, jint width, jint height);
 
+JNIEXPORT jboolean JNICALL
+Java_com_googlecode_eyesfree_opticflow_ImageBlur_isBlurredRegion(
+    JNIEnv* env, jclass clazz, jbyteArray input, jint width, jint height,
+    jint left, jint top, jint regionWidth, jint regionHeight);
+
+JNIEXPORT jbooleanArray JNICALL
+Java_com_googlecode_eyesfree_opticflow_ImageBlur_isBlurredBatch(
+    JNIEnv* env, jclass clazz, jobjectArray inputs, jint width, jint height);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,3 +64,66 @@ Java_com_googlecode_eyesfree_opticflow_ImageBlur_isBlurred(
 
   return blurred ? JNI_TRUE : JNI_FALSE;
 }
+
+JNIEXPORT jboolean JNICALL
+Java_com_googlecode_eyesfree_opticflow_ImageBlur_isBlurredRegion(
+    JNIEnv* env, jclass clazz, jbyteArray input, jint width, jint height,
+    jint left, jint top, jint regionWidth, jint regionHeight) {
+  jboolean inputCopy = JNI_FALSE;
+  jbyte* const i = env->GetByteArrayElements(input, &inputCopy);
+
+  float blur = 0;
+  float extent = 0;
+
+  resetTimeLog();
+  int blurred = IsBlurredRegion(reinterpret_cast<uint8*>(i), width, height,
+                                left, top, regionWidth, regionHeight,
+                                &blur, &extent);
+  timeLog("Finished image blur detection");
+  printTimeLog();
+
+  env->ReleaseByteArrayElements(input, i, JNI_ABORT);
+
+  return blurred ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jbooleanArray JNICALL
+Java_com_googlecode_eyesfree_opticflow_ImageBlur_isBlurredBatch(
+    JNIEnv* env, jclass clazz, jobjectArray inputs, jint width, jint height) {
+  const int num_frames = env->GetArrayLength(inputs);
+
+  jbyteArray* const arrays = new jbyteArray[num_frames];
+  jbyte** const frames = new jbyte*[num_frames];
+  int* const blurred = new int[num_frames];
+  float* const blur = new float[num_frames];
+  float* const extent = new float[num_frames];
+
+  for (int f = 0; f < num_frames; ++f) {
+    arrays[f] =
+        static_cast<jbyteArray>(env->GetObjectArrayElement(inputs, f));
+    frames[f] = env->GetByteArrayElements(arrays[f], NULL);
+  }
+
+  resetTimeLog();
+  IsBlurredBatch(reinterpret_cast<const uint8* const*>(frames), num_frames,
+                 width, height, blurred, blur, extent);
+  timeLog("Finished batch image blur detection");
+  printTimeLog();
+
+  jbooleanArray ret = env->NewBooleanArray(num_frames);
+  jboolean* const body = env->GetBooleanArrayElements(ret, 0);
+  for (int f = 0; f < num_frames; ++f) {
+    env->ReleaseByteArrayElements(arrays[f], frames[f], JNI_ABORT);
+    env->DeleteLocalRef(arrays[f]);
+    body[f] = blurred[f] ? JNI_TRUE : JNI_FALSE;
+  }
+  env->ReleaseBooleanArrayElements(ret, body, 0);
+
+  delete[] extent;
+  delete[] blur;
+  delete[] blurred;
+  delete[] frames;
+  delete[] arrays;
+
+  return ret;
+}
@@ -19,8 +19,8 @@
 // This library contains image processing method to detect
 // image blurriness.
 //
-// This library is *not* thread safe because static memory is
-// used for performance.
+// Working memory is allocated per call and per thread, so different
+// images may be checked at the same time.
 //
 // A method to detect whether a given image is blurred or not.
 // The algorithm is based on H. Tong, M. Li, H. Zhang, J. He,
@@ -30,13 +30,16 @@
 // To achieve better performance on client side, the method
 // is running on four 128x128 portions which compose the 256x256
 // central area of the given image. On Nexus One, average time
-// to process a single image is ~5 milliseconds.
+// to process a single image is ~5 milliseconds. The portions (and,
+// for a batch, the frames) are processed on separate threads, and
+// the transform and edge maps are vectorized with NEON or SSE2.
 
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "blur.h"
+#include "parallel.h"
 #include "utils.h"
 
 static const int kDecomposition = 3;
@@ -46,124 +49,259 @@ static const float kMinZero = 0.05;
 static const int kMaximumWidth = 256;
 static const int kMaximumHeight = 256;
 
-static int32 _smatrix[kMaximumWidth * kMaximumHeight];
-static int32 _arow[kMaximumWidth > kMaximumHeight ?
-    kMaximumWidth : kMaximumHeight];
-
-// Does Haar Wavelet Transformation in place on a given row of a matrix.
-// The matrix is in size of matrix_height * matrix_width and represented
-// in a linear array. Parameter offset_row indicates transformation is
-// performed on which row. offset_column and num_columns indicate column
-// range of the given row.
-inline void Haar1DX(int* matrix, int matrix_height, int matrix_width,
-    int offset_row, int offset_column, int num_columns) {
-  int32* ptr_a = _arow;
-  int32* ptr_matrix = matrix + offset_row * matrix_width + offset_column;
-  int half_num_columns = num_columns / 2;
-
-  int32* a_tmp = ptr_a;
-  int32* matrix_tmp = ptr_matrix;
-  for (int j = 0; j < half_num_columns; ++j) {
-    *a_tmp++ = (matrix_tmp[0] + matrix_tmp[1]) / 2;
-    matrix_tmp += 2;
-  }
+// The area is checked as four portions of at most this size.
+static const int kNumPortions = 4;
+static const int kPortionWidth = kMaximumWidth / 2;
+static const int kPortionHeight = kMaximumHeight / 2;
+
+// Working memory for one portion.
+struct BlurScratch {
+  // The transformed portion.
+  int32 matrix[kPortionWidth * kPortionHeight];
+  // Differences of row pairs, held until the averages are all written.
+  int32 details[kPortionWidth * (kPortionHeight / 2)];
+  // A transformed pair of rows.
+  int32 row_a[kPortionWidth];
+  int32 row_b[kPortionWidth];
+  // Sum of the absolute detail coefficients at each point of one scale.
+  int32 edges[(kPortionWidth / 2) * (kPortionHeight / 2)];
+};
+
+#if defined(HAVE_NEON)
+// Halves the sums, truncating toward zero like integer division.
+static inline int32x4_t HalveNeon(const int32x4_t sums) {
+  return vshrq_n_s32(vaddq_s32(sums, vreinterpretq_s32_u32(
+      vshrq_n_u32(vreinterpretq_u32_s32(sums), 31))), 1);
+}
+#elif defined(HAVE_SSE2)
+// Halves the sums, truncating toward zero like integer division.
+static inline __m128i HalveSse2(const __m128i sums) {
+  return _mm_srai_epi32(_mm_add_epi32(sums, _mm_srli_epi32(sums, 31)), 1);
+}
 
-  int32* average = ptr_a;
-  a_tmp = ptr_a + half_num_columns;
-  matrix_tmp = ptr_matrix;
-  for (int j = 0; j < half_num_columns; ++j) {
-    *a_tmp++ = *matrix_tmp - *average++;
-    matrix_tmp += 2;
+static inline __m128i AbsSse2(const __m128i v) {
+  const __m128i sign = _mm_srai_epi32(v, 31);
+  return _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+}
+#endif
+
+// Does one level of the Haar wavelet transformation on num_columns values
+// of a row. The first half of the output is the averages of neighboring
+// pairs and the second half the differences of the first of each pair from
+// its average. An odd last value is copied as it is.
+static void HaarRow(const uint8* const row, const int num_columns,
+                    int32* const out) {
+  const int half_num_columns = num_columns / 2;
+  int32* const average = out;
+  int32* const detail = out + half_num_columns;
+  int j = 0;
+
+#if defined(HAVE_NEON)
+  if (supportsNeon()) {
+    for (; j + 8 <= half_num_columns; j += 8) {
+      const uint8x8x2_t pairs = vld2_u8(row + 2 * j);
+      // Both values are unsigned, so halving rounds down.
+      const uint8x8_t avg = vhadd_u8(pairs.val[0], pairs.val[1]);
+      const int16x8_t diff = vreinterpretq_s16_u16(
+          vsubl_u8(pairs.val[0], avg));
+      const uint16x8_t avg16 = vmovl_u8(avg);
+      vst1q_s32(average + j,
+                vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(avg16))));
+      vst1q_s32(average + j + 4,
+                vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(avg16))));
+      vst1q_s32(detail + j, vmovl_s16(vget_low_s16(diff)));
+      vst1q_s32(detail + j + 4, vmovl_s16(vget_high_s16(diff)));
+    }
+  }
+#elif defined(HAVE_SSE2)
+  const __m128i low_bytes = _mm_set1_epi16(0xff);
+  const __m128i zero = _mm_setzero_si128();
+  for (; j + 8 <= half_num_columns; j += 8) {
+    const __m128i pairs =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * j));
+    const __m128i first = _mm_and_si128(pairs, low_bytes);
+    const __m128i second = _mm_srli_epi16(pairs, 8);
+    const __m128i avg = _mm_srli_epi16(_mm_add_epi16(first, second), 1);
+    const __m128i diff = _mm_sub_epi16(first, avg);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(average + j),
+                     _mm_unpacklo_epi16(avg, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(average + j + 4),
+                     _mm_unpackhi_epi16(avg, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(detail + j),
+                     _mm_srai_epi32(_mm_unpacklo_epi16(diff, diff), 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(detail + j + 4),
+                     _mm_srai_epi32(_mm_unpackhi_epi16(diff, diff), 16));
   }
+#endif
 
-  memcpy(ptr_matrix, ptr_a, sizeof(int32) * num_columns);
+  for (; j < half_num_columns; ++j) {
+    average[j] = (row[2 * j] + row[2 * j + 1]) / 2;
+    detail[j] = row[2 * j] - average[j];
+  }
+  if (num_columns & 1) {
+    out[num_columns - 1] = row[num_columns - 1];
+  }
 }
 
-// Does Haar Wavelet Transformation in place on a given column of a matrix.
-inline void Haar1DY(int* matrix, int matrix_height, int matrix_width,
-    int offset_column, int offset_row, int num_rows) {
-  int32* ptr_a = _arow;
-  int32* ptr_matrix = matrix + offset_row * matrix_width + offset_column;
-  int half_num_rows = num_rows / 2;
-  int two_line_width = matrix_width * 2;
-
-  int32* a_tmp = ptr_a;
-  int32* matrix_tmp = ptr_matrix;
-  for (int j = 0; j < half_num_rows; ++j) {
-    *a_tmp++ = (matrix_tmp[matrix_width] + matrix_tmp[0]) / 2;
-    matrix_tmp += two_line_width;
+static void HaarRow(const int32* const row, const int num_columns,
+                    int32* const out) {
+  const int half_num_columns = num_columns / 2;
+  int32* const average = out;
+  int32* const detail = out + half_num_columns;
+  int j = 0;
+
+#if defined(HAVE_NEON)
+  if (supportsNeon()) {
+    for (; j + 4 <= half_num_columns; j += 4) {
+      const int32x4x2_t pairs = vld2q_s32(row + 2 * j);
+      const int32x4_t avg = HalveNeon(vaddq_s32(pairs.val[0], pairs.val[1]));
+      vst1q_s32(average + j, avg);
+      vst1q_s32(detail + j, vsubq_s32(pairs.val[0], avg));
+    }
   }
-
-  int32* average = ptr_a;
-  a_tmp = ptr_a + half_num_rows;
-  matrix_tmp = ptr_matrix;
-  for (int j = 0; j < num_rows; j += 2) {
-    *a_tmp++ = *matrix_tmp - *average++;
-    matrix_tmp += two_line_width;
+#elif defined(HAVE_SSE2)
+  for (; j + 4 <= half_num_columns; j += 4) {
+    const __m128 low = _mm_castsi128_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * j)));
+    const __m128 high = _mm_castsi128_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * j + 4)));
+    const __m128i first =
+        _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+    const __m128i second =
+        _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)));
+    const __m128i avg = HalveSse2(_mm_add_epi32(first, second));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(average + j), avg);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(detail + j),
+                     _mm_sub_epi32(first, avg));
   }
+#endif
 
-  for (int j = 0; j < num_rows; ++j) {
-    *ptr_matrix = *ptr_a++;
-    ptr_matrix += matrix_width;
+  for (; j < half_num_columns; ++j) {
+    average[j] = (row[2 * j] + row[2 * j + 1]) / 2;
+    detail[j] = row[2 * j] - average[j];
+  }
+  if (num_columns & 1) {
+    out[num_columns - 1] = row[num_columns - 1];
   }
 }
 
-// Does Haar Wavelet Transformation in place for a specified area of
-// a matrix. The matrix size is specified by matrix_width and matrix_height.
-// The area on which the transformation is performed is specified by
-// offset_column, num_columns, offset_row and num_rows.
-void Haar2D(int* matrix, int matrix_height, int matrix_width,
-    int offset_column, int num_columns, int offset_row, int num_rows) {
-  for (int i = offset_row; i < offset_row + num_rows; ++i) {
-    Haar1DX(matrix, matrix_height, matrix_width, i, offset_column, num_columns);
+// Does the column step of the Haar wavelet transformation for a pair of
+// rows at once: average gets (upper + lower) / 2 and detail gets upper
+// minus that average.
+static void HaarRowPair(const int32* const upper, const int32* const lower,
+                        const int num_columns,
+                        int32* const average, int32* const detail) {
+  int j = 0;
+
+#if defined(HAVE_NEON)
+  if (supportsNeon()) {
+    for (; j + 4 <= num_columns; j += 4) {
+      const int32x4_t up = vld1q_s32(upper + j);
+      const int32x4_t avg = HalveNeon(vaddq_s32(up, vld1q_s32(lower + j)));
+      vst1q_s32(average + j, avg);
+      vst1q_s32(detail + j, vsubq_s32(up, avg));
+    }
   }
+#elif defined(HAVE_SSE2)
+  for (; j + 4 <= num_columns; j += 4) {
+    const __m128i up =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(upper + j));
+    const __m128i avg = HalveSse2(_mm_add_epi32(up,
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(lower + j))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(average + j), avg);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(detail + j),
+                     _mm_sub_epi32(up, avg));
+  }
+#endif
 
-  for (int i = offset_column; i < offset_column + num_columns; ++i){
-    Haar1DY(matrix, matrix_height, matrix_width, i, offset_row, num_rows);
+  for (; j < num_columns; ++j) {
+    average[j] = (upper[j] + lower[j]) / 2;
+    detail[j] = upper[j] - average[j];
   }
 }
 
-// Reads in a given matrix, does first round HWT and outputs result
-// matrix into target array. This function is used for optimization by
-// avoiding a memory copy. The input matrix has height rows and width
-// columns. The transformation is performed on the given area specified
-// by offset_column, num_columns, offset_row, num_rows. After
-// transformation, the output matrix has num_columns columns and
-// num_rows rows.
-void HwtFirstRound(const uint8* const data, int height, int width,
-    int offset_column, int num_columns,
-    int offset_row, int num_rows, int32* matrix) {
-  int32* ptr_a = _arow;
-  const uint8* ptr_data = data + offset_row * width + offset_column;
-  int half_num_columns = num_columns / 2;
-  for (int i = 0; i < num_rows; ++i) {
-    int32* a_tmp = ptr_a;
-    const uint8* data_tmp = ptr_data;
-    for (int j = 0; j < half_num_columns; ++j) {
-      *a_tmp++ = (int32) ((data_tmp[0] + data_tmp[1]) / 2);
-      data_tmp += 2;
-    }
+// Does Haar Wavelet Transformation in place for the top left num_columns x
+// num_rows area of a matrix with matrix_width columns.
+// Rows are transformed a pair at a time and immediately combined, which is
+// the same as transforming all rows and then all columns, but the column
+// step runs along rows of memory. Averages of the pair j go to row j, which
+// no later pair reads, and differences are held in scratch until the end.
+// An odd last row only gets the row transformation.
+template <typename T>
+static void Haar2D(const T* const source, const int source_width,
+                   const int num_columns, const int num_rows,
+                   int32* const matrix, const int matrix_width,
+                   BlurScratch* const scratch) {
+  const int half_num_rows = num_rows / 2;
+  for (int i = 0; i < half_num_rows; ++i) {
+    HaarRow(source + 2 * i * source_width, num_columns, scratch->row_a);
+    HaarRow(source + (2 * i + 1) * source_width, num_columns,
+            scratch->row_b);
+    HaarRowPair(scratch->row_a, scratch->row_b, num_columns,
+                matrix + i * matrix_width,
+                scratch->details + i * num_columns);
+  }
+  if (num_rows & 1) {
+    HaarRow(source + (num_rows - 1) * source_width, num_columns,
+            scratch->row_a);
+    memcpy(matrix + (num_rows - 1) * matrix_width, scratch->row_a,
+           sizeof(int32) * num_columns);
+  }
+  for (int i = 0; i < half_num_rows; ++i) {
+    memcpy(matrix + (half_num_rows + i) * matrix_width,
+           scratch->details + i * num_columns, sizeof(int32) * num_columns);
+  }
+}
 
-    int32* average = ptr_a;
-    a_tmp = ptr_a + half_num_columns;
-    data_tmp = ptr_data;
-    for (int j = 0; j < half_num_columns; ++j) {
-      *a_tmp++ = *data_tmp - *average++;
-      data_tmp += 2;
-    }
+// Reads in the num_columns x num_rows area at (offset_column, offset_row)
+// of a luminance matrix with width columns, does first round HWT and
+// outputs the result into scratch->matrix, which then has num_columns
+// columns.
+static void HwtFirstRound(const uint8* const data, const int width,
+    const int offset_column, const int num_columns,
+    const int offset_row, const int num_rows, BlurScratch* const scratch) {
+  Haar2D(data + offset_row * width + offset_column, width,
+         num_columns, num_rows, scratch->matrix, num_columns, scratch);
+}
 
-    int32* ptr_matrix = matrix + i * num_columns;
-    a_tmp = ptr_a;
-    for (int j = 0; j < num_columns; ++j) {
-      *ptr_matrix++ = *a_tmp++;
+// Fills edges with the sum of the absolute horizontal, vertical and
+// diagonal detail coefficients at each point of the scale whose detail
+// quadrants are scaled_width x scaled_height.
+static void ComputeEdgeMap(const int32* const matrix, const int width,
+    const int scaled_width, const int scaled_height, int32* const edges) {
+  for (int r = 0; r < scaled_height; ++r) {
+    const int32* const top_right = matrix + r * width + scaled_width;
+    const int32* const bot_left = matrix + (r + scaled_height) * width;
+    const int32* const bot_right = bot_left + scaled_width;
+    int32* const edge_row = edges + r * scaled_width;
+    int c = 0;
+
+#if defined(HAVE_NEON)
+    if (supportsNeon()) {
+      for (; c + 4 <= scaled_width; c += 4) {
+        vst1q_s32(edge_row + c, vaddq_s32(
+            vaddq_s32(vabsq_s32(vld1q_s32(top_right + c)),
+                      vabsq_s32(vld1q_s32(bot_left + c))),
+            vabsq_s32(vld1q_s32(bot_right + c))));
+      }
     }
+#elif defined(HAVE_SSE2)
+    for (; c + 4 <= scaled_width; c += 4) {
+      const __m128i tr =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(top_right + c));
+      const __m128i bl =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(bot_left + c));
+      const __m128i br =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(bot_right + c));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(edge_row + c),
+          _mm_add_epi32(_mm_add_epi32(AbsSse2(tr), AbsSse2(bl)),
+                        AbsSse2(br)));
+    }
+#endif
 
-    ptr_data += width;
-  }
-
-  // Column transformation does not involve input data.
-  for (int i = 0; i < num_columns; ++i) {
-    Haar1DY(matrix, num_rows, num_columns, i, 0, num_rows);
+    for (; c < scaled_width; ++c) {
+      edge_row[c] = abs(top_right[c]) + abs(bot_left[c]) + abs(bot_right[c]);
+    }
   }
 }
 
@@ -173,7 +311,7 @@ void HwtFirstRound(const uint8* const data, int height, int width,
 // respectively. Parameter scale tells in which scale the weight is
 // computed, must be 1, 2 or 3 which stands respectively for 1/2, 1/4
 // and 1/8 of original size.
-int ComputeEdgePointWeight(int* matrix, int width, int height,
+static int ComputeEdgePointWeight(const int32* matrix, int width, int height,
     int k, int l, int scale) {
   int r = k >> scale;
   int c = l >> scale;
@@ -192,32 +330,25 @@ int ComputeEdgePointWeight(int* matrix, int width, int height,
 // Computes point with maximum weight for a given local window for a
 // given scale.
 // Parameter scaled_width and scaled_height define scaled image size
-// of a certain decomposition level. The window size is defined by
-// window_size. Output value k and l store row (y coordinate) and
-// column (x coordinate) respectively of the point with maximum weight.
+// of a certain decomposition level, and edges is its edge map from
+// ComputeEdgeMap(). The window size is defined by window_size. Output
+// value k and l store row (y coordinate) and column (x coordinate)
+// respectively of the point with maximum weight.
 // The maximum weight is returned.
-int ComputeLocalMaximum(int* matrix, int width, int height,
-    int scaled_width, int scaled_height,
+static int ComputeLocalMaximum(const int32* matrix, const int32* edges,
+    int width, int height, int scaled_width, int scaled_height,
     int top, int left, int window_size, int* k, int* l) {
   int max = -1;
   *k = top;
   *l = left;
 
   for (int i = 0; i < window_size; ++i) {
+    const int32* const edge_row = edges + (top + i) * scaled_width + left;
     for (int j = 0; j < window_size; ++j) {
-      int r = top + i;
-      int c = left + j;
-
-      int v_top_right = abs(matrix[r * width + c + scaled_width]);
-      int v_bot_left = abs(matrix[(r + scaled_height) * width + c]);
-      int v_bot_right =
-          abs(matrix[(r + scaled_height) * width + c + scaled_width]);
-      int v = v_top_right + v_bot_left + v_bot_right;
-
-      if (v > max) {
-        max = v;
-        *k = r;
-        *l = c;
+      if (edge_row[j] > max) {
+        max = edge_row[j];
+        *k = top + i;
+        *l = left + j;
       }
     }
   }
@@ -236,8 +367,8 @@ int ComputeLocalMaximum(int* matrix, int width, int height,
 // Detects blurriness of a transformed matrix.
 // Blur confidence and extent will be returned through blur_conf
 // and blur_extent. 1 is returned while input matrix is blurred.
-int DetectBlur(int* matrix, int width, int height,
-    float* blur_conf, float* blur_extent) {
+static int DetectBlur(const int32* matrix, int32* edges, int width,
+    int height, float* blur_conf, float* blur_extent) {
   int nedge = 0;
   int nda = 0;
   int nrg = 0;
@@ -248,11 +379,12 @@ int DetectBlur(int* matrix, int width, int height,
     int scaled_width = width >> current_scale;
     int scaled_height = height >> current_scale;
     int window_size = 16 >> current_scale;  // 2, 4, 8
+    ComputeEdgeMap(matrix, width, scaled_width, scaled_height, edges);
     // For each window
     for (int r = 0; r + window_size < scaled_height; r += window_size) {
       for (int c = 0; c + window_size < scaled_width; c += window_size) {
         int k, l;
-        int emax = ComputeLocalMaximum(matrix, width, height,
+        int emax = ComputeLocalMaximum(matrix, edges, width, height,
             scaled_width, scaled_height, r, c, window_size, &k, &l);
         if (emax > kThreshold) {
           int emax1, emax2, emax3;
@@ -311,50 +443,171 @@ int DetectBlur(int* matrix, int width, int height,
 }
 
 // Detects blurriness of a given portion of a luminance matrix.
-int IsBlurredInner(const uint8* const luminance,
+static int IsBlurredInner(const uint8* const luminance,
     const int width, const int height,
     const int left, const int top,
     const int width_wanted, const int height_wanted,
-    float* const blur, float* const extent) {
-  int32* matrix = _smatrix;
+    float* const blur, float* const extent, BlurScratch* const scratch) {
+  int32* const matrix = scratch->matrix;
 
-  HwtFirstRound(luminance, height, width,
-                left, width_wanted, top, height_wanted, matrix);
-  Haar2D(matrix, height_wanted, width_wanted,
-         0, width_wanted >> 1, 0, height_wanted >> 1);
-  Haar2D(matrix, height_wanted, width_wanted,
-         0, width_wanted >> 2, 0, height_wanted >> 2);
+  HwtFirstRound(luminance, width,
+                left, width_wanted, top, height_wanted, scratch);
+  Haar2D(matrix, width_wanted, width_wanted >> 1, height_wanted >> 1,
+         matrix, width_wanted, scratch);
+  Haar2D(matrix, width_wanted, width_wanted >> 2, height_wanted >> 2,
+         matrix, width_wanted, scratch);
 
-  int blurred = DetectBlur(matrix, width_wanted, height_wanted, blur, extent);
+  int blurred = DetectBlur(matrix, scratch->edges,
+                           width_wanted, height_wanted, blur, extent);
 
   return blurred;
 }
 
+// One portion of one image.
+struct BlurPortion {
+  const uint8* luminance;
+  int width;
+  int height;
+  int left;
+  int top;
+  int width_wanted;
+  int height_wanted;
+  float conf;
+  float extent;
+};
+
+struct BlurJob {
+  BlurPortion* portions;
+  BlurScratch* scratch;  // One per worker.
+};
+
+static void BlurPortionTask(void* data, int worker, int task) {
+  BlurJob* const job = static_cast<BlurJob*>(data);
+  BlurPortion* const portion = job->portions + task;
+  IsBlurredInner(portion->luminance, portion->width, portion->height,
+                 portion->left, portion->top,
+                 portion->width_wanted, portion->height_wanted,
+                 &portion->conf, &portion->extent, job->scratch + worker);
+}
+
+// Fills in the four portions that make up the central area, of at most
+// kMaximumWidth x kMaximumHeight, of the region of interest.
+static void SplitRegion(const uint8* const luminance,
+    const int width, const int height,
+    const int region_left, const int region_top,
+    const int region_width, const int region_height,
+    BlurPortion* const portions) {
+  int desired_width = min(kMaximumWidth, region_width);
+  int desired_height = min(kMaximumHeight, region_height);
+  int left = region_left + ((region_width - desired_width) >> 1);
+  int top = region_top + ((region_height - desired_height) >> 1);
+
+  for (int i = 0; i < kNumPortions; ++i) {
+    BlurPortion* const portion = portions + i;
+    portion->luminance = luminance;
+    portion->width = width;
+    portion->height = height;
+    portion->left = left + (i & 1) * (desired_width >> 1);
+    portion->top = top + (i >> 1) * (desired_height >> 1);
+    portion->width_wanted = desired_width >> 1;
+    portion->height_wanted = desired_height >> 1;
+  }
+}
+
+// Checks all the portions on as many threads as are useful. Returns false if
+// scratch memory could not be allocated.
+static bool RunBlurPortions(BlurPortion* const portions,
+                            const int num_portions) {
+  const int num_workers = ParallelNumWorkers(num_portions);
+  BlurScratch* const scratch =
+      static_cast<BlurScratch*>(malloc(sizeof(BlurScratch) * num_workers));
+  if (scratch == NULL) {
+    LOGE("Couldn't allocate blur detection memory!");
+    return false;
+  }
+
+  BlurJob job;
+  job.portions = portions;
+  job.scratch = scratch;
+  ParallelRun(BlurPortionTask, &job, num_portions, num_workers);
+
+  free(scratch);
+  return true;
+}
+
+// Averages the results of the four portions of one image.
+static int CombinePortions(const BlurPortion* const portions,
+                           float* const blur, float* const extent) {
+  *blur = (portions[0].conf + portions[1].conf +
+           portions[2].conf + portions[3].conf) / 4;
+  *extent = (portions[0].extent + portions[1].extent +
+             portions[2].extent + portions[3].extent) / 4;
+  return *blur < kMinZero;
+}
+
+int IsBlurredRegion(const uint8* const luminance,
+    const int width, const int height,
+    const int left, const int top,
+    const int region_width, const int region_height,
+    float* const blur, float* const extent) {
+  // Keep the region inside the image.
+  const int region_left = clip(left, 0, width);
+  const int region_top = clip(top, 0, height);
+  const int clipped_width = clip(region_width, 0, width - region_left);
+  const int clipped_height = clip(region_height, 0, height - region_top);
+
+  BlurPortion portions[kNumPortions];
+  SplitRegion(luminance, width, height, region_left, region_top,
+              clipped_width, clipped_height, portions);
+  if (!RunBlurPortions(portions, kNumPortions)) {
+    *blur = 0;
+    *extent = 0;
+    return 0;
+  }
+  return CombinePortions(portions, blur, extent);
+}
+
 int IsBlurred(const uint8* const luminance,
     const int width, const int height, float* const blur, float* const extent) {
+  return IsBlurredRegion(luminance, width, height, 0, 0, width, height,
+                         blur, extent);
+}
 
-  int desired_width = min(kMaximumWidth, width);
-  int desired_height = min(kMaximumHeight, height);
-  int left = (width - desired_width) >> 1;
-  int top = (height - desired_height) >> 1;
-
-  float conf1, extent1;
-  int blur1 = IsBlurredInner(luminance, width, height,
-      left, top, desired_width >> 1, desired_height >> 1, &conf1, &extent1);
-  float conf2, extent2;
-  int blur2 = IsBlurredInner(luminance, width, height,
-      left + (desired_width >> 1), top, desired_width >> 1, desired_height >> 1,
-      &conf2, &extent2);
-  float conf3, extent3;
-  int blur3 = IsBlurredInner(luminance, width, height,
-      left, top + (desired_height >> 1), desired_width >> 1,
-      desired_height >> 1, &conf3, &extent3);
-  float conf4, extent4;
-  int blur4 = IsBlurredInner(luminance, width, height,
-      left + (desired_width >> 1), top + (desired_height >> 1),
-      desired_width >> 1, desired_height >> 1, &conf4, &extent4);
-
-  *blur = (conf1 + conf2 + conf3 + conf4) / 4;
-  *extent = (extent1 + extent2 + extent3 + extent4) / 4;
-  return *blur < kMinZero;
+void IsBlurredBatch(const uint8* const* const frames, const int num_frames,
+    const int width, const int height,
+    int* const blurred, float* const blur, float* const extent) {
+  if (num_frames <= 0) {
+    return;
+  }
+
+  BlurPortion* const portions = static_cast<BlurPortion*>(
+      malloc(sizeof(BlurPortion) * kNumPortions * num_frames));
+  if (portions == NULL) {
+    LOGE("Couldn't allocate blur detection memory!");
+    memset(blurred, 0, sizeof(*blurred) * num_frames);
+    memset(blur, 0, sizeof(*blur) * num_frames);
+    memset(extent, 0, sizeof(*extent) * num_frames);
+    return;
+  }
+
+  for (int i = 0; i < num_frames; ++i) {
+    SplitRegion(frames[i], width, height, 0, 0, width, height,
+                portions + i * kNumPortions);
+  }
+
+  // Every portion of every frame is a separate task, so a few frames keep
+  // all processors busy.
+  const bool ok = RunBlurPortions(portions, kNumPortions * num_frames);
+
+  for (int i = 0; i < num_frames; ++i) {
+    if (ok) {
+      blurred[i] = CombinePortions(portions + i * kNumPortions,
+                                   blur + i, extent + i);
+    } else {
+      blurred[i] = 0;
+      blur[i] = 0;
+      extent[i] = 0;
+    }
+  }
+  free(portions);
 }
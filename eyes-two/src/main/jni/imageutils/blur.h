@@ -17,6 +17,23 @@ extern "C" {
 int IsBlurred(const uint8* const luminance, const int width, const int height,
               float* const blur, float* const extent);
 
+// Same as IsBlurred, but only looks at the region of interest with the given
+// top left corner and size, which is clipped to the image.
+int IsBlurredRegion(const uint8* const luminance,
+                    const int width, const int height,
+                    const int left, const int top,
+                    const int region_width, const int region_height,
+                    float* const blur, float* const extent);
+
+// Runs IsBlurred on each of num_frames luminance matrices of the same size,
+// e.g. a short history of candidate frames, at the same time. The result,
+// blur confidence and extent of frames[i] are returned in blurred[i],
+// blur[i] and extent[i].
+void IsBlurredBatch(const uint8* const* const frames, const int num_frames,
+                    const int width, const int height,
+                    int* const blurred, float* const blur,
+                    float* const extent);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2011, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "parallel.h"
+#include "utils.h"
+
+int ParallelNumWorkers(int num_tasks) {
+  int num_workers = 1;
+#ifdef HAVE_PTHREAD
+  num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return max(1, min(num_workers, num_tasks));
+}
+
+#ifdef HAVE_PTHREAD
+struct ParallelJob {
+  ParallelTask func;
+  void* data;
+  int num_tasks;
+  int next_task;
+  pthread_mutex_t mutex;
+};
+
+struct ParallelWorker {
+  ParallelJob* job;
+  int index;
+};
+
+// Takes tasks off the job until there are none left.
+static void* ParallelWorkerMain(void* arg) {
+  ParallelWorker* const worker = static_cast<ParallelWorker*>(arg);
+  ParallelJob* const job = worker->job;
+  for (;;) {
+    pthread_mutex_lock(&job->mutex);
+    const int task = job->next_task++;
+    pthread_mutex_unlock(&job->mutex);
+    if (task >= job->num_tasks) {
+      break;
+    }
+    job->func(job->data, worker->index, task);
+  }
+  return NULL;
+}
+#endif
+
+void ParallelRun(ParallelTask func, void* data, int num_tasks,
+                 int num_workers) {
+#ifdef HAVE_PTHREAD
+  if (num_workers > 1 && num_tasks > 1) {
+    ParallelJob job;
+    job.func = func;
+    job.data = data;
+    job.num_tasks = num_tasks;
+    job.next_task = 0;
+    pthread_mutex_init(&job.mutex, NULL);
+
+    ParallelWorker* const workers = new ParallelWorker[num_workers];
+    pthread_t* const threads = new pthread_t[num_workers];
+    int num_started = 0;
+    for (int i = 1; i < num_workers; ++i) {
+      workers[i].job = &job;
+      workers[i].index = i;
+      if (pthread_create(&threads[i], NULL, ParallelWorkerMain,
+                         &workers[i]) != 0) {
+        break;
+      }
+      ++num_started;
+    }
+
+    // The calling thread is worker 0. If a thread failed to start, the
+    // others pick up its share.
+    workers[0].job = &job;
+    workers[0].index = 0;
+    ParallelWorkerMain(&workers[0]);
+
+    for (int i = 1; i <= num_started; ++i) {
+      pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&job.mutex);
+    delete[] threads;
+    delete[] workers;
+    return;
+  }
+#endif
+  for (int task = 0; task < num_tasks; ++task) {
+    func(data, 0, task);
+  }
+}
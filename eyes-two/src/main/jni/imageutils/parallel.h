@@ -0,0 +1,22 @@
+// Copyright 2011 Google Inc. All Rights Reserved.
+//
+// Runs independent image processing tasks on a few threads.
+
+#ifndef JAVA_COM_GOOGLE_ANDROID_APPS_UNVEIL_JNI_IMAGEUTILS_PARALLEL_H_
+#define JAVA_COM_GOOGLE_ANDROID_APPS_UNVEIL_JNI_IMAGEUTILS_PARALLEL_H_
+
+// Processes one task. worker is in [0, num_workers) and no two tasks with the
+// same worker run at the same time, so it can index per-thread scratch memory.
+typedef void (*ParallelTask)(void* data, int worker, int task);
+
+// Returns how many workers ParallelRun() should use for num_tasks tasks: one
+// per processor, but no more than there are tasks, and at least one.
+int ParallelNumWorkers(int num_tasks);
+
+// Runs func for every task in [0, num_tasks) on num_workers threads, one of
+// which is the calling thread, and returns when all tasks are done. Runs
+// everything on the calling thread without pthreads.
+void ParallelRun(ParallelTask func, void* data, int num_tasks,
+                 int num_workers);
+
+#endif  // JAVA_COM_GOOGLE_ANDROID_APPS_UNVEIL_JNI_IMAGEUTILS_PARALLEL_H_
@@ -33,6 +33,12 @@ Java_com_googlecode_eyesfree_opticflow_ImageBlur_computeSignature(
     JNIEnv* env, jclass clazz, jbyteArray input, jint width, jint height,
     jintArray signatureBuffer);
 
+JNIEXPORT jintArray JNICALL
+Java_com_googlecode_eyesfree_opticflow_ImageBlur_computeSignatureRegion(
+    JNIEnv* env, jclass clazz, jbyteArray input, jint width, jint height,
+    jint left, jint top, jint regionWidth, jint regionHeight, jint step,
+    jintArray signatureBuffer);
+
 JNIEXPORT jint JNICALL
 Java_com_googlecode_eyesfree_opticflow_ImageBlur_diffSignature(
     JNIEnv* env, jclass clazz, jintArray signature1, jintArray signature2);
@@ -40,6 +46,23 @@ Java_com_googlecode_eyesfree_opticflow_ImageBlur_diffSignature(
 }
 #endif
 
+// Copies sig into signatureBuffer, or a new array if it is not the right
+// size, and returns the array.
+static jintArray ReturnSignature(JNIEnv* env, const uint32_t* const sig,
+                                 const int sig_len,
+                                 jintArray signatureBuffer) {
+  jintArray ret = signatureBuffer;
+  if (ret == NULL || env->GetArrayLength(ret) != sig_len) {
+    ret = env->NewIntArray(sig_len);
+  }
+  jint* body = env->GetIntArrayElements(ret, 0);
+  for (int i = 0; i < sig_len; ++i) {
+    body[i] = sig[i];
+  }
+  env->ReleaseIntArrayElements(ret, body, 0);
+  return ret;
+}
+
 JNIEXPORT jintArray JNICALL
 Java_com_googlecode_eyesfree_opticflow_ImageBlur_computeSignature(
     JNIEnv* env, jclass clazz, jbyteArray input, jint width, jint height,
@@ -57,16 +80,28 @@ Java_com_googlecode_eyesfree_opticflow_ImageBlur_computeSignature(
 
   env->ReleaseByteArrayElements(input, i, JNI_ABORT);
 
-  jintArray ret = signatureBuffer;
-  if (ret == NULL || env->GetArrayLength(ret) != sig_len) {
-    ret = env->NewIntArray(sig_len);
-  }
-  jint* body = env->GetIntArrayElements(ret, 0);
-  for (int i = 0; i < sig_len; ++i) {
-    body[i] = sig[i];
-  }
-  env->ReleaseIntArrayElements(ret, body, 0);
-  return ret;
+  return ReturnSignature(env, sig, sig_len, signatureBuffer);
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_googlecode_eyesfree_opticflow_ImageBlur_computeSignatureRegion(
+    JNIEnv* env, jclass clazz, jbyteArray input, jint width, jint height,
+    jint left, jint top, jint regionWidth, jint regionHeight, jint step,
+    jintArray signatureBuffer) {
+  jboolean inputCopy = JNI_FALSE;
+  jbyte* const i = env->GetByteArrayElements(input, &inputCopy);
+
+  int sig_len = 0;
+
+  resetTimeLog();
+  uint32_t* sig = ComputeSignatureRegion(reinterpret_cast<uint8*>(i),
+      width, height, left, top, regionWidth, regionHeight, step, &sig_len);
+  timeLog("Finished image signature computation");
+  printTimeLog();
+
+  env->ReleaseByteArrayElements(input, i, JNI_ABORT);
+
+  return ReturnSignature(env, sig, sig_len, signatureBuffer);
 }
 
 JNIEXPORT jint JNICALL
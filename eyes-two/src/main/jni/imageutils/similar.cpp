@@ -19,8 +19,8 @@
 // This library contains image processing method to estimate
 // similarity of two given images.
 //
-// This library is *not* thread safe because static memory is
-// used for performance.
+// ComputeSignature() and ComputeSignatureRegion() are *not* thread safe
+// because static memory is used for performance.
 //
 // Two methods are provided to estimate the similarity of two
 // given images. ComputeSignature() is used to compute the
@@ -32,8 +32,10 @@
 //
 // For performance consideration, 480x480 of central area of
 // a given image is used for signature computation.
+#include <stdlib.h>
 #include <string.h>
 
+#include "parallel.h"
 #include "similar.h"
 #include "utils.h"
 
@@ -42,99 +44,239 @@
 // number of left shift bits rather than color numbers directly.
 // e.g. kShiftColors 4 means (1 << 4 == 16) colors are used.
 static const int kShiftColors = 4;
+static const int kNumColors = 1 << kShiftColors;
 static const int kDesiredWidthForSignature = 480;
 static const int kDesiredHeightForSignature = 480;
-static uint8 _colors[kDesiredHeightForSignature * kDesiredWidthForSignature];
+static const int kColorsSize =
+    kDesiredHeightForSignature * kDesiredWidthForSignature;
 // The final signature contains both color information of
 // inner and outer pixels, and total pixel count at last.
-static uint32_t _signature[1 + (1 << kShiftColors) * 2];
+static const int kSignatureSize = 1 + kNumColors * 2;
+static uint8 _colors[kColorsSize];
+static uint32_t _signature[kSignatureSize];
 
-uint32_t* ComputeSignatureInner(const uint8* const luminance,
-    int width, int height,
-    int left, int top, int desired_width, int desired_height, int* size) {
-  int num_colors = 1 << kShiftColors;
-
-  memset(_signature, 0, sizeof(int32) * num_colors * 2);
-
-  // Build quantized color map for input image. For each possible lumiance
-  // value from 0 to 255, quantize it into more coarse value.
-#ifdef HAVE_ARMEABI_V7A
-  if (supportsNeon()) {
-    for (int i = 0; i < desired_height; ++i) {
-      uint8* ptr_colors = _colors + i * desired_width;
-      const uint8* ptr_lumi = luminance + (i + top) * width + left;
-      int itrs = desired_width / 8;
-      for (int j = 0; j < itrs; ++j) {
-        // Load 8 bytes from ptr_lumi into neon vector
-        uint8x8_t lumix8 = vld1_u8(ptr_lumi);
-        // Batch right shift every elements (8 - kShiftColors) bits
-        // in the vector
-        uint8x8_t colorx8 = vshr_n_u8(lumix8, 8 - kShiftColors);
-        // Store above result into our own memory starting from ptr_colors
-        vst1_u8(ptr_colors, colorx8);
-
-        ptr_lumi += 8;
-        ptr_colors += 8;
+// Quantizes num_pixels luminance values, step apart, into colors.
+static void QuantizeRow(const uint8* const lumi, const int num_pixels,
+                        const int step, uint8* const colors) {
+  const int shift_bits = 8 - kShiftColors;  // equals to 256/num_colors
+  int j = 0;
+  if (step == 1) {
+#if defined(HAVE_NEON)
+    if (supportsNeon()) {
+      for (; j + 16 <= num_pixels; j += 16) {
+        // Batch right shift every element (8 - kShiftColors) bits.
+        vst1q_u8(colors + j, vshrq_n_u8(vld1q_u8(lumi + j), 8 - kShiftColors));
       }
     }
-  } else {
+#elif defined(HAVE_SSE2)
+    // There is no byte shift, so shift 16 bit lanes and mask off what came
+    // in from the neighboring byte.
+    const __m128i mask = _mm_set1_epi8(0xff >> shift_bits);
+    for (; j + 16 <= num_pixels; j += 16) {
+      const __m128i lumix16 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(lumi + j));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + j),
+                       _mm_and_si128(_mm_srli_epi16(lumix16, shift_bits),
+                                     mask));
+    }
 #endif
-    int shift_bits = 8 - kShiftColors;  // equals to 256/num_colors
-    for (int i = 0; i < desired_height; ++i) {
-      uint8* ptr_colors = &_colors[i * desired_width];
-      const uint8* ptr_lumi = luminance + (i + top) * width + left;
-      for (int j = 0; j < desired_width; ++j) {
-        *ptr_colors++ = *ptr_lumi++ >> shift_bits;
-      }
+  }
+  for (; j < num_pixels; ++j) {
+    colors[j] = lumi[j * step] >> shift_bits;
+  }
+}
+
+// Sets classes[j] to the signature bin of the pixel at column j + 1 of the
+// given row of colors: its color, plus kNumColors if it is an inner pixel,
+// that is if it has the same color as its 4 neighbours.
+static void ClassifyRow(const uint8* const colors, const int stride,
+                        const int num_pixels, uint8* const classes) {
+  const uint8* const up = colors - stride;
+  const uint8* const down = colors + stride;
+  int j = 1;
+
+#if defined(HAVE_NEON)
+  if (supportsNeon()) {
+    const uint8x16_t inner_bit = vdupq_n_u8(kNumColors);
+    for (; j + 16 <= num_pixels + 1; j += 16) {
+      const uint8x16_t y = vld1q_u8(colors + j);
+      uint8x16_t same = vandq_u8(vceqq_u8(y, vld1q_u8(colors + j - 1)),
+                                 vceqq_u8(y, vld1q_u8(colors + j + 1)));
+      same = vandq_u8(same, vandq_u8(vceqq_u8(y, vld1q_u8(up + j)),
+                                     vceqq_u8(y, vld1q_u8(down + j))));
+      vst1q_u8(classes + j - 1, vorrq_u8(y, vandq_u8(same, inner_bit)));
     }
-#ifdef HAVE_ARMEABI_V7A
+  }
+#elif defined(HAVE_SSE2)
+  const __m128i inner_bit = _mm_set1_epi8(kNumColors);
+  for (; j + 16 <= num_pixels + 1; j += 16) {
+    const __m128i y =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors + j));
+    const __m128i left =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors + j - 1));
+    const __m128i right =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors + j + 1));
+    const __m128i above =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + j));
+    const __m128i below =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + j));
+    const __m128i same = _mm_and_si128(
+        _mm_and_si128(_mm_cmpeq_epi8(y, left), _mm_cmpeq_epi8(y, right)),
+        _mm_and_si128(_mm_cmpeq_epi8(y, above), _mm_cmpeq_epi8(y, below)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(classes + j - 1),
+                     _mm_or_si128(y, _mm_and_si128(same, inner_bit)));
   }
 #endif
 
+  for (; j <= num_pixels; ++j) {
+    const uint8 y = colors[j];
+    const int inner = y == colors[j - 1] && y == colors[j + 1] &&
+                      y == up[j] && y == down[j];
+    classes[j - 1] = y | (inner << kShiftColors);
+  }
+}
+
+// Computes the signature of the desired_width x desired_height grid of
+// pixels, step apart, whose top left pixel is at (left, top) of the
+// luminance matrix, using colors as working memory.
+static void ComputeSignatureInto(const uint8* const luminance,
+    int width, int left, int top, int desired_width, int desired_height,
+    int step, uint8* const colors, uint32_t* const signature) {
+  memset(signature, 0, sizeof(uint32_t) * kSignatureSize);
+
+  // Build quantized color map for input image. For each possible lumiance
+  // value from 0 to 255, quantize it into more coarse value.
+  for (int i = 0; i < desired_height; ++i) {
+    QuantizeRow(luminance + (top + i * step) * width + left,
+                desired_width, step, colors + i * desired_width);
+  }
+
   // Go through each pixel, decide it is a inner pixel (having same
   // quantized color as its 4 neighbours) or an outer one (at least one of
   // his 4 neighbours has different color), update signature respectively.
+  // Bins are counted in four interleaved histograms so that runs of the
+  // same bin don't wait on each other.
+  uint8 classes[kDesiredWidthForSignature];
+  uint32_t counts[4][kNumColors * 2];
+  memset(counts, 0, sizeof(counts));
   int h = desired_height - 1;
   int w = desired_width - 1;
   for (int i = 1; i < h; ++i) {
-    uint8* ptr_colors = _colors + i * desired_width;
-    for (int j = 1; j < w; ++j) {
-      int inner = 0;
-      uint8 y = ptr_colors[j];
-      uint8 yleft = ptr_colors[j - 1];
-      if (y == yleft) {
-        uint8 yright = ptr_colors[j + 1];
-        if (y == yright) {
-          uint8 yup = ptr_colors[j - desired_width];
-          if (y == yup) {
-            uint8 ydown = ptr_colors[j + desired_width];
-            if (y == ydown) {
-              inner = 1;
-            }
-          }
-        }
-      }
-      _signature[inner * num_colors + y] += 1;
+    ClassifyRow(colors + i * desired_width, desired_width, w - 1, classes);
+    int j = 0;
+    for (; j + 4 <= w - 1; j += 4) {
+      ++counts[0][classes[j]];
+      ++counts[1][classes[j + 1]];
+      ++counts[2][classes[j + 2]];
+      ++counts[3][classes[j + 3]];
     }
+    for (; j < w - 1; ++j) {
+      ++counts[0][classes[j]];
+    }
+  }
+  for (int bin = 0; bin < kNumColors * 2; ++bin) {
+    signature[bin] = counts[0][bin] + counts[1][bin] +
+                     counts[2][bin] + counts[3][bin];
   }
 
-  *size = sizeof(_signature) / sizeof(uint32);
-  _signature[*size - 1] = (desired_height - 2) * (desired_width - 2);
+  signature[kSignatureSize - 1] = (desired_height - 2) * (desired_width - 2);
+}
+
+// Finds the grid of pixels, step apart, that ComputeSignatureRegion samples:
+// the central area of the region of at most 480x480 pixels of the grid.
+static void FindSignatureGrid(const int width, const int height,
+    const int region_left, const int region_top,
+    const int region_width, const int region_height, const int step,
+    int* const left, int* const top,
+    int* const desired_width, int* const desired_height) {
+  const int clipped_left = clip(region_left, 0, width);
+  const int clipped_top = clip(region_top, 0, height);
+  const int clipped_width = clip(region_width, 0, width - clipped_left);
+  const int clipped_height = clip(region_height, 0, height - clipped_top);
+
+  // Number of grid pixels that fit in the region.
+  const int grid_width = (clipped_width + step - 1) / step;
+  const int grid_height = (clipped_height + step - 1) / step;
+
+  *desired_width = min(kDesiredWidthForSignature, grid_width);
+  *desired_height = min(kDesiredHeightForSignature, grid_height);
+  *left = clipped_left +
+      ((clipped_width - ((*desired_width - 1) * step + 1)) >> 1);
+  *top = clipped_top +
+      ((clipped_height - ((*desired_height - 1) * step + 1)) >> 1);
+}
+
+uint32_t* ComputeSignatureRegion(const uint8* const luminance,
+    const int width, const int height,
+    const int left, const int top,
+    const int region_width, const int region_height,
+    const int step, int* size) {
+  int grid_left, grid_top, desired_width, desired_height;
+  FindSignatureGrid(width, height, left, top, region_width, region_height,
+                    max(step, 1), &grid_left, &grid_top,
+                    &desired_width, &desired_height);
+
+  ComputeSignatureInto(luminance, width, grid_left, grid_top,
+      desired_width, desired_height, max(step, 1), _colors, _signature);
 
+  *size = kSignatureSize;
   return _signature;
 }
 
 uint32_t* ComputeSignature(const uint8* const luminance,
     const int width, const int height, int* size) {
-  int desired_width = min(kDesiredWidthForSignature, width);
-  int desired_height = min(kDesiredHeightForSignature, height);
-  int left = (width - desired_width) >> 1;
-  int top = (height - desired_height) >> 1;
+  return ComputeSignatureRegion(luminance, width, height,
+                                0, 0, width, height, 1, size);
+}
 
-  return ComputeSignatureInner(luminance, width, height,
-      left, top, desired_width, desired_height, size);
+struct SignatureJob {
+  const uint8* const* frames;
+  int width;
+  int left;
+  int top;
+  int desired_width;
+  int desired_height;
+  int step;
+  uint8* colors;  // kColorsSize per worker.
+  uint32_t* signatures;
+};
+
+static void SignatureTask(void* data, int worker, int task) {
+  SignatureJob* const job = static_cast<SignatureJob*>(data);
+  ComputeSignatureInto(job->frames[task], job->width, job->left, job->top,
+                       job->desired_width, job->desired_height, job->step,
+                       job->colors + worker * kColorsSize,
+                       job->signatures + task * kSignatureSize);
 }
 
+int ComputeSignatureBatch(const uint8* const* const frames,
+    const int num_frames, const int width, const int height,
+    const int step, uint32_t* const signatures) {
+  if (num_frames <= 0) {
+    return kSignatureSize;
+  }
+
+  SignatureJob job;
+  job.frames = frames;
+  job.width = width;
+  job.step = max(step, 1);
+  job.signatures = signatures;
+  FindSignatureGrid(width, height, 0, 0, width, height, job.step,
+                    &job.left, &job.top,
+                    &job.desired_width, &job.desired_height);
+
+  const int num_workers = ParallelNumWorkers(num_frames);
+  job.colors = static_cast<uint8*>(malloc(kColorsSize * num_workers));
+  if (job.colors == NULL) {
+    LOGE("Couldn't allocate signature memory!");
+    memset(signatures, 0, sizeof(uint32_t) * kSignatureSize * num_frames);
+    return kSignatureSize;
+  }
+  ParallelRun(SignatureTask, &job, num_frames, num_workers);
+  free(job.colors);
+
+  return kSignatureSize;
+}
 int Diff(const int32* const signature1, const int32* const signature2,
     const int size) {
   int total = signature1[size - 1];
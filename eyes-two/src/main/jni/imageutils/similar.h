@@ -16,6 +16,27 @@ extern "C" {
 uint32* ComputeSignature(const uint8* const luminance,
                          const int width, const int height, int* size);
 
+// Same as ComputeSignature, but only looks at the region of interest with the
+// given top left corner and size, clipped to the image, and only at every
+// step-th pixel of every step-th row of it. Only signatures computed with the
+// same step should be compared.
+uint32* ComputeSignatureRegion(const uint8* const luminance,
+                               const int width, const int height,
+                               const int left, const int top,
+                               const int region_width,
+                               const int region_height,
+                               const int step, int* size);
+
+// Computes the signatures of num_frames luminance matrices of the same size,
+// e.g. a short history of candidate frames, at the same time, sampling every
+// step-th pixel. The signature of frames[i] is written to the signature size
+// values at signatures + i * size, where size is returned and is the same as
+// returned by ComputeSignature. Unlike ComputeSignature, this is thread safe.
+int ComputeSignatureBatch(const uint8* const* const frames,
+                          const int num_frames,
+                          const int width, const int height,
+                          const int step, uint32* const signatures);
+
 // Returns how different two given images (represented by their signatures)
 // are. The input signatures must be in the same size. An integer from 0 to
 // 100 is returned to indicate difference percentage of signature2
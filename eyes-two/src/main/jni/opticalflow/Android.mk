@@ -16,9 +16,15 @@ LOCAL_CFLAGS := -Wall \
 
 LOCAL_SRC_FILES := optical_flow-jni.cpp \
                    optical_flow.cpp \
-                   feature_detector.cpp
-
-LOCAL_C_INCLUDES += $(LOCAL_PATH)/../common
+                   feature_detector.cpp \
+                   frame_scheduler-jni.cpp \
+                   frame_scheduler.cpp \
+                   ../imageutils/blur.cpp \
+                   ../imageutils/similar.cpp \
+                   ../imageutils/parallel.cpp
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../common \
+                    $(LOCAL_PATH)/../imageutils
 
 ifeq ($(LOG_TIME),true)
   LOCAL_CFLAGS += -DLOG_TIME
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2017 Robert Theis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jni.h>
+#include "types.h"
+#include "utils.h"
+#include "frame_scheduler.h"
+
+namespace flow {
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  JNIEXPORT
+  jlong
+  JNICALL
+  Java_com_googlecode_eyesfree_opticflow_FrameScheduler_createNative(
+      JNIEnv* env,
+      jobject thiz,
+      jint width,
+      jint height,
+      jint downsample_factor,
+      jobject recognizer);
+
+  JNIEXPORT
+  jint
+  JNICALL
+  Java_com_googlecode_eyesfree_opticflow_FrameScheduler_processFrameNative(
+      JNIEnv* env,
+      jobject thiz,
+      jlong native_scheduler,
+      jbyteArray photo_data,
+      jlong timestamp);
+
+  JNIEXPORT
+  jfloatArray
+  JNICALL
+  Java_com_googlecode_eyesfree_opticflow_FrameScheduler_getRegionsNative(
+      JNIEnv* env,
+      jobject thiz,
+      jlong native_scheduler);
+
+  JNIEXPORT
+  void
+  JNICALL
+  Java_com_googlecode_eyesfree_opticflow_FrameScheduler_destroyNative(
+      JNIEnv* env,
+      jobject thiz,
+      jlong native_scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Number of floats each box returned by FrameScheduler.Recognizer takes up.
+#define RECOGNIZED_BOX_STEP 5
+
+// Hands the requests of the scheduler to a FrameScheduler.Recognizer.
+class JavaRecognizer : public FrameRecognizer {
+ public:
+  JavaRecognizer(JNIEnv* const env, jobject recognizer) :
+      vm_(NULL),
+      recognizer_(env->NewGlobalRef(recognizer)),
+      worker_attached_(false) {
+    env->GetJavaVM(&vm_);
+
+    jclass recognizer_class = env->GetObjectClass(recognizer);
+    recognize_ = env->GetMethodID(recognizer_class, "recognize", "([BIIII)[F");
+    env->DeleteLocalRef(recognizer_class);
+  }
+
+  virtual ~JavaRecognizer() {
+    JNIEnv* env = NULL;
+    const bool attached = attach(&env);
+    env->DeleteGlobalRef(recognizer_);
+    if (attached) {
+      vm_->DetachCurrentThread();
+    }
+  }
+
+  // Attaches the worker thread to the VM for as long as it runs, rather
+  // than once per request.
+  virtual void workerStarted() {
+    JNIEnv* env = NULL;
+    worker_attached_ = attach(&env);
+  }
+
+  virtual void workerStopping() {
+    if (worker_attached_) {
+      vm_->DetachCurrentThread();
+      worker_attached_ = false;
+    }
+  }
+
+  virtual int32 recognize(const RecognitionRequest& request,
+                          RecognizedBox* const boxes,
+                          const int32 max_boxes) {
+    // Only attaches when called on a thread that workerStarted() was not.
+    JNIEnv* env = NULL;
+    const bool attached = attach(&env);
+
+    const int32 num_pixels = request.width * request.height;
+    jbyteArray pixels = env->NewByteArray(num_pixels);
+    env->SetByteArrayRegion(pixels, 0, num_pixels,
+                            reinterpret_cast<const jbyte*>(request.pixels));
+
+    jfloatArray found = static_cast<jfloatArray>(env->CallObjectMethod(
+        recognizer_, recognize_, pixels, request.left, request.top,
+        request.width, request.height));
+    env->DeleteLocalRef(pixels);
+
+    int32 num_boxes = 0;
+    if (env->ExceptionCheck()) {
+      LOGE("Recognizer threw an exception on request %d.", request.id);
+      env->ExceptionClear();
+    } else if (found != NULL) {
+      num_boxes = min(env->GetArrayLength(found) / RECOGNIZED_BOX_STEP,
+                      max_boxes);
+
+      jfloat* const values = env->GetFloatArrayElements(found, NULL);
+      for (int32 i = 0; i < num_boxes; ++i) {
+        const jfloat* const value = values + i * RECOGNIZED_BOX_STEP;
+        boxes[i].left = value[0];
+        boxes[i].top = value[1];
+        boxes[i].right = value[2];
+        boxes[i].bottom = value[3];
+        boxes[i].tag = static_cast<int32>(value[4]);
+      }
+      env->ReleaseFloatArrayElements(found, values, JNI_ABORT);
+      env->DeleteLocalRef(found);
+    }
+
+    if (attached) {
+      vm_->DetachCurrentThread();
+    }
+    return num_boxes;
+  }
+
+ private:
+  // Gets the JNIEnv of the calling thread, attaching it to the VM if needed.
+  // Returns whether it was attached, in which case it should be detached.
+  bool attach(JNIEnv** const env) {
+    if (vm_->GetEnv(reinterpret_cast<void**>(env), JNI_VERSION_1_4) ==
+        JNI_EDETACHED) {
+      vm_->AttachCurrentThread(env, NULL);
+      return true;
+    }
+    return false;
+  }
+
+  JavaVM* vm_;
+  jobject recognizer_;
+  jmethodID recognize_;
+
+  // Whether workerStarted() attached the worker thread.
+  bool worker_attached_;
+};
+
+
+JNIEXPORT
+jlong
+JNICALL
+Java_com_googlecode_eyesfree_opticflow_FrameScheduler_createNative(
+    JNIEnv* env,
+    jobject thiz,
+    jint width,
+    jint height,
+    jint downsample_factor,
+    jobject recognizer) {
+  LOGI("Initializing frame scheduler. %dx%d, %d",
+       width, height, downsample_factor);
+
+  FrameScheduler* const scheduler = new FrameScheduler(
+      width, height, downsample_factor, new JavaRecognizer(env, recognizer));
+  return reinterpret_cast<jlong>(scheduler);
+}
+
+
+JNIEXPORT
+jint
+JNICALL
+Java_com_googlecode_eyesfree_opticflow_FrameScheduler_processFrameNative(
+    JNIEnv* env,
+    jobject thiz,
+    jlong native_scheduler,
+    jbyteArray photo_data,
+    jlong timestamp) {
+  FrameScheduler* const scheduler =
+      reinterpret_cast<FrameScheduler*>(native_scheduler);
+  CHECK(scheduler != NULL, "Frame scheduler not initialized!");
+
+  jbyte* pixels = env->GetByteArrayElements(photo_data, NULL);
+
+  const ScheduleResult result =
+      scheduler->processFrame(reinterpret_cast<uint8*>(pixels), timestamp);
+
+  env->ReleaseByteArrayElements(photo_data, pixels, JNI_ABORT);
+
+  return result;
+}
+
+
+JNIEXPORT
+jfloatArray
+JNICALL
+Java_com_googlecode_eyesfree_opticflow_FrameScheduler_getRegionsNative(
+    JNIEnv* env,
+    jobject thiz,
+    jlong native_scheduler) {
+  FrameScheduler* const scheduler =
+      reinterpret_cast<FrameScheduler*>(native_scheduler);
+  CHECK(scheduler != NULL, "Frame scheduler not initialized!");
+
+  jfloat region_arr[MAX_TRACKED_REGIONS * REGION_STEP];
+
+  const int32 number_of_regions = scheduler->getRegions(region_arr);
+
+  jfloatArray regions = env->NewFloatArray(number_of_regions * REGION_STEP);
+  if (regions == NULL) {
+    LOGE("null array!");
+    return NULL;
+  }
+  env->SetFloatArrayRegion(
+      regions, 0, number_of_regions * REGION_STEP, region_arr);
+
+  return regions;
+}
+
+
+JNIEXPORT
+void
+JNICALL
+Java_com_googlecode_eyesfree_opticflow_FrameScheduler_destroyNative(
+    JNIEnv* env,
+    jobject thiz,
+    jlong native_scheduler) {
+  LOGI("Cleaning up frame scheduler.");
+
+  FrameScheduler* scheduler =
+      reinterpret_cast<FrameScheduler*>(native_scheduler);
+  SAFE_DELETE(scheduler);
+}
+
+}  // namespace flow
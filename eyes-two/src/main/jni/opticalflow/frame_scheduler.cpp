@@ -0,0 +1,479 @@
+/*
+ * Copyright 2017 Robert Theis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "utils.h"
+#include "blur.h"
+#include "similar.h"
+#include "frame_scheduler.h"
+
+namespace flow {
+
+FrameScheduler::FrameScheduler(const int32 frame_width,
+                               const int32 frame_height,
+                               const int32 downsample_factor,
+                               FrameRecognizer* const recognizer) :
+    frame_width_(frame_width),
+    frame_height_(frame_height),
+    optical_flow_(frame_width, frame_height, downsample_factor),
+    recognizer_(recognizer),
+    last_timestamp_(0),
+    num_regions_(0),
+    next_region_id_(0),
+    signature_size_(0),
+    request_pixels_(new uint8[frame_width * frame_height]),
+    num_result_boxes_(0),
+    next_request_id_(0),
+    request_pending_(false),
+    result_ready_(false) {
+  memset(reference_valid_, false, sizeof(reference_valid_));
+  memset(&request_, 0, sizeof(request_));
+
+#ifdef HAVE_PTHREAD
+  stopping_ = false;
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&cond_, NULL);
+
+  // Without a worker, requests are recognized on the calling thread.
+  worker_started_ = pthread_create(&worker_, NULL, workerMain, this) == 0;
+  if (!worker_started_) {
+    LOGW("Could not start the recognition worker, recognizing inline.");
+  }
+#endif
+}
+
+
+FrameScheduler::~FrameScheduler() {
+#ifdef HAVE_PTHREAD
+  if (worker_started_) {
+    pthread_mutex_lock(&mutex_);
+    stopping_ = true;
+    pthread_cond_signal(&cond_);
+    pthread_mutex_unlock(&mutex_);
+    pthread_join(worker_, NULL);
+  }
+  pthread_cond_destroy(&cond_);
+  pthread_mutex_destroy(&mutex_);
+#endif
+
+  delete[] request_pixels_;
+  delete recognizer_;
+}
+
+
+ScheduleResult FrameScheduler::processFrame(const uint8* const frame,
+                                            const clock_t timestamp) {
+  // Results refer to frames already in the optical flow history, so they are
+  // picked up before the new frame moves the history on.
+  collectResults();
+
+  optical_flow_.nextFrame(frame, timestamp);
+  optical_flow_.computeFeatures(true);
+  optical_flow_.computeFlow();
+
+  const clock_t previous_timestamp = last_timestamp_;
+  last_timestamp_ = timestamp;
+
+  trackRegions(previous_timestamp, timestamp);
+
+  if (request_pending_) {
+    return SCHEDULE_BUSY;
+  }
+
+  const Point2D frame_delta =
+      deltaSince(frame_width_ / 2.0f, frame_height_ / 2.0f,
+                 max(frame_width_, frame_height_) / 2.0f, previous_timestamp);
+  if (square(frame_delta.x) + square(frame_delta.y) >
+      square(MAX_FRAME_MOTION)) {
+    return SCHEDULE_MOVING;
+  }
+
+  for (int32 row = 0; row < SCHEDULER_GRID_ROWS; ++row) {
+    for (int32 column = 0; column < SCHEDULER_GRID_COLUMNS; ++column) {
+      const int32 left = cellLeft(column);
+      const int32 top = cellTop(row);
+
+      int size = 0;
+      const uint32* const signature = ComputeSignatureRegion(
+          frame, frame_width_, frame_height_, left, top,
+          cellLeft(column + 1) - left, cellTop(row + 1) - top,
+          CELL_SIGNATURE_STEP, &size);
+      CHECK(size <= MAX_SIGNATURE_SIZE, "Signature too large: %d", size);
+
+      signature_size_ = size;
+      memcpy(cell_signatures_[row * SCHEDULER_GRID_COLUMNS + column],
+             signature, sizeof(*signature) * size);
+    }
+  }
+
+  bool changed[SCHEDULER_NUM_CELLS];
+  if (findChangedCells(changed) == 0) {
+    return SCHEDULE_UNCHANGED;
+  }
+
+  // Recognize the bounding box of the changed cells in one go.
+  int32 left = frame_width_;
+  int32 top = frame_height_;
+  int32 right = 0;
+  int32 bottom = 0;
+  for (int32 row = 0; row < SCHEDULER_GRID_ROWS; ++row) {
+    for (int32 column = 0; column < SCHEDULER_GRID_COLUMNS; ++column) {
+      if (changed[row * SCHEDULER_GRID_COLUMNS + column]) {
+        left = min(left, cellLeft(column));
+        top = min(top, cellTop(row));
+        right = max(right, cellLeft(column + 1));
+        bottom = max(bottom, cellTop(row + 1));
+      }
+    }
+  }
+
+  float blur = 0.0f;
+  float extent = 0.0f;
+  if (IsBlurredRegion(frame, frame_width_, frame_height_, left, top,
+                      right - left, bottom - top, &blur, &extent)) {
+    LOGV("Skipping blurred frame: %.2f %.2f", blur, extent);
+    return SCHEDULE_BLURRED;
+  }
+
+  dispatch(frame, timestamp, left, top, right, bottom);
+  return SCHEDULE_DISPATCHED;
+}
+
+
+int32 FrameScheduler::getRegions(float32* const out_data) const {
+  for (int32 i = 0; i < num_regions_; ++i) {
+    const TrackedRegion& region = regions_[i];
+    float32* const out = out_data + i * REGION_STEP;
+
+    out[0] = region.id;
+    out[1] = region.box.tag;
+    out[2] = region.box.left;
+    out[3] = region.box.top;
+    out[4] = region.box.right;
+    out[5] = region.box.bottom;
+  }
+  return num_regions_;
+}
+
+
+void FrameScheduler::collectResults() {
+  if (!request_pending_) {
+    return;
+  }
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&mutex_);
+  const bool ready = result_ready_;
+  pthread_mutex_unlock(&mutex_);
+
+  if (!ready) {
+    return;
+  }
+#endif
+
+  // Where the recognized area is as of the latest frame.
+  const float32 half_width = request_.width / 2.0f;
+  const float32 half_height = request_.height / 2.0f;
+  const Point2D request_delta =
+      deltaSince(request_.left + half_width, request_.top + half_height,
+                 max(half_width, half_height), request_.timestamp);
+  const float32 left = request_.left + request_delta.x;
+  const float32 top = request_.top + request_delta.y;
+  const float32 right = left + request_.width;
+  const float32 bottom = top + request_.height;
+
+  // The new boxes replace whatever was tracked in the area.
+  int32 kept = 0;
+  for (int32 i = 0; i < num_regions_; ++i) {
+    const RecognizedBox& box = regions_[i].box;
+    const float32 center_x = (box.left + box.right) / 2.0f;
+    const float32 center_y = (box.top + box.bottom) / 2.0f;
+
+    if (!inRange(center_x, left, right) || !inRange(center_y, top, bottom)) {
+      regions_[kept++] = regions_[i];
+    }
+  }
+  num_regions_ = kept;
+
+  for (int32 i = 0; i < num_result_boxes_; ++i) {
+    const RecognizedBox& box = result_boxes_[i];
+    if (box.right <= box.left || box.bottom <= box.top) {
+      continue;
+    }
+
+    if (num_regions_ == MAX_TRACKED_REGIONS) {
+      LOGW("Too many regions, dropping %d of them.", num_result_boxes_ - i);
+      break;
+    }
+
+    // Tracked from the time of the request on by the next trackRegions.
+    TrackedRegion* const region = &regions_[num_regions_++];
+    region->id = next_region_id_++;
+    region->box = box;
+    region->position_time = request_.timestamp;
+    region->recognized_time = request_.timestamp;
+  }
+
+  for (int32 row = 0; row < SCHEDULER_GRID_ROWS; ++row) {
+    for (int32 column = 0; column < SCHEDULER_GRID_COLUMNS; ++column) {
+      const int32 cell = row * SCHEDULER_GRID_COLUMNS + column;
+      if (!request_cells_[cell]) {
+        continue;
+      }
+
+      const float32 cell_left = cellLeft(column);
+      const float32 cell_top = cellTop(row);
+      const float32 cell_half_width = (cellLeft(column + 1) - cell_left) / 2.0f;
+      const float32 cell_half_height = (cellTop(row + 1) - cell_top) / 2.0f;
+      const Point2D cell_delta =
+          deltaSince(cell_left + cell_half_width, cell_top + cell_half_height,
+                     max(cell_half_width, cell_half_height),
+                     request_.timestamp);
+
+      memcpy(reference_signatures_[cell], request_signatures_[cell],
+             sizeof(*request_signatures_[cell]) * signature_size_);
+      reference_shift_x_[cell] = cell_delta.x;
+      reference_shift_y_[cell] = cell_delta.y;
+      reference_valid_[cell] = true;
+    }
+  }
+
+  LOGV("Request %d found %d boxes, tracking %d regions.",
+       request_.id, num_result_boxes_, num_regions_);
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&mutex_);
+#endif
+  request_pending_ = false;
+  result_ready_ = false;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&mutex_);
+#endif
+}
+
+
+void FrameScheduler::trackRegions(const clock_t previous_timestamp,
+                                  const clock_t timestamp) {
+  int32 kept = 0;
+  for (int32 i = 0; i < num_regions_; ++i) {
+    TrackedRegion region = regions_[i];
+    if (timestamp - region.recognized_time > REGION_TIMEOUT_MS) {
+      continue;
+    }
+
+    RecognizedBox* const box = &region.box;
+    const float32 half_width = (box->right - box->left) / 2.0f;
+    const float32 half_height = (box->bottom - box->top) / 2.0f;
+    const Point2D delta =
+        deltaSince(box->left + half_width, box->top + half_height,
+                   max(half_width, half_height), region.position_time);
+
+    box->left += delta.x;
+    box->top += delta.y;
+    box->right += delta.x;
+    box->bottom += delta.y;
+    region.position_time = timestamp;
+
+    // Drop the ones that left the frame.
+    if (box->right <= 0.0f || box->bottom <= 0.0f ||
+        box->left >= frame_width_ || box->top >= frame_height_) {
+      continue;
+    }
+
+    regions_[kept++] = region;
+  }
+  num_regions_ = kept;
+
+  for (int32 row = 0; row < SCHEDULER_GRID_ROWS; ++row) {
+    for (int32 column = 0; column < SCHEDULER_GRID_COLUMNS; ++column) {
+      const int32 cell = row * SCHEDULER_GRID_COLUMNS + column;
+      if (!reference_valid_[cell]) {
+        continue;
+      }
+
+      const float32 left = cellLeft(column);
+      const float32 top = cellTop(row);
+      const float32 half_width = (cellLeft(column + 1) - left) / 2.0f;
+      const float32 half_height = (cellTop(row + 1) - top) / 2.0f;
+      const Point2D delta =
+          deltaSince(left + half_width, top + half_height,
+                     max(half_width, half_height), previous_timestamp);
+
+      reference_shift_x_[cell] += delta.x;
+      reference_shift_y_[cell] += delta.y;
+    }
+  }
+}
+
+
+Point2D FrameScheduler::deltaSince(const float32 x, const float32 y,
+                                   const float32 radius,
+                                   const clock_t timestamp) const {
+  return optical_flow_.getAccumulatedDelta(Point2D(x, y), radius, timestamp);
+}
+
+
+int32 FrameScheduler::findChangedCells(bool* const changed) {
+  int32 num_changed = 0;
+
+  for (int32 row = 0; row < SCHEDULER_GRID_ROWS; ++row) {
+    for (int32 column = 0; column < SCHEDULER_GRID_COLUMNS; ++column) {
+      const int32 cell = row * SCHEDULER_GRID_COLUMNS + column;
+      const int32 left = cellLeft(column);
+      const int32 top = cellTop(row);
+      const int32 right = cellLeft(column + 1);
+      const int32 bottom = cellTop(row + 1);
+
+      changed[cell] = true;
+
+      if (reference_valid_[cell]) {
+        const float32 max_shift =
+            CELL_MAX_SHIFT * min(right - left, bottom - top);
+        const bool moved =
+            square(reference_shift_x_[cell]) +
+            square(reference_shift_y_[cell]) > square(max_shift);
+
+        if (!moved) {
+          // Still looking at the same thing, so see whether it changed.
+          changed[cell] = Diff(
+              reinterpret_cast<const int32*>(reference_signatures_[cell]),
+              reinterpret_cast<const int32*>(cell_signatures_[cell]),
+              signature_size_) > CELL_CHANGE_THRESHOLD;
+        } else {
+          // Whatever moved into a cell that has tracked regions in it was
+          // recognized before and moved along with the regions.
+          bool covered = false;
+          for (int32 i = 0; i < num_regions_ && !covered; ++i) {
+            const RecognizedBox& box = regions_[i].box;
+            covered = inRange((box.left + box.right) / 2.0f,
+                              static_cast<float32>(left),
+                              static_cast<float32>(right)) &&
+                      inRange((box.top + box.bottom) / 2.0f,
+                              static_cast<float32>(top),
+                              static_cast<float32>(bottom));
+          }
+
+          if (covered) {
+            memcpy(reference_signatures_[cell], cell_signatures_[cell],
+                   sizeof(*cell_signatures_[cell]) * signature_size_);
+            reference_shift_x_[cell] = 0.0f;
+            reference_shift_y_[cell] = 0.0f;
+            changed[cell] = false;
+          }
+        }
+      }
+
+      if (changed[cell]) {
+        ++num_changed;
+      }
+    }
+  }
+
+  return num_changed;
+}
+
+
+void FrameScheduler::dispatch(const uint8* const frame,
+                              const clock_t timestamp,
+                              const int32 left, const int32 top,
+                              const int32 right, const int32 bottom) {
+  request_.id = next_request_id_++;
+  request_.timestamp = timestamp;
+  request_.left = left;
+  request_.top = top;
+  request_.width = right - left;
+  request_.height = bottom - top;
+  request_.pixels = request_pixels_;
+
+  for (int32 y = 0; y < request_.height; ++y) {
+    memcpy(request_pixels_ + y * request_.width,
+           frame + (top + y) * frame_width_ + left, request_.width);
+  }
+
+  // The area is made up of whole cells, whose signatures become the
+  // references once the request is recognized.
+  for (int32 row = 0; row < SCHEDULER_GRID_ROWS; ++row) {
+    for (int32 column = 0; column < SCHEDULER_GRID_COLUMNS; ++column) {
+      const int32 cell = row * SCHEDULER_GRID_COLUMNS + column;
+      request_cells_[cell] =
+          cellLeft(column) >= left && cellLeft(column + 1) <= right &&
+          cellTop(row) >= top && cellTop(row + 1) <= bottom;
+
+      if (request_cells_[cell]) {
+        memcpy(request_signatures_[cell], cell_signatures_[cell],
+               sizeof(*cell_signatures_[cell]) * signature_size_);
+      }
+    }
+  }
+
+  LOGV("Dispatching request %d: %dx%d at %d, %d",
+       request_.id, request_.width, request_.height, left, top);
+
+#ifdef HAVE_PTHREAD
+  if (worker_started_) {
+    pthread_mutex_lock(&mutex_);
+    request_pending_ = true;
+    result_ready_ = false;
+    pthread_cond_signal(&cond_);
+    pthread_mutex_unlock(&mutex_);
+    return;
+  }
+#endif
+
+  request_pending_ = true;
+  recognizePending();
+  result_ready_ = true;
+}
+
+
+void FrameScheduler::recognizePending() {
+  const int32 num_boxes =
+      recognizer_->recognize(request_, result_boxes_, MAX_TRACKED_REGIONS);
+  num_result_boxes_ = clip(num_boxes, 0, MAX_TRACKED_REGIONS);
+}
+
+
+#ifdef HAVE_PTHREAD
+void* FrameScheduler::workerMain(void* scheduler) {
+  FrameScheduler* const self = static_cast<FrameScheduler*>(scheduler);
+  self->recognizer_->workerStarted();
+
+  pthread_mutex_lock(&self->mutex_);
+  while (true) {
+    while (!self->stopping_ &&
+           (!self->request_pending_ || self->result_ready_)) {
+      pthread_cond_wait(&self->cond_, &self->mutex_);
+    }
+    if (self->stopping_) {
+      break;
+    }
+
+    pthread_mutex_unlock(&self->mutex_);
+    self->recognizePending();
+    pthread_mutex_lock(&self->mutex_);
+
+    self->result_ready_ = true;
+  }
+  pthread_mutex_unlock(&self->mutex_);
+
+  self->recognizer_->workerStopping();
+  return NULL;
+}
+#endif
+
+}  // namespace flow
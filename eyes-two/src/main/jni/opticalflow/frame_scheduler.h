@@ -0,0 +1,249 @@
+/*
+ * Copyright 2017 Robert Theis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#ifndef JAVA_COM_GOOGLE_ANDROID_APPS_UNVEIL_JNI_OPTICALFLOW_FRAME_SCHEDULER_H_
+#define JAVA_COM_GOOGLE_ANDROID_APPS_UNVEIL_JNI_OPTICALFLOW_FRAME_SCHEDULER_H_
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "types.h"
+#include "utils.h"
+#include "optical_flow_utils.h"
+#include "time_log.h"
+#include "image.h"
+#include "optical_flow.h"
+
+// The frame is split into this grid of cells to decide which parts of it
+// need to be recognized again.
+#define SCHEDULER_GRID_COLUMNS 4
+#define SCHEDULER_GRID_ROWS 4
+#define SCHEDULER_NUM_CELLS (SCHEDULER_GRID_COLUMNS * SCHEDULER_GRID_ROWS)
+
+// Maximum number of recognized boxes kept track of, and returned per request.
+#define MAX_TRACKED_REGIONS 256
+
+// Number of floats each tracked region takes up when exporting to an array.
+#define REGION_STEP 6
+
+// Room for the signature of a cell, see ComputeSignatureRegion.
+#define MAX_SIGNATURE_SIZE 64
+
+// Only every this many pixels of every this many rows of a cell are looked
+// at for its signature.
+#define CELL_SIGNATURE_STEP 2
+
+// Percentage of difference (see Diff) above which a cell has changed since it
+// was last recognized.
+#define CELL_CHANGE_THRESHOLD 10
+
+// A cell that moved more than this fraction of its size since it was last
+// recognized can no longer be compared against its old signature.
+#define CELL_MAX_SHIFT 0.25f
+
+// Frames that moved more than this many pixels since the previous frame are
+// not sent for recognition, as they are likely to be smeared.
+#define MAX_FRAME_MOTION 4.0f
+
+// Recognized boxes are dropped and their area recognized again after this
+// long, so that tracking errors do not build up forever.
+#define REGION_TIMEOUT_MS 10000
+
+namespace flow {
+
+// A box found by the recognizer, in frame coordinates.  tag is chosen by the
+// recognizer and handed back with the box, e.g. to find the recognized text.
+struct RecognizedBox {
+  float32 left;
+  float32 top;
+  float32 right;
+  float32 bottom;
+  int32 tag;
+};
+
+// A piece of a frame to be recognized.  pixels holds width * height luminance
+// values, one byte per pixel, of the area at left, top of the frame captured
+// at timestamp.
+struct RecognitionRequest {
+  int32 id;
+  clock_t timestamp;
+  int32 left;
+  int32 top;
+  int32 width;
+  int32 height;
+  const uint8* pixels;
+};
+
+// Does the actual recognition for a FrameScheduler, e.g. by calling Tesseract.
+class FrameRecognizer {
+ public:
+  virtual ~FrameRecognizer() {}
+
+  // Recognizes the given request and writes what was found to boxes, at most
+  // max_boxes of them.  Returns the number of boxes found.  Called on the
+  // worker thread of the scheduler, one request at a time.
+  virtual int32 recognize(const RecognitionRequest& request,
+                          RecognizedBox* const boxes,
+                          const int32 max_boxes) = 0;
+
+  // Called on the worker thread of the scheduler once when it starts, before
+  // any call to recognize(), and once just before it exits.  Not called if
+  // the scheduler has no worker and recognizes on the calling thread.
+  virtual void workerStarted() {}
+  virtual void workerStopping() {}
+};
+
+// A recognized box moved along with the camera since it was recognized.
+struct TrackedRegion {
+  int32 id;
+  RecognizedBox box;
+
+  // Time the position of box refers to.
+  clock_t position_time;
+
+  // Time of the frame box was recognized in.
+  clock_t recognized_time;
+};
+
+// What FrameScheduler::processFrame did with a frame.
+enum ScheduleResult {
+  SCHEDULE_DISPATCHED = 0,  // Part of the frame was sent for recognition.
+  SCHEDULE_UNCHANGED,       // Nothing new to recognize.
+  SCHEDULE_MOVING,          // The camera moves too fast to recognize.
+  SCHEDULE_BLURRED,         // The part to recognize is blurred.
+  SCHEDULE_BUSY             // Still recognizing a previous frame.
+};
+
+// Decides which preview frames, and which parts of them, are worth
+// recognizing.  Each frame is fed to optical flow, which moves the boxes
+// recognized so far along with the camera, so they do not need to be
+// recognized again.  Only the cells of the frame that are new or changed
+// since they were last recognized are sent to the recognizer, and only when
+// the camera is steady, the area is sharp and the recognizer is idle.
+// Recognition runs on a worker thread; its results are picked up by the
+// next call to processFrame.
+//
+// Apart from the recognizer, which is called on the worker thread, the
+// scheduler should only be used from one thread.
+class FrameScheduler {
+ public:
+  // Takes ownership of recognizer.
+  FrameScheduler(const int32 frame_width, const int32 frame_height,
+                 const int32 downsample_factor,
+                 FrameRecognizer* const recognizer);
+  ~FrameScheduler();
+
+  // Adds a new frame, as for OpticalFlow::nextFrame, and sends the parts of
+  // it that need recognition to the recognizer.
+  ScheduleResult processFrame(const uint8* const frame,
+                              const clock_t timestamp);
+
+  // Copies the regions tracked as of the last frame to out_data, which
+  // should be at least MAX_TRACKED_REGIONS * REGION_STEP long.  Its format is
+  // [id tag left top right bottom] repeated N times, where N is returned.
+  int32 getRegions(float32* const out_data) const;
+
+  int32 getNumRegions() const {
+    return num_regions_;
+  }
+
+ private:
+  // Adds the boxes of a finished recognition, if any, to the tracked regions.
+  void collectResults();
+
+  // Moves the tracked regions to the given time and drops the stale ones, and
+  // adds the motion since the previous frame to the cell shifts.
+  void trackRegions(const clock_t previous_timestamp, const clock_t timestamp);
+
+  // Returns how far the area of the given radius around the given point moved
+  // from timestamp to the latest frame.
+  Point2D deltaSince(const float32 x, const float32 y, const float32 radius,
+                     const clock_t timestamp) const;
+
+  // Flags the cells that need to be recognized and returns how many there
+  // are.  Refreshes the reference signatures of cells that moved but are
+  // covered by tracked regions.
+  int32 findChangedCells(bool* const changed);
+
+  // Copies the area of the frame to the request and hands it to the worker.
+  void dispatch(const uint8* const frame, const clock_t timestamp,
+                const int32 left, const int32 top,
+                const int32 right, const int32 bottom);
+
+  // Recognizes the pending request and stores the result for collectResults.
+  void recognizePending();
+
+#ifdef HAVE_PTHREAD
+  static void* workerMain(void* scheduler);
+#endif
+
+  inline int32 cellLeft(const int32 column) const {
+    return column * frame_width_ / SCHEDULER_GRID_COLUMNS;
+  }
+
+  inline int32 cellTop(const int32 row) const {
+    return row * frame_height_ / SCHEDULER_GRID_ROWS;
+  }
+
+  const int32 frame_width_;
+  const int32 frame_height_;
+
+  OpticalFlow optical_flow_;
+  FrameRecognizer* const recognizer_;
+
+  clock_t last_timestamp_;
+
+  TrackedRegion regions_[MAX_TRACKED_REGIONS];
+  int32 num_regions_;
+  int32 next_region_id_;
+
+  // Signature of each cell in the current frame.
+  uint32 cell_signatures_[SCHEDULER_NUM_CELLS][MAX_SIGNATURE_SIZE];
+  int32 signature_size_;
+
+  // Signature of each cell when it was last recognized, if known, and how far
+  // the contents of the cell moved since.
+  uint32 reference_signatures_[SCHEDULER_NUM_CELLS][MAX_SIGNATURE_SIZE];
+  float32 reference_shift_x_[SCHEDULER_NUM_CELLS];
+  float32 reference_shift_y_[SCHEDULER_NUM_CELLS];
+  bool reference_valid_[SCHEDULER_NUM_CELLS];
+
+  // The one request in flight.  Owned by the worker while request_pending_
+  // is set and result_ready_ is not, and by the scheduler otherwise.
+  RecognitionRequest request_;
+  uint8* request_pixels_;
+  bool request_cells_[SCHEDULER_NUM_CELLS];
+  uint32 request_signatures_[SCHEDULER_NUM_CELLS][MAX_SIGNATURE_SIZE];
+  RecognizedBox result_boxes_[MAX_TRACKED_REGIONS];
+  int32 num_result_boxes_;
+  int32 next_request_id_;
+
+  bool request_pending_;
+  bool result_ready_;
+
+#ifdef HAVE_PTHREAD
+  pthread_t worker_;
+  bool worker_started_;
+  bool stopping_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+#endif
+};
+
+}  // namespace flow
+
+#endif  // JAVA_COM_GOOGLE_ANDROID_APPS_UNVEIL_JNI_OPTICALFLOW_FRAME_SCHEDULER_H_
@@ -31,6 +31,261 @@
 
 namespace flow {
 
+// Row kernels behind the Image operations below. The generic versions handle
+// any pixel type; the uint8 and int32 overloads use NEON or SSE2. Those that
+// return an int32 process columns from x while a full vector fits before end
+// and return the first column left for the caller's scalar loop.
+
+// Sets out[k] to the horizontal interpolation (a * p[k]) + (b * p[k + 1]) for
+// k in [0, n). Reads p[0] to p[n].
+template <typename T>
+inline void interpolateRow(const T* const p, const float32 a, const float32 b,
+                           const int32 n, float32* const out) {
+  for (int32 k = 0; k < n; ++k) {
+    out[k] = (a * p[k]) + (b * p[k + 1]);
+  }
+}
+
+#ifdef HAVE_FLOAT4
+template <typename T>
+inline void interpolateRowFloat4(const T* const p,
+                                 const float32 a, const float32 b,
+                                 const int32 n, float32* const out) {
+  const Float4 as = splatFloat4(a);
+  const Float4 bs = splatFloat4(b);
+  // The last group of four is shifted back to end at n, overlapping the one
+  // before it rather than reading past p[n].
+  for (int32 k = 0; k < n; k += 4) {
+    const int32 i = min(k, n - 4);
+    storeFloat4(out + i, addFloat4(mulFloat4(as, loadFloat4(p + i)),
+                                   mulFloat4(bs, loadFloat4(p + i + 1))));
+  }
+}
+
+inline void interpolateRow(const uint8* const p,
+                           const float32 a, const float32 b,
+                           const int32 n, float32* const out) {
+  if (n >= 4 && useFloat4()) {
+    interpolateRowFloat4(p, a, b, n, out);
+  } else {
+    interpolateRow<uint8>(p, a, b, n, out);
+  }
+}
+
+inline void interpolateRow(const int32* const p,
+                           const float32 a, const float32 b,
+                           const int32 n, float32* const out) {
+  if (n >= 4 && useFloat4()) {
+    interpolateRowFloat4(p, a, b, n, out);
+  } else {
+    interpolateRow<int32>(p, a, b, n, out);
+  }
+}
+#endif
+
+// Sets out[k] to the vertical interpolation (c * above[k]) + (d * below[k]).
+inline void blendRows(const float32* const above, const float32* const below,
+                      const float32 c, const float32 d,
+                      const int32 n, float32* const out) {
+  int32 k = 0;
+#ifdef HAVE_FLOAT4
+  if (n >= 4 && useFloat4()) {
+    const Float4 cs = splatFloat4(c);
+    const Float4 ds = splatFloat4(d);
+    for (; k < n; k += 4) {
+      const int32 i = min(k, n - 4);
+      storeFloat4(out + i, addFloat4(mulFloat4(cs, loadFloat4(above + i)),
+                                     mulFloat4(ds, loadFloat4(below + i))));
+    }
+  }
+#endif
+  for (; k < n; ++k) {
+    out[k] = (c * above[k]) + (d * below[k]);
+  }
+}
+
+// Sets dest[i] to (next[i] - prev[i]) / 2.
+template <typename T, typename U>
+inline int32 halfDiffRow(const U* const prev, const U* const next,
+                         const int32 x, const int32 end, T* const dest) {
+  return x;
+}
+
+inline int32 halfDiffRow(const uint8* const prev, const uint8* const next,
+                         int32 x, const int32 end, int32* const dest) {
+#if defined(HAVE_NEON)
+  if (!supportsNeon()) {
+    return x;
+  }
+  for (; x + 8 <= end; x += 8) {
+    int16x8_t diff =
+        vreinterpretq_s16_u16(vsubl_u8(vld1_u8(next + x), vld1_u8(prev + x)));
+    // Add the sign bit before shifting so that the halving truncates toward
+    // zero like integer division.
+    diff = vshrq_n_s16(vaddq_s16(diff, vreinterpretq_s16_u16(vshrq_n_u16(
+        vreinterpretq_u16_s16(diff), 15))), 1);
+    vst1q_s32(dest + x, vmovl_s16(vget_low_s16(diff)));
+    vst1q_s32(dest + x + 4, vmovl_s16(vget_high_s16(diff)));
+  }
+#elif defined(HAVE_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; x + 8 <= end; x += 8) {
+    const __m128i p = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(prev + x)), zero);
+    const __m128i n = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(next + x)), zero);
+    __m128i diff = _mm_sub_epi16(n, p);
+    // Add the sign bit before shifting so that the halving truncates toward
+    // zero like integer division.
+    diff = _mm_srai_epi16(_mm_add_epi16(diff, _mm_srli_epi16(diff, 15)), 1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x),
+                     _mm_srai_epi32(_mm_unpacklo_epi16(diff, diff), 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x + 4),
+                     _mm_srai_epi32(_mm_unpackhi_epi16(diff, diff), 16));
+  }
+#endif
+  return x;
+}
+
+// Sets dest[i] to the Scharr response
+//   (3 * ((b[0] - a[0]) + (b[2] - a[2])) + 10 * (b[1] - a[1])) / 32
+// where each a[k] and b[k] is read at offset i; the caller picks the rows and
+// columns that make this the X or Y filter.
+template <typename T, typename U>
+inline int32 scharrRow(const U* const* const a, const U* const* const b,
+                       const int32 x, const int32 end, T* const dest) {
+  return x;
+}
+
+inline int32 scharrRow(const uint8* const* const a,
+                       const uint8* const* const b,
+                       int32 x, const int32 end, int32* const dest) {
+#if defined(HAVE_NEON)
+  if (!supportsNeon()) {
+    return x;
+  }
+  for (; x + 8 <= end; x += 8) {
+    const int16x8_t outer = vreinterpretq_s16_u16(vaddq_u16(
+        vsubl_u8(vld1_u8(b[0] + x), vld1_u8(a[0] + x)),
+        vsubl_u8(vld1_u8(b[2] + x), vld1_u8(a[2] + x))));
+    const int16x8_t inner = vreinterpretq_s16_u16(
+        vsubl_u8(vld1_u8(b[1] + x), vld1_u8(a[1] + x)));
+    int16x8_t sum = vmlaq_n_s16(vmulq_n_s16(outer, 3), inner, 10);
+    // Round toward zero like integer division by 32.
+    sum = vshrq_n_s16(vaddq_s16(sum, vandq_s16(vshrq_n_s16(sum, 15),
+                                               vdupq_n_s16(31))), 5);
+    vst1q_s32(dest + x, vmovl_s16(vget_low_s16(sum)));
+    vst1q_s32(dest + x + 4, vmovl_s16(vget_high_s16(sum)));
+  }
+#elif defined(HAVE_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; x + 8 <= end; x += 8) {
+    __m128i diffs[3];
+    for (int32 k = 0; k < 3; ++k) {
+      diffs[k] = _mm_sub_epi16(
+          _mm_unpacklo_epi8(_mm_loadl_epi64(
+              reinterpret_cast<const __m128i*>(b[k] + x)), zero),
+          _mm_unpacklo_epi8(_mm_loadl_epi64(
+              reinterpret_cast<const __m128i*>(a[k] + x)), zero));
+    }
+    __m128i sum = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_add_epi16(diffs[0], diffs[2]), _mm_set1_epi16(3)),
+        _mm_mullo_epi16(diffs[1], _mm_set1_epi16(10)));
+    // Round toward zero like integer division by 32.
+    sum = _mm_srai_epi16(_mm_add_epi16(sum, _mm_and_si128(
+        _mm_srai_epi16(sum, 15), _mm_set1_epi16(31))), 5);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x),
+                     _mm_srai_epi32(_mm_unpacklo_epi16(sum, sum), 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x + 4),
+                     _mm_srai_epi32(_mm_unpackhi_epi16(sum, sum), 16));
+  }
+#endif
+  return x;
+}
+
+// Sets dest[i] to the [1 2 1]^2 / 16 smoothed value of rows r0, r1 and r2
+// about column 2 * i. Needs x >= 1 so that the left neighbor is in the row.
+template <typename T>
+inline int32 downsampleSmoothedRow(const T* const r0, const T* const r1,
+                                   const T* const r2, const int32 orig_width,
+                                   const int32 x, const int32 end,
+                                   T* const dest) {
+  return x;
+}
+
+inline int32 downsampleSmoothedRow(const uint8* const r0,
+                                   const uint8* const r1,
+                                   const uint8* const r2,
+                                   const int32 orig_width,
+                                   int32 x, const int32 end,
+                                   uint8* const dest) {
+#if defined(HAVE_NEON)
+  if (!supportsNeon()) {
+    return x;
+  }
+  for (; x + 8 <= end && 2 * x + 16 <= orig_width; x += 8) {
+    // De-interleave into even (val[0]) and odd (val[1]) columns. Loading one
+    // column earlier puts the left neighbors of the even columns in val[0].
+    const uint8x8x2_t left0 = vld2_u8(r0 + 2 * x - 1);
+    const uint8x8x2_t left1 = vld2_u8(r1 + 2 * x - 1);
+    const uint8x8x2_t left2 = vld2_u8(r2 + 2 * x - 1);
+    const uint8x8x2_t center0 = vld2_u8(r0 + 2 * x);
+    const uint8x8x2_t center1 = vld2_u8(r1 + 2 * x);
+    const uint8x8x2_t center2 = vld2_u8(r2 + 2 * x);
+
+    // Smooth vertically, then horizontally.
+    const uint16x8_t left = vaddq_u16(vaddl_u8(left0.val[0], left2.val[0]),
+                                      vshll_n_u8(left1.val[0], 1));
+    const uint16x8_t center =
+        vaddq_u16(vaddl_u8(center0.val[0], center2.val[0]),
+                  vshll_n_u8(center1.val[0], 1));
+    const uint16x8_t right =
+        vaddq_u16(vaddl_u8(center0.val[1], center2.val[1]),
+                  vshll_n_u8(center1.val[1], 1));
+    const uint16x8_t sum =
+        vaddq_u16(vaddq_u16(left, right), vshlq_n_u16(center, 1));
+    vst1_u8(dest + x, vshrn_n_u16(sum, 4));
+  }
+#elif defined(HAVE_SSE2)
+  const __m128i low_bytes = _mm_set1_epi16(0xff);
+  for (; x + 8 <= end && 2 * x + 16 <= orig_width; x += 8) {
+    const __m128i early0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 2 * x - 1));
+    const __m128i early1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 2 * x - 1));
+    const __m128i early2 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(r2 + 2 * x - 1));
+    const __m128i aligned0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 2 * x));
+    const __m128i aligned1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 2 * x));
+    const __m128i aligned2 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(r2 + 2 * x));
+
+    // Smooth vertically, then horizontally, with even columns in the low and
+    // odd columns in the high byte of each 16 bit lane. Loading one column
+    // earlier puts the left neighbors of the even columns in the low bytes.
+    const __m128i left = _mm_add_epi16(
+        _mm_add_epi16(_mm_and_si128(early0, low_bytes),
+                      _mm_and_si128(early2, low_bytes)),
+        _mm_slli_epi16(_mm_and_si128(early1, low_bytes), 1));
+    const __m128i center = _mm_add_epi16(
+        _mm_add_epi16(_mm_and_si128(aligned0, low_bytes),
+                      _mm_and_si128(aligned2, low_bytes)),
+        _mm_slli_epi16(_mm_and_si128(aligned1, low_bytes), 1));
+    const __m128i right = _mm_add_epi16(
+        _mm_add_epi16(_mm_srli_epi16(aligned0, 8), _mm_srli_epi16(aligned2, 8)),
+        _mm_slli_epi16(_mm_srli_epi16(aligned1, 8), 1));
+    const __m128i sum = _mm_srli_epi16(_mm_add_epi16(
+        _mm_add_epi16(left, right), _mm_slli_epi16(center, 1)), 4);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + x),
+                     _mm_packus_epi16(sum, sum));
+  }
+#endif
+  return x;
+}
+
+
 // TODO(andrewharp): Make explicit which operations support negative numbers or
 // struct/class types in image data (possibly create fast multi-dim array class
 // for data where pixel arithmetic does not make sense).
@@ -104,7 +359,7 @@ class Image {
 
 // Experimental NEON acceleration... not to be turned on until it's faster.
 #if FALSE
-#ifdef HAVE_ARMEABI_V7A
+#ifdef HAVE_NEON
     if (supportsNeon()) {
       // Output value:
       // a * c * p1 +
@@ -162,6 +417,52 @@ class Image {
            (y >= ZERO) && (y < height_less_one_);
   }
 
+  // Returns true iff every pixel of the size x size window with its top left
+  // corner at (left, top) is valid for interpolation.
+  inline bool validInterpWindow(const float32 left, const float32 top,
+                                const int32 size) const {
+    return validInterpPixel(left, top) &&
+           validInterpPixel(left + (size - 1), top + (size - 1));
+  }
+
+  // Bilinearly samples the size x size window with its top left corner at
+  // (left, top) into vals, in row major order. Uses the same weights as
+  // getPixelInterp() on each pixel of the window, computed only once, and
+  // interpolates each row of source pixels only once. The results may differ
+  // from getPixelInterp() in the last bits, as the vector paths and fast
+  // math builds are free to round the products and sums differently.
+  inline void getWindowInterp(const float32 left, const float32 top,
+                              const int32 size, float32* const vals) const {
+    CHECK(validInterpWindow(left, top, size),
+          "Window %.2f, %.2f, %d out of bounds in %dx%d image.",
+          left, top, size, width_, height_);
+    CHECK(size <= kMaxInterpWindow,
+          "Window %d > %d!", size, kMaxInterpWindow);
+
+    const int32 floored_x = (int32) left;
+    const int32 floored_y = (int32) top;
+
+    const float32 b = left - floored_x;
+    const float32 a = 1.0f - b;
+
+    const float32 d = top - floored_y;
+    const float32 c = 1.0f - d;
+
+    // Horizontally interpolated source rows, alternating between above and
+    // below as the window moves down.
+    float32 rows[2][kMaxInterpWindow];
+
+    const T* pix_ptr = getPixelPtrConst(floored_x, floored_y);
+    interpolateRow(pix_ptr, a, b, size, rows[0]);
+    for (int32 y = 0; y < size; ++y) {
+      pix_ptr += width_;
+      const float32* const above = rows[y & 1];
+      float32* const below = rows[(y + 1) & 1];
+      interpolateRow(pix_ptr, a, b, size, below);
+      blendRows(above, below, c, d, size, vals + y * size);
+    }
+  }
+
   // Safe lookup with boundary enforcement.
   inline T getPixelClipped(const int32 x, const int32 y) const {
     return getPixel(clip(x, ZERO, width_less_one_),
@@ -198,7 +499,7 @@ class Image {
   }
 
 
-#ifdef HAVE_ARMEABI_V7A
+#if defined(HAVE_NEON)
   // This function does the bulk of the work.
   inline void downsample32ColumnsNeon(const uint8* const original,
                                       const int32 stride,
@@ -276,6 +577,63 @@ class Image {
       downsample32ColumnsNeon(original, stride, min(orig_x, orig_width - 32));
     }
   }
+#elif defined(HAVE_SSE2)
+  // SSE2 counterpart of downsample32ColumnsNeon.
+  inline void downsample32ColumnsSse2(const uint8* const original,
+                                      const int32 stride,
+                                      const int32 orig_x) {
+    // Divide input x offset by 4 to find output offset.
+    const int32 new_x = orig_x >> 2;
+
+    // Initial offset into top row.
+    const uint8* offset = original + orig_x;
+
+    const __m128i low_bytes = _mm_set1_epi16(0xff);
+    const __m128i ones = _mm_set1_epi16(1);
+
+    // Sum along vertical columns.
+    // Process 32x4 input pixels and 8x1 output pixels per iteration.
+    for (int32 new_y = 0; new_y < height_; ++new_y) {
+      __m128i accum1 = _mm_setzero_si128();
+      __m128i accum2 = _mm_setzero_si128();
+
+      for (int32 row_num = 0; row_num < 4; ++row_num) {
+        const __m128i curr_data1 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(offset));
+        const __m128i curr_data2 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(offset + 16));
+
+        // Pairwise add into 16 bit lanes and accumulate.
+        accum1 = _mm_add_epi16(accum1,
+            _mm_add_epi16(_mm_and_si128(curr_data1, low_bytes),
+                          _mm_srli_epi16(curr_data1, 8)));
+        accum2 = _mm_add_epi16(accum2,
+            _mm_add_epi16(_mm_and_si128(curr_data2, low_bytes),
+                          _mm_srli_epi16(curr_data2, 8)));
+
+        // Move offset down one row.
+        offset += stride;
+      }
+
+      // Add pairs of pairs into 32 bits, divide by 16 and narrow to 8 bpp.
+      const __m128i tmp_pix1 = _mm_srli_epi32(_mm_madd_epi16(accum1, ones), 4);
+      const __m128i tmp_pix2 = _mm_srli_epi32(_mm_madd_epi16(accum2, ones), 4);
+      const __m128i pix16 = _mm_packs_epi32(tmp_pix1, tmp_pix2);
+
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(getPixelPtr(new_x, new_y)),
+                       _mm_packus_epi16(pix16, pix16));
+    }
+  }
+
+  // SSE2 counterpart of downsampleAveragedNeon. Requires that downsampling be
+  // by a factor of 4 and that the image be at least 8 pixels wide.
+  void downsampleAveragedSse2(const uint8* const original,
+                              const int32 stride) {
+    const int32 orig_width = width_ * 4;
+    for (int32 orig_x = 0; orig_x < orig_width; orig_x += 32) {
+      downsample32ColumnsSse2(original, stride, min(orig_x, orig_width - 32));
+    }
+  }
 #endif
 
 
@@ -283,13 +641,19 @@ class Image {
   // blocks of size factor x factor.
   void downsampleAveraged(const T* const original, const int32 stride,
                           const int32 factor) {
-#ifdef HAVE_ARMEABI_V7A
+#if defined(HAVE_NEON)
     if (supportsNeon() &&
         factor == 4 &&
+        width_ >= 8 &&
         (height_ % 4) == 0) {
       downsampleAveragedNeon(original, stride);
       return;
     }
+#elif defined(HAVE_SSE2)
+    if (factor == 4 && width_ >= 8) {
+      downsampleAveragedSse2(original, stride);
+      return;
+    }
 #endif
 
     const int32 pixels_per_block = factor * factor;
@@ -335,31 +699,19 @@ class Image {
       const int32 min_y = clip(orig_y - 1, ZERO, original.height_less_one_);
       const int32 max_y = clip(orig_y + 1, ZERO, original.height_less_one_);
 
-      for (int32 x = 0; x < width_; ++x) {
-        const int32 orig_x = clip(2 * x, ZERO, original.width_less_one_);
-        const int32 min_x = clip(orig_x - 1, ZERO, original.width_less_one_);
-        const int32 max_x = clip(orig_x + 1, ZERO, original.width_less_one_);
-
-        // Center.
-        int32 pixel_sum = original.getPixel(orig_x, orig_y) * 4;
-
-        // Sides.
-        pixel_sum += (original.getPixel(max_x, orig_y) +
-                      original.getPixel(min_x, orig_y) +
-                      original.getPixel(orig_x, max_y) +
-                      original.getPixel(orig_x, min_y)) * 2;
-
-        // Diagonals.
-        pixel_sum += (original.getPixel(max_x, max_y) +
-                      original.getPixel(min_x, max_y) +
-                      original.getPixel(max_x, min_y) +
-                      original.getPixel(min_x, min_y));
-
-        const int32 pixel_val = pixel_sum>>4;  // 16
-
-        //LOGV("Setting %d,%d to %d", col, row, pixel_val);
+      const T* const row_above = original.getPixelPtrConst(0, min_y);
+      const T* const row = original.getPixelPtrConst(0, orig_y);
+      const T* const row_below = original.getPixelPtrConst(0, max_y);
+      T* const dest_row = getPixelPtr(0, y);
 
-        setPixel(x, y, pixel_val);
+      // The first column clips its left neighbor, so the vectorized columns
+      // start at 1 and the remainder are finished off below.
+      dest_row[0] = smoothedPixel3x3(original, row_above, row, row_below, 0);
+      int32 x = downsampleSmoothedRow(row_above, row, row_below,
+                                      original.width_, 1, width_, dest_row);
+      for (; x < width_; ++x) {
+        dest_row[x] =
+            smoothedPixel3x3(original, row_above, row, row_below, x);
       }
     }
   }
@@ -425,7 +777,7 @@ class Image {
     return (3 * (original.getPixel(max_x, min_y)
                  + original.getPixel(max_x, max_y)
                  - original.getPixel(min_x, min_y)
-                 - original.getPixel(min_x, min_y))
+                 - original.getPixel(min_x, max_y))
             + 10 * (original.getPixel(max_x, center_y)
                     - original.getPixel(min_x, center_y))) / 32;
   }
@@ -456,8 +808,21 @@ class Image {
   template <typename U>
   inline void scharrX(const Image<U>& original) {
     for (int32 y = 0; y < height_; ++y) {
-      for (int32 x = 0; x < width_; ++x) {
-        setPixel(x, y, scharrPixelX(original, x, y));
+      const U* const row_above =
+          original.getPixelPtrConst(0, max(0, y - 1));
+      const U* const row = original.getPixelPtrConst(0, y);
+      const U* const row_below =
+          original.getPixelPtrConst(0, min(height_less_one_, y + 1));
+      T* const dest_row = getPixelPtr(0, y);
+
+      // Right neighbors minus left neighbors of each row.
+      const U* const lefts[] = { row_above - 1, row - 1, row_below - 1 };
+      const U* const rights[] = { row_above + 1, row + 1, row_below + 1 };
+
+      dest_row[0] = scharrPixelX(original, 0, y);
+      int32 x = scharrRow(lefts, rights, 1, width_less_one_, dest_row);
+      for (; x < width_; ++x) {
+        dest_row[x] = scharrPixelX(original, x, y);
       }
     }
   }
@@ -467,8 +832,20 @@ class Image {
   template <typename U>
   inline void scharrY(const Image<U>& original) {
     for (int32 y = 0; y < height_; ++y) {
-      for (int32 x = 0; x < width_; ++x) {
-        setPixel(x, y, scharrPixelY(original, x, y));
+      const U* const row_above =
+          original.getPixelPtrConst(0, max(0, y - 1));
+      const U* const row_below =
+          original.getPixelPtrConst(0, min(height_less_one_, y + 1));
+      T* const dest_row = getPixelPtr(0, y);
+
+      // Lower neighbors minus upper neighbors of each column.
+      const U* const uppers[] = { row_above - 1, row_above, row_above + 1 };
+      const U* const lowers[] = { row_below - 1, row_below, row_below + 1 };
+
+      dest_row[0] = scharrPixelY(original, 0, y);
+      int32 x = scharrRow(uppers, lowers, 1, width_less_one_, dest_row);
+      for (; x < width_; ++x) {
+        dest_row[x] = scharrPixelY(original, x, y);
       }
     }
   }
@@ -493,7 +870,9 @@ class Image {
       // All the pixels in between.
       const U* const source_prev_pixel = source_row - 1;
       const U* const source_next_pixel = source_row + 1;
-      for (int32 x = 1; x < width_less_one_; ++x) {
+      int32 x = halfDiffRow(source_prev_pixel, source_next_pixel,
+                            1, width_less_one_, dest_row);
+      for (; x < width_less_one_; ++x) {
         dest_row[x] = halfDiff(source_prev_pixel[x], source_next_pixel[x]);
       }
     }
@@ -510,7 +889,9 @@ class Image {
       const U* const source_next_pixel =
           original.getPixelPtrConst(0, min(height_less_one_, y + 1));
 
-      for (int32 x = 0; x < width_; ++x) {
+      int32 x = halfDiffRow(source_prev_pixel, source_next_pixel,
+                            0, width_, dest_row);
+      for (; x < width_; ++x) {
         dest_row[x] = halfDiff(source_prev_pixel[x], source_next_pixel[x]);
       }
     }
@@ -525,9 +906,11 @@ class Image {
                             const int32 total) const {
     int32 sum = 0;
     for (int32 filter_y = 0; filter_y < 3; ++filter_y) {
-      const int32 y = clip(center_y - 1 + filter_y, 0, original.getHeight());
+      const int32 y =
+          clip(center_y - 1 + filter_y, ZERO, original.height_less_one_);
       for (int32 filter_x = 0; filter_x < 3; ++filter_x) {
-        const int32 x = clip(center_x - 1 + filter_x, 0, original.getWidth());
+        const int32 x =
+            clip(center_x - 1 + filter_x, ZERO, original.width_less_one_);
         sum += original.getPixel(x, y) * filter[filter_y * 3 + filter_x];
       }
     }
@@ -544,8 +927,27 @@ class Image {
       sum += abs(filter[i]);
     }
     for (int32 y = 0; y < height_; ++y) {
-      for (int32 x = 0; x < width_; ++x) {
-        setPixel(x, y, convolvePixel3x3(original, filter, x, y, sum));
+      const U* const rows[] = {
+        original.getPixelPtrConst(0, max(0, y - 1)),
+        original.getPixelPtrConst(0, y),
+        original.getPixelPtrConst(0, min(height_less_one_, y + 1))
+      };
+      T* const dest_row = getPixelPtr(0, y);
+
+      // Only the first and last columns need their neighbors clipped.
+      dest_row[0] = convolvePixel3x3(original, filter, 0, y, sum);
+      for (int32 x = 1; x < width_less_one_; ++x) {
+        int32 pixel_sum = 0;
+        for (int32 filter_y = 0; filter_y < 3; ++filter_y) {
+          const U* const p = rows[filter_y] + x - 1;
+          const int32* const f = filter + filter_y * 3;
+          pixel_sum += p[0] * f[0] + p[1] * f[1] + p[2] * f[2];
+        }
+        dest_row[x] = pixel_sum / sum;
+      }
+      if (width_less_one_ > 0) {
+        dest_row[width_less_one_] =
+            convolvePixel3x3(original, filter, width_less_one_, y, sum);
       }
     }
   }
@@ -570,6 +972,28 @@ class Image {
   }
 
  private:
+  // Largest window getWindowInterp() can sample.
+  static const int32 kMaxInterpWindow = 11;
+
+  // Returns the [1 2 1]^2 / 16 smoothed value of original about column 2 * x
+  // of the given rows, clipping the columns to the image.
+  static inline T smoothedPixel3x3(const Image<T>& original,
+                                   const T* const row_above,
+                                   const T* const row,
+                                   const T* const row_below,
+                                   const int32 x) {
+    const int32 orig_x = clip(2 * x, ZERO, original.width_less_one_);
+    const int32 min_x = clip(orig_x - 1, ZERO, original.width_less_one_);
+    const int32 max_x = clip(orig_x + 1, ZERO, original.width_less_one_);
+
+    const int32 pixel_sum =
+        (row_above[min_x] + 2 * row_above[orig_x] + row_above[max_x]) +
+        2 * (row[min_x] + 2 * row[orig_x] + row[max_x]) +
+        (row_below[min_x] + 2 * row_below[orig_x] + row_below[max_x]);
+
+    return pixel_sum >> 4;  // 16
+  }
+
   inline void allocate() {
     image_data_ = (T*)malloc(num_pixels_ * sizeof(T));
     if (image_data_ == NULL) {
@@ -671,59 +1095,33 @@ inline static bool markImage(const int32 x, const int32 y,
 inline void calculateG(const float32* const vals_x, const float32* const vals_y,
                        const int32 num_vals, float* const G) {
   // Defined here because we want to keep track of how many values were
-  // processed by NEON, so that we can finish off the remainder the normal
-  // way.
+  // processed with vectors, so that we can finish off the remainder the
+  // normal way.
   int32 i = 0;
 
-#ifdef HAVE_ARMEABI_V7A
-  if (supportsNeon()) {
-    const float32_t* const arm_vals_x = (const float32_t*) vals_x;
-    const float32_t* const arm_vals_y = (const float32_t*) vals_y;
-
+#ifdef HAVE_FLOAT4
+  if (useFloat4()) {
     // Running sums.
-    float32x4_t xx = vdupq_n_f32(0.0f);
-    float32x4_t xy = vdupq_n_f32(0.0f);
-    float32x4_t yy = vdupq_n_f32(0.0f);
-
-    // Maximum index we can load 4 consecutive values from.
-    // e.g. if there are 81 values, our last full pass can be from index 77:
-    // 81-4=>77 (77, 78, 79, 80)
-    const int32 max_i = num_vals - 4;
+    Float4 xx = splatFloat4(0.0f);
+    Float4 xy = splatFloat4(0.0f);
+    Float4 yy = splatFloat4(0.0f);
 
     // Process values 4 at a time, accumulating the sums of
     // the pixel-wise x*x, x*y, and y*y values.
-    for (; i <= max_i; i += 4) {
-      // Load xs
-      float32x4_t x = vld1q_f32(arm_vals_x + i);
+    for (; i + 4 <= num_vals; i += 4) {
+      const Float4 x = loadFloat4(vals_x + i);
+      const Float4 y = loadFloat4(vals_y + i);
 
-      // Multiply x*x and accumulate.
-      xx = vmlaq_f32(xx, x, x);
-
-      // Load ys
-      float32x4_t y = vld1q_f32(arm_vals_y + i);
-
-      // Multiply x*y and accumulate.
-      xy = vmlaq_f32(xy, x, y);
-
-      // Multiply y*y and accumulate.
-      yy = vmlaq_f32(yy, y, y);
+      xx = addFloat4(xx, mulFloat4(x, x));
+      xy = addFloat4(xy, mulFloat4(x, y));
+      yy = addFloat4(yy, mulFloat4(y, y));
     }
 
-    static float32_t xx_vals[4];
-    static float32_t xy_vals[4];
-    static float32_t yy_vals[4];
-
-    vst1q_f32(xx_vals, xx);
-    vst1q_f32(xy_vals, xy);
-    vst1q_f32(yy_vals, yy);
-
-    // Accumulated values are store in sets of 4, we have to manually add
-    // the last bits together.
-    for (int32 j = 0; j < 4; ++j) {
-      G[0] += xx_vals[j];
-      G[1] += xy_vals[j];
-      G[3] += yy_vals[j];
-    }
+    // Accumulated values are stored in sets of 4, we have to manually add
+    // the lanes together.
+    G[0] += sumFloat4(xx);
+    G[1] += sumFloat4(xy);
+    G[3] += sumFloat4(yy);
   }
 #endif
   // Non-accelerated version, also finishes off last few values (< 4) from
@@ -747,7 +1145,7 @@ inline void calculateG(const int window_size,
                        float* const G) {
   CHECK(I_x.validPixel(center_x, center_y), "Problem in calculateG!");
 
-  // Hardcoded to allow for a max window radius of 5 (9 pixels x 9 pixels).
+  // Hardcoded to allow for a max window radius of 5 (11 pixels x 11 pixels).
   static const int kMaxWindowRadius = 5;
   CHECK(window_size <= kMaxWindowRadius,
         "Window %d > %d!", window_size, kMaxWindowRadius);
@@ -756,22 +1154,16 @@ inline void calculateG(const int window_size,
   static const int kWindowBufferSize =
       (kMaxWindowRadius * 2 + 1) * (kMaxWindowRadius * 2 + 1);
 
-  // Preallocate buffers statically for efficiency.
-  static float32 vals_x[kWindowBufferSize];
-  static float32 vals_y[kWindowBufferSize];
+  float32 vals_x[kWindowBufferSize];
+  float32 vals_y[kWindowBufferSize];
 
-  int32 num_vals = 0;
+  const int32 diameter = window_size * 2 + 1;
+  I_x.getWindowInterp(center_x - window_size, center_y - window_size,
+                      diameter, vals_x);
+  I_y.getWindowInterp(center_x - window_size, center_y - window_size,
+                      diameter, vals_y);
 
-  for (int32 win_x = -window_size; win_x <= window_size; ++win_x) {
-    for (int32 win_y = -window_size; win_y <= window_size; ++win_y) {
-      vals_x[num_vals] = I_x.getPixelInterp(center_x + win_x,
-                                            center_y + win_y);
-      vals_y[num_vals] = I_y.getPixelInterp(center_x + win_x,
-                                            center_y + win_y);
-      ++num_vals;
-    }
-  }
-  calculateG(vals_x, vals_y, num_vals, G);
+  calculateG(vals_x, vals_y, diameter * diameter, G);
 }
 
 }  // namespace flow
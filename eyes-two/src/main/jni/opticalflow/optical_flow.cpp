@@ -321,25 +321,18 @@ bool OpticalFlow::findFlowAtPoint(const float32 u_x, const float32 u_y,
     float32 vals_I_x[ARRAY_SIZE];
     float32 vals_I_y[ARRAY_SIZE];
 
-    int32 val_idx = 0;
-    for (int32 win_x = -WINDOW_SIZE; win_x <= WINDOW_SIZE; ++win_x) {
-      for (int32 win_y = -WINDOW_SIZE; win_y <= WINDOW_SIZE; ++win_y) {
-        const float32 x_pos = p_x + win_x;
-        const float32 y_pos = p_y + win_y;
+    // Top left corner of the window about p.
+    const float32 left = p_x - WINDOW_SIZE;
+    const float32 top = p_y - WINDOW_SIZE;
 
-        if (!img_I.validInterpPixel(x_pos, y_pos)) {
-          return false;
-        }
-
-        vals_I[val_idx] = img_I.getPixelInterp(x_pos, y_pos);
-
-        vals_I_x[val_idx] = I_x.getPixelInterp(x_pos, y_pos);
-        vals_I_y[val_idx] = I_y.getPixelInterp(x_pos, y_pos);
-
-        ++val_idx;
-      }
+    if (!img_I.validInterpWindow(left, top, WINDOW_DIAMETER)) {
+      return false;
     }
 
+    img_I.getWindowInterp(left, top, WINDOW_DIAMETER, vals_I);
+    I_x.getWindowInterp(left, top, WINDOW_DIAMETER, vals_I_x);
+    I_y.getWindowInterp(left, top, WINDOW_DIAMETER, vals_I_y);
+
     // Compute the spatial gradient matrix about point p.
     float32 G[] = { 0, 0, 0, 0 };
     calculateG(vals_I_x, vals_I_y, ARRAY_SIZE, G);
@@ -360,51 +353,28 @@ bool OpticalFlow::findFlowAtPoint(const float32 u_x, const float32 u_y,
     for (int32 iteration = 0; iteration < NUM_ITERATIONS; ++iteration) {
       // Get values for frame 2.
       float32 vals_J[ARRAY_SIZE];
-      int32 val_idx = 0;
-      for (int32 win_x = -WINDOW_SIZE; win_x <= WINDOW_SIZE; ++win_x) {
-        for (int32 win_y = -WINDOW_SIZE; win_y <= WINDOW_SIZE; ++win_y) {
-          const float32 x_pos = p_x + win_x + g_x;
-          const float32 y_pos = p_y + win_y + g_y;
-
-          if (!img_I.validInterpPixel(x_pos, y_pos)) {
-            return false;
-          }
-
-          vals_J[val_idx] = img_J.getPixelInterp(x_pos, y_pos);
-
-          ++val_idx;
-        }
+      if (!img_I.validInterpWindow(left + g_x, top + g_y, WINDOW_DIAMETER)) {
+        return false;
       }
+      img_J.getWindowInterp(left + g_x, top + g_y, WINDOW_DIAMETER, vals_J);
 
+      // Compute image mismatch vector.
+      float32 b_x;
+      float32 b_y;
 #ifdef NORMALIZE
       const float32 mean_J = computeMean(vals_J, ARRAY_SIZE);
       const float32 std_dev_J = computeStdDev(vals_J, ARRAY_SIZE, mean_J);
 
       const float32 std_dev_ratio = std_dev_I / std_dev_J;
-#endif
-
-      // Compute image mismatch vector.
-      float32 b_x = 0.0f;
-      float32 b_y = 0.0f;
-      val_idx = 0;
-      for (int32 win_x = -WINDOW_SIZE; win_x <= WINDOW_SIZE; ++win_x) {
-        for (int32 win_y = -WINDOW_SIZE; win_y <= WINDOW_SIZE; ++win_y) {
-          // Normalized Image difference.
 
-#ifdef NORMALIZE
-          const float32 dI = (vals_I[val_idx] - mean_I) -
-                             (vals_J[val_idx] - mean_J) * std_dev_ratio;
+      // Normalized Image difference.
+      computeMismatch(vals_I, vals_J, vals_I_x, vals_I_y, ARRAY_SIZE,
+                      mean_I, mean_J, std_dev_ratio, &b_x, &b_y);
 #else
-          const float32 dI = vals_I[val_idx] - vals_J[val_idx];
+      computeMismatch(vals_I, vals_J, vals_I_x, vals_I_y, ARRAY_SIZE,
+                      0.0f, 0.0f, 1.0f, &b_x, &b_y);
 #endif
 
-          b_x += dI * vals_I_x[val_idx];
-          b_y += dI * vals_I_y[val_idx];
-
-          ++val_idx;
-        }
-      }
-
       // Optical flow... solve n = G^-1 * b
       const float32 n_x = (G_inv[0] * b_x) + (G_inv[1] * b_y);
       const float32 n_y = (G_inv[2] * b_x) + (G_inv[3] * b_y);
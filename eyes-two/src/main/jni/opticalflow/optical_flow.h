@@ -32,8 +32,11 @@
 // Window size to integrate over to find local image derivative.
 #define WINDOW_SIZE 3
 
+// Width and height of integration windows.
+#define WINDOW_DIAMETER (2 * WINDOW_SIZE + 1)
+
 // Total area of integration windows.
-#define ARRAY_SIZE (2 * WINDOW_SIZE + 1) * (2 * WINDOW_SIZE + 1)
+#define ARRAY_SIZE (WINDOW_DIAMETER * WINDOW_DIAMETER)
 
 // Error that's considered good enough to early abort tracking.
 #define THRESHOLD 0.03f
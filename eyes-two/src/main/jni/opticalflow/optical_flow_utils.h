@@ -6,6 +6,7 @@
 
 #include "utils.h"
 #include <cmath>
+#include <string.h>
 
 namespace flow {
 
@@ -79,24 +80,127 @@ inline bool invert2x2(const float32* const a, float32* const a_inv) {
   return true;
 }
 
-// TODO(andrewharp): Accelerate with NEON.
+// A minimal four-lane float vector over NEON or SSE2, so that the tracker's
+// window arithmetic is only written once. Only use when useFloat4() is true.
+#if defined(HAVE_NEON)
+#define HAVE_FLOAT4 1
+typedef float32x4_t Float4;
+
+inline bool useFloat4() { return supportsNeon(); }
+
+inline Float4 loadFloat4(const float32* const p) { return vld1q_f32(p); }
+
+// Loads four consecutive pixels. Reads exactly four bytes.
+inline Float4 loadFloat4(const uint8* const p) {
+  uint32 word;
+  memcpy(&word, p, sizeof(word));
+  const uint8x8_t bytes = vreinterpret_u8_u32(vdup_n_u32(word));
+  return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(bytes))));
+}
+
+inline Float4 loadFloat4(const int32* const p) {
+  return vcvtq_f32_s32(vld1q_s32(p));
+}
+
+inline void storeFloat4(float32* const p, const Float4 v) { vst1q_f32(p, v); }
+inline Float4 splatFloat4(const float32 v) { return vdupq_n_f32(v); }
+inline Float4 addFloat4(const Float4 a, const Float4 b) {
+  return vaddq_f32(a, b);
+}
+inline Float4 subFloat4(const Float4 a, const Float4 b) {
+  return vsubq_f32(a, b);
+}
+inline Float4 mulFloat4(const Float4 a, const Float4 b) {
+  return vmulq_f32(a, b);
+}
+
+// Returns the sum of the four lanes.
+inline float32 sumFloat4(const Float4 v) {
+  const float32x2_t half = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(half, half), 0);
+}
+#elif defined(HAVE_SSE2)
+#define HAVE_FLOAT4 1
+typedef __m128 Float4;
+
+inline bool useFloat4() { return true; }
+
+inline Float4 loadFloat4(const float32* const p) { return _mm_loadu_ps(p); }
+
+// Loads four consecutive pixels. Reads exactly four bytes.
+inline Float4 loadFloat4(const uint8* const p) {
+  int32 word;
+  memcpy(&word, p, sizeof(word));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bytes = _mm_cvtsi32_si128(word);
+  return _mm_cvtepi32_ps(
+      _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+inline Float4 loadFloat4(const int32* const p) {
+  return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+inline void storeFloat4(float32* const p, const Float4 v) {
+  _mm_storeu_ps(p, v);
+}
+inline Float4 splatFloat4(const float32 v) { return _mm_set1_ps(v); }
+inline Float4 addFloat4(const Float4 a, const Float4 b) {
+  return _mm_add_ps(a, b);
+}
+inline Float4 subFloat4(const Float4 a, const Float4 b) {
+  return _mm_sub_ps(a, b);
+}
+inline Float4 mulFloat4(const Float4 a, const Float4 b) {
+  return _mm_mul_ps(a, b);
+}
+
+// Returns the sum of the four lanes.
+inline float32 sumFloat4(const Float4 v) {
+  const __m128 half = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  return _mm_cvtss_f32(
+      _mm_add_ss(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+#endif
+
 inline float32 computeMean(const float32* const values,
                            const int32 num_vals) {
   // Get mean.
   float32 sum = 0.0f;
-  for (int32 i = 0; i < num_vals; ++i) {
+  int32 i = 0;
+#ifdef HAVE_FLOAT4
+  if (useFloat4()) {
+    Float4 sums = splatFloat4(0.0f);
+    for (; i + 4 <= num_vals; i += 4) {
+      sums = addFloat4(sums, loadFloat4(values + i));
+    }
+    sum = sumFloat4(sums);
+  }
+#endif
+  for (; i < num_vals; ++i) {
     sum += values[i];
   }
   return sum / static_cast<float32>(num_vals);
 }
 
-// TODO(andrewharp): Accelerate with NEON.
 inline float32 computeStdDev(const float32* const values,
                              const int32 num_vals,
                              const float32 mean) {
   // Get Std dev.
   float32 squared_sum = 0.0f;
-  for (int32 i = 0; i < num_vals; ++i) {
+  int32 i = 0;
+#ifdef HAVE_FLOAT4
+  if (useFloat4()) {
+    const Float4 means = splatFloat4(mean);
+    Float4 sums = splatFloat4(0.0f);
+    for (; i + 4 <= num_vals; i += 4) {
+      const Float4 diff = subFloat4(loadFloat4(values + i), means);
+      sums = addFloat4(sums, mulFloat4(diff, diff));
+    }
+    squared_sum = sumFloat4(sums);
+  }
+#endif
+  for (; i < num_vals; ++i) {
     squared_sum += square(values[i] - mean);
   }
   return sqrt(squared_sum / static_cast<float32>(num_vals));
@@ -115,6 +219,48 @@ inline float32 computeWeightedMean(const float32* const values,
   return sum / num_vals;
 }
 
+// Computes the image mismatch vector b of a Lucas-Kanade iteration, the sum of
+// dI * (I_x, I_y) with dI = (I - offset_I) - (J - offset_J) * scale.
+inline void computeMismatch(const float32* const vals_I,
+                            const float32* const vals_J,
+                            const float32* const vals_I_x,
+                            const float32* const vals_I_y,
+                            const int32 num_vals,
+                            const float32 offset_I,
+                            const float32 offset_J,
+                            const float32 scale,
+                            float32* const b_x, float32* const b_y) {
+  float32 sum_x = 0.0f;
+  float32 sum_y = 0.0f;
+  int32 i = 0;
+#ifdef HAVE_FLOAT4
+  if (useFloat4()) {
+    const Float4 offsets_I = splatFloat4(offset_I);
+    const Float4 offsets_J = splatFloat4(offset_J);
+    const Float4 scales = splatFloat4(scale);
+    Float4 sums_x = splatFloat4(0.0f);
+    Float4 sums_y = splatFloat4(0.0f);
+    for (; i + 4 <= num_vals; i += 4) {
+      const Float4 dI =
+          subFloat4(subFloat4(loadFloat4(vals_I + i), offsets_I),
+                    mulFloat4(subFloat4(loadFloat4(vals_J + i), offsets_J),
+                              scales));
+      sums_x = addFloat4(sums_x, mulFloat4(dI, loadFloat4(vals_I_x + i)));
+      sums_y = addFloat4(sums_y, mulFloat4(dI, loadFloat4(vals_I_y + i)));
+    }
+    sum_x = sumFloat4(sums_x);
+    sum_y = sumFloat4(sums_y);
+  }
+#endif
+  for (; i < num_vals; ++i) {
+    const float32 dI = (vals_I[i] - offset_I) - (vals_J[i] - offset_J) * scale;
+    sum_x += dI * vals_I_x[i];
+    sum_y += dI * vals_I_y[i];
+  }
+  *b_x = sum_x;
+  *b_y = sum_y;
+}
+
 // Partitioning phase of quicksort.
 template<typename T>
 inline int32 partition(T* const arr_start,
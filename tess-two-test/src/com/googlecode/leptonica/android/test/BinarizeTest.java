@@ -16,8 +16,71 @@
 
 package com.googlecode.leptonica.android.test;
 
+import android.graphics.Bitmap;
+import android.graphics.Canvas;
+import android.graphics.Color;
+import android.graphics.Paint;
+import android.graphics.Paint.Style;
+import android.test.suitebuilder.annotation.SmallTest;
+
+import com.googlecode.leptonica.android.Binarize;
+import com.googlecode.leptonica.android.Convert;
+import com.googlecode.leptonica.android.GrayQuant;
+import com.googlecode.leptonica.android.Pix;
+import com.googlecode.leptonica.android.ReadFile;
+
 import junit.framework.TestCase;
 
 public class BinarizeTest extends TestCase {
+    @SmallTest
+    public void testSetNumThreads() {
+        Pix pixg = createGridPix(640, 480);
+
+        // Each tile and window holds some of the lines, so both methods
+        // should find exactly the lines, on any number of threads.
+        Pix expected = GrayQuant.pixThresholdToBinary(pixg, 128);
+
+        for (int numThreads : new int[] { 1, 4 }) {
+            Binarize.setNumThreads(numThreads);
+            Pix sauvola = Binarize.sauvolaBinarizeTiled(pixg, 8, 0.35f, 1, 1);
+            Pix sauvolaTiled = Binarize.sauvolaBinarizeTiled(pixg, 8, 0.35f, 2, 2);
+            Pix otsu = Binarize.otsuAdaptiveThreshold(pixg);
+
+            assertEquals(1.0f, TestUtils.comparePix(expected, sauvola));
+            assertEquals(1.0f, TestUtils.comparePix(expected, sauvolaTiled));
+            assertEquals(1.0f, TestUtils.comparePix(expected, otsu));
+
+            sauvola.recycle();
+            sauvolaTiled.recycle();
+            otsu.recycle();
+        }
+        Binarize.setNumThreads(1);
+
+        pixg.recycle();
+        expected.recycle();
+    }
+
+    private static Pix createGridPix(int width, int height) {
+        Bitmap bmp = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888);
+        Canvas canvas = new Canvas(bmp);
+        Paint paint = new Paint();
+
+        // Paint a light background with dark lines 2 pixels wide, every 16 pixels
+        canvas.drawColor(Color.rgb(210, 210, 210));
+        paint.setColor(Color.rgb(30, 30, 30));
+        paint.setStyle(Style.FILL);
+        for (int x = 0; x < width; x += 16) {
+            canvas.drawRect(x, 0, x + 2, height, paint);
+        }
+        for (int y = 0; y < height; y += 16) {
+            canvas.drawRect(0, y, width, y + 2, paint);
+        }
+
+        Pix pixs = ReadFile.readBitmap(bmp);
+        Pix pixg = Convert.convertTo8(pixs);
+        pixs.recycle();
+        bmp.recycle();
 
+        return pixg;
+    }
 }
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2017 Robert Theis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package com.googlecode.leptonica.android.test;
+
+import android.graphics.Color;
+import android.test.suitebuilder.annotation.SmallTest;
+
+import com.googlecode.leptonica.android.Convert;
+import com.googlecode.leptonica.android.MorphApp;
+import com.googlecode.leptonica.android.Pix;
+
+import junit.framework.TestCase;
+
+import java.util.Random;
+
+public class MorphAppTest extends TestCase {
+    private static final int[] MORPH_TYPES = { MorphApp.L_MORPH_DILATE,
+            MorphApp.L_MORPH_ERODE, MorphApp.L_MORPH_OPEN, MorphApp.L_MORPH_CLOSE };
+
+    @SmallTest
+    public void testPixMorphBrick() {
+        // Image sizes on either side of a 32-bit word, and Sels that are
+        // one pixel wide, cross a word, or are wider than the image.
+        int[][] dims = { { 1, 1 }, { 31, 7 }, { 32, 33 }, { 65, 40 }, { 150, 97 } };
+        int[][] sizes = { { 1, 1 }, { 1, 5 }, { 4, 1 }, { 3, 3 }, { 8, 2 },
+                { 33, 5 }, { 5, 40 }, { 200, 3 } };
+        Random random = new Random(1);
+
+        for (int[] dim : dims) {
+            Pix pixs = createRandomPix(dim[0], dim[1], random);
+
+            for (int[] size : sizes) {
+                for (int type : MORPH_TYPES) {
+                    assertMorphBrickMatchesReference(pixs, size[0], size[1], type);
+                }
+            }
+
+            pixs.recycle();
+        }
+    }
+
+    @SmallTest
+    public void testSetNumThreads() {
+        Pix pixs = TestUtils.createTestPix(640, 480);
+        Pix pixg = Convert.convertTo8(pixs);
+        Pix pixb = createRandomPix(300, 200, new Random(2));
+
+        // Ensure that the results do not depend on the number of threads.
+        MorphApp.setNumThreads(1);
+        Pix tophat1 = MorphApp.pixTophat(pixg, 15, 15, MorphApp.L_TOPHAT_BLACK);
+        Pix fast1 = MorphApp.pixFastTophat(pixg, 2, 2, MorphApp.L_TOPHAT_WHITE);
+        MorphApp.setNumThreads(4);
+        Pix tophat4 = MorphApp.pixTophat(pixg, 15, 15, MorphApp.L_TOPHAT_BLACK);
+        Pix fast4 = MorphApp.pixFastTophat(pixg, 2, 2, MorphApp.L_TOPHAT_WHITE);
+        for (int type : MORPH_TYPES) {
+            assertMorphBrickMatchesReference(pixb, 9, 70, type);
+        }
+        MorphApp.setNumThreads(1);
+
+        assertEquals(1.0f, TestUtils.comparePix(tophat1, tophat4));
+        assertEquals(1.0f, TestUtils.comparePix(fast1, fast4));
+
+        pixs.recycle();
+        pixg.recycle();
+        pixb.recycle();
+        tophat1.recycle();
+        tophat4.recycle();
+        fast1.recycle();
+        fast4.recycle();
+    }
+
+    private static void assertMorphBrickMatchesReference(Pix pixs, int hsize, int vsize, int type) {
+        int width = pixs.getWidth();
+        int height = pixs.getHeight();
+        boolean[][] src = new boolean[height][width];
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                src[y][x] = pixs.getPixel(x, y) == Color.WHITE;
+            }
+        }
+
+        boolean[][] expected;
+        switch (type) {
+            case MorphApp.L_MORPH_DILATE:
+                expected = dilate(src, hsize, vsize);
+                break;
+            case MorphApp.L_MORPH_ERODE:
+                expected = erode(src, hsize, vsize);
+                break;
+            case MorphApp.L_MORPH_OPEN:
+                expected = dilate(erode(src, hsize, vsize), hsize, vsize);
+                break;
+            default:
+                expected = erode(dilate(src, hsize, vsize), hsize, vsize);
+                break;
+        }
+
+        Pix brick = MorphApp.pixMorphBrick(pixs, hsize, vsize, type);
+        int wrong = 0;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if ((brick.getPixel(x, y) == Color.WHITE) != expected[y][x]) {
+                    wrong++;
+                }
+            }
+        }
+        brick.recycle();
+
+        assertEquals("Wrong pixels for " + width + "x" + height + " image, "
+                + hsize + "x" + vsize + " Sel, type " + type, 0, wrong);
+    }
+
+    // Dilates by an hsize x vsize brick with its origin at (hsize / 2,
+    // vsize / 2), taking pixels outside the image to be OFF, as pixDilate()
+    // does with the default boundary condition.
+    private static boolean[][] dilate(boolean[][] src, int hsize, int vsize) {
+        int height = src.length;
+        int width = src[0].length;
+        boolean[][] dst = new boolean[height][width];
+
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                for (int i = 0; i < vsize && !dst[y][x]; i++) {
+                    for (int j = 0; j < hsize && !dst[y][x]; j++) {
+                        dst[y][x] = isOn(src, x - j + hsize / 2, y - i + vsize / 2);
+                    }
+                }
+            }
+        }
+
+        return dst;
+    }
+
+    // Erodes by the same brick, taking pixels outside the image to be OFF,
+    // as pixErode() does with the default boundary condition.
+    private static boolean[][] erode(boolean[][] src, int hsize, int vsize) {
+        int height = src.length;
+        int width = src[0].length;
+        boolean[][] dst = new boolean[height][width];
+
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                dst[y][x] = true;
+                for (int i = 0; i < vsize && dst[y][x]; i++) {
+                    for (int j = 0; j < hsize && dst[y][x]; j++) {
+                        dst[y][x] = isOn(src, x + j - hsize / 2, y + i - vsize / 2);
+                    }
+                }
+            }
+        }
+
+        return dst;
+    }
+
+    private static boolean isOn(boolean[][] pix, int x, int y) {
+        return y >= 0 && y < pix.length && x >= 0 && x < pix[0].length && pix[y][x];
+    }
+
+    private static Pix createRandomPix(int width, int height, Random random) {
+        Pix pix = new Pix(width, height, 1);
+
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (random.nextInt(3) == 0) {
+                    pix.setPixel(x, y, Color.WHITE);
+                }
+            }
+        }
+
+        return pix;
+    }
+}
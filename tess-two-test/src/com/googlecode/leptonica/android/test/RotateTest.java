@@ -113,4 +113,63 @@ public class RotateTest extends TestCase {
         assertTrue("Rotated width is not 100.", (pixd.getWidth() == 100));
         pixd.recycle();
     }
-}
\ No newline at end of file
+
+    @SmallTest
+    public void testSetNumThreads() {
+        Bitmap bmp = Bitmap.createBitmap(100, 100, Bitmap.Config.ARGB_8888);
+        Canvas canvas = new Canvas(bmp);
+        Paint paint = new Paint();
+
+        // Paint the background white
+        canvas.drawColor(Color.WHITE);
+
+        // Paint a black square off the center
+        paint.setColor(Color.BLACK);
+        paint.setStyle(Style.FILL);
+        canvas.drawRect(20, 30, 60, 50, paint);
+
+        Pix pixs = ReadFile.readBitmap(bmp);
+        bmp.recycle();
+
+        // Ensure that the square is rotated correctly with either number
+        // of threads, with and without high-quality rotation.
+        for (int numThreads : new int[] { 1, 4 }) {
+            Rotate.setNumThreads(numThreads);
+            assertRotatedRect(pixs, 7, true);
+            assertRotatedRect(pixs, 7, false);
+        }
+        Rotate.setNumThreads(1);
+
+        pixs.recycle();
+    }
+
+    /**
+     * Checks the pixels of a 100x100 image with a black rectangle at
+     * (20, 30)-(60, 50), rotated about its center. Pixels that come from
+     * well inside the rectangle must be black, and those that come from
+     * well outside it must be white. Pixels near its edges are not checked.
+     */
+    private static void assertRotatedRect(Pix pixs, float degrees, boolean quality) {
+        Pix pixd = Rotate.rotate(pixs, degrees, quality, false);
+        double cos = Math.cos(Math.toRadians(degrees));
+        double sin = Math.sin(Math.toRadians(degrees));
+
+        assertNotNull(pixd);
+
+        for (int y = 0; y < pixd.getHeight(); y++) {
+            for (int x = 0; x < pixd.getWidth(); x++) {
+                double sx = 50 + (x - 50) * cos + (y - 50) * sin;
+                double sy = 50 + (y - 50) * cos - (x - 50) * sin;
+                int rgb = pixd.getPixel(x, y) & 0xffffff;
+
+                if (sx >= 22 && sx <= 58 && sy >= 32 && sy <= 48) {
+                    assertEquals("Pixel " + x + "," + y + " is not black", 0, rgb);
+                } else if (sx < 18 || sx > 62 || sy < 28 || sy > 52) {
+                    assertEquals("Pixel " + x + "," + y + " is not white", 0xffffff, rgb);
+                }
+            }
+        }
+
+        pixd.recycle();
+    }
+}
@@ -17,6 +17,7 @@
 package com.googlecode.leptonica.android.test;
 
 import android.graphics.Bitmap;
+import android.graphics.Color;
 import android.test.suitebuilder.annotation.SmallTest;
 
 import com.googlecode.leptonica.android.Pix;
@@ -38,6 +39,13 @@ public class ScaleTest extends TestCase {
         testScaleGeneral(640, 480, 0.5f);
     }
 
+    @SmallTest
+    public void testScaleUniform() {
+        testScaleUniform(641, 479, 0.3f);
+        testScaleUniform(641, 479, 0.5f);
+        testScaleUniform(641, 479, 1.7f);
+    }
+
     private void testScale(int inputWidth, int inputHeight, float scaleX, float scaleY) {
         Bitmap bmp = Bitmap.createBitmap(inputWidth, inputHeight, Bitmap.Config.ARGB_8888);
         Pix pixs = ReadFile.readBitmap(bmp);
@@ -63,4 +71,25 @@ public class ScaleTest extends TestCase {
         pixs.recycle();
         pixd.recycle();
     }
+
+    private void testScaleUniform(int inputWidth, int inputHeight, float scale) {
+        int color = Color.rgb(200, 120, 40);
+        Bitmap bmp = Bitmap.createBitmap(inputWidth, inputHeight, Bitmap.Config.ARGB_8888);
+        bmp.eraseColor(color);
+        Pix pixs = ReadFile.readBitmap(bmp);
+        Pix pixd = Scale.scaleWithoutSharpening(pixs, scale);
+
+        int[][] points = { { 0, 0 }, { pixd.getWidth() / 2, pixd.getHeight() / 2 },
+                { pixd.getWidth() - 1, pixd.getHeight() - 1 } };
+        for (int[] point : points) {
+            int pixel = pixd.getPixel(point[0], point[1]);
+            assertEquals(Color.red(color), Color.red(pixel));
+            assertEquals(Color.green(color), Color.green(pixel));
+            assertEquals(Color.blue(color), Color.blue(pixel));
+        }
+
+        bmp.recycle();
+        pixs.recycle();
+        pixd.recycle();
+    }
 }
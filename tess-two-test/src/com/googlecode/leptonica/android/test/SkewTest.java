@@ -42,7 +42,39 @@ public class SkewTest extends TestCase {
         testFindSkew(SENTENCE, 640, 480, 15.0f);
     }
 
+    @SmallTest
+    public void testSetNumThreads() {
+        float skew = 5.0f;
+        Pix pixd = createSkewedText(SENTENCE, 640, 480, skew);
+
+        // Ensure that the skew is still found with several threads, and
+        // that the result does not depend on the number of threads.
+        Skew.setNumThreads(1);
+        float skew1 = -Skew.findSkew(pixd);
+        Skew.setNumThreads(4);
+        float skew4 = -Skew.findSkew(pixd);
+        Skew.setNumThreads(1);
+
+        float tol = 1f;
+        boolean isInRange = skew - tol < skew4 && skew4 < skew + tol;
+        assertTrue("Skew has incorrect value: " + skew4, isInRange);
+        assertEquals(skew1, skew4);
+
+        pixd.recycle();
+    }
+
     private void testFindSkew(String text, int width, int height, float skew) {
+        Pix pixd = createSkewedText(text, width, height, skew);
+
+        float measuredSkew = -Skew.findSkew(pixd);
+        float tol = 1f;
+        boolean isInRange = skew - tol < measuredSkew && measuredSkew < skew + tol;
+        assertTrue("Skew has incorrect value.", isInRange);
+
+        pixd.recycle();
+    }
+
+    private Pix createSkewedText(String text, int width, int height, float skew) {
         Bitmap bmp = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888);
         Paint paint = new Paint();
         Canvas canvas = new Canvas(bmp);
@@ -71,13 +103,9 @@ public class SkewTest extends TestCase {
             pixd = GrayQuant.pixThresholdToBinary(pixs, 1);
         }
 
-        float measuredSkew = -Skew.findSkew(pixd);
-        float tol = 1f;
-        boolean isInRange = skew - tol < measuredSkew && measuredSkew < skew + tol;
-        assertTrue("Skew has incorrect value.", isInRange);
-
         pixs.recycle();
-        pixd.recycle();
         bmp.recycle();
+
+        return pixd;
     }
 }
@@ -31,19 +31,26 @@ import android.test.suitebuilder.annotation.SmallTest;
 import android.text.Html;
 import android.util.Pair;
 
+import com.googlecode.leptonica.android.Box;
+import com.googlecode.leptonica.android.Constants;
 import com.googlecode.leptonica.android.Pix;
 import com.googlecode.leptonica.android.Pixa;
+import com.googlecode.leptonica.android.ReadFile;
 import com.googlecode.tesseract.android.ResultIterator;
 import com.googlecode.tesseract.android.TessBaseAPI;
+import com.googlecode.tesseract.android.TessBaseAPI.JobListener;
+import com.googlecode.tesseract.android.TessBaseAPI.JobResult;
 import com.googlecode.tesseract.android.TessBaseAPI.PageIteratorLevel;
 import com.googlecode.tesseract.android.TessBaseAPI.ProgressNotifier;
 import com.googlecode.tesseract.android.TessBaseAPI.ProgressValues;
+import com.googlecode.tesseract.android.TessBaseAPI.RegionText;
 
 import junit.framework.TestCase;
 
 import java.io.File;
 import java.io.FileOutputStream;
 import java.io.IOException;
+import java.io.RandomAccessFile;
 import java.util.List;
 import java.util.concurrent.Semaphore;
 
@@ -302,6 +309,120 @@ public class TessBaseAPITest extends TestCase {
         baseApi.end();
     }
 
+    @SmallTest
+    public void testGetResults() {
+        final String inputText = "hello world\nsecond line";
+        final Bitmap bmp = getTextImage(inputText, 640, 480);
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+
+        baseApi.setPageSegMode(DEFAULT_PAGE_SEG_MODE);
+        baseApi.setImage(bmp);
+        String recognizedText = baseApi.getUTF8Text();
+        assertTrue("No recognized text found.", recognizedText != null && !recognizedText.equals(""));
+
+        // Ensure that the bulk results match a word-by-word iteration.
+        ResultIterator iterator = baseApi.getResultIterator();
+        ResultIterator.Results results = iterator.getResults(PageIteratorLevel.RIL_WORD);
+        assertTrue(results.size() > 0);
+        iterator.begin();
+        int index = 0;
+        do {
+            String word = iterator.getUTF8Text(PageIteratorLevel.RIL_WORD);
+            if (word == null || word.isEmpty())
+                continue;
+            assertTrue(index < results.size());
+            assertEquals(word, results.getUTF8Text(index));
+            assertEquals(iterator.confidence(PageIteratorLevel.RIL_WORD),
+                    results.getConfidence(index), 0.001f);
+            assertEquals(iterator.getBoundingRect(PageIteratorLevel.RIL_WORD),
+                    results.getBoundingRect(index));
+            assertEquals(iterator.isAtBeginningOf(PageIteratorLevel.RIL_TEXTLINE),
+                    results.isAtBeginningOf(index, PageIteratorLevel.RIL_TEXTLINE));
+            index++;
+        } while (iterator.next(PageIteratorLevel.RIL_WORD));
+        assertEquals(index, results.size());
+        assertTrue(results.isAtBeginningOf(0, PageIteratorLevel.RIL_TEXTLINE));
+        iterator.delete();
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        bmp.recycle();
+    }
+
+    @SmallTest
+    public void testGetTextOutputs() {
+        final String inputText = "hello";
+        final Bitmap bmp = getTextImage(inputText, 640, 480);
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+
+        baseApi.setPageSegMode(TessBaseAPI.PageSegMode.PSM_SINGLE_LINE);
+        baseApi.setImage(bmp);
+
+        // Request several formats at once.
+        final String[] outputs = baseApi.getTextOutputs(0,
+                TessBaseAPI.TextOutputFormat.HOCR,
+                TessBaseAPI.TextOutputFormat.UTF8,
+                TessBaseAPI.TextOutputFormat.BOX);
+        assertNotNull("Text outputs not found.", outputs);
+        assertEquals(3, outputs.length);
+
+        // Ensure each output matches its individual getter.
+        assertEquals(baseApi.getHOCRText(0), outputs[0]);
+        assertEquals(baseApi.getUTF8Text(), outputs[1]);
+        assertEquals(baseApi.getBoxText(0), outputs[2]);
+        assertEquals(inputText, outputs[1].trim());
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        bmp.recycle();
+    }
+
+    @SmallTest
+    public void testGetTextOutputs_imageBlock() {
+        final Bitmap bmp = getTextImage("hello world\n\nthe quick brown fox", 640, 480);
+
+        // Paint a picture above the text, so that the page starts with an
+        // image block, which has an empty word and no paragraph text.
+        final Canvas canvas = new Canvas(bmp);
+        final Paint paint = new Paint();
+        for (int x = 20; x < 620; x += 4) {
+            paint.setColor(Color.rgb(x % 256, (3 * x) % 256, 128));
+            canvas.drawRect(x, 20, x + 4, 140, paint);
+        }
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+
+        baseApi.setPageSegMode(TessBaseAPI.PageSegMode.PSM_AUTO);
+        baseApi.setImage(bmp);
+
+        // Ensure that the text matches GetUTF8Text, alone and with hOCR.
+        final String text = baseApi.getUTF8Text();
+        assertTrue(text.contains("fox"));
+        String[] outputs = baseApi.getTextOutputs(0,
+                TessBaseAPI.TextOutputFormat.UTF8);
+        assertEquals(text, outputs[0]);
+        outputs = baseApi.getTextOutputs(0,
+                TessBaseAPI.TextOutputFormat.UTF8,
+                TessBaseAPI.TextOutputFormat.HOCR);
+        assertEquals(text, outputs[0]);
+        assertEquals(baseApi.getHOCRText(0), outputs[1]);
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        bmp.recycle();
+    }
+
     @SmallTest
     public void testGetThresholdedImage() {
         // Attempt to initialize the API.
@@ -325,6 +446,50 @@ public class TessBaseAPITest extends TestCase {
         pixd.recycle();
     }
 
+    @SmallTest
+    public void testRecognizeRegions() {
+        final Bitmap bmp = getTextImage("hello\n\n\n\nworld", 640, 480);
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+        baseApi.setImage(bmp);
+
+        // Make a region around each line of text, as a text detector would.
+        final Pixa regions = Pixa.createPixa(2, bmp.getWidth(), bmp.getHeight());
+        final Box[] boxes = { new Box(0, 140, 640, 90), new Box(0, 250, 640, 90) };
+        for (Box box : boxes) {
+            Pix pix = new Pix(box.getWidth(), box.getHeight(), 1);
+            regions.add(pix, box, Constants.L_COPY);
+            pix.recycle();
+            box.recycle();
+        }
+        final float[] regionConfidences = { 0.2f, 0.9f };
+
+        // Ensure both regions are recognized and reported in region order.
+        List<RegionText> results = baseApi.recognizeRegions(regions, regionConfidences, 0, 0);
+        assertNotNull("Region results not found.", results);
+        assertEquals(2, results.size());
+        assertEquals(0, results.get(0).getIndex());
+        assertEquals("hello", results.get(0).getText());
+        assertEquals(1, results.get(1).getIndex());
+        assertEquals("world", results.get(1).getText());
+        assertEquals(new Rect(0, 250, 640, 340), results.get(1).getRect());
+
+        // Ensure only the most confident region is recognized within the limit.
+        results = baseApi.recognizeRegions(regions, regionConfidences, 1, 0);
+        assertNotNull("Region results not found.", results);
+        assertEquals(1, results.size());
+        assertEquals(1, results.get(0).getIndex());
+        assertEquals("world", results.get(0).getText());
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        regions.recycle();
+        bmp.recycle();
+    }
+
     //    @SmallTest
     //    public void testGetUTF8Text_combined() {
     //        checkCubeData();
@@ -475,6 +640,98 @@ public class TessBaseAPITest extends TestCase {
         bmp.recycle();
     }
 
+    @SmallTest
+    public void testProgressValues_eventBuffer() {
+        final String inputText = "hello";
+        final Bitmap bmp = getTextImage(inputText, 640, 480);
+        final Rect imageBounds = new Rect(0, 0, bmp.getWidth(), bmp.getHeight());
+
+        class Notifier implements ProgressNotifier {
+            public boolean receivedProgress = false;
+
+            @Override
+            public void onProgressValues(ProgressValues progressValues) {
+                receivedProgress = true;
+            }
+        }
+
+        final Notifier notifier = new Notifier();
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI(notifier);
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+
+        assertTrue(baseApi.setProgressEventBuffer(64));
+        assertTrue(baseApi.pollProgressValues().isEmpty());
+
+        baseApi.setPageSegMode(TessBaseAPI.PageSegMode.PSM_SINGLE_LINE);
+        baseApi.setImage(bmp);
+        baseApi.getHOCRText(0);
+
+        // Ensure that progress went to the buffer instead of the notifier.
+        assertFalse(notifier.receivedProgress);
+        List<ProgressValues> values = baseApi.pollProgressValues();
+        assertFalse(values.isEmpty());
+        int lastPercent = 0;
+        for (ProgressValues progressValues : values) {
+            testProgressValues(progressValues, imageBounds);
+            assertTrue(progressValues.getPercent() >= lastPercent);
+            lastPercent = progressValues.getPercent();
+        }
+
+        // Ensure that values are only returned once.
+        assertTrue(baseApi.pollProgressValues().isEmpty());
+
+        // Ensure that disabling the buffer restores notifier callbacks.
+        assertTrue(baseApi.setProgressEventBuffer(0));
+        baseApi.setImage(bmp);
+        baseApi.getHOCRText(0);
+        assertTrue(notifier.receivedProgress);
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        bmp.recycle();
+    }
+
+    @SmallTest
+    public void testProgressValues_interval() {
+        final String inputText = "the quick brown fox jumps";
+        final Bitmap bmp = getTextImage(inputText, 640, 480);
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+
+        assertTrue(baseApi.setProgressEventBuffer(256));
+        baseApi.setPageSegMode(TessBaseAPI.PageSegMode.PSM_SINGLE_LINE);
+
+        // Report every update.
+        baseApi.setProgressInterval(0);
+        baseApi.setImage(bmp);
+        baseApi.getHOCRText(0);
+        List<ProgressValues> all = baseApi.pollProgressValues();
+
+        // With an interval much longer than recognition takes, only the
+        // first update and the last one are reported.
+        baseApi.setProgressInterval(3600 * 1000);
+        baseApi.setImage(bmp);
+        baseApi.getHOCRText(0);
+        List<ProgressValues> throttled = baseApi.pollProgressValues();
+
+        assertTrue(all.size() > 2);
+        assertEquals(2, throttled.size());
+        ProgressValues last = all.get(all.size() - 1);
+        ProgressValues lastThrottled = throttled.get(throttled.size() - 1);
+        assertEquals(last.getPercent(), lastThrottled.getPercent());
+        assertEquals(last.getCurrentWordRect(), lastThrottled.getCurrentWordRect());
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        bmp.recycle();
+    }
+
     @SmallTest
     public void testProgressValues_setRectangle() {
         class Notifier implements ProgressNotifier {
@@ -575,6 +832,89 @@ public class TessBaseAPITest extends TestCase {
         assertTrue(textRect.contains(absoluteWordRect));
     }
 
+    @SmallTest
+    public void testSaveAdaptiveClassifier() throws IOException {
+        final String inputText = "hello";
+        final Bitmap bmp = getTextImage(inputText, 640, 480);
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+
+        // Recognize a page so that the adaptive classifier learns something.
+        baseApi.setPageSegMode(TessBaseAPI.PageSegMode.PSM_SINGLE_LINE);
+        baseApi.setImage(bmp);
+        baseApi.getUTF8Text();
+
+        // Ensure that the adaptive data can be saved and loaded back.
+        File file = File.createTempFile("testSaveAdaptiveClassifier", ".a");
+        assertTrue("Failed to save adaptive classifier.",
+                baseApi.saveAdaptiveClassifier(file.getPath()));
+        baseApi.clear();
+        assertTrue("Failed to load adaptive classifier.",
+                baseApi.loadAdaptiveClassifier(file.getPath()));
+
+        // Ensure that recognition still works with the loaded classifier.
+        baseApi.setImage(bmp);
+        final String outputText = baseApi.getUTF8Text();
+        assertEquals("\"" + outputText + "\" != \"" + inputText + "\"", inputText, outputText);
+
+        // Ensure that a file that is not adaptive data is rejected.
+        FileOutputStream fileStream = new FileOutputStream(file);
+        fileStream.write(new byte[] { 1, 2, 3, 4, 5, 6, 7, 8 });
+        fileStream.close();
+        assertFalse("Loaded an invalid adaptive classifier file.",
+                baseApi.loadAdaptiveClassifier(file.getPath()));
+        file.delete();
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        bmp.recycle();
+    }
+
+    @SmallTest
+    public void testLoadAdaptiveClassifier_truncated() throws IOException {
+        final String inputText = "hello";
+        final Bitmap bmp = getTextImage(inputText, 640, 480);
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+
+        // Recognize a page so that the adaptive classifier learns something.
+        baseApi.setPageSegMode(TessBaseAPI.PageSegMode.PSM_SINGLE_LINE);
+        baseApi.setImage(bmp);
+        baseApi.getUTF8Text();
+
+        File file = File.createTempFile("testLoadAdaptiveClassifier", ".a");
+        assertTrue("Failed to save adaptive classifier.",
+                baseApi.saveAdaptiveClassifier(file.getPath()));
+
+        // Ensure that a file cut short anywhere is rejected.
+        final long length = file.length();
+        final long[] truncatedLengths = { 4, 20, length / 2, length - 1 };
+        for (long truncatedLength : truncatedLengths) {
+            RandomAccessFile truncated = new RandomAccessFile(file, "rw");
+            truncated.setLength(truncatedLength);
+            truncated.close();
+            assertFalse("Loaded adaptive classifier truncated to "
+                    + truncatedLength + " bytes.",
+                    baseApi.loadAdaptiveClassifier(file.getPath()));
+        }
+        file.delete();
+
+        // Ensure that recognition still works with the current classifier.
+        baseApi.setImage(bmp);
+        final String outputText = baseApi.getUTF8Text();
+        assertEquals("\"" + outputText + "\" != \"" + inputText + "\"", inputText, outputText);
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        bmp.recycle();
+    }
+
     @SmallTest
     public void testSetImage_bitmap() {
         // Attempt to initialize the API.
@@ -774,6 +1114,134 @@ public class TessBaseAPITest extends TestCase {
         bmp.recycle();
     }
 
+    @SmallTest
+    public void testSubmitJob() throws InterruptedException {
+        final String inputText = "hello";
+        final Bitmap bmp = getTextImage(inputText, 640, 480);
+        final Pix pix = ReadFile.readBitmap(bmp);
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+
+        // Poll for the result of a job.
+        success = baseApi.startJobs(4, 1, null);
+        assertTrue(success);
+        long jobId = baseApi.submitJob(pix, null, TessBaseAPI.PageSegMode.PSM_SINGLE_LINE,
+                TessBaseAPI.TextOutputFormat.UTF8);
+        assertTrue(jobId != 0);
+
+        JobResult result;
+        while ((result = baseApi.takeJobResult(jobId)) == null) {
+            Thread.sleep(10);
+        }
+        assertEquals(jobId, result.getJobId());
+        assertEquals(TessBaseAPI.JobStatus.DONE, result.getStatus());
+        assertEquals(inputText,
+                result.getOutput(TessBaseAPI.TextOutputFormat.UTF8).trim());
+        assertEquals(TessBaseAPI.JobStatus.UNKNOWN, baseApi.getJobStatus(jobId));
+
+        baseApi.stopJobs();
+
+        // Have the results delivered to a listener instead. The listener
+        // holds up the only engine on the first result, so that the next job
+        // is still queued when it is cancelled.
+        final Semaphore resultSem = new Semaphore(0);
+        final Semaphore listenerGate = new Semaphore(0);
+        final JobResult[] delivered = new JobResult[2];
+        final boolean[] stopRejected = new boolean[1];
+        success = baseApi.startJobs(4, 1, new JobListener() {
+            private int count = 0;
+
+            @Override
+            public void onJobFinished(JobResult jobResult) {
+                delivered[count++] = jobResult;
+                if (count == 1) {
+                    resultSem.release();
+                    listenerGate.acquireUninterruptibly();
+                } else {
+                    // Ensure that jobs cannot be stopped from the listener.
+                    try {
+                        baseApi.stopJobs();
+                    } catch (IllegalStateException e) {
+                        stopRejected[0] = true;
+                    }
+                    resultSem.release();
+                }
+            }
+        });
+        assertTrue(success);
+
+        // Ensure that starting jobs again fails and keeps the listener.
+        assertFalse(baseApi.startJobs(4, 1, null));
+
+        jobId = baseApi.submitJob(pix, null, TessBaseAPI.PageSegMode.PSM_SINGLE_LINE,
+                TessBaseAPI.TextOutputFormat.UTF8);
+        resultSem.acquire();
+        assertEquals(jobId, delivered[0].getJobId());
+        assertEquals(TessBaseAPI.JobStatus.DONE, delivered[0].getStatus());
+        assertEquals(inputText,
+                delivered[0].getOutput(TessBaseAPI.TextOutputFormat.UTF8).trim());
+
+        // Ensure a cancelled job produces no text.
+        jobId = baseApi.submitJob(pix, null, TessBaseAPI.PageSegMode.PSM_SINGLE_LINE,
+                TessBaseAPI.TextOutputFormat.UTF8);
+        assertTrue(jobId != 0);
+        assertTrue(baseApi.cancelJob(jobId));
+        listenerGate.release();
+        resultSem.acquire();
+        assertEquals(jobId, delivered[1].getJobId());
+        assertEquals(TessBaseAPI.JobStatus.CANCELLED, delivered[1].getStatus());
+        assertNull(delivered[1].getOutput(TessBaseAPI.TextOutputFormat.UTF8));
+        assertTrue("Jobs were stopped from the listener.", stopRejected[0]);
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        pix.recycle();
+        bmp.recycle();
+    }
+
+    @SmallTest
+    public void testSubmitJob_variables() throws InterruptedException {
+        final String inputText = "hello";
+        final Bitmap bmp = getTextImage(inputText, 640, 480);
+        final Pix pix = ReadFile.readBitmap(bmp);
+
+        // Attempt to initialize the API.
+        final TessBaseAPI baseApi = new TessBaseAPI();
+        boolean success = baseApi.init(TESSBASE_PATH, DEFAULT_LANGUAGE);
+        assertTrue(success);
+        baseApi.setVariable(TessBaseAPI.VAR_CHAR_BLACKLIST, "l");
+
+        // Ensure that every engine recognizes with the variable set.
+        final int numJobs = 8;
+        success = baseApi.startJobs(numJobs, 4, null);
+        assertTrue(success);
+        long[] jobIds = new long[numJobs];
+        for (int i = 0; i < numJobs; i++) {
+            jobIds[i] = baseApi.submitJob(pix, null,
+                    TessBaseAPI.PageSegMode.PSM_SINGLE_LINE,
+                    TessBaseAPI.TextOutputFormat.UTF8);
+            assertTrue(jobIds[i] != 0);
+        }
+        for (long jobId : jobIds) {
+            JobResult result;
+            while ((result = baseApi.takeJobResult(jobId)) == null) {
+                Thread.sleep(10);
+            }
+            assertEquals(TessBaseAPI.JobStatus.DONE, result.getStatus());
+            final String outputText = result.getOutput(TessBaseAPI.TextOutputFormat.UTF8);
+            assertFalse("Found blacklisted character in \"" + outputText + "\"",
+                    outputText.contains("l"));
+        }
+
+        // Attempt to shut down the API.
+        baseApi.end();
+        pix.recycle();
+        bmp.recycle();
+    }
+
     @SmallTest
     public void testWordConfidences() {
         final String inputText = "one two three";
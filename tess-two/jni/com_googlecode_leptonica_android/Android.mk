@@ -18,7 +18,8 @@ LOCAL_SRC_FILES := \
   $(filter-out $(BLACKLIST_SRC_FILES),$(LEPTONICA_SRC_FILES))
 
 LOCAL_CFLAGS := \
-  -DHAVE_CONFIG_H
+  -DHAVE_CONFIG_H \
+  -DHAVE_PTHREAD
 
 LOCAL_LDLIBS := \
   -lz
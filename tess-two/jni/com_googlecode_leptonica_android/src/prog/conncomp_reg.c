@@ -30,16 +30,22 @@
  *      Regression test for connected components (both 4 and 8
  *      connected), including regeneration of the original
  *      image from the components.  This is also an implicit
- *      test of rasterop.
+ *      test of rasterop.  The boxes, images and pixel counts from
+ *      pixConnCompRuns() are checked against a seedfill of each c.c.
  */
 
 #include "allheaders.h"
 
+static void TestConnCompRuns(L_REGPARAMS *rp, PIX *pixs,
+                             l_int32 connectivity);
+static BOXA *ConnCompBySeedfill(PIX *pixs, l_int32 connectivity,
+                                PIXA **ppixa, NUMA **pna);
+
 int main(int    argc,
          char **argv)
 {
 l_uint8      *array1, *array2;
-l_int32       n1, n2, n3;
+l_int32       i, j, n1, n2, n3;
 size_t        size1, size2;
 FILE         *fp;
 BOXA         *boxa1, *boxa2;
@@ -133,8 +139,112 @@ L_REGPARAMS  *rp;
     pixDestroy(&pix1);
     pixaDestroy(&pixa1);
 
+
+    /* --------------------------------------------------------------- *
+     *     Test pixConnCompRuns() against a seedfill of each c.c.,     *
+     *     on the text image and on random noise, whose odd width      *
+     *     puts c.c. across every word boundary                        *
+     * --------------------------------------------------------------- */
+    TestConnCompRuns(rp, pixs, 4);  /* 12 - 15 */
+    TestConnCompRuns(rp, pixs, 8);  /* 16 - 19 */
+    pix1 = pixCreate(173, 91, 1);
+    srand(31415);
+    for (i = 0; i < 91; i++) {
+        for (j = 0; j < 173; j++) {
+            if (rand() % 5 < 2)
+                pixSetPixel(pix1, j, i, 1);
+        }
+    }
+    TestConnCompRuns(rp, pix1, 4);  /* 20 - 23 */
+    TestConnCompRuns(rp, pix1, 8);  /* 24 - 27 */
+    pixDestroy(&pix1);
+
     pixDestroy(&pixs);
     return regTestCleanup(rp);
 }
 
 
+    /* Compares the boxa, pixa and pixel counts from pixConnCompRuns()
+     * with those found by seedfill. */
+static void
+TestConnCompRuns(L_REGPARAMS  *rp,
+                 PIX          *pixs,
+                 l_int32       connectivity)
+{
+l_int32  same;
+BOXA    *boxa1, *boxa2;
+NUMA    *na1, *na2;
+PIXA    *pixa1, *pixa2;
+
+    boxa1 = pixConnCompRuns(pixs, &pixa1, &na1, connectivity);
+    boxa2 = ConnCompBySeedfill(pixs, connectivity, &pixa2, &na2);
+    fprintf(stderr, "Number of %d c.c. by runs: %d; by seedfill: %d\n",
+            connectivity, boxaGetCount(boxa1), boxaGetCount(boxa2));
+    regTestCompareValues(rp, boxaGetCount(boxa2), boxaGetCount(boxa1), 0);
+    boxaEqual(boxa1, boxa2, 0, NULL, &same);
+    regTestCompareValues(rp, 1, same, 0);
+    pixaEqual(pixa1, pixa2, 0, NULL, &same);
+    regTestCompareValues(rp, 1, same, 0);
+    numaSimilar(na1, na2, 0.0, &same);
+    regTestCompareValues(rp, 1, same, 0);
+    boxaDestroy(&boxa1);
+    boxaDestroy(&boxa2);
+    pixaDestroy(&pixa1);
+    pixaDestroy(&pixa2);
+    numaDestroy(&na1);
+    numaDestroy(&na2);
+}
+
+
+    /* Finds each c.c. in raster order by erasing it with a seedfill,
+     * as pixConnCompPixa() did before it used runs.  The image of the
+     * c.c. is what the seedfill removed. */
+static BOXA *
+ConnCompBySeedfill(PIX      *pixs,
+                   l_int32   connectivity,
+                   PIXA    **ppixa,
+                   NUMA    **pna)
+{
+l_int32   x, y, xstart, ystart, count;
+BOX      *box;
+BOXA     *boxa;
+L_STACK  *stack;
+NUMA     *na;
+PIX      *pix1, *pix2, *pix3, *pix4;
+PIXA     *pixa;
+
+    pix1 = pixCopy(NULL, pixs);
+    pix2 = pixCopy(NULL, pixs);
+    stack = lstackCreate(pixGetHeight(pixs));
+    stack->auxstack = lstackCreate(0);
+    boxa = boxaCreate(0);
+    pixa = pixaCreate(0);
+    na = numaCreate(0);
+    xstart = ystart = 0;
+    while (nextOnPixelInRaster(pix1, xstart, ystart, &x, &y)) {
+        box = pixSeedfillBB(pix1, stack, x, y, connectivity);
+        pix3 = pixClipRectangle(pix1, box, NULL);
+        pix4 = pixClipRectangle(pix2, box, NULL);
+        pixXor(pix3, pix3, pix4);
+        pixRasterop(pix2, box->x, box->y, box->w, box->h, PIX_SRC ^ PIX_DST,
+                    pix3, 0, 0);
+        pixCountPixels(pix3, &count, NULL);
+        numaAddNumber(na, count);
+        pixaAddPix(pixa, pix3, L_INSERT);
+        boxaAddBox(boxa, box, L_INSERT);
+        pixDestroy(&pix4);
+        xstart = x;
+        ystart = y;
+    }
+    boxaDestroy(&pixa->boxa);
+    pixa->boxa = boxaCopy(boxa, L_COPY);
+
+    lstackDestroy(&stack, TRUE);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    *ppixa = pixa;
+    *pna = na;
+    return boxa;
+}
+
+
@@ -55,6 +55,9 @@
  *      Thresholding using connected components
  *          PIX       *pixThresholdByConnComp()
  *
+ *      Threads used for tiled binarization
+ *          void       l_binarizeSetNumThreads()
+ *
  *  Notes:
  *      (1) pixOtsuAdaptiveThreshold() computes a global threshold over each
  *          tile and performs the threshold operation, resulting in a
@@ -72,11 +75,92 @@
  *          components at different thresholding to determine if a
  *          global threshold can be used (for text or line-art) and the
  *          value it should have.
+ *      (5) When built with HAVE_PTHREAD, the tiles of
+ *          pixOtsuAdaptiveThreshold() and pixSauvolaBinarizeTiled(), and
+ *          bands of rows in pixSauvolaBinarize(), can be processed on
+ *          several threads; see l_binarizeSetNumThreads().  The results
+ *          do not depend on the number of threads.
  * </pre>
  */
 
 #include <math.h>
 #include "allheaders.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define  SAUVOLA_USE_NEON  1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define  SAUVOLA_USE_SSE2  1
+#endif
+
+    /* Number of threads used for the tiles and row bands, or 0 for the
+     * number of processors online; default is 1 */
+static l_int32  var_BINARIZE_THREADS = 1;
+
+    /* Largest window half-width for which pixSauvolaBinarize() computes
+     * the local statistics directly.  The sum of squares in a window of
+     * (2 * 128 + 1)^2 pixels is still less than 2^32. */
+static const l_int32  MAX_DIRECT_SAUVOLA_WHSIZE = 128;
+
+    /* Fewest output rows given to each thread in pixSauvolaBinarize() */
+static const l_int32  MIN_SAUVOLA_BAND_HEIGHT = 32;
+
+    /* Byte index of pixel j within a raster line, for direct access to
+     * the line as an array of bytes; see GET_DATA_BYTE() */
+#ifdef  L_BIG_ENDIAN
+#define  BYTE_INDEX(j)   (j)
+#else  /* L_LITTLE_ENDIAN */
+#define  BYTE_INDEX(j)   ((j) ^ 3)
+#endif  /* L_BIG_ENDIAN */
+
+    /* Shared data for the tile tasks of pixOtsuAdaptiveThreshold() */
+struct OtsuTiles {
+    PIXTILING  *pt;
+    l_int32     nx;
+    l_float32   scorefract;
+    l_int32    *thresh;     /* Otsu threshold of each tile */
+    PIX        *pixth;      /* threshold to apply to each tile */
+    PIX       **tiles;      /* thresholded tiles */
+};
+
+    /* Shared data for the tile tasks of pixSauvolaBinarizeTiled() */
+struct SauvolaTiles {
+    PIXTILING  *pt;
+    l_int32     nx;
+    l_int32     whsize;
+    l_float32   factor;
+    PIX       **tileth;     /* thresholds of each tile, or null */
+    PIX       **tiled;      /* thresholded tiles, or null */
+};
+
+    /* Shared data for the row band tasks of pixSauvolaBinarize() */
+struct SauvolaBands {
+    PIX        *pixg;       /* input with border */
+    l_int32     whsize;
+    l_float32   factor;
+    l_int32     nbands;
+    PIX        *pixth;      /* thresholds, or null */
+    PIX        *pixd;       /* thresholded image, or null */
+};
+
+static void otsuThreshTileTask(void *data, l_int32 index);
+static void otsuBinarizeTileTask(void *data, l_int32 index);
+static void sauvolaTileTask(void *data, l_int32 index);
+static void sauvolaBandTask(void *data, l_int32 index);
+
+static l_int32 pixSauvolaBinarizeThreads(PIX *pixs, l_int32 whsize,
+                                         l_float32 factor, l_int32 addborder,
+                                         PIX **ppixm, PIX **ppixsd,
+                                         PIX **ppixth, PIX **ppixd,
+                                         l_int32 nthreads);
+static void sauvolaBandLow(l_uint32 *datag, l_int32 wplg, l_int32 wd,
+                           l_int32 whsize, l_float32 factor,
+                           l_int32 firstrow, l_int32 lastrow,
+                           l_uint32 *datath, l_int32 wplth,
+                           l_uint32 *datad, l_int32 wpld);
+static void sauvolaUpdateColumnsLow(l_uint32 *colsum, l_uint32 *colsq,
+                                    const l_uint8 *linein,
+                                    const l_uint8 *lineout, l_int32 nbytes);
 
 /*------------------------------------------------------------------*
  *                 Adaptive Otsu-based thresholding                 *
@@ -146,10 +230,10 @@ pixOtsuAdaptiveThreshold(PIX       *pixs,
                          PIX      **ppixth,
                          PIX      **ppixd)
 {
-l_int32     w, h, nx, ny, i, j, thresh;
-l_uint32    val;
-PIX        *pixt, *pixb, *pixthresh, *pixth, *pixd;
-PIXTILING  *pt;
+l_int32           w, h, nx, ny, i, j;
+PIX              *pixthresh, *pixth, *pixd;
+PIXTILING        *pt;
+struct OtsuTiles  ot;
 
     PROCNAME("pixOtsuAdaptiveThreshold");
 
@@ -170,15 +254,16 @@ PIXTILING  *pt;
     smoothy = L_MIN(smoothy, (ny - 1) / 2);
     pt = pixTilingCreate(pixs, nx, ny, 0, 0, 0, 0);
     pixthresh = pixCreate(nx, ny, 8);
+    ot.pt = pt;
+    ot.nx = nx;
+    ot.scorefract = scorefract;
+    ot.thresh = (l_int32 *)LEPT_CALLOC(nx * ny, sizeof(l_int32));
+    l_runTasks(otsuThreshTileTask, &ot, nx * ny, var_BINARIZE_THREADS);
     for (i = 0; i < ny; i++) {
-        for (j = 0; j < nx; j++) {
-            pixt = pixTilingGetTile(pt, i, j);
-            pixSplitDistributionFgBg(pixt, scorefract, 1, &thresh,
-                                     NULL, NULL, NULL);
-            pixSetPixel(pixthresh, j, i, thresh);  /* see note (4) */
-            pixDestroy(&pixt);
-        }
+        for (j = 0; j < nx; j++)  /* see note (4) */
+            pixSetPixel(pixthresh, j, i, ot.thresh[i * nx + j]);
     }
+    LEPT_FREE(ot.thresh);
 
         /* Optionally smooth the threshold array */
     if (smoothx > 0 || smoothy > 0)
@@ -191,16 +276,17 @@ PIXTILING  *pt;
     if (ppixd) {
         pixd = pixCreate(w, h, 1);
         pixCopyResolution(pixd, pixs);
+        ot.pixth = pixth;
+        ot.tiles = (PIX **)LEPT_CALLOC(nx * ny, sizeof(PIX *));
+        l_runTasks(otsuBinarizeTileTask, &ot, nx * ny, var_BINARIZE_THREADS);
+            /* Tiles can share words of pixd, so paint them here */
         for (i = 0; i < ny; i++) {
             for (j = 0; j < nx; j++) {
-                pixt = pixTilingGetTile(pt, i, j);
-                pixGetPixel(pixth, j, i, &val);
-                pixb = pixThresholdToBinary(pixt, val);
-                pixTilingPaintTile(pixd, i, j, pixb, pt);
-                pixDestroy(&pixt);
-                pixDestroy(&pixb);
+                pixTilingPaintTile(pixd, i, j, ot.tiles[i * nx + j], pt);
+                pixDestroy(&ot.tiles[i * nx + j]);
             }
         }
+        LEPT_FREE(ot.tiles);
         *ppixd = pixd;
     }
 
@@ -474,10 +560,10 @@ pixSauvolaBinarizeTiled(PIX       *pixs,
                         PIX      **ppixth,
                         PIX      **ppixd)
 {
-l_int32     i, j, w, h, xrat, yrat;
-PIX        *pixth, *pixd, *tileth, *tiled, *pixt;
-PIX       **ptileth, **ptiled;
-PIXTILING  *pt;
+l_int32              i, j, k, w, h, xrat, yrat;
+PIX                 *pixth, *pixd;
+PIXTILING           *pt;
+struct SauvolaTiles  st;
 
     PROCNAME("pixSauvolaBinarizeTiled");
 
@@ -530,24 +616,30 @@ PIXTILING  *pt;
     pt = pixTilingCreate(pixs, nx, ny, 0, 0, whsize + 1, whsize + 1);
     pixTilingNoStripOnPaint(pt);  /* pixSauvolaBinarize() does the stripping */
 
+        /* Binarize the tiles, possibly in parallel, then paint them here
+         * because neighboring tiles can share words of the outputs. */
+    st.pt = pt;
+    st.nx = nx;
+    st.whsize = whsize;
+    st.factor = factor;
+    st.tileth = (ppixth) ? (PIX **)LEPT_CALLOC(nx * ny, sizeof(PIX *)) : NULL;
+    st.tiled = (ppixd) ? (PIX **)LEPT_CALLOC(nx * ny, sizeof(PIX *)) : NULL;
+    l_runTasks(sauvolaTileTask, &st, nx * ny, var_BINARIZE_THREADS);
     for (i = 0; i < ny; i++) {
         for (j = 0; j < nx; j++) {
-            pixt = pixTilingGetTile(pt, i, j);
-            ptileth = (ppixth) ? &tileth : NULL;
-            ptiled = (ppixd) ? &tiled : NULL;
-            pixSauvolaBinarize(pixt, whsize, factor, 0, NULL, NULL,
-                               ptileth, ptiled);
+            k = i * nx + j;
             if (ppixth) {  /* do not strip */
-                pixTilingPaintTile(pixth, i, j, tileth, pt);
-                pixDestroy(&tileth);
+                pixTilingPaintTile(pixth, i, j, st.tileth[k], pt);
+                pixDestroy(&st.tileth[k]);
             }
             if (ppixd) {
-                pixTilingPaintTile(pixd, i, j, tiled, pt);
-                pixDestroy(&tiled);
+                pixTilingPaintTile(pixd, i, j, st.tiled[k], pt);
+                pixDestroy(&st.tiled[k]);
             }
-            pixDestroy(&pixt);
         }
     }
+    if (st.tileth) LEPT_FREE(st.tileth);
+    if (st.tiled) LEPT_FREE(st.tiled);
 
     pixTilingDestroy(&pt);
     return 0;
@@ -590,6 +682,10 @@ PIXTILING  *pt;
  *          and the larger the variance, the closer to the median
  *          it should be chosen.  Typical values for k are between
  *          0.2 and 0.5.
+ *      (6) If neither the mean nor the standard deviation is requested,
+ *          the local statistics are computed a band of rows at a time,
+ *          without the full-size accumulators, for %whsize up to 128.
+ *          The output is identical.
  * </pre>
  */
 l_int32
@@ -602,10 +698,37 @@ pixSauvolaBinarize(PIX       *pixs,
                    PIX      **ppixth,
                    PIX      **ppixd)
 {
-l_int32  w, h;
-PIX     *pixg, *pixsc, *pixm, *pixms, *pixth, *pixd;
+    return pixSauvolaBinarizeThreads(pixs, whsize, factor, addborder,
+                                     ppixm, ppixsd, ppixth, ppixd,
+                                     var_BINARIZE_THREADS);
+}
+
+
+/*!
+ * \brief   pixSauvolaBinarizeThreads()
+ *
+ * \param[in]    pixs, whsize, factor, addborder   see pixSauvolaBinarize()
+ * \param[out]   ppixm, ppixsd, ppixth, ppixd      see pixSauvolaBinarize()
+ * \param[in]    nthreads max number of threads for the row bands; 0 for
+ *                        the number of processors online
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+pixSauvolaBinarizeThreads(PIX       *pixs,
+                          l_int32    whsize,
+                          l_float32  factor,
+                          l_int32    addborder,
+                          PIX      **ppixm,
+                          PIX      **ppixsd,
+                          PIX      **ppixth,
+                          PIX      **ppixd,
+                          l_int32    nthreads)
+{
+l_int32              w, h, wd, hd;
+PIX                 *pixg, *pixsc, *pixm, *pixms, *pixth, *pixd;
+struct SauvolaBands  sb;
 
-    PROCNAME("pixSauvolaBinarize");
+    PROCNAME("pixSauvolaBinarizeThreads");
 
     if (ppixm) *ppixm = NULL;
     if (ppixsd) *ppixsd = NULL;
@@ -628,13 +751,48 @@ PIX     *pixg, *pixsc, *pixm, *pixms, *pixth, *pixd;
     if (addborder) {
         pixg = pixAddMirroredBorder(pixs, whsize + 1, whsize + 1,
                                     whsize + 1, whsize + 1);
-        pixsc = pixClone(pixs);
     } else {
         pixg = pixClone(pixs);
+    }
+    if (!pixg)
+        return ERROR_INT("pixg not made", procName, 1);
+
+        /* Without the mean and standard deviation outputs, the threshold
+         * can be found directly from the window sums (see note 6). */
+    if (!ppixm && !ppixsd && whsize <= MAX_DIRECT_SAUVOLA_WHSIZE) {
+        wd = pixGetWidth(pixg) - 2 * (whsize + 1);
+        hd = pixGetHeight(pixg) - 2 * (whsize + 1);
+        sb.pixg = pixg;
+        sb.whsize = whsize;
+        sb.factor = factor;
+        if (nthreads > 0) {
+            sb.nbands = L_MIN(nthreads, hd / MIN_SAUVOLA_BAND_HEIGHT);
+        } else {  /* keep the bands well above the window height */
+            sb.nbands = hd / L_MAX(MIN_SAUVOLA_BAND_HEIGHT,
+                                   4 * (2 * whsize + 1));
+        }
+        sb.nbands = L_MAX(1, sb.nbands);
+        sb.pixth = (ppixth) ? pixCreate(wd, hd, 8) : NULL;
+        sb.pixd = (ppixd) ? pixCreate(wd, hd, 1) : NULL;
+        l_runTasks(sauvolaBandTask, &sb, sb.nbands, nthreads);
+        if (ppixth)
+            *ppixth = sb.pixth;
+        if (ppixd) {
+            pixCopyResolution(sb.pixd, pixs);
+            *ppixd = sb.pixd;
+        }
+        pixDestroy(&pixg);
+        return 0;
+    }
+
+    if (addborder)
+        pixsc = pixClone(pixs);
+    else
         pixsc = pixRemoveBorder(pixs, whsize + 1);
+    if (!pixsc) {
+        pixDestroy(&pixg);
+        return ERROR_INT("pixsc not made", procName, 1);
     }
-    if (!pixg || !pixsc)
-        return ERROR_INT("pixg and pixsc not made", procName, 1);
 
         /* All these functions strip off the border pixels. */
     if (ppixm || ppixth || ppixd)
@@ -763,7 +921,7 @@ PIX        *pixsd, *pixd;
         for (j = 0; j < w; j++) {
             mv = GET_DATA_BYTE(linem, j);
             ms = linems[j];
-            var = ms - mv * mv;
+            var = L_MAX(0, ms - mv * mv);  /* rounding can give -1 */
             if (usetab)
                 sd = tab[var];
             else
@@ -1013,3 +1171,320 @@ PIX       *pix1, *pix2, *pix3;
     pixDestroy(&pix2);
     return 1;
 }
+
+
+/*----------------------------------------------------------------------*
+ *                   Threads used for tiled binarization                *
+ *----------------------------------------------------------------------*/
+/*!
+ * \brief   l_binarizeSetNumThreads()
+ *
+ * \param[in]    nthreads max number of threads; use 0 for the number
+ *                        of processors online
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This sets the number of threads used for the tiles of
+ *          pixOtsuAdaptiveThreshold() and pixSauvolaBinarizeTiled(),
+ *          and for bands of rows in pixSauvolaBinarize().  The default
+ *          is 1, which does all the work on the calling thread.
+ *      (2) The tasks are run with l_runTasks(), so this has no effect
+ *          unless leptonica is built with HAVE_PTHREAD.
+ *      (3) The results do not depend on the number of threads.
+ * </pre>
+ */
+void
+l_binarizeSetNumThreads(l_int32  nthreads)
+{
+    var_BINARIZE_THREADS = L_MAX(0, nthreads);
+}
+
+
+/*
+ *  otsuThreshTileTask()
+ *
+ *      Finds the Otsu threshold of tile %index for pixOtsuAdaptiveThreshold().
+ */
+static void
+otsuThreshTileTask(void     *data,
+                   l_int32   index)
+{
+PIX               *pixt;
+struct OtsuTiles  *ot;
+
+    ot = (struct OtsuTiles *)data;
+    pixt = pixTilingGetTile(ot->pt, index / ot->nx, index % ot->nx);
+    pixSplitDistributionFgBg(pixt, ot->scorefract, 1, &ot->thresh[index],
+                             NULL, NULL, NULL);
+    pixDestroy(&pixt);
+}
+
+
+/*
+ *  otsuBinarizeTileTask()
+ *
+ *      Thresholds tile %index for pixOtsuAdaptiveThreshold().
+ */
+static void
+otsuBinarizeTileTask(void     *data,
+                     l_int32   index)
+{
+l_int32            i, j;
+l_uint32           val;
+PIX               *pixt;
+struct OtsuTiles  *ot;
+
+    ot = (struct OtsuTiles *)data;
+    i = index / ot->nx;
+    j = index % ot->nx;
+    pixt = pixTilingGetTile(ot->pt, i, j);
+    pixGetPixel(ot->pixth, j, i, &val);
+    ot->tiles[index] = pixThresholdToBinary(pixt, val);
+    pixDestroy(&pixt);
+}
+
+
+/*
+ *  sauvolaTileTask()
+ *
+ *      Binarizes tile %index for pixSauvolaBinarizeTiled().
+ */
+static void
+sauvolaTileTask(void     *data,
+                l_int32   index)
+{
+PIX                  *pixt;
+struct SauvolaTiles  *st;
+
+    st = (struct SauvolaTiles *)data;
+    pixt = pixTilingGetTile(st->pt, index / st->nx, index % st->nx);
+    pixSauvolaBinarizeThreads(pixt, st->whsize, st->factor, 0, NULL, NULL,
+                              (st->tileth) ? &st->tileth[index] : NULL,
+                              (st->tiled) ? &st->tiled[index] : NULL, 1);
+    pixDestroy(&pixt);
+}
+
+
+/*
+ *  sauvolaBandTask()
+ *
+ *      Binarizes band %index of the rows for pixSauvolaBinarizeThreads().
+ */
+static void
+sauvolaBandTask(void     *data,
+                l_int32   index)
+{
+l_int32               wd, hd;
+struct SauvolaBands  *sb;
+
+    sb = (struct SauvolaBands *)data;
+    wd = pixGetWidth(sb->pixg) - 2 * (sb->whsize + 1);
+    hd = pixGetHeight(sb->pixg) - 2 * (sb->whsize + 1);
+    sauvolaBandLow(pixGetData(sb->pixg), pixGetWpl(sb->pixg), wd,
+                   sb->whsize, sb->factor,
+                   index * hd / sb->nbands, (index + 1) * hd / sb->nbands,
+                   (sb->pixth) ? pixGetData(sb->pixth) : NULL,
+                   (sb->pixth) ? pixGetWpl(sb->pixth) : 0,
+                   (sb->pixd) ? pixGetData(sb->pixd) : NULL,
+                   (sb->pixd) ? pixGetWpl(sb->pixd) : 0);
+}
+
+
+/*----------------------------------------------------------------------*
+ *                     Low-level Sauvola thresholding                   *
+ *----------------------------------------------------------------------*/
+/*
+ *  sauvolaBandLow()
+ *
+ *      Input:  datag, wplg (8 bpp input, with a border of whsize + 1)
+ *              wd (width of the output; without the border)
+ *              whsize (window half-width)
+ *              factor (for reducing threshold due to variance; >= 0)
+ *              firstrow, lastrow (output rows firstrow ... lastrow - 1)
+ *              datath, wplth (8 bpp thresholds; can be null)
+ *              datad, wpld (1 bpp thresholded image; can be null)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This gives the same thresholds as pixWindowedMean(),
+ *          pixWindowedMeanSquare() and pixSauvolaGetThreshold(), and
+ *          the same bits as pixApplyLocalThreshold(), using sums over
+ *          the window instead of full-size accumulators.  For each
+ *          output row it keeps the sums of the values and squares in
+ *          each column of the window, and slides the window along the
+ *          row by adding one column and removing another.
+ *      (2) The sums are exact in unsigned 32 bit arithmetic, even where
+ *          intermediate values wrap around, because the total over any
+ *          window with whsize <= 128 is less than 2^32.  They are
+ *          converted and normalized with the same expressions as the
+ *          accumulator functions, so the results are bit-identical.
+ *      (3) The columns are indexed by byte within the raster line, so the
+ *          column sums can be updated a word at a time.
+ */
+static void
+sauvolaBandLow(l_uint32  *datag,
+               l_int32    wplg,
+               l_int32    wd,
+               l_int32    whsize,
+               l_float32  factor,
+               l_int32    firstrow,
+               l_int32    lastrow,
+               l_uint32  *datath,
+               l_int32    wplth,
+               l_uint32  *datad,
+               l_int32    wpld)
+{
+l_int32     i, j, k, nbytes, wincr, hincr, mv, ms, var, thresh, vals;
+l_uint32    sum, sumsq;
+l_uint8    *bytes;
+l_uint32   *colsum, *colsq, *lineg, *lineth, *lined;
+l_float32   normf, sd;
+l_float64   normd;
+
+    wincr = hincr = 2 * whsize + 1;
+    normf = 1.0 / (wincr * hincr);
+    normd = 1.0 / (wincr * hincr);
+    nbytes = 4 * wplg;
+    colsum = (l_uint32 *)LEPT_CALLOC(nbytes, sizeof(l_uint32));
+    colsq = (l_uint32 *)LEPT_CALLOC(nbytes, sizeof(l_uint32));
+    lineth = lined = NULL;
+
+        /* Sum the columns over the window of the first row */
+    for (i = firstrow + 1; i <= firstrow + hincr; i++) {
+        bytes = (l_uint8 *)(datag + i * wplg);
+        for (k = 0; k < nbytes; k++) {
+            colsum[k] += bytes[k];
+            colsq[k] += bytes[k] * bytes[k];
+        }
+    }
+
+    for (i = firstrow; i < lastrow; i++) {
+        if (i > firstrow) {  /* move the window down one row */
+            sauvolaUpdateColumnsLow(colsum, colsq,
+                                    (l_uint8 *)(datag + (i + hincr) * wplg),
+                                    (l_uint8 *)(datag + i * wplg), nbytes);
+        }
+        lineg = datag + (i + whsize + 1) * wplg;  /* window centers */
+        if (datath) lineth = datath + i * wplth;
+        if (datad) lined = datad + i * wpld;
+        sum = sumsq = 0;
+        for (k = 1; k <= wincr; k++) {
+            sum += colsum[BYTE_INDEX(k)];
+            sumsq += colsq[BYTE_INDEX(k)];
+        }
+        for (j = 0; j < wd; j++) {
+            if (j > 0) {  /* move the window right one column */
+                sum += colsum[BYTE_INDEX(j + wincr)] - colsum[BYTE_INDEX(j)];
+                sumsq += colsq[BYTE_INDEX(j + wincr)] - colsq[BYTE_INDEX(j)];
+            }
+            mv = (l_uint8)(normf * sum);
+            ms = (l_uint32)(normd * sumsq);
+            var = L_MAX(0, ms - mv * mv);  /* rounding can give -1 */
+            sd = sqrtf((l_float32)var);
+            thresh = (l_int32)(mv * (1.0 - factor * (1.0 - sd / 128.)));
+            if (datath)
+                SET_DATA_BYTE(lineth, j, thresh);
+            if (datad) {
+                vals = GET_DATA_BYTE(lineg, j + whsize + 1);
+                if (vals < (l_uint8)thresh)
+                    SET_DATA_BIT(lined, j);
+            }
+        }
+    }
+
+    LEPT_FREE(colsum);
+    LEPT_FREE(colsq);
+}
+
+
+/*
+ *  sauvolaUpdateColumnsLow()
+ *
+ *      Input:  colsum, colsq (sums of values and squares in each column)
+ *              linein (raster line entering the window)
+ *              lineout (raster line leaving the window)
+ *              nbytes (bytes in each line)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) With NEON or SSE2 this does 8 columns at a time.  The squares
+ *          of 8 bit values fit in 16 bits, so they are exact in the
+ *          16 bit lanes before being widened.
+ */
+static void
+sauvolaUpdateColumnsLow(l_uint32       *colsum,
+                        l_uint32       *colsq,
+                        const l_uint8  *linein,
+                        const l_uint8  *lineout,
+                        l_int32         nbytes)
+{
+l_int32      k, vin, vout;
+#if defined(SAUVOLA_USE_NEON)
+uint8x8_t    in8, out8;
+uint16x8_t   in16, out16, insq, outsq;
+#elif defined(SAUVOLA_USE_SSE2)
+__m128i      zero, in16, out16, insq, outsq, acc;
+#endif
+
+    k = 0;
+#if defined(SAUVOLA_USE_NEON)
+    for (; k + 8 <= nbytes; k += 8) {
+        in8 = vld1_u8(linein + k);
+        out8 = vld1_u8(lineout + k);
+        in16 = vmovl_u8(in8);
+        out16 = vmovl_u8(out8);
+        insq = vmull_u8(in8, in8);
+        outsq = vmull_u8(out8, out8);
+        vst1q_u32(colsum + k,
+                  vsubw_u16(vaddw_u16(vld1q_u32(colsum + k),
+                                      vget_low_u16(in16)),
+                            vget_low_u16(out16)));
+        vst1q_u32(colsum + k + 4,
+                  vsubw_u16(vaddw_u16(vld1q_u32(colsum + k + 4),
+                                      vget_high_u16(in16)),
+                            vget_high_u16(out16)));
+        vst1q_u32(colsq + k,
+                  vsubw_u16(vaddw_u16(vld1q_u32(colsq + k),
+                                      vget_low_u16(insq)),
+                            vget_low_u16(outsq)));
+        vst1q_u32(colsq + k + 4,
+                  vsubw_u16(vaddw_u16(vld1q_u32(colsq + k + 4),
+                                      vget_high_u16(insq)),
+                            vget_high_u16(outsq)));
+    }
+#elif defined(SAUVOLA_USE_SSE2)
+    zero = _mm_setzero_si128();
+    for (; k + 8 <= nbytes; k += 8) {
+        in16 = _mm_unpacklo_epi8(
+                   _mm_loadl_epi64((const __m128i *)(linein + k)), zero);
+        out16 = _mm_unpacklo_epi8(
+                    _mm_loadl_epi64((const __m128i *)(lineout + k)), zero);
+        insq = _mm_mullo_epi16(in16, in16);
+        outsq = _mm_mullo_epi16(out16, out16);
+        acc = _mm_loadu_si128((const __m128i *)(colsum + k));
+        acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(in16, zero));
+        acc = _mm_sub_epi32(acc, _mm_unpacklo_epi16(out16, zero));
+        _mm_storeu_si128((__m128i *)(colsum + k), acc);
+        acc = _mm_loadu_si128((const __m128i *)(colsum + k + 4));
+        acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(in16, zero));
+        acc = _mm_sub_epi32(acc, _mm_unpackhi_epi16(out16, zero));
+        _mm_storeu_si128((__m128i *)(colsum + k + 4), acc);
+        acc = _mm_loadu_si128((const __m128i *)(colsq + k));
+        acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(insq, zero));
+        acc = _mm_sub_epi32(acc, _mm_unpacklo_epi16(outsq, zero));
+        _mm_storeu_si128((__m128i *)(colsq + k), acc);
+        acc = _mm_loadu_si128((const __m128i *)(colsq + k + 4));
+        acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(insq, zero));
+        acc = _mm_sub_epi32(acc, _mm_unpackhi_epi16(outsq, zero));
+        _mm_storeu_si128((__m128i *)(colsq + k + 4), acc);
+    }
+#endif
+
+    for (; k < nbytes; k++) {
+        vin = linein[k];
+        vout = lineout[k];
+        colsum[k] += vin - vout;
+        colsq[k] += vin * vin - vout * vout;
+    }
+}
@@ -273,6 +273,13 @@ struct L_WallTimer {
 typedef struct L_WallTimer  L_WALLTIMER;
 
 
+/*------------------------------------------------------------------------*
+ *                     Tasks run on several threads                       *
+ *------------------------------------------------------------------------*/
+/*! Task run by l_runTasks() for each index */
+typedef void (*L_TASK_FUNC)(void *data, l_int32 index);
+
+
 /*------------------------------------------------------------------------*
  *                      Standard memory allocation                        *
  *                                                                        *
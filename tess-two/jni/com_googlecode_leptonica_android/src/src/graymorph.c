@@ -46,8 +46,13 @@
  *            PIX           *pixCloseGray3()
  *
  *      Low-level grayscale morphological operations
- *            static void    dilateGrayLow()
- *            static void    erodeGrayLow()
+ *            static l_int32 dilateGrayLow()
+ *            static l_int32 erodeGrayLow()
+ *            static l_int32 grayMorphLow()
+ *            static void    grayMorphBandTask()
+ *            static void    grayMorphStripTask()
+ *            static void    grayMorphLinesLow()
+ *            static void    minMaxLinesLow()
  *
  *
  *      Method: Algorithm by van Herk and Gil and Werman, 1992
@@ -56,7 +61,11 @@
  *      pixel per 120 PIII clock cycles, for a horizontal or vertical
  *      erosion or dilation.  The computation time doubles for opening
  *      or closing, or for a square SE, as expected, and is independent
- *      of the size of the SE.
+ *      of the size of the SE.  The vHGW passes are run on 16 lines at
+ *      a time, 16 bytes per step with NEON or SSE2 where available:
+ *      consecutive rows for vertical Sels, and bands of 16 rows,
+ *      transposed, for horizontal Sels.  The bands and strips are
+ *      shared among the threads set by l_morphSetNumThreads().
  *
  *      A faster implementation can be made directly for brick Sels
  *      of maximum size 3.  We unroll the computation for sets of 8 bytes.
@@ -119,7 +128,18 @@
  * </pre>
  */
 
+#include <string.h>
 #include "allheaders.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define  GRAYMORPH_USE_NEON  1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define  GRAYMORPH_USE_SSE2  1
+#endif
+
+    /* Number of threads for the bands and strips; defined in morph.c */
+extern l_int32  MorphNumThreads;
 
     /* Special static operations for 3x1, 1x3 and 3x3 structuring elements */
 static PIX *pixErodeGray3h(PIX *pixs);
@@ -127,15 +147,38 @@ static PIX *pixErodeGray3v(PIX *pixs);
 static PIX *pixDilateGray3h(PIX *pixs);
 static PIX *pixDilateGray3v(PIX *pixs);
 
+    /* Rows in each band done by grayMorphBandTask(), one per byte of a
+     * SIMD register, and bytes of each row in a strip done by
+     * grayMorphStripTask() */
+#define  GRAY_BAND_HEIGHT  16
+static const l_int32  GRAY_STRIP_BYTES = 256;
+
+    /* Shared by the tasks of grayMorphLow() */
+struct GrayMorph {
+    l_uint32  *datad, *datas;
+    l_int32    w, h, wpld, wpls;
+    l_int32    size, type;
+    l_int32   *taskerr;      /* set for each task that failed */
+};
+
     /*  Low-level gray morphological operations */
-static void dilateGrayLow(l_uint32 *datad, l_int32 w, l_int32 h,
-                          l_int32 wpld, l_uint32 *datas, l_int32 wpls,
-                          l_int32 size, l_int32 direction, l_uint8 *buffer,
-                          l_uint8 *maxarray);
-static void erodeGrayLow(l_uint32 *datad, l_int32 w, l_int32 h,
-                         l_int32 wpld, l_uint32 *datas, l_int32 wpls,
-                         l_int32 size, l_int32 direction, l_uint8 *buffer,
-                         l_uint8 *minarray);
+static l_int32 dilateGrayLow(l_uint32 *datad, l_int32 w, l_int32 h,
+                             l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                             l_int32 size, l_int32 direction);
+static l_int32 erodeGrayLow(l_uint32 *datad, l_int32 w, l_int32 h,
+                            l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                            l_int32 size, l_int32 direction);
+static l_int32 grayMorphLow(l_uint32 *datad, l_int32 w, l_int32 h,
+                            l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                            l_int32 size, l_int32 direction, l_int32 type);
+static void grayMorphBandTask(void *data, l_int32 index);
+static void grayMorphStripTask(void *data, l_int32 index);
+static void grayMorphLinesLow(l_uint8 *datad, l_int32 strided,
+                              l_uint8 *datas, l_int32 strides, l_int32 n,
+                              l_int32 nbytes, l_int32 size, l_int32 type,
+                              l_uint8 *array);
+static void minMaxLinesLow(l_uint8 *lined, l_uint8 *line1, l_uint8 *line2,
+                           l_int32 n, l_int32 type);
 
 /*-----------------------------------------------------------------*
  *           Top-level grayscale morphological operations          *
@@ -159,9 +202,8 @@ pixErodeGray(PIX     *pixs,
              l_int32  hsize,
              l_int32  vsize)
 {
-l_uint8   *buffer, *minarray;
-l_int32    w, h, wplb, wplt;
-l_int32    leftpix, rightpix, toppix, bottompix, maxsize;
+l_int32    w, h, wplb, wplt, error;
+l_int32    leftpix, rightpix, toppix, bottompix;
 l_uint32  *datab, *datat;
 PIX       *pixb, *pixt, *pixd;
 
@@ -183,7 +225,7 @@ PIX       *pixb, *pixt, *pixd;
     }
 
     pixb = pixt = pixd = NULL;
-    buffer = minarray = NULL;
+    error = 0;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(NULL, pixs);
@@ -218,38 +260,29 @@ PIX       *pixb, *pixt, *pixd;
     wplb = pixGetWpl(pixb);
     wplt = pixGetWpl(pixt);
 
-    buffer = (l_uint8 *)LEPT_CALLOC(L_MAX(w, h), sizeof(l_uint8));
-    maxsize = L_MAX(hsize, vsize);
-    minarray = (l_uint8 *)LEPT_CALLOC(2 * maxsize, sizeof(l_uint8));
-    if (!buffer || !minarray) {
-        L_ERROR("buffer and minarray not made\n", procName);
-        goto cleanup;
-    }
-
     if (vsize == 1) {
-        erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                     buffer, minarray);
+        error |= erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
     } else if (hsize == 1) {
-        erodeGrayLow(datat, w, h, wplt, datab, wplb, vsize, L_VERT,
-                     buffer, minarray);
+        error |= erodeGrayLow(datat, w, h, wplt, datab, wplb, vsize, L_VERT);
     } else {
-        erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                     buffer, minarray);
+        error |= erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_SET);
-        erodeGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT,
-                     buffer, minarray);
+        error |= erodeGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT);
         pixDestroy(&pixt);
         pixt = pixClone(pixb);
     }
 
+    if (error) {
+        L_ERROR("buffers not made\n", procName);
+        goto cleanup;
+    }
+
     pixd = pixRemoveBorderGeneral(pixt, leftpix, rightpix, toppix, bottompix);
     if (!pixd)
         L_ERROR("pixd not made\n", procName);
 
 cleanup:
-    LEPT_FREE(buffer);
-    LEPT_FREE(minarray);
     pixDestroy(&pixb);
     pixDestroy(&pixt);
     return pixd;
@@ -275,9 +308,8 @@ pixDilateGray(PIX     *pixs,
               l_int32  hsize,
               l_int32  vsize)
 {
-l_uint8   *buffer, *maxarray;
-l_int32    w, h, wplb, wplt;
-l_int32    leftpix, rightpix, toppix, bottompix, maxsize;
+l_int32    w, h, wplb, wplt, error;
+l_int32    leftpix, rightpix, toppix, bottompix;
 l_uint32  *datab, *datat;
 PIX       *pixb, *pixt, *pixd;
 
@@ -299,7 +331,7 @@ PIX       *pixb, *pixt, *pixd;
     }
 
     pixb = pixt = pixd = NULL;
-    buffer = maxarray = NULL;
+    error = 0;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(NULL, pixs);
@@ -334,38 +366,29 @@ PIX       *pixb, *pixt, *pixd;
     wplb = pixGetWpl(pixb);
     wplt = pixGetWpl(pixt);
 
-    buffer = (l_uint8 *)LEPT_CALLOC(L_MAX(w, h), sizeof(l_uint8));
-    maxsize = L_MAX(hsize, vsize);
-    maxarray = (l_uint8 *)LEPT_CALLOC(2 * maxsize, sizeof(l_uint8));
-    if (!buffer || !maxarray) {
-        L_ERROR("buffer and maxarray not made\n", procName);
-        goto cleanup;
-    }
-
     if (vsize == 1) {
-        dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                      buffer, maxarray);
+        error |= dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
     } else if (hsize == 1) {
-        dilateGrayLow(datat, w, h, wplt, datab, wplb, vsize, L_VERT,
-                      buffer, maxarray);
+        error |= dilateGrayLow(datat, w, h, wplt, datab, wplb, vsize, L_VERT);
     } else {
-        dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                      buffer, maxarray);
+        error |= dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_CLR);
-        dilateGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT,
-                      buffer, maxarray);
+        error |= dilateGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT);
         pixDestroy(&pixt);
         pixt = pixClone(pixb);
     }
 
+    if (error) {
+        L_ERROR("buffers not made\n", procName);
+        goto cleanup;
+    }
+
     pixd = pixRemoveBorderGeneral(pixt, leftpix, rightpix, toppix, bottompix);
     if (!pixd)
         L_ERROR("pixd not made\n", procName);
 
 cleanup:
-    LEPT_FREE(buffer);
-    LEPT_FREE(maxarray);
     pixDestroy(&pixb);
     pixDestroy(&pixt);
     return pixd;
@@ -391,10 +414,8 @@ pixOpenGray(PIX     *pixs,
             l_int32  hsize,
             l_int32  vsize)
 {
-l_uint8   *buffer;
-l_uint8   *array;  /* used to find either min or max in interval */
-l_int32    w, h, wplb, wplt;
-l_int32    leftpix, rightpix, toppix, bottompix, maxsize;
+l_int32    w, h, wplb, wplt, error;
+l_int32    leftpix, rightpix, toppix, bottompix;
 l_uint32  *datab, *datat;
 PIX       *pixb, *pixt, *pixd;
 
@@ -416,7 +437,7 @@ PIX       *pixb, *pixt, *pixd;
     }
 
     pixb = pixt = pixd = NULL;
-    buffer = array = NULL;
+    error = 0;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(NULL, pixs);
@@ -451,44 +472,33 @@ PIX       *pixb, *pixt, *pixd;
     wplb = pixGetWpl(pixb);
     wplt = pixGetWpl(pixt);
 
-    buffer = (l_uint8 *)LEPT_CALLOC(L_MAX(w, h), sizeof(l_uint8));
-    maxsize = L_MAX(hsize, vsize);
-    array = (l_uint8 *)LEPT_CALLOC(2 * maxsize, sizeof(l_uint8));
-    if (!buffer || !array) {
-        L_ERROR("buffer and array not made\n", procName);
-        goto cleanup;
-    }
-
     if (vsize == 1) {
-        erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                     buffer, array);
+        error |= erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_CLR);
-        dilateGrayLow(datab, w, h, wplb, datat, wplt, hsize, L_HORIZ,
-                      buffer, array);
+        error |= dilateGrayLow(datab, w, h, wplb, datat, wplt, hsize, L_HORIZ);
     }
     else if (hsize == 1) {
-        erodeGrayLow(datat, w, h, wplt, datab, wplb, vsize, L_VERT,
-                     buffer, array);
+        error |= erodeGrayLow(datat, w, h, wplt, datab, wplb, vsize, L_VERT);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_CLR);
-        dilateGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT,
-                      buffer, array);
+        error |= dilateGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT);
     } else {
-        erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                     buffer, array);
+        error |= erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_SET);
-        erodeGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT,
-                     buffer, array);
+        error |= erodeGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT);
         pixSetOrClearBorder(pixb, leftpix, rightpix, toppix, bottompix,
                             PIX_CLR);
-        dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                      buffer, array);
+        error |= dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_CLR);
-        dilateGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT,
-                      buffer, array);
+        error |= dilateGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT);
+    }
+
+    if (error) {
+        L_ERROR("buffers not made\n", procName);
+        goto cleanup;
     }
 
     pixd = pixRemoveBorderGeneral(pixb, leftpix, rightpix, toppix, bottompix);
@@ -496,8 +506,6 @@ PIX       *pixb, *pixt, *pixd;
         L_ERROR("pixd not made\n", procName);
 
 cleanup:
-    LEPT_FREE(buffer);
-    LEPT_FREE(array);
     pixDestroy(&pixb);
     pixDestroy(&pixt);
     return pixd;
@@ -523,10 +531,8 @@ pixCloseGray(PIX     *pixs,
              l_int32  hsize,
              l_int32  vsize)
 {
-l_uint8   *buffer;
-l_uint8   *array;  /* used to find either min or max in interval */
-l_int32    w, h, wplb, wplt;
-l_int32    leftpix, rightpix, toppix, bottompix, maxsize;
+l_int32    w, h, wplb, wplt, error;
+l_int32    leftpix, rightpix, toppix, bottompix;
 l_uint32  *datab, *datat;
 PIX       *pixb, *pixt, *pixd;
 
@@ -548,7 +554,7 @@ PIX       *pixb, *pixt, *pixd;
     }
 
     pixb = pixt = pixd = NULL;
-    buffer = array = NULL;
+    error = 0;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(NULL, pixs);
@@ -583,43 +589,32 @@ PIX       *pixb, *pixt, *pixd;
     wplb = pixGetWpl(pixb);
     wplt = pixGetWpl(pixt);
 
-    buffer = (l_uint8 *)LEPT_CALLOC(L_MAX(w, h), sizeof(l_uint8));
-    maxsize = L_MAX(hsize, vsize);
-    array = (l_uint8 *)LEPT_CALLOC(2 * maxsize, sizeof(l_uint8));
-    if (!buffer || !array) {
-        L_ERROR("buffer and array not made\n", procName);
-        goto cleanup;
-    }
-
     if (vsize == 1) {
-        dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                     buffer, array);
+        error |= dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_SET);
-        erodeGrayLow(datab, w, h, wplb, datat, wplt, hsize, L_HORIZ,
-                      buffer, array);
+        error |= erodeGrayLow(datab, w, h, wplb, datat, wplt, hsize, L_HORIZ);
     } else if (hsize == 1) {
-        dilateGrayLow(datat, w, h, wplt, datab, wplb, vsize, L_VERT,
-                     buffer, array);
+        error |= dilateGrayLow(datat, w, h, wplt, datab, wplb, vsize, L_VERT);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_SET);
-        erodeGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT,
-                      buffer, array);
+        error |= erodeGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT);
     } else {
-        dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                      buffer, array);
+        error |= dilateGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_CLR);
-        dilateGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT,
-                      buffer, array);
+        error |= dilateGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT);
         pixSetOrClearBorder(pixb, leftpix, rightpix, toppix, bottompix,
                             PIX_SET);
-        erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ,
-                     buffer, array);
+        error |= erodeGrayLow(datat, w, h, wplt, datab, wplb, hsize, L_HORIZ);
         pixSetOrClearBorder(pixt, leftpix, rightpix, toppix, bottompix,
                             PIX_SET);
-        erodeGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT,
-                     buffer, array);
+        error |= erodeGrayLow(datab, w, h, wplb, datat, wplt, vsize, L_VERT);
+    }
+
+    if (error) {
+        L_ERROR("buffers not made\n", procName);
+        goto cleanup;
     }
 
     pixd = pixRemoveBorderGeneral(pixb, leftpix, rightpix, toppix, bottompix);
@@ -627,8 +622,6 @@ PIX       *pixb, *pixt, *pixd;
         L_ERROR("pixd not made\n", procName);
 
 cleanup:
-    LEPT_FREE(buffer);
-    LEPT_FREE(array);
     pixDestroy(&pixb);
     pixDestroy(&pixt);
     return pixd;
@@ -1158,9 +1151,7 @@ PIX  *pixt, *pixb, *pixbd, *pixd;
  * \param[in]    datas, wpls  8 bpp image, of same dimensions
  * \param[in]    size  full length of SEL; restricted to odd numbers
  * \param[in]    direction  L_HORIZ or L_VERT
- * \param[in]    buffer  holds full line or column of src image pixels
- * \param[in]    maxarray  array of dimension 2*size+1
- * \return  void
+ * \return  0 if OK, 1 if a buffer could not be made
  *
  * <pre>
  * Notes:
@@ -1173,10 +1164,11 @@ PIX  *pixt, *pixb, *pixbd, *pixd;
  *            and we initialize the src border pixels to 0.
  *            This allows full processing over the actual image; at
  *            the end the border is removed.
- *        (2) Uses algorithm of van Herk, Gil and Werman
+ *        (2) Uses algorithm of van Herk, Gil and Werman; see
+ *            grayMorphLinesLow().
  * </pre>
  */
-static void
+static l_int32
 dilateGrayLow(l_uint32  *datad,
               l_int32    w,
               l_int32    h,
@@ -1184,83 +1176,10 @@ dilateGrayLow(l_uint32  *datad,
               l_uint32  *datas,
               l_int32    wpls,
               l_int32    size,
-              l_int32    direction,
-              l_uint8   *buffer,
-              l_uint8   *maxarray)
+              l_int32    direction)
 {
-l_int32    i, j, k;
-l_int32    hsize, nsteps, startmax, startx, starty;
-l_uint8    maxval;
-l_uint32  *lines, *lined;
-
-    if (direction == L_HORIZ) {
-        hsize = size / 2;
-        nsteps = (w - 2 * hsize) / size;
-        for (i = 0; i < h; i++) {
-            lines = datas + i * wpls;
-            lined = datad + i * wpld;
-
-                /* fill buffer with pixels in byte order */
-            for (j = 0; j < w; j++)
-                buffer[j] = GET_DATA_BYTE(lines, j);
-
-            for (j = 0; j < nsteps; j++) {
-                    /* refill the minarray */
-                startmax = (j + 1) * size - 1;
-                maxarray[size - 1] = buffer[startmax];
-                for (k = 1; k < size; k++) {
-                    maxarray[size - 1 - k] =
-                        L_MAX(maxarray[size - k], buffer[startmax - k]);
-                    maxarray[size - 1 + k] =
-                        L_MAX(maxarray[size + k - 2], buffer[startmax + k]);
-                }
-
-                    /* compute dilation values */
-                startx = hsize + j * size;
-                SET_DATA_BYTE(lined, startx, maxarray[0]);
-                SET_DATA_BYTE(lined, startx + size - 1, maxarray[2 * size - 2]);
-                for (k = 1; k < size - 1; k++) {
-                    maxval = L_MAX(maxarray[k], maxarray[k + size - 1]);
-                    SET_DATA_BYTE(lined, startx + k, maxval);
-                }
-            }
-        }
-    } else {  /* direction == L_VERT */
-        hsize = size / 2;
-        nsteps = (h - 2 * hsize) / size;
-        for (j = 0; j < w; j++) {
-                /* fill buffer with pixels in byte order */
-            for (i = 0; i < h; i++) {
-                lines = datas + i * wpls;
-                buffer[i] = GET_DATA_BYTE(lines, j);
-            }
-
-            for (i = 0; i < nsteps; i++) {
-                    /* refill the minarray */
-                startmax = (i + 1) * size - 1;
-                maxarray[size - 1] = buffer[startmax];
-                for (k = 1; k < size; k++) {
-                    maxarray[size - 1 - k] =
-                        L_MAX(maxarray[size - k], buffer[startmax - k]);
-                    maxarray[size - 1 + k] =
-                        L_MAX(maxarray[size + k - 2], buffer[startmax + k]);
-                }
-
-                    /* compute dilation values */
-                starty = hsize + i * size;
-                lined = datad + starty * wpld;
-                SET_DATA_BYTE(lined, j, maxarray[0]);
-                SET_DATA_BYTE(lined + (size - 1) * wpld, j,
-                        maxarray[2 * size - 2]);
-                for (k = 1; k < size - 1; k++) {
-                    maxval = L_MAX(maxarray[k], maxarray[k + size - 1]);
-                    SET_DATA_BYTE(lined + wpld * k, j, maxval);
-                }
-            }
-        }
-    }
-
-    return;
+    return grayMorphLow(datad, w, h, wpld, datas, wpls, size, direction,
+                        L_MORPH_DILATE);
 }
 
 
@@ -1271,17 +1190,55 @@ l_uint32  *lines, *lined;
  * \param[in]    datas, wpls  8 bpp image, of same dimensions
  * \param[in]    size  full length of SEL; restricted to odd numbers
  * \param[in]    direction  L_HORIZ or L_VERT
- * \param[in]    buffer  holds full line or column of src image pixels
- * \param[in]    minarray  array of dimension 2*size+1
- * \return  void
+ * \return  0 if OK, 1 if a buffer could not be made
  *
  * <pre>
  * Notes:
  *        (1) See notes in dilateGrayLow()
  * </pre>
  */
-static void
+static l_int32
 erodeGrayLow(l_uint32  *datad,
+             l_int32    w,
+             l_int32    h,
+             l_int32    wpld,
+             l_uint32  *datas,
+             l_int32    wpls,
+             l_int32    size,
+             l_int32    direction)
+{
+    return grayMorphLow(datad, w, h, wpld, datas, wpls, size, direction,
+                        L_MORPH_ERODE);
+}
+
+
+/*!
+ * \brief   grayMorphLow()
+ *
+ * \param[in]    datad, w, h, wpld 8 bpp image
+ * \param[in]    datas, wpls  8 bpp image, of same dimensions
+ * \param[in]    size  full length of SEL; restricted to odd numbers
+ * \param[in]    direction  L_HORIZ or L_VERT
+ * \param[in]    type  L_MORPH_DILATE or L_MORPH_ERODE
+ * \return  0 if OK, 1 if a buffer could not be made
+ *
+ * <pre>
+ * Notes:
+ *        (1) For L_VERT, the image is split into strips of
+ *            GRAY_STRIP_BYTES columns, and the lines of each strip are
+ *            processed a row at a time.
+ *        (2) For L_HORIZ, the image is split into bands of 16 rows.
+ *            Each band is transposed, so that its columns can be
+ *            processed the same way, and transposed back.
+ *        (3) The strips and bands are run with l_runTasks(), on the
+ *            threads set by l_morphSetNumThreads().
+ *            Only the pixels that the scalar version of this algorithm
+ *            set are written, except in the padding at the end of
+ *            each row for L_VERT.
+ * </pre>
+ */
+static l_int32
+grayMorphLow(l_uint32  *datad,
              l_int32    w,
              l_int32    h,
              l_int32    wpld,
@@ -1289,80 +1246,239 @@ erodeGrayLow(l_uint32  *datad,
              l_int32    wpls,
              l_int32    size,
              l_int32    direction,
-             l_uint8   *buffer,
-             l_uint8   *minarray)
+             l_int32    type)
+{
+l_int32           i, ntasks, error;
+struct GrayMorph  gm;
+
+    PROCNAME("grayMorphLow");
+
+    if (direction == L_HORIZ)
+        ntasks = (h + GRAY_BAND_HEIGHT - 1) / GRAY_BAND_HEIGHT;
+    else  /* direction == L_VERT */
+        ntasks = (4 * wpls + GRAY_STRIP_BYTES - 1) / GRAY_STRIP_BYTES;
+    gm.taskerr = (l_int32 *)LEPT_CALLOC(ntasks, sizeof(l_int32));
+    if (!gm.taskerr)
+        return ERROR_INT("taskerr not made", procName, 1);
+
+    gm.datad = datad;
+    gm.datas = datas;
+    gm.w = w;
+    gm.h = h;
+    gm.wpld = wpld;
+    gm.wpls = wpls;
+    gm.size = size;
+    gm.type = type;
+    if (direction == L_HORIZ)
+        l_runTasks(grayMorphBandTask, &gm, ntasks, MorphNumThreads);
+    else  /* direction == L_VERT */
+        l_runTasks(grayMorphStripTask, &gm, ntasks, MorphNumThreads);
+
+    for (i = 0, error = 0; i < ntasks; i++)
+        error |= gm.taskerr[i];
+    LEPT_FREE(gm.taskerr);
+    return error;
+}
+
+
+/*
+ *  grayMorphBandTask()
+ *
+ *      Does the horizontal operation on band %index of rows.  Sets
+ *      taskerr[index] if the buffers cannot be made.
+ */
+static void
+grayMorphBandTask(void    *data,
+                  l_int32  index)
+{
+l_int32            i, j, x, nrows, size, hsize, nsteps;
+l_uint8           *bufs, *bufd, *array;
+l_uint32          *lines, *lined;
+struct GrayMorph  *gm;
+
+    gm = (struct GrayMorph *)data;
+    size = gm->size;
+    hsize = size / 2;
+    nsteps = (gm->w - 2 * hsize) / size;
+    if (nsteps <= 0)
+        return;
+    i = index * GRAY_BAND_HEIGHT;
+    nrows = L_MIN(GRAY_BAND_HEIGHT, gm->h - i);
+
+    bufs = (l_uint8 *)LEPT_CALLOC(gm->w * GRAY_BAND_HEIGHT, sizeof(l_uint8));
+    bufd = (l_uint8 *)LEPT_MALLOC(gm->w * GRAY_BAND_HEIGHT * sizeof(l_uint8));
+    array = (l_uint8 *)LEPT_MALLOC((2 * size - 1) * GRAY_BAND_HEIGHT *
+                                   sizeof(l_uint8));
+    if (!bufs || !bufd || !array) {
+        gm->taskerr[index] = 1;
+        goto cleanup;
+    }
+
+        /* Pixel x of row j of the band goes to bufs[x * 16 + j] */
+    for (j = 0; j < nrows; j++) {
+        lines = gm->datas + (i + j) * gm->wpls;
+        for (x = 0; x < gm->w; x++)
+            bufs[x * GRAY_BAND_HEIGHT + j] = GET_DATA_BYTE(lines, x);
+    }
+
+    grayMorphLinesLow(bufd, GRAY_BAND_HEIGHT, bufs, GRAY_BAND_HEIGHT, gm->w,
+                      GRAY_BAND_HEIGHT, size, gm->type, array);
+
+    for (j = 0; j < nrows; j++) {
+        lined = gm->datad + (i + j) * gm->wpld;
+        for (x = hsize; x < hsize + nsteps * size; x++)
+            SET_DATA_BYTE(lined, x, bufd[x * GRAY_BAND_HEIGHT + j]);
+    }
+
+cleanup:
+    LEPT_FREE(bufs);
+    LEPT_FREE(bufd);
+    LEPT_FREE(array);
+}
+
+
+/*
+ *  grayMorphStripTask()
+ *
+ *      Does the vertical operation on strip %index of columns.  Sets
+ *      taskerr[index] if the buffer cannot be made.
+ */
+static void
+grayMorphStripTask(void    *data,
+                   l_int32  index)
 {
-l_int32    i, j, k;
-l_int32    hsize, nsteps, startmin, startx, starty;
-l_uint8    minval;
-l_uint32  *lines, *lined;
-
-    if (direction == L_HORIZ) {
-        hsize = size / 2;
-        nsteps = (w - 2 * hsize) / size;
-        for (i = 0; i < h; i++) {
-            lines = datas + i * wpls;
-            lined = datad + i * wpld;
-
-                /* fill buffer with pixels in byte order */
-            for (j = 0; j < w; j++)
-                buffer[j] = GET_DATA_BYTE(lines, j);
-
-            for (j = 0; j < nsteps; j++) {
-                    /* refill the minarray */
-                startmin = (j + 1) * size - 1;
-                minarray[size - 1] = buffer[startmin];
-                for (k = 1; k < size; k++) {
-                    minarray[size - 1 - k] =
-                        L_MIN(minarray[size - k], buffer[startmin - k]);
-                    minarray[size - 1 + k] =
-                        L_MIN(minarray[size + k - 2], buffer[startmin + k]);
-                }
-
-                    /* compute erosion values */
-                startx = hsize + j * size;
-                SET_DATA_BYTE(lined, startx, minarray[0]);
-                SET_DATA_BYTE(lined, startx + size - 1, minarray[2 * size - 2]);
-                for (k = 1; k < size - 1; k++) {
-                    minval = L_MIN(minarray[k], minarray[k + size - 1]);
-                    SET_DATA_BYTE(lined, startx + k, minval);
-                }
-            }
+l_int32            start, nbytes;
+l_uint8           *array;
+struct GrayMorph  *gm;
+
+    gm = (struct GrayMorph *)data;
+    start = index * GRAY_STRIP_BYTES;
+    nbytes = L_MIN(GRAY_STRIP_BYTES, 4 * gm->wpls - start);
+    array = (l_uint8 *)LEPT_MALLOC((2 * gm->size - 1) * nbytes *
+                                   sizeof(l_uint8));
+    if (!array) {
+        gm->taskerr[index] = 1;
+        return;
+    }
+
+        /* Each column is independent, so the byte order is irrelevant */
+    grayMorphLinesLow((l_uint8 *)gm->datad + start, 4 * gm->wpld,
+                      (l_uint8 *)gm->datas + start, 4 * gm->wpls,
+                      gm->h, nbytes, gm->size, gm->type, array);
+
+    LEPT_FREE(array);
+}
+
+
+/*!
+ * \brief   grayMorphLinesLow()
+ *
+ * \param[in]    datad  first line of dest
+ * \param[in]    strided  bytes between lines of dest
+ * \param[in]    datas  first line of src
+ * \param[in]    strides  bytes between lines of src
+ * \param[in]    n  number of lines
+ * \param[in]    nbytes  bytes in each line
+ * \param[in]    size  full length of SEL; restricted to odd numbers
+ * \param[in]    type  L_MORPH_DILATE or L_MORPH_ERODE
+ * \param[in]    array  holds 2 * size - 1 lines of nbytes
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *        (1) This does the van Herk/Gil-Werman operation on each byte
+ *            column of the lines, down the lines.  Line j of dest gets
+ *            the max (or min) of lines j - size/2 ... j + size/2 of src,
+ *            for the lines j written by the scalar algorithm.
+ *        (2) Each group of size lines is done as in the notes at the
+ *            top of this file, except that each entry of the array of
+ *            partial maxima is a line of nbytes.
+ * </pre>
+ */
+static void
+grayMorphLinesLow(l_uint8  *datad,
+                  l_int32   strided,
+                  l_uint8  *datas,
+                  l_int32   strides,
+                  l_int32   n,
+                  l_int32   nbytes,
+                  l_int32   size,
+                  l_int32   type,
+                  l_uint8  *array)
+{
+l_int32   j, k, hsize, nsteps, start, startd;
+l_uint8  *mid;
+
+    hsize = size / 2;
+    nsteps = (n - 2 * hsize) / size;
+    mid = array + (size - 1) * nbytes;
+    for (j = 0; j < nsteps; j++) {
+            /* refill the array of partial extrema */
+        start = (j + 1) * size - 1;
+        memcpy(mid, datas + start * strides, nbytes);
+        for (k = 1; k < size; k++) {
+            minMaxLinesLow(mid - k * nbytes, mid - (k - 1) * nbytes,
+                           datas + (start - k) * strides, nbytes, type);
+            minMaxLinesLow(mid + k * nbytes, mid + (k - 1) * nbytes,
+                           datas + (start + k) * strides, nbytes, type);
         }
-    } else {  /* direction == L_VERT */
-        hsize = size / 2;
-        nsteps = (h - 2 * hsize) / size;
-        for (j = 0; j < w; j++) {
-                /* fill buffer with pixels in byte order */
-            for (i = 0; i < h; i++) {
-                lines = datas + i * wpls;
-                buffer[i] = GET_DATA_BYTE(lines, j);
-            }
-
-            for (i = 0; i < nsteps; i++) {
-                    /* refill the minarray */
-                startmin = (i + 1) * size - 1;
-                minarray[size - 1] = buffer[startmin];
-                for (k = 1; k < size; k++) {
-                    minarray[size - 1 - k] =
-                        L_MIN(minarray[size - k], buffer[startmin - k]);
-                    minarray[size - 1 + k] =
-                        L_MIN(minarray[size + k - 2], buffer[startmin + k]);
-                }
-
-                    /* compute erosion values */
-                starty = hsize + i * size;
-                lined = datad + starty * wpld;
-                SET_DATA_BYTE(lined, j, minarray[0]);
-                SET_DATA_BYTE(lined + (size - 1) * wpld, j,
-                        minarray[2 * size - 2]);
-                for (k = 1; k < size - 1; k++) {
-                    minval = L_MIN(minarray[k], minarray[k + size - 1]);
-                    SET_DATA_BYTE(lined + wpld * k, j, minval);
-                }
-            }
+
+            /* compute the result for each line of the group */
+        startd = hsize + j * size;
+        memcpy(datad + startd * strided, array, nbytes);
+        memcpy(datad + (startd + size - 1) * strided,
+               array + (2 * size - 2) * nbytes, nbytes);
+        for (k = 1; k < size - 1; k++) {
+            minMaxLinesLow(datad + (startd + k) * strided, array + k * nbytes,
+                           array + (k + size - 1) * nbytes, nbytes, type);
         }
     }
+}
+
 
-    return;
+/*
+ *  minMaxLinesLow()
+ *
+ *      Sets lined[i] to the max (L_MORPH_DILATE) or min (L_MORPH_ERODE)
+ *      of line1[i] and line2[i], for 0 <= i < n.
+ */
+static void
+minMaxLinesLow(l_uint8  *lined,
+               l_uint8  *line1,
+               l_uint8  *line2,
+               l_int32   n,
+               l_int32   type)
+{
+l_int32  i;
+
+    i = 0;
+    if (type == L_MORPH_DILATE) {
+#if defined(GRAYMORPH_USE_NEON)
+        for (; i + 16 <= n; i += 16)
+            vst1q_u8(lined + i, vmaxq_u8(vld1q_u8(line1 + i),
+                                         vld1q_u8(line2 + i)));
+#elif defined(GRAYMORPH_USE_SSE2)
+        for (; i + 16 <= n; i += 16) {
+            _mm_storeu_si128((__m128i *)(lined + i),
+                _mm_max_epu8(_mm_loadu_si128((__m128i *)(line1 + i)),
+                             _mm_loadu_si128((__m128i *)(line2 + i))));
+        }
+#endif  /* GRAYMORPH_USE_NEON */
+        for (; i < n; i++)
+            lined[i] = L_MAX(line1[i], line2[i]);
+    } else {  /* L_MORPH_ERODE */
+#if defined(GRAYMORPH_USE_NEON)
+        for (; i + 16 <= n; i += 16)
+            vst1q_u8(lined + i, vminq_u8(vld1q_u8(line1 + i),
+                                         vld1q_u8(line2 + i)));
+#elif defined(GRAYMORPH_USE_SSE2)
+        for (; i + 16 <= n; i += 16) {
+            _mm_storeu_si128((__m128i *)(lined + i),
+                _mm_min_epu8(_mm_loadu_si128((__m128i *)(line1 + i)),
+                             _mm_loadu_si128((__m128i *)(line2 + i))));
+        }
+#endif  /* GRAYMORPH_USE_NEON */
+        for (; i < n; i++)
+            lined[i] = L_MIN(line1[i], line2[i]);
+    }
 }
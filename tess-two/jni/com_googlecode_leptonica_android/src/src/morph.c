@@ -58,6 +58,16 @@
  *         void     resetMorphBoundaryCondition()
  *         l_int32  getMorphBorderPixelColor()
  *
+ *     Low-level separable dilation and erosion with brick Sels
+ *         static PIX     *pixMorphBrickLow()
+ *         static void     morphBrickRowTask()
+ *         static void     morphBrickColumnTask()
+ *         static void     shiftedOrLow()
+ *         static void     orRowsLow()
+ *
+ *     Threads used for brick morphology
+ *         void     l_morphSetNumThreads()
+ *
  *     Static helpers for arg processing
  *         static PIX     *processMorphArgs1()
  *         static PIX     *processMorphArgs2()
@@ -77,10 +87,10 @@
  *  These six brick Sel methods are enumerated as follows:
  *
  *  (1) Brick Sels: pix*Brick(), where * = {Dilate, Erode, Open, Close}.
- *      These are separable rasterop implementations.  The Sels are
- *      automatically generated, used, and destroyed at the end.
- *      You can get the result as a new Pix, in-place back into the src Pix,
- *      or written to another existing Pix.
+ *      These are separable implementations that dilate each row and
+ *      column by shifted ORs of words; no Sels are made.  See the
+ *      last note below.  You can get the result as a new Pix, in-place
+ *      back into the src Pix, or written to another existing Pix.
  *
  *  (2) Brick Sels: pix*CompBrick(), where * = {Dilate, Erode, Open, Close}.
  *      These are separable, 2-way composite, rasterop implementations.
@@ -95,9 +105,9 @@
  *      These are separable dwa (destination word accumulation)
  *      implementations.  They use auto-gen'd dwa code.  You can get
  *      the result as a new Pix, in-place back into the src Pix,
- *      or written to another existing Pix.  This is typically
- *      about 3x faster than the analogous rasterop pix*Brick()
- *      function, but it has the limitation that the Sel size must
+ *      or written to another existing Pix.  This is about as fast
+ *      as pix*Brick() for small Sels and slower for large ones,
+ *      and it has the limitation that the Sel size must
  *      be less than 63.  This is pre-set to work on a number
  *      of pre-generated Sels.  If you want to use other Sels, the
  *      code can be auto-gen'd for them; see the instructions in morphdwa.c.
@@ -159,11 +169,29 @@
  *
  *  These functions are extensively tested in prog/binmorph1_reg.c,
  *  prog/binmorph2_reg.c, and prog/binmorph3_reg.c.
+ *
+ *  The pix*Brick() functions do not use rasterops with the generated
+ *  Sels.  Each row is dilated by a brick of width size with
+ *  log2(size) + 1 shifted ORs, by first ORing runs of 2, 4, 8, ...
+ *  pixels and then ORing two overlapping runs that together cover the
+ *  brick.  Columns are done the same way, a row at a time.  Erosion
+ *  is done as the dilation of the inverted image.  With NEON or SSE2
+ *  this works on 128 pixels at a time.  The rows, and then strips of
+ *  columns, can be processed on several threads; see
+ *  l_morphSetNumThreads().  The results are identical to those
+ *  made with rasterops, and do not depend on the number of threads.
  * </pre>
  */
 
 #include <math.h>
 #include "allheaders.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define  MORPH_USE_NEON  1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define  MORPH_USE_SSE2  1
+#endif
 
     /* Global constant; initialized here; must be declared extern
      * in other files to access it directly.  However, in most
@@ -174,10 +202,46 @@ LEPT_DLL l_int32  MORPH_BC = ASYMMETRIC_MORPH_BC;
     /* We accept this cost in extra rasterops for decomposing exactly. */
 static const l_int32  ACCEPTABLE_COST = 5;
 
+    /* Global variable; initialized here; declared extern in graymorph.c.
+     * Number of threads used for brick and grayscale morphology, or 0
+     * for the number of processors online; default is 1.  Set with
+     * l_morphSetNumThreads(). */
+LEPT_DLL l_int32  MorphNumThreads = 1;
+
+    /* Rows given to each task of the horizontal pass, and words of each
+     * row given to each task of the vertical pass, of pixMorphBrickLow() */
+static const l_int32  MORPH_BAND_HEIGHT = 64;
+static const l_int32  MORPH_STRIP_WORDS = 16;
+
+    /* Shared by the tasks of pixMorphBrickLow().  The image is dilated
+     * after being XOR'd with %inv, which inverts it for erosion. */
+struct MorphBrick {
+    l_uint32  *datas, *datat, *datad;
+    l_int32    h, nwords;        /* height, and words of image in a row  */
+    l_int32    wpls, wpld;
+    l_int32    hsize, vsize;
+    l_int32    hoff, voff;       /* dest pixel is this far into the Sel  */
+    l_int32    vpad;             /* rows of %fill above and below datat  */
+    l_uint32   inv;              /* 0 to dilate; 0xffffffff to erode     */
+    l_uint32   fill;             /* pixels outside the image, XOR'd      */
+    l_uint32   lastmask;         /* image pixels in last word of a row   */
+    l_int32   *rowerr;           /* set for each row band that failed    */
+};
+
     /* Static helpers for arg processing */
 static PIX * processMorphArgs1(PIX *pixd, PIX *pixs, SEL *sel, PIX **ppixt);
 static PIX * processMorphArgs2(PIX *pixd, PIX *pixs, SEL *sel);
 
+    /* Static low-level brick operations */
+static PIX * pixMorphBrickLow(PIX *pixd, PIX *pixs, l_int32 hsize,
+                              l_int32 vsize, l_int32 type);
+static void morphBrickRowTask(void *data, l_int32 index);
+static void morphBrickColumnTask(void *data, l_int32 index);
+static void shiftedOrLow(l_uint32 *datad, l_uint32 *datas, l_int32 n,
+                         l_int32 shift1, l_int32 shift2, l_uint32 inv);
+static void orRowsLow(l_uint32 *lined, l_uint32 *line1, l_uint32 *line2,
+                      l_int32 n, l_uint32 inv);
+
 
 /*-----------------------------------------------------------------*
  *    Generic binary morphological ops implemented with rasterop   *
@@ -686,9 +750,6 @@ pixDilateBrick(PIX     *pixd,
                l_int32  hsize,
                l_int32  vsize)
 {
-PIX  *pixt;
-SEL  *sel, *selh, *selv;
-
     PROCNAME("pixDilateBrick");
 
     if (!pixs)
@@ -700,21 +761,7 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixd = pixDilate(pixd, pixs, sel);
-        selDestroy(&sel);
-    } else {
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixDilate(NULL, pixs, selh);
-        pixd = pixDilate(pixd, pixt, selv);
-        pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
-    }
-
-    return pixd;
+    return pixMorphBrickLow(pixd, pixs, hsize, vsize, L_MORPH_DILATE);
 }
 
 
@@ -750,9 +797,6 @@ pixErodeBrick(PIX     *pixd,
               l_int32  hsize,
               l_int32  vsize)
 {
-PIX  *pixt;
-SEL  *sel, *selh, *selv;
-
     PROCNAME("pixErodeBrick");
 
     if (!pixs)
@@ -764,21 +808,7 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixd = pixErode(pixd, pixs, sel);
-        selDestroy(&sel);
-    } else {
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixErode(NULL, pixs, selh);
-        pixd = pixErode(pixd, pixt, selv);
-        pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
-    }
-
-    return pixd;
+    return pixMorphBrickLow(pixd, pixs, hsize, vsize, L_MORPH_ERODE);
 }
 
 
@@ -815,7 +845,6 @@ pixOpenBrick(PIX     *pixd,
              l_int32  vsize)
 {
 PIX  *pixt;
-SEL  *sel, *selh, *selv;
 
     PROCNAME("pixOpenBrick");
 
@@ -828,22 +857,11 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixd = pixOpen(pixd, pixs, sel);
-        selDestroy(&sel);
-    } else {  /* do separably */
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixErode(NULL, pixs, selh);
-        pixd = pixErode(pixd, pixt, selv);
-        pixDilate(pixt, pixd, selh);
-        pixDilate(pixd, pixt, selv);
-        pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
-    }
-
+    if ((pixt = pixMorphBrickLow(NULL, pixs, hsize, vsize,
+                                 L_MORPH_ERODE)) == NULL)
+        return (PIX *)ERROR_PTR("pixt not made", procName, pixd);
+    pixd = pixMorphBrickLow(pixd, pixt, hsize, vsize, L_MORPH_DILATE);
+    pixDestroy(&pixt);
     return pixd;
 }
 
@@ -881,7 +899,6 @@ pixCloseBrick(PIX     *pixd,
               l_int32  vsize)
 {
 PIX  *pixt;
-SEL  *sel, *selh, *selv;
 
     PROCNAME("pixCloseBrick");
 
@@ -894,22 +911,11 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixd = pixClose(pixd, pixs, sel);
-        selDestroy(&sel);
-    } else {  /* do separably */
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixDilate(NULL, pixs, selh);
-        pixd = pixDilate(pixd, pixt, selv);
-        pixErode(pixt, pixd, selh);
-        pixErode(pixd, pixt, selv);
-        pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
-    }
-
+    if ((pixt = pixMorphBrickLow(NULL, pixs, hsize, vsize,
+                                 L_MORPH_DILATE)) == NULL)
+        return (PIX *)ERROR_PTR("pixt not made", procName, pixd);
+    pixd = pixMorphBrickLow(pixd, pixt, hsize, vsize, L_MORPH_ERODE);
+    pixDestroy(&pixt);
     return pixd;
 }
 
@@ -953,7 +959,6 @@ pixCloseSafeBrick(PIX     *pixd,
 {
 l_int32  maxtrans, bordsize;
 PIX     *pixsb, *pixt, *pixdb;
-SEL     *sel, *selh, *selv;
 
     PROCNAME("pixCloseSafeBrick");
 
@@ -974,23 +979,7 @@ SEL     *sel, *selh, *selv;
     maxtrans = L_MAX(hsize / 2, vsize / 2);
     bordsize = 32 * ((maxtrans + 31) / 32);  /* full 32 bit words */
     pixsb = pixAddBorder(pixs, bordsize, 0);
-
-    if (hsize == 1 || vsize == 1) {  /* no intermediate result */
-        sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
-        pixdb = pixClose(NULL, pixsb, sel);
-        selDestroy(&sel);
-    } else {  /* do separably */
-        selh = selCreateBrick(1, hsize, 0, hsize / 2, SEL_HIT);
-        selv = selCreateBrick(vsize, 1, vsize / 2, 0, SEL_HIT);
-        pixt = pixDilate(NULL, pixsb, selh);
-        pixdb = pixDilate(NULL, pixt, selv);
-        pixErode(pixt, pixdb, selh);
-        pixErode(pixdb, pixt, selv);
-        pixDestroy(&pixt);
-        selDestroy(&selh);
-        selDestroy(&selv);
-    }
-
+    pixdb = pixCloseBrick(NULL, pixsb, hsize, vsize);
     pixt = pixRemoveBorder(pixdb, bordsize);
     pixDestroy(&pixsb);
     pixDestroy(&pixdb);
@@ -1726,6 +1715,384 @@ getMorphBorderPixelColor(l_int32  type,
 }
 
 
+/*-----------------------------------------------------------------*
+ *      Low-level separable dilation and erosion with brick Sels   *
+ *-----------------------------------------------------------------*/
+/*!
+ * \brief   pixMorphBrickLow()
+ *
+ * \param[in]    pixd  [optional]; this can be null, equal to pixs,
+ *                     or different from pixs
+ * \param[in]    pixs 1 bpp
+ * \param[in]    hsize width of brick Sel
+ * \param[in]    vsize height of brick Sel
+ * \param[in]    type L_MORPH_DILATE or L_MORPH_ERODE
+ * \return  pixd, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This gives the same result as pixDilate() or pixErode() with
+ *          a brick Sel of hsize x vsize hits and the origin at
+ *          (hsize/2, vsize/2), done separably.
+ *      (2) Each row is dilated into a temporary image with a border of
+ *          vsize rows, which is then dilated in vertical strips.
+ *          The last word of each row of pixd has its pad bits cleared.
+ *      (3) On error, pixd is destroyed if it was made here.
+ * </pre>
+ */
+static PIX *
+pixMorphBrickLow(PIX     *pixd,
+                 PIX     *pixs,
+                 l_int32  hsize,
+                 l_int32  vsize,
+                 l_int32  type)
+{
+l_int32            i, w, h, nrows, nbands, error;
+PIX               *pixm;
+struct MorphBrick  mb;
+
+    PROCNAME("pixMorphBrickLow");
+
+    pixm = NULL;
+    if (!pixd) {
+        if ((pixd = pixCreateTemplate(pixs)) == NULL)
+            return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+        pixm = pixd;
+    } else {
+        pixResizeImageData(pixd, pixs);
+    }
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    mb.datas = pixGetData(pixs);
+    mb.datad = pixGetData(pixd);
+    mb.datat = NULL;
+    mb.h = h;
+    mb.nwords = (w + 31) / 32;
+    mb.wpls = pixGetWpl(pixs);
+    mb.wpld = pixGetWpl(pixd);
+    mb.hsize = hsize;
+    mb.vsize = vsize;
+    mb.vpad = vsize;
+    mb.lastmask = (w & 31) ? 0xffffffff << (32 - (w & 31)) : 0xffffffff;
+    if (type == L_MORPH_DILATE) {
+        mb.hoff = hsize - 1 - hsize / 2;
+        mb.voff = vsize - 1 - vsize / 2;
+        mb.inv = 0;
+        mb.fill = 0;
+    } else {  /* L_MORPH_ERODE; pixels outside are OFF unless symmetric */
+        mb.hoff = hsize / 2;
+        mb.voff = vsize / 2;
+        mb.inv = 0xffffffff;
+        mb.fill = (MORPH_BC == ASYMMETRIC_MORPH_BC) ? 0xffffffff : 0;
+    }
+
+    nbands = (h + MORPH_BAND_HEIGHT - 1) / MORPH_BAND_HEIGHT;
+    mb.rowerr = (l_int32 *)LEPT_CALLOC(nbands, sizeof(l_int32));
+    if (!mb.rowerr) {
+        pixDestroy(&pixm);
+        return (PIX *)ERROR_PTR("rowerr not made", procName, NULL);
+    }
+    if (vsize > 1) {
+        nrows = h + 2 * mb.vpad;
+        mb.datat = (l_uint32 *)LEPT_MALLOC(nrows * mb.nwords *
+                                           sizeof(l_uint32));
+        if (!mb.datat) {
+            LEPT_FREE(mb.rowerr);
+            pixDestroy(&pixm);
+            return (PIX *)ERROR_PTR("datat not made", procName, NULL);
+        }
+        for (i = 0; i < mb.vpad * mb.nwords; i++) {
+            mb.datat[i] = mb.fill;
+            mb.datat[(mb.vpad + h) * mb.nwords + i] = mb.fill;
+        }
+    }
+
+    l_runTasks(morphBrickRowTask, &mb, nbands, MorphNumThreads);
+    for (i = 0, error = 0; i < nbands; i++)
+        error |= mb.rowerr[i];
+    if (vsize > 1 && !error) {
+        l_runTasks(morphBrickColumnTask, &mb,
+                   (mb.nwords + MORPH_STRIP_WORDS - 1) / MORPH_STRIP_WORDS,
+                   MorphNumThreads);
+    }
+    LEPT_FREE(mb.datat);
+    LEPT_FREE(mb.rowerr);
+    if (error) {
+        pixDestroy(&pixm);
+        return (PIX *)ERROR_PTR("row buffer not made", procName, NULL);
+    }
+    return pixd;
+}
+
+
+/*
+ *  morphBrickRowTask()
+ *
+ *      Dilates the rows of band %index of the XOR'd image by the
+ *      horizontal part of the Sel.  The result goes to datad if the
+ *      Sel is one row high, and to datat otherwise.  Sets rowerr[index]
+ *      if the row buffer cannot be made.
+ */
+static void
+morphBrickRowTask(void    *data,
+                  l_int32  index)
+{
+l_int32             i, j, y, m, nwords, npad, ybeg, yend;
+l_uint32            outinv;
+l_uint32           *lines, *lined, *buf;
+struct MorphBrick  *mb;
+
+    mb = (struct MorphBrick *)data;
+    nwords = mb->nwords;
+    ybeg = index * MORPH_BAND_HEIGHT;
+    yend = L_MIN(mb->h, ybeg + MORPH_BAND_HEIGHT);
+    outinv = (mb->vsize > 1) ? 0 : mb->inv;
+
+        /* Each row is put in the middle of npad words of fill on either
+         * side, which is enough for the Sel to reach past the ends */
+    npad = (mb->hsize + 31) / 32;
+    buf = NULL;
+    if (mb->hsize > 1) {
+        buf = (l_uint32 *)LEPT_MALLOC((2 * npad + nwords + 1) *
+                                      sizeof(l_uint32));
+        if (!buf) {
+            mb->rowerr[index] = 1;
+            return;
+        }
+    }
+
+    for (y = ybeg; y < yend; y++) {
+        lines = mb->datas + y * mb->wpls;
+        if (mb->vsize > 1)
+            lined = mb->datat + (mb->vpad + y) * nwords;
+        else
+            lined = mb->datad + y * mb->wpld;
+
+        if (mb->hsize == 1) {
+            for (j = 0; j < nwords; j++)
+                lined[j] = lines[j] ^ mb->inv;
+            continue;
+        }
+
+        for (i = 0; i < npad; i++)
+            buf[i] = mb->fill;
+        for (j = 0; j < nwords; j++)
+            buf[npad + j] = lines[j] ^ mb->inv;
+        buf[npad + nwords - 1] = (buf[npad + nwords - 1] & mb->lastmask) |
+                                 (mb->fill & ~mb->lastmask);
+        for (i = npad + nwords; i < 2 * npad + nwords + 1; i++)
+            buf[i] = mb->fill;
+
+            /* Each pixel of buf becomes the OR of the m pixels
+             * starting there, for m = 2, 4, ... <= hsize */
+        for (m = 1; 2 * m <= mb->hsize; m *= 2)
+            shiftedOrLow(buf, buf, npad + nwords, 0, m, 0);
+
+            /* OR the runs of m at both ends of the Sel */
+        shiftedOrLow(lined, buf, nwords, 32 * npad - mb->hoff,
+                     32 * npad - mb->hoff + mb->hsize - m, outinv);
+        lined[nwords - 1] &= mb->lastmask;
+    }
+
+    LEPT_FREE(buf);
+}
+
+
+/*
+ *  morphBrickColumnTask()
+ *
+ *      Dilates strip %index of the columns of datat by the vertical
+ *      part of the Sel, and puts the result in datad, XOR'd back.
+ */
+static void
+morphBrickColumnTask(void    *data,
+                     l_int32  index)
+{
+l_int32             y, m, n, nwords, xbeg, last;
+l_uint32           *datat, *lined, *line1;
+struct MorphBrick  *mb;
+
+    mb = (struct MorphBrick *)data;
+    nwords = mb->nwords;
+    xbeg = index * MORPH_STRIP_WORDS;
+    n = L_MIN(nwords - xbeg, MORPH_STRIP_WORDS);
+    datat = mb->datat + xbeg;
+    last = (xbeg + n == nwords);
+
+        /* Each pixel becomes the OR of the m pixels starting there and
+         * going down, for m = 2, 4, ... <= vsize.  Rows below the
+         * image only see fill, so they are not changed. */
+    for (m = 1; 2 * m <= mb->vsize; m *= 2) {
+        for (y = 0; y < mb->vpad + mb->h; y++) {
+            line1 = datat + y * nwords;
+            orRowsLow(line1, line1, line1 + m * nwords, n, 0);
+        }
+    }
+
+    for (y = 0; y < mb->h; y++) {
+        line1 = datat + (mb->vpad + y - mb->voff) * nwords;
+        lined = mb->datad + y * mb->wpld + xbeg;
+        orRowsLow(lined, line1, line1 + (mb->vsize - m) * nwords, n,
+                  mb->inv);
+        if (last)
+            lined[n - 1] &= mb->lastmask;
+    }
+}
+
+
+/*
+ *  shiftedOrLow()
+ *
+ *      Sets word i of datad, for 0 <= i < n, to the OR of the 32 pixels
+ *      of datas starting at pixel 32 * i + shift1 and the 32 pixels
+ *      starting at 32 * i + shift2, XOR'd with inv.  Both shifts must
+ *      be >= 0, and datas must have the word after the last one read.
+ *      datad can be datas if shift1 and shift2 are < 32 * n.
+ */
+static void
+shiftedOrLow(l_uint32  *datad,
+             l_uint32  *datas,
+             l_int32    n,
+             l_int32    shift1,
+             l_int32    shift2,
+             l_uint32   inv)
+{
+l_int32    i, q1, r1, q2, r2;
+l_uint32   w1, w2;
+
+    q1 = shift1 >> 5;
+    r1 = shift1 & 31;
+    q2 = shift2 >> 5;
+    r2 = shift2 & 31;
+    i = 0;
+
+#if defined(MORPH_USE_NEON)
+    {
+    int32x4_t   l1, l2, rr1, rr2;
+    uint32x4_t  vinv, v1, v2;
+
+    l1 = vdupq_n_s32(r1);
+    rr1 = vdupq_n_s32(r1 - 32);
+    l2 = vdupq_n_s32(r2);
+    rr2 = vdupq_n_s32(r2 - 32);
+    vinv = vdupq_n_u32(inv);
+    for (; i + 4 <= n; i += 4) {
+        v1 = vorrq_u32(vshlq_u32(vld1q_u32(datas + i + q1), l1),
+                       vshlq_u32(vld1q_u32(datas + i + q1 + 1), rr1));
+        v2 = vorrq_u32(vshlq_u32(vld1q_u32(datas + i + q2), l2),
+                       vshlq_u32(vld1q_u32(datas + i + q2 + 1), rr2));
+        vst1q_u32(datad + i, veorq_u32(vorrq_u32(v1, v2), vinv));
+    }
+    }
+#elif defined(MORPH_USE_SSE2)
+    {
+    __m128i  l1, rr1, l2, rr2, vinv, v1, v2;
+
+    l1 = _mm_cvtsi32_si128(r1);
+    rr1 = _mm_cvtsi32_si128(32 - r1);
+    l2 = _mm_cvtsi32_si128(r2);
+    rr2 = _mm_cvtsi32_si128(32 - r2);
+    vinv = _mm_set1_epi32((int)inv);
+    for (; i + 4 <= n; i += 4) {
+        v1 = _mm_or_si128(
+            _mm_sll_epi32(_mm_loadu_si128((__m128i *)(datas + i + q1)), l1),
+            _mm_srl_epi32(_mm_loadu_si128((__m128i *)(datas + i + q1 + 1)),
+                          rr1));
+        v2 = _mm_or_si128(
+            _mm_sll_epi32(_mm_loadu_si128((__m128i *)(datas + i + q2)), l2),
+            _mm_srl_epi32(_mm_loadu_si128((__m128i *)(datas + i + q2 + 1)),
+                          rr2));
+        _mm_storeu_si128((__m128i *)(datad + i),
+                         _mm_xor_si128(_mm_or_si128(v1, v2), vinv));
+    }
+    }
+#endif  /* MORPH_USE_NEON */
+
+    for (; i < n; i++) {
+        w1 = datas[i + q1];
+        if (r1)
+            w1 = (w1 << r1) | (datas[i + q1 + 1] >> (32 - r1));
+        w2 = datas[i + q2];
+        if (r2)
+            w2 = (w2 << r2) | (datas[i + q2 + 1] >> (32 - r2));
+        datad[i] = (w1 | w2) ^ inv;
+    }
+}
+
+
+/*
+ *  orRowsLow()
+ *
+ *      Sets lined[i] = (line1[i] | line2[i]) ^ inv, for 0 <= i < n.
+ *      lined can be line1.
+ */
+static void
+orRowsLow(l_uint32  *lined,
+          l_uint32  *line1,
+          l_uint32  *line2,
+          l_int32    n,
+          l_uint32   inv)
+{
+l_int32  i;
+
+    i = 0;
+#if defined(MORPH_USE_NEON)
+    {
+    uint32x4_t  vinv;
+
+    vinv = vdupq_n_u32(inv);
+    for (; i + 4 <= n; i += 4) {
+        vst1q_u32(lined + i, veorq_u32(vorrq_u32(vld1q_u32(line1 + i),
+                                                 vld1q_u32(line2 + i)),
+                                       vinv));
+    }
+    }
+#elif defined(MORPH_USE_SSE2)
+    {
+    __m128i  vinv;
+
+    vinv = _mm_set1_epi32((int)inv);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i *)(lined + i),
+            _mm_xor_si128(_mm_or_si128(_mm_loadu_si128((__m128i *)(line1 + i)),
+                                       _mm_loadu_si128((__m128i *)(line2 + i))),
+                          vinv));
+    }
+    }
+#endif  /* MORPH_USE_NEON */
+
+    for (; i < n; i++)
+        lined[i] = (line1[i] | line2[i]) ^ inv;
+}
+
+
+/*-----------------------------------------------------------------*
+ *               Threads used for brick morphology                 *
+ *-----------------------------------------------------------------*/
+/*!
+ * \brief   l_morphSetNumThreads()
+ *
+ * \param[in]    nthreads max number of threads; use 0 for the number
+ *                        of processors online
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This sets the number of threads used for binary brick
+ *          morphology, pix*Brick(), and for grayscale morphology,
+ *          pix*Gray().  The default is 1, which does all the work on
+ *          the calling thread.
+ *      (2) It has no effect unless leptonica is built with HAVE_PTHREAD.
+ *      (3) The results do not depend on the number of threads.
+ * </pre>
+ */
+void
+l_morphSetNumThreads(l_int32  nthreads)
+{
+    MorphNumThreads = L_MAX(0, nthreads);
+}
+
+
 /*-----------------------------------------------------------------*
  *               Static helpers for arg processing                 *
  *-----------------------------------------------------------------*/
@@ -45,6 +45,7 @@
  *      Conversion from RGB color to grayscale
  *           PIX        *pixConvertRGBToLuminance()
  *           PIX        *pixConvertRGBToGray()
+ *           static l_int32  convertRGBToGrayLineLow()
  *           PIX        *pixConvertRGBToGrayFast()
  *           PIX        *pixConvertRGBToGrayMinMax()
  *           PIX        *pixConvertRGBToGraySatBoost()
@@ -148,6 +149,17 @@
 #include <string.h>
 #include <math.h>
 #include "allheaders.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define  PIXCONV_USE_NEON  1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define  PIXCONV_USE_SSE2  1
+#endif
+
+static l_int32 convertRGBToGrayLineLow(l_uint32 *lined, const l_uint32 *lines,
+                                       l_int32 w, l_float32 rwt,
+                                       l_float32 gwt, l_float32 bwt);
 
 /* ------- Set neutral point for min/max boost conversion to gray ------ */
    /* Call l_setNeutralBoostVal() to change this */
@@ -740,6 +752,8 @@ pixConvertRGBToLuminance(PIX *pixs)
  * <pre>
  * Notes:
  *      (1) Use a weighted average of the RGB values.
+ *      (2) With NEON or SSE2, 16 pixels are converted at a time,
+ *          with the same result.
  * </pre>
  */
 PIX *
@@ -791,7 +805,8 @@ PIX       *pixd;
     for (i = 0; i < h; i++) {
         lines = datas + i * wpls;
         lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
+        j = convertRGBToGrayLineLow(lined, lines, w, rwt, gwt, bwt);
+        for (; j < w; j++) {
             word = *(lines + j);
             val = (l_int32)(rwt * ((word >> L_RED_SHIFT) & 0xff) +
                             gwt * ((word >> L_GREEN_SHIFT) & 0xff) +
@@ -804,6 +819,117 @@ PIX       *pixd;
 }
 
 
+/*!
+ * \brief   convertRGBToGrayLineLow()
+ *
+ * \param[in]    lined 8 bpp dest line
+ * \param[in]    lines 32 bpp src line
+ * \param[in]    w width in pixels
+ * \param[in]    rwt, gwt, bwt weights, adding to 1.0
+ * \return  number of pixels converted, a multiple of 16
+ *
+ * <pre>
+ * Notes:
+ *      (1) This does the same float operations as pixConvertRGBToGray(),
+ *          in the same order.  The rounding of the sum s, which is done
+ *          there in double precision as (l_int32)(s + 0.5), is done
+ *          exactly here by adding 1 to the integer part of s if its
+ *          fractional part is at least 0.5.
+ *      (2) The 16 gray values are in pixel order, and are swapped
+ *          within each word on little-endian machines.
+ *      (3) Without NEON or SSE2 this does nothing.
+ * </pre>
+ */
+static l_int32
+convertRGBToGrayLineLow(l_uint32        *lined,
+                        const l_uint32  *lines,
+                        l_int32          w,
+                        l_float32        rwt,
+                        l_float32        gwt,
+                        l_float32        bwt)
+{
+l_int32       j;
+#if defined(PIXCONV_USE_NEON)
+l_int32       k;
+float32x4_t   rw, gw, bw, half, sum;
+uint32x4_t    mask, word, val[4];
+uint8x16_t    bytes;
+#elif defined(PIXCONV_USE_SSE2)
+l_int32      k;
+__m128       rw, gw, bw, half, sum;
+__m128i      mask, word, val[4], bytes;
+#endif
+
+    j = 0;
+#if defined(PIXCONV_USE_NEON)
+    rw = vdupq_n_f32(rwt);
+    gw = vdupq_n_f32(gwt);
+    bw = vdupq_n_f32(bwt);
+    half = vdupq_n_f32(0.5);
+    mask = vdupq_n_u32(0xff);
+    for (; j + 16 <= w; j += 16) {
+            /* The shifts are L_RED_SHIFT, L_GREEN_SHIFT and L_BLUE_SHIFT,
+             * which NEON needs as literal constants */
+        for (k = 0; k < 4; k++) {
+            word = vld1q_u32(lines + j + 4 * k);
+            sum = vaddq_f32(
+                vaddq_f32(
+                    vmulq_f32(rw, vcvtq_f32_u32(
+                        vandq_u32(vshrq_n_u32(word, 24), mask))),
+                    vmulq_f32(gw, vcvtq_f32_u32(
+                        vandq_u32(vshrq_n_u32(word, 16), mask)))),
+                vmulq_f32(bw, vcvtq_f32_u32(
+                    vandq_u32(vshrq_n_u32(word, 8), mask))));
+            val[k] = vcvtq_u32_f32(sum);
+            val[k] = vsubq_u32(val[k],
+                         vcgeq_f32(vsubq_f32(sum, vcvtq_f32_u32(val[k])),
+                                   half));
+        }
+        bytes = vcombine_u8(
+            vmovn_u16(vcombine_u16(vmovn_u32(val[0]), vmovn_u32(val[1]))),
+            vmovn_u16(vcombine_u16(vmovn_u32(val[2]), vmovn_u32(val[3]))));
+#ifndef L_BIG_ENDIAN
+        bytes = vrev32q_u8(bytes);
+#endif  /* L_BIG_ENDIAN */
+        vst1q_u8((l_uint8 *)(lined + j / 4), bytes);
+    }
+#elif defined(PIXCONV_USE_SSE2)
+    rw = _mm_set1_ps(rwt);
+    gw = _mm_set1_ps(gwt);
+    bw = _mm_set1_ps(bwt);
+    half = _mm_set1_ps(0.5);
+    mask = _mm_set1_epi32(0xff);
+    for (; j + 16 <= w; j += 16) {
+        for (k = 0; k < 4; k++) {
+            word = _mm_loadu_si128((const __m128i *)(lines + j + 4 * k));
+            sum = _mm_add_ps(
+                _mm_add_ps(
+                    _mm_mul_ps(rw, _mm_cvtepi32_ps(_mm_and_si128(
+                        _mm_srli_epi32(word, L_RED_SHIFT), mask))),
+                    _mm_mul_ps(gw, _mm_cvtepi32_ps(_mm_and_si128(
+                        _mm_srli_epi32(word, L_GREEN_SHIFT), mask)))),
+                _mm_mul_ps(bw, _mm_cvtepi32_ps(_mm_and_si128(
+                    _mm_srli_epi32(word, L_BLUE_SHIFT), mask))));
+            val[k] = _mm_cvttps_epi32(sum);
+            val[k] = _mm_sub_epi32(val[k], _mm_castps_si128(
+                         _mm_cmpge_ps(_mm_sub_ps(sum, _mm_cvtepi32_ps(val[k])),
+                                      half)));
+        }
+        bytes = _mm_packus_epi16(_mm_packs_epi32(val[0], val[1]),
+                                 _mm_packs_epi32(val[2], val[3]));
+#ifndef L_BIG_ENDIAN
+        bytes = _mm_or_si128(_mm_slli_epi16(bytes, 8),
+                             _mm_srli_epi16(bytes, 8));
+        bytes = _mm_shufflehi_epi16(_mm_shufflelo_epi16(bytes, 0xb1), 0xb1);
+#endif  /* L_BIG_ENDIAN */
+        _mm_storeu_si128((__m128i *)(lined + j / 4), bytes);
+    }
+#endif
+
+    return j;
+}
+
+
 /*!
  * \brief   pixConvertRGBToGrayFast()
  *
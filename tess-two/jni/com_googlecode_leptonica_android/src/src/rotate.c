@@ -35,6 +35,7 @@
  *
  *     General rotation by sampling
  *              PIX     *pixRotateBySampling()
+ *              static void  rotateSampleTask()
  *
  *     Nice (slow) rotation of 1 bpp image
  *              PIX     *pixRotateBinaryNice()
@@ -42,6 +43,9 @@
  *     Rotation including alpha (blend) component
  *              PIX     *pixRotateWithAlpha()
  *
+ *     Threads used for rotation by sampling and area mapping
+ *              void     l_rotateSetNumThreads()
+ *
  *     Rotations are measured in radians; clockwise is positive.
  *
  *     The general rotation pixRotate() does the best job for
@@ -50,6 +54,10 @@
  *     If requested, it expands the output image so that no pixels are lost
  *     in the rotation, and this can be done on multiple successive shears
  *     without expanding beyond the maximum necessary size.
+ *
+ *     Rotation by sampling and by area mapping is done in bands of
+ *     rows, which can be shared among several threads; see
+ *     l_rotateSetNumThreads().
  * </pre>
  */
 
@@ -61,6 +69,37 @@ static const l_float32  MIN_ANGLE_TO_ROTATE = 0.001;  /* radians; ~0.06 deg */
 static const l_float32  MAX_1BPP_SHEAR_ANGLE = 0.06;  /* radians; ~3 deg    */
 static const l_float32  LIMIT_SHEAR_ANGLE = 0.35;     /* radians; ~20 deg   */
 
+    /* Global variable; initialized here; declared extern in rotateamlow.c.
+     * Number of threads used for rotation, or 0 for the number of
+     * processors online; default is 1.  Set with l_rotateSetNumThreads(). */
+LEPT_DLL l_int32  RotateNumThreads = 1;
+
+    /* Number of dest rows rotated by each task in pixRotateBySampling() */
+static const l_int32  ROTATE_SAMPLE_BAND_ROWS = 32;
+
+    /* Parameters shared by the tasks of pixRotateBySampling() */
+struct RotateSample
+{
+    void      **lines;     /*!< source line ptrs                         */
+    l_uint32   *datad;     /*!< dest data                                */
+    l_int32     wpld;      /*!< dest words in each row                   */
+    l_int32     w;         /*!< width of both images                     */
+    l_int32     h;         /*!< height of both images                    */
+    l_int32     d;         /*!< depth of both images                     */
+    l_int32     xcen;      /*!< x value of center of rotation            */
+    l_int32     ycen;      /*!< y value of center of rotation            */
+    l_int32     incolor;   /*!< L_BRING_IN_WHITE, L_BRING_IN_BLACK       */
+    l_float32   sina;      /*!< sin(angle)                               */
+    l_float32   cosa;      /*!< cos(angle)                               */
+    l_float32  *xcos;      /*!< -xdif * cosa for each column             */
+    l_float32  *xsin;      /*!< xdif * sina for each column; in the same
+                                allocation as xcos                       */
+    l_int32    *taskerr;   /*!< set for each band that failed            */
+};
+typedef struct RotateSample  ROTATE_SAMPLE;
+
+static void rotateSampleTask(void *data, l_int32 index);
+
 
 /*------------------------------------------------------------------*
  *                  General rotation about the center               *
@@ -327,12 +366,10 @@ pixRotateBySampling(PIX       *pixs,
                     l_float32  angle,
                     l_int32    incolor)
 {
-l_int32    w, h, d, i, j, x, y, xdif, ydif, wm1, hm1, wpld;
-l_uint32   val;
-l_float32  sina, cosa;
-l_uint32  *datad, *lined;
-void     **lines;
-PIX       *pixd;
+l_int32         w, h, d, i, j, xdif, nbands, error;
+l_float32       sina, cosa;
+ROTATE_SAMPLE   rs;
+PIX            *pixd;
 
     PROCNAME("pixRotateBySampling");
 
@@ -351,77 +388,155 @@ PIX       *pixd;
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     pixSetBlackOrWhite(pixd, incolor);
 
+        /* Tabulate the products that depend only on the column */
     sina = sin(angle);
     cosa = cos(angle);
-    datad = pixGetData(pixd);
-    wpld = pixGetWpl(pixd);
+    nbands = (h + ROTATE_SAMPLE_BAND_ROWS - 1) / ROTATE_SAMPLE_BAND_ROWS;
+    rs.xcos = (l_float32 *)LEPT_CALLOC(2 * w, sizeof(l_float32));
+    rs.lines = pixGetLinePtrs(pixs, NULL);
+    rs.taskerr = (l_int32 *)LEPT_CALLOC(nbands, sizeof(l_int32));
+    if (!rs.xcos || !rs.lines || !rs.taskerr) {
+        LEPT_FREE(rs.xcos);
+        LEPT_FREE(rs.lines);
+        LEPT_FREE(rs.taskerr);
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("tables not made", procName, NULL);
+    }
+    rs.xsin = rs.xcos + w;
+    for (j = 0; j < w; j++) {
+        xdif = xcen - j;
+        rs.xcos[j] = -xdif * cosa;
+        rs.xsin[j] = xdif * sina;
+    }
+    rs.datad = pixGetData(pixd);
+    rs.wpld = pixGetWpl(pixd);
+    rs.w = w;
+    rs.h = h;
+    rs.d = d;
+    rs.xcen = xcen;
+    rs.ycen = ycen;
+    rs.incolor = incolor;
+    rs.sina = sina;
+    rs.cosa = cosa;
+    l_runTasks(rotateSampleTask, &rs, nbands, RotateNumThreads);
+
+    for (i = 0, error = 0; i < nbands; i++)
+        error |= rs.taskerr[i];
+    LEPT_FREE(rs.xcos);
+    LEPT_FREE(rs.lines);
+    LEPT_FREE(rs.taskerr);
+    if (error) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("band buffers not made", procName, NULL);
+    }
+    return pixd;
+}
+
+
+/*!
+ * \brief   rotateSampleTask()
+ *
+ * <pre>
+ * Notes:
+ *      (1) Rotates one band of ROTATE_SAMPLE_BAND_ROWS dest rows.
+ *      (2) The source pixel of dest pixel (j, i) is at
+ *              x = xcen + (l_int32)(-xdif * cosa - ydif * sina)
+ *              y = ycen + (l_int32)(-ydif * cosa + xdif * sina)
+ *          with xdif = xcen - j and ydif = ycen - i.  The products
+ *          that depend only on j are tabulated, and the others are
+ *          found once for each row.  The source locations for the
+ *          row are found first, so that the copying loop for each
+ *          depth is simple.  Pixels with no source keep the color
+ *          set by pixRotateBySampling().
+ *      (3) Sets taskerr[index] if the band buffers cannot be made.
+ * </pre>
+ */
+static void
+rotateSampleTask(void     *data,
+                 l_int32   index)
+{
+l_int32         i, j, w, wm1, hm1, ydif, x, y, i1;
+l_int32        *xs, *ys;
+l_uint32       *lined;
+l_float32       ysin, ycos;
+void          **lines;
+ROTATE_SAMPLE  *rs;
+
+    rs = (ROTATE_SAMPLE *)data;
+    w = rs->w;
     wm1 = w - 1;
-    hm1 = h - 1;
-    lines = pixGetLinePtrs(pixs, NULL);
-
-        /* Treat 1 bpp case specially */
-    if (d == 1) {
-        for (i = 0; i < h; i++) {  /* scan over pixd */
-            lined = datad + i * wpld;
-            ydif = ycen - i;
+    hm1 = rs->h - 1;
+    lines = rs->lines;
+    if ((xs = (l_int32 *)LEPT_CALLOC(2 * w, sizeof(l_int32))) == NULL) {
+        rs->taskerr[index] = 1;
+        return;
+    }
+    ys = xs + w;
+
+    i1 = L_MIN(rs->h, (index + 1) * ROTATE_SAMPLE_BAND_ROWS);
+    for (i = index * ROTATE_SAMPLE_BAND_ROWS; i < i1; i++) {
+        lined = rs->datad + i * rs->wpld;
+        ydif = rs->ycen - i;
+        ysin = ydif * rs->sina;
+        ycos = -ydif * rs->cosa;
+        for (j = 0; j < w; j++) {
+            x = rs->xcen + (l_int32)(rs->xcos[j] - ysin);
+            y = rs->ycen + (l_int32)(ycos + rs->xsin[j]);
+            if (x < 0 || x > wm1 || y < 0 || y > hm1)
+                x = -1;
+            xs[j] = x;
+            ys[j] = y;
+        }
+
+        switch (rs->d)
+        {
+        case 1:
             for (j = 0; j < w; j++) {
-                xdif = xcen - j;
-                x = xcen + (l_int32)(-xdif * cosa - ydif * sina);
-                if (x < 0 || x > wm1) continue;
-                y = ycen + (l_int32)(-ydif * cosa + xdif * sina);
-                if (y < 0 || y > hm1) continue;
-                if (incolor == L_BRING_IN_WHITE) {
-                    if (GET_DATA_BIT(lines[y], x))
+                if ((x = xs[j]) < 0) continue;
+                if (rs->incolor == L_BRING_IN_WHITE) {
+                    if (GET_DATA_BIT(lines[ys[j]], x))
                         SET_DATA_BIT(lined, j);
                 } else {
-                    if (!GET_DATA_BIT(lines[y], x))
+                    if (!GET_DATA_BIT(lines[ys[j]], x))
                         CLEAR_DATA_BIT(lined, j);
                 }
             }
-        }
-        LEPT_FREE(lines);
-        return pixd;
-    }
-
-    for (i = 0; i < h; i++) {  /* scan over pixd */
-        lined = datad + i * wpld;
-        ydif = ycen - i;
-        for (j = 0; j < w; j++) {
-            xdif = xcen - j;
-            x = xcen + (l_int32)(-xdif * cosa - ydif * sina);
-            if (x < 0 || x > wm1) continue;
-            y = ycen + (l_int32)(-ydif * cosa + xdif * sina);
-            if (y < 0 || y > hm1) continue;
-            switch (d)
-            {
-            case 8:
-                val = GET_DATA_BYTE(lines[y], x);
-                SET_DATA_BYTE(lined, j, val);
-                break;
-            case 32:
-                val = GET_DATA_FOUR_BYTES(lines[y], x);
-                SET_DATA_FOUR_BYTES(lined, j, val);
-                break;
-            case 2:
-                val = GET_DATA_DIBIT(lines[y], x);
-                SET_DATA_DIBIT(lined, j, val);
-                break;
-            case 4:
-                val = GET_DATA_QBIT(lines[y], x);
-                SET_DATA_QBIT(lined, j, val);
-                break;
-            case 16:
-                val = GET_DATA_TWO_BYTES(lines[y], x);
-                SET_DATA_TWO_BYTES(lined, j, val);
-                break;
-            default:
-                return (PIX *)ERROR_PTR("invalid depth", procName, NULL);
+            break;
+        case 2:
+            for (j = 0; j < w; j++) {
+                if ((x = xs[j]) < 0) continue;
+                SET_DATA_DIBIT(lined, j, GET_DATA_DIBIT(lines[ys[j]], x));
             }
+            break;
+        case 4:
+            for (j = 0; j < w; j++) {
+                if ((x = xs[j]) < 0) continue;
+                SET_DATA_QBIT(lined, j, GET_DATA_QBIT(lines[ys[j]], x));
+            }
+            break;
+        case 8:
+            for (j = 0; j < w; j++) {
+                if ((x = xs[j]) < 0) continue;
+                SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines[ys[j]], x));
+            }
+            break;
+        case 16:
+            for (j = 0; j < w; j++) {
+                if ((x = xs[j]) < 0) continue;
+                SET_DATA_TWO_BYTES(lined, j,
+                                   GET_DATA_TWO_BYTES(lines[ys[j]], x));
+            }
+            break;
+        default:  /* d == 32 */
+            for (j = 0; j < w; j++) {
+                if ((x = xs[j]) < 0) continue;
+                lined[j] = ((l_uint32 *)lines[ys[j]])[x];
+            }
+            break;
         }
     }
 
-    LEPT_FREE(lines);
-    return pixd;
+    LEPT_FREE(xs);
 }
 
 
@@ -598,3 +713,33 @@ PIX     *pixd, *pix32, *pixg2, *pixgr;
     pixDestroy(&pixgr);
     return pixd;
 }
+
+
+/*------------------------------------------------------------------*
+ *     Threads used for rotation by sampling and area mapping       *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   l_rotateSetNumThreads()
+ *
+ * \param[in]    nthreads max number of threads; use 0 for the number
+ *                        of processors online
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This sets the number of threads used for rotation by
+ *          sampling, pixRotateBySampling(), and by area mapping
+ *          about the center, pixRotateAMGray() and pixRotateAMColor().
+ *          These are the rotations done by pixRotate() for all but
+ *          small angles of 1 bpp images.  The default is 1, which does
+ *          all the work on the calling thread.
+ *      (2) The bands are rotated with l_runTasks(), so this has no
+ *          effect unless leptonica is built with HAVE_PTHREAD.
+ *      (3) The results do not depend on the number of threads.
+ * </pre>
+ */
+void
+l_rotateSetNumThreads(l_int32  nthreads)
+{
+    RotateNumThreads = L_MAX(0, nthreads);
+}
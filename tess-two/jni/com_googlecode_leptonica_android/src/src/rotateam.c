@@ -53,9 +53,9 @@
  *     the color image into three 8 bpp images, rotate each of these,
  *     and then combine the result.  Method (1) is about 2.5x faster.
  *     We have also implemented a fast approximation for color area-mapping
- *     rotation (pixRotateAMColorFast()), which is about 25% faster
- *     than the standard color rotator.  If you need the extra speed,
- *     use it.
+ *     rotation (pixRotateAMColorFast()).  It was about 25% faster than
+ *     the standard color rotator, but that is now vectorized (see below)
+ *     and is the faster of the two where NEON or SSE2 is available.
  *
  *     Area mapping works as follows.  For each dest
  *     pixel you find the 4 source pixels that it partially
@@ -85,12 +85,16 @@
  *
  *     But it is still pretty fast.  With standard 3 GHz hardware,
  *     the anti-aliased (area-mapped) color rotation speed is
- *     about 15 million pixels/sec.
+ *     about 15 million pixels/sec with scalar code.  For rotation
+ *     about the center, the area weighting is done with NEON or SSE2
+ *     where available, and bands of rows can be done on several
+ *     threads (see l_rotateSetNumThreads()).  On one thread with SSE2,
+ *     this is about 100 million pixels/sec for color and gray.
  *
- *     The function pixRotateAMColorFast() is about 10-20% faster
- *     than pixRotateAMColor().  The quality is slightly worse,
- *     and if you make many successive small rotations, with a
- *     total angle of 360 degrees, it has been noted that the
+ *     Without vectorization, the function pixRotateAMColorFast() is
+ *     about 10-20% faster than pixRotateAMColor().  The quality is
+ *     slightly worse, and if you make many successive small rotations,
+ *     with a total angle of 360 degrees, it has been noted that the
  *     center wanders -- it seems to be doing a 1 pixel translation
  *     in addition to the rotation.
  * </pre>
@@ -205,16 +209,24 @@ PIX       *pix1, *pix2, *pixd;
     pixGetDimensions(pixs, &w, &h, NULL);
     datas = pixGetData(pixs);
     wpls = pixGetWpl(pixs);
-    pixd = pixCreateTemplate(pixs);
+    if ((pixd = pixCreateTemplate(pixs)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
 
-    rotateAMColorLow(datad, w, h, wpld, datas, wpls, angle, colorval);
+    if (rotateAMColorLow(datad, w, h, wpld, datas, wpls, angle, colorval)) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("rotation failed", procName, NULL);
+    }
     if (pixGetSpp(pixs) == 4) {
         pix1 = pixGetRGBComponent(pixs, L_ALPHA_CHANNEL);
         pix2 = pixRotateAMGray(pix1, angle, 255);  /* bring in opaque */
-        pixSetRGBComponent(pixd, pix2, L_ALPHA_CHANNEL);
         pixDestroy(&pix1);
+        if (!pix2) {
+            pixDestroy(&pixd);
+            return (PIX *)ERROR_PTR("alpha not rotated", procName, NULL);
+        }
+        pixSetRGBComponent(pixd, pix2, L_ALPHA_CHANNEL);
         pixDestroy(&pix2);
     }
 
@@ -259,11 +271,15 @@ PIX        *pixd;
     pixGetDimensions(pixs, &w, &h, NULL);
     datas = pixGetData(pixs);
     wpls = pixGetWpl(pixs);
-    pixd = pixCreateTemplate(pixs);
+    if ((pixd = pixCreateTemplate(pixs)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
 
-    rotateAMGrayLow(datad, w, h, wpld, datas, wpls, angle, grayval);
+    if (rotateAMGrayLow(datad, w, h, wpld, datas, wpls, angle, grayval)) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("rotation failed", procName, NULL);
+    }
 
     return pixd;
 }
@@ -32,10 +32,10 @@
  *      Grayscale and color rotation (area mapped)
  *
  *          32 bpp grayscale rotation about image center
- *               void    rotateAMColorLow()
+ *               l_int32 rotateAMColorLow()
  *
  *          8 bpp grayscale rotation about image center
- *               void    rotateAMGrayLow()
+ *               l_int32 rotateAMGrayLow()
  *
  *          32 bpp grayscale rotation about UL corner of image
  *               void    rotateAMColorCornerLow()
@@ -46,18 +46,100 @@
  *          Fast RGB color rotation about center:
  *               void    rotateAMColorFastLow()
  *
+ *          Helpers for rotation about the center
+ *               static l_int32  rotateAMInit()
+ *               static l_int32  rotateAMFinish()
+ *               static void     rotateAMCoords()
+ *               static void     rotateAMColorTask()
+ *               static void     rotateAMGrayTask()
+ *               static void     rotateAMColorBlend()
+ *               static void     rotateAMGrayBlend()
+ *               static (NEON or SSE2 vector)  rotateAMBlend16()
+ *
+ *      Rotation about the center is done in bands of rows, which are
+ *      shared among the threads set by l_rotateSetNumThreads().  Each
+ *      band is done in tiles of columns.  For each row of a tile, the
+ *      sampling points are found from tables of the
+ *      column products, the source pixels are gathered, and the area
+ *      weighting is done with NEON or SSE2 where available.  The
+ *      results do not depend on the number of threads.
  * </pre>
  */
 
 #include <string.h>
 #include <math.h>   /* required for sin and tan */
 #include "allheaders.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define  ROTATE_USE_NEON  1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define  ROTATE_USE_SSE2  1
+#endif
+
+    /* Number of threads for the bands; defined in rotate.c */
+extern l_int32  RotateNumThreads;
+
+    /* Number of dest rows rotated by each task about the center,
+     * and number of columns rotated at a time within the task */
+static const l_int32  ROTATE_AM_BAND_ROWS = 32;
+static const l_int32  ROTATE_AM_TILE_COLS = 256;   /* multiple of 8 */
+
+/*!
+ * \brief   The struct RotateAM holds the parameters of an area-map
+ *  rotation about the center, shared by the tasks that do its bands.
+ */
+struct RotateAM
+{
+    l_uint32   *datad;    /*!< dest data                                 */
+    l_int32     w;        /*!< width of both images                      */
+    l_int32     h;        /*!< height of both images                     */
+    l_int32     wpld;     /*!< dest words in each row                    */
+    l_uint32   *datas;    /*!< source data                               */
+    l_int32     wpls;     /*!< source words in each row                  */
+    l_uint32    fillval;  /*!< colorval or grayval brought in            */
+    l_float32   sina;     /*!< 16 * sin(angle)                           */
+    l_float32   cosa;     /*!< 16 * cos(angle)                           */
+    l_float32  *xcos;     /*!< -xdif * cosa for each column              */
+    l_float32  *xsin;     /*!< xdif * sina for each column; in the same
+                               allocation as xcos                        */
+    l_int32     nbands;   /*!< number of bands of dest rows              */
+    l_int32    *taskerr;  /*!< set for each band that failed             */
+};
+typedef struct RotateAM  ROTATE_AM;
+
+static l_int32 rotateAMInit(ROTATE_AM *ra, l_uint32 *datad, l_int32 w,
+                            l_int32 h, l_int32 wpld, l_uint32 *datas,
+                            l_int32 wpls, l_float32 angle, l_uint32 fillval);
+static l_int32 rotateAMFinish(ROTATE_AM *ra);
+static void rotateAMCoords(l_int32 *xpm, l_int32 *ypm, const l_float32 *xcos,
+                           const l_float32 *xsin, l_float32 ysin,
+                           l_float32 ycos, l_int32 w);
+static void rotateAMColorTask(void *data, l_int32 index);
+static void rotateAMGrayTask(void *data, l_int32 index);
+static void rotateAMColorBlend(l_uint32 *lined, const l_uint32 *w00,
+                               const l_uint32 *w10, const l_uint32 *w01,
+                               const l_uint32 *w11, const l_uint16 *wx,
+                               const l_uint16 *wy, const l_uint32 *amask,
+                               l_int32 n);
+static void rotateAMGrayBlend(l_uint8 *vald, const l_uint16 *v00,
+                              const l_uint16 *v10, const l_uint16 *v01,
+                              const l_uint16 *v11, const l_uint16 *xf,
+                              const l_uint16 *yf, l_int32 n);
+#if ROTATE_USE_NEON
+static uint16x8_t rotateAMBlend16(uint16x8_t v00, uint16x8_t v10,
+                                  uint16x8_t v01, uint16x8_t v11,
+                                  uint16x8_t xf, uint16x8_t yf);
+#elif ROTATE_USE_SSE2
+static __m128i rotateAMBlend16(__m128i v00, __m128i v10, __m128i v01,
+                               __m128i v11, __m128i xf, __m128i yf);
+#endif  /* ROTATE_USE_NEON */
 
 
 /*------------------------------------------------------------------*
  *             32 bpp grayscale rotation about the center           *
  *------------------------------------------------------------------*/
-void
+l_int32
 rotateAMColorLow(l_uint32  *datad,
                  l_int32    w,
                  l_int32    h,
@@ -67,73 +149,23 @@ rotateAMColorLow(l_uint32  *datad,
                  l_float32  angle,
                  l_uint32   colorval)
 {
-l_int32    i, j, xcen, ycen, wm2, hm2;
-l_int32    xdif, ydif, xpm, ypm, xp, yp, xf, yf;
-l_int32    rval, gval, bval;
-l_uint32   word00, word01, word10, word11;
-l_uint32  *lines, *lined;
-l_float32  sina, cosa;
-
-    xcen = w / 2;
-    wm2 = w - 2;
-    ycen = h / 2;
-    hm2 = h - 2;
-    sina = 16. * sin(angle);
-    cosa = 16. * cos(angle);
-
-    for (i = 0; i < h; i++) {
-        ydif = ycen - i;
-        lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            xdif = xcen - j;
-            xpm = (l_int32)(-xdif * cosa - ydif * sina);
-            ypm = (l_int32)(-ydif * cosa + xdif * sina);
-            xp = xcen + (xpm >> 4);
-            yp = ycen + (ypm >> 4);
-            xf = xpm & 0x0f;
-            yf = ypm & 0x0f;
-
-                /* if off the edge, write input colorval */
-            if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
-                *(lined + j) = colorval;
-                continue;
-            }
-
-            lines = datas + yp * wpls;
+ROTATE_AM  ra;
 
-                /* do area weighting.  Without this, we would
-                 * simply do:
-                 *   *(lined + j) = *(lines + xp);
-                 * which is faster but gives lousy results!
-                 */
-            word00 = *(lines + xp);
-            word10 = *(lines + xp + 1);
-            word01 = *(lines + wpls + xp);
-            word11 = *(lines + wpls + xp + 1);
-            rval = ((16 - xf) * (16 - yf) * ((word00 >> L_RED_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_RED_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_RED_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_RED_SHIFT) & 0xff) + 128) / 256;
-            gval = ((16 - xf) * (16 - yf) * ((word00 >> L_GREEN_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_GREEN_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_GREEN_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_GREEN_SHIFT) & 0xff) + 128) / 256;
-            bval = ((16 - xf) * (16 - yf) * ((word00 >> L_BLUE_SHIFT) & 0xff) +
-                    xf * (16 - yf) * ((word10 >> L_BLUE_SHIFT) & 0xff) +
-                    (16 - xf) * yf * ((word01 >> L_BLUE_SHIFT) & 0xff) +
-                    xf * yf * ((word11 >> L_BLUE_SHIFT) & 0xff) + 128) / 256;
-            composeRGBPixel(rval, gval, bval, lined + j);
-        }
-    }
+    PROCNAME("rotateAMColorLow");
 
-    return;
+    if (rotateAMInit(&ra, datad, w, h, wpld, datas, wpls, angle, colorval))
+        return ERROR_INT("column tables not made", procName, 1);
+    l_runTasks(rotateAMColorTask, &ra, ra.nbands, RotateNumThreads);
+    if (rotateAMFinish(&ra))
+        return ERROR_INT("tile buffers not made", procName, 1);
+    return 0;
 }
 
 
 /*------------------------------------------------------------------*
  *             8 bpp grayscale rotation about the center            *
  *------------------------------------------------------------------*/
-void
+l_int32
 rotateAMGrayLow(l_uint32  *datad,
                 l_int32    w,
                 l_int32    h,
@@ -143,56 +175,546 @@ rotateAMGrayLow(l_uint32  *datad,
                 l_float32  angle,
                 l_uint8    grayval)
 {
-l_int32    i, j, xcen, ycen, wm2, hm2;
-l_int32    xdif, ydif, xpm, ypm, xp, yp, xf, yf;
-l_int32    v00, v01, v10, v11;
-l_uint8    val;
-l_uint32  *lines, *lined;
+ROTATE_AM  ra;
+
+    PROCNAME("rotateAMGrayLow");
+
+    if (rotateAMInit(&ra, datad, w, h, wpld, datas, wpls, angle, grayval))
+        return ERROR_INT("column tables not made", procName, 1);
+    l_runTasks(rotateAMGrayTask, &ra, ra.nbands, RotateNumThreads);
+    if (rotateAMFinish(&ra))
+        return ERROR_INT("tile buffers not made", procName, 1);
+    return 0;
+}
+
+
+/*------------------------------------------------------------------*
+ *          Helpers for area-map rotation about the center          *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   rotateAMInit()
+ *
+ * <pre>
+ * Notes:
+ *      (1) The sampling point of dest pixel (j, i), in 1/16 pixel units
+ *          relative to the center, is
+ *              xpm = (l_int32)(-xdif * cosa - ydif * sina)
+ *              ypm = (l_int32)(-ydif * cosa + xdif * sina)
+ *          with xdif = xcen - j and ydif = ycen - i.  The products
+ *          that depend only on j are tabulated here, and those that
+ *          depend only on i are found once for each row, so each
+ *          pixel needs just a float add and a conversion for each
+ *          coordinate.  The products are the same floats as in the
+ *          expressions above, so the sampling points do not change,
+ *          except where a compiler had fused the multiply and the add.
+ *          There the point can move by 1/16 pixel.
+ *      (2) Also makes the error flag of each band; free everything
+ *          with rotateAMFinish().
+ * </pre>
+ */
+static l_int32
+rotateAMInit(ROTATE_AM  *ra,
+             l_uint32   *datad,
+             l_int32     w,
+             l_int32     h,
+             l_int32     wpld,
+             l_uint32   *datas,
+             l_int32     wpls,
+             l_float32   angle,
+             l_uint32    fillval)
+{
+l_int32    j, xdif;
 l_float32  sina, cosa;
 
+    ra->datad = datad;
+    ra->w = w;
+    ra->h = h;
+    ra->wpld = wpld;
+    ra->datas = datas;
+    ra->wpls = wpls;
+    ra->fillval = fillval;
+    ra->sina = sina = 16. * sin(angle);
+    ra->cosa = cosa = 16. * cos(angle);
+    ra->nbands = (h + ROTATE_AM_BAND_ROWS - 1) / ROTATE_AM_BAND_ROWS;
+    ra->xcos = (l_float32 *)LEPT_CALLOC(2 * w, sizeof(l_float32));
+    ra->taskerr = (l_int32 *)LEPT_CALLOC(ra->nbands, sizeof(l_int32));
+    if (!ra->xcos || !ra->taskerr) {
+        LEPT_FREE(ra->xcos);
+        LEPT_FREE(ra->taskerr);
+        return 1;
+    }
+    ra->xsin = ra->xcos + w;
+    for (j = 0; j < w; j++) {
+        xdif = w / 2 - j;
+        ra->xcos[j] = -xdif * cosa;
+        ra->xsin[j] = xdif * sina;
+    }
+    return 0;
+}
+
+
+/*!
+ * \brief   rotateAMFinish()
+ *
+ * <pre>
+ * Notes:
+ *      (1) Frees what rotateAMInit() made, and returns 1 if any band
+ *          failed, or 0 if all were rotated.
+ * </pre>
+ */
+static l_int32
+rotateAMFinish(ROTATE_AM  *ra)
+{
+l_int32  i, error;
+
+    for (i = 0, error = 0; i < ra->nbands; i++)
+        error |= ra->taskerr[i];
+    LEPT_FREE(ra->xcos);
+    LEPT_FREE(ra->taskerr);
+    return error;
+}
+
+
+/*!
+ * \brief   rotateAMCoords()
+ *
+ * <pre>
+ * Notes:
+ *      (1) Finds the sampling points of one dest row, in 1/16 pixel
+ *          units relative to the center; see rotateAMInit().
+ *          The conversions truncate toward zero, as a cast does.
+ * </pre>
+ */
+static void
+rotateAMCoords(l_int32          *xpm,
+               l_int32          *ypm,
+               const l_float32  *xcos,
+               const l_float32  *xsin,
+               l_float32         ysin,
+               l_float32         ycos,
+               l_int32           w)
+{
+l_int32  j;
+
+    j = 0;
+#if ROTATE_USE_NEON
+    {
+    float32x4_t  ys, yc;
+    ys = vdupq_n_f32(ysin);
+    yc = vdupq_n_f32(ycos);
+    for (; j + 4 <= w; j += 4) {
+        vst1q_s32(xpm + j, vcvtq_s32_f32(vsubq_f32(vld1q_f32(xcos + j), ys)));
+        vst1q_s32(ypm + j, vcvtq_s32_f32(vaddq_f32(yc, vld1q_f32(xsin + j))));
+    }
+    }
+#elif ROTATE_USE_SSE2
+    {
+    __m128  ys, yc;
+    ys = _mm_set1_ps(ysin);
+    yc = _mm_set1_ps(ycos);
+    for (; j + 4 <= w; j += 4) {
+        _mm_storeu_si128((__m128i *)(xpm + j),
+                         _mm_cvttps_epi32(_mm_sub_ps(_mm_loadu_ps(xcos + j),
+                                                     ys)));
+        _mm_storeu_si128((__m128i *)(ypm + j),
+                         _mm_cvttps_epi32(_mm_add_ps(yc,
+                                                     _mm_loadu_ps(xsin + j))));
+    }
+    }
+#endif  /* ROTATE_USE_NEON */
+    for (; j < w; j++) {
+        xpm[j] = (l_int32)(xcos[j] - ysin);
+        ypm[j] = (l_int32)(ycos + xsin[j]);
+    }
+}
+
+
+/*!
+ * \brief   rotateAMColorTask()
+ *
+ * <pre>
+ * Notes:
+ *      (1) Rotates one band of ROTATE_AM_BAND_ROWS dest rows, in tiles
+ *          of ROTATE_AM_TILE_COLS columns.  For small angles, the
+ *          source pixels of a tile then stay in the cache.
+ *      (2) For each row of a tile, the four source words around each
+ *          sampling point are gathered, with their fractional weights
+ *          repeated for each of the 4 bytes.  Pixels off the edge get
+ *          four copies of colorval and zero weights, which blend to
+ *          colorval.  The blend keeps the alpha byte of those pixels
+ *          and clears it for the others, as composeRGBPixel() does.
+ *      (3) Sets taskerr[index] if the tile buffers cannot be made.
+ * </pre>
+ */
+static void
+rotateAMColorTask(void     *data,
+                  l_int32   index)
+{
+l_int32     i, j, k, w, wpls, xcen, ycen, wm2, hm2, xp, yp, ydif;
+l_int32     i0, i1, j0, nj;
+l_int32    *xpm, *ypm;
+l_uint16   *wx, *wy;
+l_uint32    colorval;
+l_uint32   *lines, *lined, *buf, *w00, *w10, *w01, *w11, *amask;
+ROTATE_AM  *ra;
+
+    ra = (ROTATE_AM *)data;
+    w = ra->w;
+    wpls = ra->wpls;
+    colorval = ra->fillval;
     xcen = w / 2;
+    ycen = ra->h / 2;
     wm2 = w - 2;
-    ycen = h / 2;
-    hm2 = h - 2;
-    sina = 16. * sin(angle);
-    cosa = 16. * cos(angle);
+    hm2 = ra->h - 2;
+    if ((buf = (l_uint32 *)LEPT_CALLOC(11 * ROTATE_AM_TILE_COLS,
+                                       sizeof(l_uint32))) == NULL) {
+        ra->taskerr[index] = 1;
+        return;
+    }
+    xpm = (l_int32 *)buf;
+    ypm = xpm + ROTATE_AM_TILE_COLS;
+    w00 = buf + 2 * ROTATE_AM_TILE_COLS;
+    w10 = w00 + ROTATE_AM_TILE_COLS;
+    w01 = w10 + ROTATE_AM_TILE_COLS;
+    w11 = w01 + ROTATE_AM_TILE_COLS;
+    amask = w11 + ROTATE_AM_TILE_COLS;
+    wx = (l_uint16 *)(amask + ROTATE_AM_TILE_COLS);
+    wy = wx + 4 * ROTATE_AM_TILE_COLS;
 
-    for (i = 0; i < h; i++) {
-        ydif = ycen - i;
-        lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
-            xdif = xcen - j;
-            xpm = (l_int32)(-xdif * cosa - ydif * sina);
-            ypm = (l_int32)(-ydif * cosa + xdif * sina);
-            xp = xcen + (xpm >> 4);
-            yp = ycen + (ypm >> 4);
-            xf = xpm & 0x0f;
-            yf = ypm & 0x0f;
+    i0 = index * ROTATE_AM_BAND_ROWS;
+    i1 = L_MIN(ra->h, i0 + ROTATE_AM_BAND_ROWS);
+    for (j0 = 0; j0 < w; j0 += ROTATE_AM_TILE_COLS) {
+        nj = L_MIN(ROTATE_AM_TILE_COLS, w - j0);
+        for (i = i0; i < i1; i++) {
+            ydif = ycen - i;
+            lined = ra->datad + i * ra->wpld;
+            rotateAMCoords(xpm, ypm, ra->xcos + j0, ra->xsin + j0,
+                           ydif * ra->sina, -ydif * ra->cosa, nj);
+            for (k = 0; k < nj; k++) {
+                xp = xcen + (xpm[k] >> 4);
+                yp = ycen + (ypm[k] >> 4);
+                if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
+                    w00[k] = w10[k] = w01[k] = w11[k] = colorval;
+                    amask[k] = 0xffffffff;
+                    for (j = 4 * k; j < 4 * k + 4; j++)
+                        wx[j] = wy[j] = 0;
+                    continue;
+                }
+                lines = ra->datas + yp * wpls;
+                w00[k] = lines[xp];
+                w10[k] = lines[xp + 1];
+                w01[k] = lines[wpls + xp];
+                w11[k] = lines[wpls + xp + 1];
+                amask[k] = ~(0xff << L_ALPHA_SHIFT);
+                for (j = 4 * k; j < 4 * k + 4; j++) {
+                    wx[j] = xpm[k] & 0x0f;
+                    wy[j] = ypm[k] & 0x0f;
+                }
+            }
+            rotateAMColorBlend(lined + j0, w00, w10, w01, w11, wx, wy,
+                               amask, nj);
+        }
+    }
 
-                /* if off the edge, write input grayval */
-            if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
-                SET_DATA_BYTE(lined, j, grayval);
-                continue;
+    LEPT_FREE(buf);
+}
+
+
+/*!
+ * \brief   rotateAMGrayTask()
+ *
+ * <pre>
+ * Notes:
+ *      (1) Rotates one band of ROTATE_AM_BAND_ROWS dest rows, in tiles
+ *          of ROTATE_AM_TILE_COLS columns, as in rotateAMColorTask().
+ *      (2) For each row of a tile, the four source pixels around each
+ *          sampling point are gathered with their fractional weights.
+ *          Pixels off the edge get four copies of grayval and zero
+ *          weights, which blend to grayval.
+ *      (3) Sets taskerr[index] if the tile buffers cannot be made.
+ * </pre>
+ */
+static void
+rotateAMGrayTask(void     *data,
+                 l_int32   index)
+{
+l_int32     i, j, k, w, wpls, xcen, ycen, wm2, hm2, xp, yp, ydif;
+l_int32     i0, i1, j0, nj;
+l_int32    *xpm, *ypm;
+l_uint8     grayval;
+l_uint8    *vald;
+l_uint16   *v00, *v10, *v01, *v11, *xf, *yf;
+l_uint32   *lines, *lined;
+void       *buf;
+ROTATE_AM  *ra;
+
+    ra = (ROTATE_AM *)data;
+    w = ra->w;
+    wpls = ra->wpls;
+    grayval = (l_uint8)ra->fillval;
+    xcen = w / 2;
+    ycen = ra->h / 2;
+    wm2 = w - 2;
+    hm2 = ra->h - 2;
+    if ((buf = LEPT_CALLOC(ROTATE_AM_TILE_COLS,
+                           2 * sizeof(l_int32) + 6 * sizeof(l_uint16) +
+                           sizeof(l_uint8))) == NULL) {
+        ra->taskerr[index] = 1;
+        return;
+    }
+    xpm = (l_int32 *)buf;
+    ypm = xpm + ROTATE_AM_TILE_COLS;
+    v00 = (l_uint16 *)(ypm + ROTATE_AM_TILE_COLS);
+    v10 = v00 + ROTATE_AM_TILE_COLS;
+    v01 = v10 + ROTATE_AM_TILE_COLS;
+    v11 = v01 + ROTATE_AM_TILE_COLS;
+    xf = v11 + ROTATE_AM_TILE_COLS;
+    yf = xf + ROTATE_AM_TILE_COLS;
+    vald = (l_uint8 *)(yf + ROTATE_AM_TILE_COLS);
+
+    i0 = index * ROTATE_AM_BAND_ROWS;
+    i1 = L_MIN(ra->h, i0 + ROTATE_AM_BAND_ROWS);
+    for (j0 = 0; j0 < w; j0 += ROTATE_AM_TILE_COLS) {
+        nj = L_MIN(ROTATE_AM_TILE_COLS, w - j0);
+        for (i = i0; i < i1; i++) {
+            ydif = ycen - i;
+            lined = ra->datad + i * ra->wpld;
+            rotateAMCoords(xpm, ypm, ra->xcos + j0, ra->xsin + j0,
+                           ydif * ra->sina, -ydif * ra->cosa, nj);
+            for (k = 0; k < nj; k++) {
+                xp = xcen + (xpm[k] >> 4);
+                yp = ycen + (ypm[k] >> 4);
+                if (xp < 0 || yp < 0 || xp > wm2 || yp > hm2) {
+                    v00[k] = v10[k] = v01[k] = v11[k] = grayval;
+                    xf[k] = yf[k] = 0;
+                    continue;
+                }
+                lines = ra->datas + yp * wpls;
+                v00[k] = GET_DATA_BYTE(lines, xp);
+                v10[k] = GET_DATA_BYTE(lines, xp + 1);
+                v01[k] = GET_DATA_BYTE(lines + wpls, xp);
+                v11[k] = GET_DATA_BYTE(lines + wpls, xp + 1);
+                xf[k] = xpm[k] & 0x0f;
+                yf[k] = ypm[k] & 0x0f;
             }
+            rotateAMGrayBlend(vald, v00, v10, v01, v11, xf, yf, nj);
 
-            lines = datas + yp * wpls;
+                /* Pack the whole words; j0 is a multiple of 4 */
+            for (k = 0; k + 4 <= nj; k += 4) {
+                lined[(j0 + k) / 4] = ((l_uint32)vald[k] << 24) |
+                                      ((l_uint32)vald[k + 1] << 16) |
+                                      ((l_uint32)vald[k + 2] << 8) |
+                                      vald[k + 3];
+            }
+            for (j = j0 + k; k < nj; k++, j++)
+                SET_DATA_BYTE(lined, j, vald[k]);
+        }
+    }
 
-                /* do area weighting.  Without this, we would
-                 * simply do:
-                 *   SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xp));
-                 * which is faster but gives lousy results!
-                 */
-            v00 = (16 - xf) * (16 - yf) * GET_DATA_BYTE(lines, xp);
-            v10 = xf * (16 - yf) * GET_DATA_BYTE(lines, xp + 1);
-            v01 = (16 - xf) * yf * GET_DATA_BYTE(lines + wpls, xp);
-            v11 = xf * yf * GET_DATA_BYTE(lines + wpls, xp + 1);
-            val = (l_uint8)((v00 + v01 + v10 + v11 + 128) / 256);
-            SET_DATA_BYTE(lined, j, val);
+    LEPT_FREE(buf);
+}
+
+
+/*!
+ * \brief   rotateAMColorBlend()
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each byte of the dest word is
+ *            ((16 - yf) * ((16 - xf) * b00 + xf * b10) +
+ *             yf * ((16 - xf) * b01 + xf * b11) + 128) / 256
+ *          which is the area weighting of the four source bytes,
+ *          factored so that every intermediate fits in 16 bits.
+ *          It is done for 4 pixels at a time with NEON or SSE2, and
+ *          otherwise for two bytes at a time in each word.
+ *      (2) %wx and %wy have each weight repeated 4 times, once for
+ *          each byte of the pixel.
+ * </pre>
+ */
+static void
+rotateAMColorBlend(l_uint32        *lined,
+                   const l_uint32  *w00,
+                   const l_uint32  *w10,
+                   const l_uint32  *w01,
+                   const l_uint32  *w11,
+                   const l_uint16  *wx,
+                   const l_uint16  *wy,
+                   const l_uint32  *amask,
+                   l_int32          n)
+{
+l_int32   j, k, shift;
+l_uint32  xf, yf, v00, v10, v01, v11, val, word;
+
+    j = 0;
+#if ROTATE_USE_NEON
+    {
+    uint8x16_t  a, b, c, d;
+    uint16x8_t  lo, hi;
+    for (; j + 4 <= n; j += 4) {
+        a = vreinterpretq_u8_u32(vld1q_u32(w00 + j));
+        b = vreinterpretq_u8_u32(vld1q_u32(w10 + j));
+        c = vreinterpretq_u8_u32(vld1q_u32(w01 + j));
+        d = vreinterpretq_u8_u32(vld1q_u32(w11 + j));
+        lo = rotateAMBlend16(vmovl_u8(vget_low_u8(a)),
+                             vmovl_u8(vget_low_u8(b)),
+                             vmovl_u8(vget_low_u8(c)),
+                             vmovl_u8(vget_low_u8(d)),
+                             vld1q_u16(wx + 4 * j), vld1q_u16(wy + 4 * j));
+        hi = rotateAMBlend16(vmovl_u8(vget_high_u8(a)),
+                             vmovl_u8(vget_high_u8(b)),
+                             vmovl_u8(vget_high_u8(c)),
+                             vmovl_u8(vget_high_u8(d)),
+                             vld1q_u16(wx + 4 * j + 8),
+                             vld1q_u16(wy + 4 * j + 8));
+        vst1q_u32(lined + j,
+                  vandq_u32(vreinterpretq_u32_u8(vcombine_u8(vmovn_u16(lo),
+                                                             vmovn_u16(hi))),
+                            vld1q_u32(amask + j)));
+    }
+    }
+#elif ROTATE_USE_SSE2
+    {
+    __m128i  zero, a, b, c, d, lo, hi;
+    zero = _mm_setzero_si128();
+    for (; j + 4 <= n; j += 4) {
+        a = _mm_loadu_si128((const __m128i *)(w00 + j));
+        b = _mm_loadu_si128((const __m128i *)(w10 + j));
+        c = _mm_loadu_si128((const __m128i *)(w01 + j));
+        d = _mm_loadu_si128((const __m128i *)(w11 + j));
+        lo = rotateAMBlend16(_mm_unpacklo_epi8(a, zero),
+                             _mm_unpacklo_epi8(b, zero),
+                             _mm_unpacklo_epi8(c, zero),
+                             _mm_unpacklo_epi8(d, zero),
+                             _mm_loadu_si128((const __m128i *)(wx + 4 * j)),
+                             _mm_loadu_si128((const __m128i *)(wy + 4 * j)));
+        hi = rotateAMBlend16(_mm_unpackhi_epi8(a, zero),
+                             _mm_unpackhi_epi8(b, zero),
+                             _mm_unpackhi_epi8(c, zero),
+                             _mm_unpackhi_epi8(d, zero),
+                             _mm_loadu_si128((const __m128i *)(wx + 4 * j + 8)),
+                             _mm_loadu_si128((const __m128i *)(wy + 4 * j + 8)));
+        _mm_storeu_si128((__m128i *)(lined + j),
+                         _mm_and_si128(_mm_packus_epi16(lo, hi),
+                                       _mm_loadu_si128((const __m128i *)
+                                                       (amask + j))));
+    }
+    }
+#endif  /* ROTATE_USE_NEON */
+        /* Alternate bytes are blended together in 16-bit fields */
+    for (; j < n; j++) {
+        xf = wx[4 * j];
+        yf = wy[4 * j];
+        for (k = 0, word = 0; k < 2; k++) {
+            shift = 8 * k;
+            v00 = (w00[j] >> shift) & 0x00ff00ff;
+            v10 = (w10[j] >> shift) & 0x00ff00ff;
+            v01 = (w01[j] >> shift) & 0x00ff00ff;
+            v11 = (w11[j] >> shift) & 0x00ff00ff;
+            val = (16 - yf) * ((16 - xf) * v00 + xf * v10) +
+                  yf * ((16 - xf) * v01 + xf * v11) + 0x00800080;
+            word |= ((val >> 8) & 0x00ff00ff) << shift;
         }
+        lined[j] = word & amask[j];
     }
+}
 
-    return;
+
+/*!
+ * \brief   rotateAMGrayBlend()
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the area weighting of rotateAMColorBlend() for
+ *          single bytes, done for 8 pixels at a time with NEON or SSE2.
+ * </pre>
+ */
+static void
+rotateAMGrayBlend(l_uint8         *vald,
+                  const l_uint16  *v00,
+                  const l_uint16  *v10,
+                  const l_uint16  *v01,
+                  const l_uint16  *v11,
+                  const l_uint16  *xf,
+                  const l_uint16  *yf,
+                  l_int32          n)
+{
+l_int32  j;
+
+    j = 0;
+#if ROTATE_USE_NEON
+    for (; j + 8 <= n; j += 8) {
+        vst1_u8(vald + j,
+                vmovn_u16(rotateAMBlend16(vld1q_u16(v00 + j),
+                                          vld1q_u16(v10 + j),
+                                          vld1q_u16(v01 + j),
+                                          vld1q_u16(v11 + j),
+                                          vld1q_u16(xf + j),
+                                          vld1q_u16(yf + j))));
+    }
+#elif ROTATE_USE_SSE2
+    {
+    __m128i  v;
+    for (; j + 8 <= n; j += 8) {
+        v = rotateAMBlend16(_mm_loadu_si128((const __m128i *)(v00 + j)),
+                            _mm_loadu_si128((const __m128i *)(v10 + j)),
+                            _mm_loadu_si128((const __m128i *)(v01 + j)),
+                            _mm_loadu_si128((const __m128i *)(v11 + j)),
+                            _mm_loadu_si128((const __m128i *)(xf + j)),
+                            _mm_loadu_si128((const __m128i *)(yf + j)));
+        _mm_storel_epi64((__m128i *)(vald + j),
+                         _mm_packus_epi16(v, v));
+    }
+    }
+#endif  /* ROTATE_USE_NEON */
+    for (; j < n; j++) {
+        vald[j] = (l_uint8)(((16 - yf[j]) * ((16 - xf[j]) * v00[j] +
+                                             xf[j] * v10[j]) +
+                             yf[j] * ((16 - xf[j]) * v01[j] +
+                                      xf[j] * v11[j]) + 128) >> 8);
+    }
+}
+
+
+#if ROTATE_USE_NEON
+    /* Area weighting of 8 values; see rotateAMColorBlend() */
+static uint16x8_t
+rotateAMBlend16(uint16x8_t  v00,
+                uint16x8_t  v10,
+                uint16x8_t  v01,
+                uint16x8_t  v11,
+                uint16x8_t  xf,
+                uint16x8_t  yf)
+{
+uint16x8_t  sixteen, xf1, top, bot;
+
+    sixteen = vdupq_n_u16(16);
+    xf1 = vsubq_u16(sixteen, xf);
+    top = vmlaq_u16(vmulq_u16(v00, xf1), v10, xf);
+    bot = vmlaq_u16(vmulq_u16(v01, xf1), v11, xf);
+    top = vmlaq_u16(vmulq_u16(top, vsubq_u16(sixteen, yf)), bot, yf);
+    return vshrq_n_u16(vaddq_u16(top, vdupq_n_u16(128)), 8);
+}
+#elif ROTATE_USE_SSE2
+    /* Area weighting of 8 values; see rotateAMColorBlend() */
+static __m128i
+rotateAMBlend16(__m128i  v00,
+                __m128i  v10,
+                __m128i  v01,
+                __m128i  v11,
+                __m128i  xf,
+                __m128i  yf)
+{
+__m128i  sixteen, xf1, top, bot;
+
+    sixteen = _mm_set1_epi16(16);
+    xf1 = _mm_sub_epi16(sixteen, xf);
+    top = _mm_add_epi16(_mm_mullo_epi16(v00, xf1), _mm_mullo_epi16(v10, xf));
+    bot = _mm_add_epi16(_mm_mullo_epi16(v01, xf1), _mm_mullo_epi16(v11, xf));
+    top = _mm_add_epi16(_mm_mullo_epi16(top, _mm_sub_epi16(sixteen, yf)),
+                        _mm_mullo_epi16(bot, yf));
+    return _mm_srli_epi16(_mm_add_epi16(top, _mm_set1_epi16(128)), 8);
 }
+#endif  /* ROTATE_USE_NEON */
 
 
 /*------------------------------------------------------------------*
@@ -34,6 +34,9 @@
  *
  *         Grayscale (interpolated) scaling: general case
  *                  void       scaleGrayLILow()
+ *                  static void  scaleColorLIRowLow()
+ *                  static void  scaleGrayLIRowLow()
+ *                  static void  scaleLIBlendRowsLow()
  *
  *         Color (interpolated) scaling: 2x upscaling
  *                  void       scaleColor2xLILow()
@@ -57,7 +60,12 @@
  *         Color and grayscale downsampling with (antialias) area mapping
  *                  l_int32    scaleColorAreaMapLow()
  *                  l_int32    scaleGrayAreaMapLow()
+ *                  static l_int32 *scaleAreaMapMakeTabx()
+ *                  static void  scaleAreaMapSumRowsLow()
+ *                  static void  scaleAreaMapAddRowLow()
  *                  l_int32    scaleAreaMapLow2()
+ *                  static l_int32  scaleAreaMapGray2Low()
+ *                  static l_int32  scaleAreaMapColor2Low()
  *
  *         Binary scaling by closest pixel sampling
  *                  l_int32    scaleBinaryLow()
@@ -91,11 +99,47 @@
  *         Grayscale mipmap
  *                  l_int32    scaleMipmapLow()
  *
+ *     The general interpolated and area mapped scaling, and the
+ *     2x area mapped reduction, use NEON or SSE2 for their inner
+ *     loops when the compiler targets them, with identical results.
+ *
  * </pre>
  */
 
 #include <string.h>
 #include "allheaders.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define  SCALE_USE_NEON  1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define  SCALE_USE_SSE2  1
+#endif
+
+    /* Index of pixel j in a line of 8 bit pixels, viewed as bytes */
+#ifdef  L_BIG_ENDIAN
+#define  BYTE_INDEX(j)   (j)
+#else  /* L_LITTLE_ENDIAN */
+#define  BYTE_INDEX(j)   ((j) ^ 3)
+#endif  /* L_BIG_ENDIAN */
+
+static void scaleColorLIRowLow(l_uint16 *hrow, const l_uint8 *bytes,
+                               const l_int32 *tabx, l_int32 wd);
+static void scaleGrayLIRowLow(l_uint16 *hrow, const l_uint8 *bytes,
+                              const l_int32 *tabx, l_int32 wd);
+static void scaleLIBlendRowsLow(l_uint8 *lined, const l_uint16 *hrow0,
+                                const l_uint16 *hrow1, l_int32 nbytes,
+                                l_int32 yf);
+static l_int32 *scaleAreaMapMakeTabx(l_float32 scx, l_int32 wd);
+static void scaleAreaMapSumRowsLow(l_uint32 *vsum, const l_uint8 *bytes,
+                                   l_int32 wpls, l_int32 nbytes, l_int32 dely,
+                                   l_int32 yuf, l_int32 ylf);
+static void scaleAreaMapAddRowLow(l_uint32 *vsum, const l_uint8 *bytes,
+                                  l_int32 nbytes, l_int32 weight);
+static l_int32 scaleAreaMapGray2Low(l_uint32 *lined, const l_uint32 *lines1,
+                                    const l_uint32 *lines2, l_int32 nwords);
+static l_int32 scaleAreaMapColor2Low(l_uint32 *lined, const l_uint32 *lines1,
+                                     const l_uint32 *lines2, l_int32 wd);
 
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_OVERFLOW   0
@@ -115,7 +159,15 @@
  *  by 256) associated with each of the four nearest src pixels,
  *  and weighting each pixel value by this fractional area.
  *
- *  P3 speed is about 7 x 10^6 dst pixels/sec/GHz
+ *  The interpolation is separable, so it is done in two passes.
+ *  Each src row that is needed is first interpolated horizontally,
+ *  into 16-bit sums for each component, using the src column and
+ *  fraction for each dest column, which are computed once.  A dest
+ *  row is then the vertical blend of the two interpolated src rows
+ *  above and below it.  For upscaling, consecutive dest rows
+ *  usually share their src rows, and these are interpolated
+ *  only once.  The result is identical to doing the bilinear
+ *  interpolation on each dest pixel.
  */
 void
 scaleColorLILow(l_uint32  *datad,
@@ -127,15 +179,16 @@ scaleColorLILow(l_uint32  *datad,
                l_int32    hs,
                l_int32    wpls)
 {
-l_int32    i, j, wm2, hm2;
-l_int32    xpm, ypm;  /* location in src image, to 1/16 of a pixel */
-l_int32    xp, yp, xf, yf;  /* src pixel and pixel fraction coordinates */
-l_int32    v00r, v01r, v10r, v11r, v00g, v01g, v10g, v11g;
-l_int32    v00b, v01b, v10b, v11b, area00, area01, area10, area11;
-l_uint32   pixels1, pixels2, pixels3, pixels4, pixel;
-l_uint32  *lines, *lined;
+l_int32    i, j, k, wm2, hm2, nbytes, yf;
+l_int32    ypm, yp, ypn;  /* src row, to 1/16 of a pixel; src rows */
+l_int32    row0, row1;  /* src rows held in hrow0 and hrow1 */
+l_int32   *tabx;
+l_uint8   *bytes;
+l_uint16  *hrow0, *hrow1, *htmp;
 l_float32  scx, scy;
 
+    PROCNAME("scaleColorLILow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -145,66 +198,65 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
-        /* Iterate over the destination pixels */
+        /* The horizontally interpolated rows are kept in the byte
+         * order of the dest line, with the alpha byte left at 0. */
+    nbytes = 4 * wpld;
+    tabx = (l_int32 *)LEPT_CALLOC(3 * wd, sizeof(l_int32));
+    hrow0 = (l_uint16 *)LEPT_CALLOC(nbytes, sizeof(l_uint16));
+    hrow1 = (l_uint16 *)LEPT_CALLOC(nbytes, sizeof(l_uint16));
+    if (!tabx || !hrow0 || !hrow1) {
+        LEPT_FREE(tabx);
+        LEPT_FREE(hrow0);
+        LEPT_FREE(hrow1);
+        L_ERROR("buffers not made\n", procName);
+        return;
+    }
+
+        /* Src pixel, its right-hand neighbor and the fraction for
+         * each dest column.  Near the right side, the neighbor is
+         * the pixel itself. */
+    for (j = 0; j < wd; j++) {
+        k = (l_int32)(scx * (l_float32)j);
+        tabx[3 * j] = k >> 4;
+        tabx[3 * j + 1] = (tabx[3 * j] > wm2) ? k >> 4 : (k >> 4) + 1;
+        tabx[3 * j + 2] = k & 0x0f;
+    }
+
+        /* Iterate over the destination rows */
+    row0 = row1 = -1;
     for (i = 0; i < hd; i++) {
         ypm = (l_int32)(scy * (l_float32)i);
         yp = ypm >> 4;
         yf = ypm & 0x0f;
-        lined = datad + i * wpld;
-        lines = datas + yp * wpls;
-        for (j = 0; j < wd; j++) {
-            xpm = (l_int32)(scx * (l_float32)j);
-            xp = xpm >> 4;
-            xf = xpm & 0x0f;
-
-                /* Do bilinear interpolation.  This is a simple
-                 * generalization of the calculation in scaleGrayLILow().
-                 * Without this, we could simply subsample:
-                 *     *(lined + j) = *(lines + xp);
-                 * which is faster but gives lousy results!  */
-            pixels1 = *(lines + xp);
-
-            if (xp > wm2 || yp > hm2) {
-                if (yp > hm2 && xp <= wm2) {  /* pixels near bottom */
-                    pixels2 = *(lines + xp + 1);
-                    pixels3 = pixels1;
-                    pixels4 = pixels2;
-                } else if (xp > wm2 && yp <= hm2) {  /* pixels near rt side */
-                    pixels2 = pixels1;
-                    pixels3 = *(lines + wpls + xp);
-                    pixels4 = pixels3;
-                } else {  /* pixels at LR corner */
-                    pixels4 = pixels3 = pixels2 = pixels1;
-                }
+        ypn = (yp > hm2) ? yp : yp + 1;  /* near bottom: use the same row */
+
+        if (row0 != yp) {
+            if (row1 == yp) {
+                htmp = hrow0; hrow0 = hrow1; hrow1 = htmp;
+                row1 = row0;
             } else {
-                pixels2 = *(lines + xp + 1);
-                pixels3 = *(lines + wpls + xp);
-                pixels4 = *(lines + wpls + xp + 1);
+                bytes = (l_uint8 *)(datas + yp * wpls);
+                scaleColorLIRowLow(hrow0, bytes, tabx, wd);
             }
-
-            area00 = (16 - xf) * (16 - yf);
-            area10 = xf * (16 - yf);
-            area01 = (16 - xf) * yf;
-            area11 = xf * yf;
-            v00r = area00 * ((pixels1 >> L_RED_SHIFT) & 0xff);
-            v00g = area00 * ((pixels1 >> L_GREEN_SHIFT) & 0xff);
-            v00b = area00 * ((pixels1 >> L_BLUE_SHIFT) & 0xff);
-            v10r = area10 * ((pixels2 >> L_RED_SHIFT) & 0xff);
-            v10g = area10 * ((pixels2 >> L_GREEN_SHIFT) & 0xff);
-            v10b = area10 * ((pixels2 >> L_BLUE_SHIFT) & 0xff);
-            v01r = area01 * ((pixels3 >> L_RED_SHIFT) & 0xff);
-            v01g = area01 * ((pixels3 >> L_GREEN_SHIFT) & 0xff);
-            v01b = area01 * ((pixels3 >> L_BLUE_SHIFT) & 0xff);
-            v11r = area11 * ((pixels4 >> L_RED_SHIFT) & 0xff);
-            v11g = area11 * ((pixels4 >> L_GREEN_SHIFT) & 0xff);
-            v11b = area11 * ((pixels4 >> L_BLUE_SHIFT) & 0xff);
-            pixel = (((v00r + v10r + v01r + v11r + 128) << 16) & 0xff000000) |
-                    (((v00g + v10g + v01g + v11g + 128) << 8) & 0x00ff0000) |
-                    ((v00b + v10b + v01b + v11b + 128) & 0x0000ff00);
-            *(lined + j) = pixel;
+            row0 = yp;
         }
+        if (ypn == yp) {
+            scaleLIBlendRowsLow((l_uint8 *)(datad + i * wpld), hrow0, hrow0,
+                                nbytes, yf);
+            continue;
+        }
+        if (row1 != ypn) {
+            bytes = (l_uint8 *)(datas + ypn * wpls);
+            scaleColorLIRowLow(hrow1, bytes, tabx, wd);
+            row1 = ypn;
+        }
+        scaleLIBlendRowsLow((l_uint8 *)(datad + i * wpld), hrow0, hrow1,
+                            nbytes, yf);
     }
 
+    LEPT_FREE(tabx);
+    LEPT_FREE(hrow0);
+    LEPT_FREE(hrow1);
     return;
 }
 
@@ -220,6 +272,10 @@ l_float32  scx, scy;
  *  fractional area (i.e., number of sub-pixels divided
  *  by 256) associated with each of the four nearest src pixels,
  *  and weighting each pixel value by this fractional area.
+ *
+ *  As in scaleColorLILow(), the src rows are interpolated
+ *  horizontally, and each dest row is the vertical blend of
+ *  two of them.
  */
 void
 scaleGrayLILow(l_uint32  *datad,
@@ -231,14 +287,16 @@ scaleGrayLILow(l_uint32  *datad,
                l_int32    hs,
                l_int32    wpls)
 {
-l_int32    i, j, wm2, hm2;
-l_int32    xpm, ypm;  /* location in src image, to 1/16 of a pixel */
-l_int32    xp, yp, xf, yf;  /* src pixel and pixel fraction coordinates */
-l_int32    v00, v01, v10, v11, v00_val, v01_val, v10_val, v11_val;
-l_uint8    val;
-l_uint32  *lines, *lined;
+l_int32    i, j, k, wm2, hm2, nbytes, yf;
+l_int32    ypm, yp, ypn;  /* src row, to 1/16 of a pixel; src rows */
+l_int32    row0, row1;  /* src rows held in hrow0 and hrow1 */
+l_int32   *tabx;
+l_uint8   *bytes;
+l_uint16  *hrow0, *hrow1, *htmp;
 l_float32  scx, scy;
 
+    PROCNAME("scaleGrayLILow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -248,55 +306,188 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
-        /* Iterate over the destination pixels */
+        /* The horizontally interpolated rows are kept in the byte
+         * order of the dest line. */
+    nbytes = 4 * wpld;
+    tabx = (l_int32 *)LEPT_CALLOC(3 * wd, sizeof(l_int32));
+    hrow0 = (l_uint16 *)LEPT_CALLOC(nbytes, sizeof(l_uint16));
+    hrow1 = (l_uint16 *)LEPT_CALLOC(nbytes, sizeof(l_uint16));
+    if (!tabx || !hrow0 || !hrow1) {
+        LEPT_FREE(tabx);
+        LEPT_FREE(hrow0);
+        LEPT_FREE(hrow1);
+        L_ERROR("buffers not made\n", procName);
+        return;
+    }
+
+        /* Src pixel, its right-hand neighbor and the fraction for
+         * each dest column.  Near the right side, the neighbor is
+         * the pixel itself. */
+    for (j = 0; j < wd; j++) {
+        k = (l_int32)(scx * (l_float32)j);
+        tabx[3 * j] = k >> 4;
+        tabx[3 * j + 1] = (tabx[3 * j] > wm2) ? k >> 4 : (k >> 4) + 1;
+        tabx[3 * j + 2] = k & 0x0f;
+    }
+
+        /* Iterate over the destination rows */
+    row0 = row1 = -1;
     for (i = 0; i < hd; i++) {
         ypm = (l_int32)(scy * (l_float32)i);
         yp = ypm >> 4;
         yf = ypm & 0x0f;
-        lined = datad + i * wpld;
-        lines = datas + yp * wpls;
-        for (j = 0; j < wd; j++) {
-            xpm = (l_int32)(scx * (l_float32)j);
-            xp = xpm >> 4;
-            xf = xpm & 0x0f;
-
-                /* Do bilinear interpolation.  Without this, we could
-                 * simply subsample:
-                 *   SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xp));
-                 * which is faster but gives lousy results!  */
-            v00_val = GET_DATA_BYTE(lines, xp);
-            if (xp > wm2 || yp > hm2) {
-                if (yp > hm2 && xp <= wm2) {  /* pixels near bottom */
-                    v01_val = v00_val;
-                    v10_val = GET_DATA_BYTE(lines, xp + 1);
-                    v11_val = v10_val;
-                } else if (xp > wm2 && yp <= hm2) {  /* pixels near rt side */
-                    v01_val = GET_DATA_BYTE(lines + wpls, xp);
-                    v10_val = v00_val;
-                    v11_val = v01_val;
-                } else {  /* pixels at LR corner */
-                    v10_val = v01_val = v11_val = v00_val;
-                }
+        ypn = (yp > hm2) ? yp : yp + 1;  /* near bottom: use the same row */
+
+        if (row0 != yp) {
+            if (row1 == yp) {
+                htmp = hrow0; hrow0 = hrow1; hrow1 = htmp;
+                row1 = row0;
             } else {
-                v10_val = GET_DATA_BYTE(lines, xp + 1);
-                v01_val = GET_DATA_BYTE(lines + wpls, xp);
-                v11_val = GET_DATA_BYTE(lines + wpls, xp + 1);
+                bytes = (l_uint8 *)(datas + yp * wpls);
+                scaleGrayLIRowLow(hrow0, bytes, tabx, wd);
             }
-
-            v00 = (16 - xf) * (16 - yf) * v00_val;
-            v10 = xf * (16 - yf) * v10_val;
-            v01 = (16 - xf) * yf * v01_val;
-            v11 = xf * yf * v11_val;
-
-            val = (l_uint8)((v00 + v01 + v10 + v11 + 128) / 256);
-            SET_DATA_BYTE(lined, j, val);
+            row0 = yp;
+        }
+        if (ypn == yp) {
+            scaleLIBlendRowsLow((l_uint8 *)(datad + i * wpld), hrow0, hrow0,
+                                nbytes, yf);
+            continue;
+        }
+        if (row1 != ypn) {
+            bytes = (l_uint8 *)(datas + ypn * wpls);
+            scaleGrayLIRowLow(hrow1, bytes, tabx, wd);
+            row1 = ypn;
         }
+        scaleLIBlendRowsLow((l_uint8 *)(datad + i * wpld), hrow0, hrow1,
+                            nbytes, yf);
     }
 
+    LEPT_FREE(tabx);
+    LEPT_FREE(hrow0);
+    LEPT_FREE(hrow1);
     return;
 }
 
 
+/*!
+ * \brief   scaleColorLIRowLow()
+ *
+ *      Input:  hrow (16 bit sums, in the byte order of the dest line)
+ *              bytes (src line)
+ *              tabx (src column, right-hand neighbor and fraction
+ *                    for each dest column)
+ *              wd (dest width)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Each sum is at most 16 * 255, and the alpha sums are not set.
+ */
+static void
+scaleColorLIRowLow(l_uint16       *hrow,
+                   const l_uint8  *bytes,
+                   const l_int32  *tabx,
+                   l_int32         wd)
+{
+l_int32    j, xp, xpn, xf;
+l_int32    ir, ig, ib;
+
+    ir = BYTE_INDEX(COLOR_RED);
+    ig = BYTE_INDEX(COLOR_GREEN);
+    ib = BYTE_INDEX(COLOR_BLUE);
+    for (j = 0; j < wd; j++, tabx += 3, hrow += 4) {
+        xp = 4 * tabx[0];
+        xpn = 4 * tabx[1];
+        xf = tabx[2];
+        hrow[ir] = (16 - xf) * bytes[xp + ir] + xf * bytes[xpn + ir];
+        hrow[ig] = (16 - xf) * bytes[xp + ig] + xf * bytes[xpn + ig];
+        hrow[ib] = (16 - xf) * bytes[xp + ib] + xf * bytes[xpn + ib];
+    }
+}
+
+
+/*!
+ * \brief   scaleGrayLIRowLow()
+ *
+ *      Input:  hrow (16 bit sums, in the byte order of the dest line)
+ *              bytes (src line)
+ *              tabx (src column, right-hand neighbor and fraction
+ *                    for each dest column)
+ *              wd (dest width)
+ *      Return: void
+ */
+static void
+scaleGrayLIRowLow(l_uint16       *hrow,
+                  const l_uint8  *bytes,
+                  const l_int32  *tabx,
+                  l_int32         wd)
+{
+l_int32    j, xf;
+
+    for (j = 0; j < wd; j++, tabx += 3) {
+        xf = tabx[2];
+        hrow[BYTE_INDEX(j)] = (16 - xf) * bytes[BYTE_INDEX(tabx[0])] +
+                              xf * bytes[BYTE_INDEX(tabx[1])];
+    }
+}
+
+
+/*!
+ * \brief   scaleLIBlendRowsLow()
+ *
+ *      Input:  lined (dest line, as bytes)
+ *              hrow0, hrow1 (horizontally interpolated src rows)
+ *              nbytes (bytes in the dest line)
+ *              yf (fraction of hrow1, in 1/16 of a pixel)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) Each value is (16 - yf) * hrow0 + yf * hrow1 + 128, divided
+ *          by 256.  This is at most 16 * 16 * 255 + 128, so it fits
+ *          in a 16 bit lane, and NEON and SSE2 do 8 bytes at a time.
+ */
+static void
+scaleLIBlendRowsLow(l_uint8         *lined,
+                    const l_uint16  *hrow0,
+                    const l_uint16  *hrow1,
+                    l_int32          nbytes,
+                    l_int32          yf)
+{
+l_int32      k;
+#if defined(SCALE_USE_NEON)
+uint16x8_t   w0, w1, round, sum;
+#elif defined(SCALE_USE_SSE2)
+__m128i      w0, w1, round, sum;
+#endif
+
+    k = 0;
+#if defined(SCALE_USE_NEON)
+    w0 = vdupq_n_u16(16 - yf);
+    w1 = vdupq_n_u16(yf);
+    round = vdupq_n_u16(128);
+    for (; k + 8 <= nbytes; k += 8) {
+        sum = vmlaq_u16(vmulq_u16(vld1q_u16(hrow0 + k), w0),
+                        vld1q_u16(hrow1 + k), w1);
+        vst1_u8(lined + k, vshrn_n_u16(vaddq_u16(sum, round), 8));
+    }
+#elif defined(SCALE_USE_SSE2)
+    w0 = _mm_set1_epi16(16 - yf);
+    w1 = _mm_set1_epi16(yf);
+    round = _mm_set1_epi16(128);
+    for (; k + 8 <= nbytes; k += 8) {
+        sum = _mm_add_epi16(
+                  _mm_mullo_epi16(
+                      _mm_loadu_si128((const __m128i *)(hrow0 + k)), w0),
+                  _mm_mullo_epi16(
+                      _mm_loadu_si128((const __m128i *)(hrow1 + k)), w1));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+        _mm_storel_epi64((__m128i *)(lined + k), _mm_packus_epi16(sum, sum));
+    }
+#endif
+
+    for (; k < nbytes; k++)
+        lined[k] = ((16 - yf) * hrow0[k] + yf * hrow1[k] + 128) >> 8;
+}
+
 /*------------------------------------------------------------------*
  *                2x linear interpolated color scaling              *
  *------------------------------------------------------------------*/
@@ -1256,6 +1447,15 @@ l_uint32   pixel;
  *  and are weighted by the number of sub-pixels covered by
  *  the dest pixel.  This is about 2x slower than scaleSmoothLow(),
  *  but the results are significantly better on small text.
+ *
+ *  The weight of a src pixel is the product of its weights in
+ *  each direction, so the sum is done in two passes.  For each
+ *  dest row, the src rows it covers are summed into one row of
+ *  32-bit sums with their vertical weights.  The sums along that
+ *  row are then accumulated, so that each dest pixel needs only
+ *  its two partially covered columns and the difference of two
+ *  accumulated sums for the fully covered ones.  The result is
+ *  identical to summing over each dest pixel.
  */
 void
 scaleColorAreaMapLow(l_uint32  *datad,
@@ -1267,24 +1467,18 @@ scaleColorAreaMapLow(l_uint32  *datad,
                     l_int32    hs,
                     l_int32    wpls)
 {
-l_int32    i, j, k, m, wm2, hm2;
-l_int32    area00, area10, area01, area11, areal, arear, areat, areab;
-l_int32    xu, yu;  /* UL corner in src image, to 1/16 of a pixel */
-l_int32    xl, yl;  /* LR corner in src image, to 1/16 of a pixel */
-l_int32    xup, yup, xuf, yuf;  /* UL src pixel: integer and fraction */
-l_int32    xlp, ylp, xlf, ylf;  /* LR src pixel: integer and fraction */
-l_int32    delx, dely, area;
-l_int32    v00r, v00g, v00b;  /* contrib. from UL src pixel */
-l_int32    v01r, v01g, v01b;  /* contrib. from LL src pixel */
-l_int32    v10r, v10g, v10b;  /* contrib from UR src pixel */
-l_int32    v11r, v11g, v11b;  /* contrib from LR src pixel */
-l_int32    vinr, ving, vinb;  /* contrib from all full interior src pixels */
-l_int32    vmidr, vmidg, vmidb;  /* contrib from side parts */
-l_int32    rval, gval, bval;
-l_uint32   pixel00, pixel10, pixel01, pixel11, pixel;
-l_uint32  *lines, *lined;
+l_int32    i, j, k, c, wm2, hm2, nbytes;
+l_int32    yu, yl;  /* UL and LR rows in src image, to 1/16 of a pixel */
+l_int32    yup, yuf, ylp, ylf, dely, areay;
+l_int32    xup, xuf, xlp, xlf, delx, area;
+l_int32    index[3], val[3];
+l_int32   *tabx;
+l_uint32   sum;
+l_uint32  *lines, *lined, *vsum, *hsum;
 l_float32  scx, scy;
 
+    PROCNAME("scaleColorAreaMapLow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -1294,7 +1488,24 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
-        /* Iterate over the destination pixels */
+        /* vsum holds the weighted column sums for each byte of the
+         * src line; hsum holds them accumulated along the line */
+    nbytes = 4 * wpls;
+    tabx = scaleAreaMapMakeTabx(scx, wd);
+    vsum = (l_uint32 *)LEPT_CALLOC(nbytes, sizeof(l_uint32));
+    hsum = (l_uint32 *)LEPT_CALLOC(4 * (ws + 1), sizeof(l_uint32));
+    if (!tabx || !vsum || !hsum) {
+        LEPT_FREE(tabx);
+        LEPT_FREE(vsum);
+        LEPT_FREE(hsum);
+        L_ERROR("buffers not made\n", procName);
+        return;
+    }
+    index[0] = BYTE_INDEX(COLOR_RED);
+    index[1] = BYTE_INDEX(COLOR_GREEN);
+    index[2] = BYTE_INDEX(COLOR_BLUE);
+
+        /* Iterate over the destination rows */
     for (i = 0; i < hd; i++) {
         yu = (l_int32)(scy * i);
         yl = (l_int32)(scy * (i + 1.0));
@@ -1305,17 +1516,30 @@ l_float32  scx, scy;
         dely = ylp - yup;
         lined = datad + i * wpld;
         lines = datas + yup * wpls;
+
+            /* If near the bottom, just use src pixel values */
+        if (ylp > hm2) {
+            for (j = 0; j < wd; j++)
+                *(lined + j) = *(lines + tabx[5 * j]);
+            continue;
+        }
+
+            /* Area summed over in the vertical direction, in subpixels */
+        areay = (16 - yuf) + 16 * (dely - 1) + ylf;
+        scaleAreaMapSumRowsLow(vsum, (l_uint8 *)lines, wpls, nbytes,
+                               dely, yuf, ylf);
+        for (k = 0; k < 4 * ws; k++)
+            hsum[k + 4] = hsum[k] + vsum[k];
+
         for (j = 0; j < wd; j++) {
-            xu = (l_int32)(scx * j);
-            xl = (l_int32)(scx * (j + 1.0));
-            xup = xu >> 4;
-            xuf = xu & 0x0f;
-            xlp = xl >> 4;
-            xlf = xl & 0x0f;
+            xup = tabx[5 * j];
+            xuf = tabx[5 * j + 1];
+            xlp = tabx[5 * j + 2];
+            xlf = tabx[5 * j + 3];
             delx = xlp - xup;
 
                 /* If near the edge, just use a src pixel value */
-            if (xlp > wm2 || ylp > hm2) {
+            if (xlp > wm2) {
                 *(lined + j) = *(lines + xup);
                 continue;
             }
@@ -1323,82 +1547,31 @@ l_float32  scx, scy;
                 /* Area summed over, in subpixels.  This varies
                  * due to the quantization, so we can't simply take
                  * the area to be a constant: area = scx * scy. */
-            area = ((16 - xuf) + 16 * (delx - 1) + xlf) *
-                   ((16 - yuf) + 16 * (dely - 1) + ylf);
-
-                /* Do area map summation */
-            pixel00 = *(lines + xup);
-            pixel10 = *(lines + xlp);
-            pixel01 = *(lines + dely * wpls +  xup);
-            pixel11 = *(lines + dely * wpls +  xlp);
-            area00 = (16 - xuf) * (16 - yuf);
-            area10 = xlf * (16 - yuf);
-            area01 = (16 - xuf) * ylf;
-            area11 = xlf * ylf;
-            v00r = area00 * ((pixel00 >> L_RED_SHIFT) & 0xff);
-            v00g = area00 * ((pixel00 >> L_GREEN_SHIFT) & 0xff);
-            v00b = area00 * ((pixel00 >> L_BLUE_SHIFT) & 0xff);
-            v10r = area10 * ((pixel10 >> L_RED_SHIFT) & 0xff);
-            v10g = area10 * ((pixel10 >> L_GREEN_SHIFT) & 0xff);
-            v10b = area10 * ((pixel10 >> L_BLUE_SHIFT) & 0xff);
-            v01r = area01 * ((pixel01 >> L_RED_SHIFT) & 0xff);
-            v01g = area01 * ((pixel01 >> L_GREEN_SHIFT) & 0xff);
-            v01b = area01 * ((pixel01 >> L_BLUE_SHIFT) & 0xff);
-            v11r = area11 * ((pixel11 >> L_RED_SHIFT) & 0xff);
-            v11g = area11 * ((pixel11 >> L_GREEN_SHIFT) & 0xff);
-            v11b = area11 * ((pixel11 >> L_BLUE_SHIFT) & 0xff);
-            vinr = ving = vinb = 0;
-            for (k = 1; k < dely; k++) {  /* for full src pixels */
-                for (m = 1; m < delx; m++) {
-                    pixel = *(lines + k * wpls + xup + m);
-                    vinr += 256 * ((pixel >> L_RED_SHIFT) & 0xff);
-                    ving += 256 * ((pixel >> L_GREEN_SHIFT) & 0xff);
-                    vinb += 256 * ((pixel >> L_BLUE_SHIFT) & 0xff);
+            area = tabx[5 * j + 4] * areay;
+
+                /* Sum the partial columns on each side, and the
+                 * full columns between them */
+            for (c = 0; c < 3; c++) {
+                sum = (16 - xuf) * vsum[4 * xup + index[c]] +
+                      xlf * vsum[4 * xlp + index[c]];
+                if (delx > 1) {
+                    sum += 16 * (hsum[4 * xlp + index[c]] -
+                                 hsum[4 * (xup + 1) + index[c]]);
                 }
+                val[c] = (l_int32)((sum + 128) / (l_uint32)area);
             }
-            vmidr = vmidg = vmidb = 0;
-            areal = (16 - xuf) * 16;
-            arear = xlf * 16;
-            areat = 16 * (16 - yuf);
-            areab = 16 * ylf;
-            for (k = 1; k < dely; k++) {  /* for left side */
-                pixel = *(lines + k * wpls + xup);
-                vmidr += areal * ((pixel >> L_RED_SHIFT) & 0xff);
-                vmidg += areal * ((pixel >> L_GREEN_SHIFT) & 0xff);
-                vmidb += areal * ((pixel >> L_BLUE_SHIFT) & 0xff);
-            }
-            for (k = 1; k < dely; k++) {  /* for right side */
-                pixel = *(lines + k * wpls + xlp);
-                vmidr += arear * ((pixel >> L_RED_SHIFT) & 0xff);
-                vmidg += arear * ((pixel >> L_GREEN_SHIFT) & 0xff);
-                vmidb += arear * ((pixel >> L_BLUE_SHIFT) & 0xff);
-            }
-            for (m = 1; m < delx; m++) {  /* for top side */
-                pixel = *(lines + xup + m);
-                vmidr += areat * ((pixel >> L_RED_SHIFT) & 0xff);
-                vmidg += areat * ((pixel >> L_GREEN_SHIFT) & 0xff);
-                vmidb += areat * ((pixel >> L_BLUE_SHIFT) & 0xff);
-            }
-            for (m = 1; m < delx; m++) {  /* for bottom side */
-                pixel = *(lines + dely * wpls + xup + m);
-                vmidr += areab * ((pixel >> L_RED_SHIFT) & 0xff);
-                vmidg += areab * ((pixel >> L_GREEN_SHIFT) & 0xff);
-                vmidb += areab * ((pixel >> L_BLUE_SHIFT) & 0xff);
-            }
-
-                /* Sum all the contributions */
-            rval = (v00r + v01r + v10r + v11r + vinr + vmidr + 128) / area;
-            gval = (v00g + v01g + v10g + v11g + ving + vmidg + 128) / area;
-            bval = (v00b + v01b + v10b + v11b + vinb + vmidb + 128) / area;
 #if  DEBUG_OVERFLOW
-            if (rval > 255) fprintf(stderr, "rval ovfl: %d\n", rval);
-            if (gval > 255) fprintf(stderr, "gval ovfl: %d\n", gval);
-            if (bval > 255) fprintf(stderr, "bval ovfl: %d\n", bval);
+            if (val[0] > 255) fprintf(stderr, "rval ovfl: %d\n", val[0]);
+            if (val[1] > 255) fprintf(stderr, "gval ovfl: %d\n", val[1]);
+            if (val[2] > 255) fprintf(stderr, "bval ovfl: %d\n", val[2]);
 #endif  /* DEBUG_OVERFLOW */
-            composeRGBPixel(rval, gval, bval, lined + j);
+            composeRGBPixel(val[0], val[1], val[2], lined + j);
         }
     }
 
+    LEPT_FREE(tabx);
+    LEPT_FREE(vsum);
+    LEPT_FREE(hsum);
     return;
 }
 
@@ -1413,6 +1586,9 @@ l_float32  scx, scy;
  *  factors between 1.5 and 5.  All src pixels are subdivided
  *  into 256 sub-pixels, and are weighted by the number of
  *  sub-pixels covered by the dest pixel.
+ *
+ *  As in scaleColorAreaMapLow(), the src rows are summed into
+ *  weighted column sums, which are accumulated along the row.
  */
 void
 scaleGrayAreaMapLow(l_uint32  *datad,
@@ -1424,22 +1600,18 @@ scaleGrayAreaMapLow(l_uint32  *datad,
                     l_int32    hs,
                     l_int32    wpls)
 {
-l_int32    i, j, k, m, wm2, hm2;
-l_int32    xu, yu;  /* UL corner in src image, to 1/16 of a pixel */
-l_int32    xl, yl;  /* LR corner in src image, to 1/16 of a pixel */
-l_int32    xup, yup, xuf, yuf;  /* UL src pixel: integer and fraction */
-l_int32    xlp, ylp, xlf, ylf;  /* LR src pixel: integer and fraction */
-l_int32    delx, dely, area;
-l_int32    v00;  /* contrib. from UL src pixel */
-l_int32    v01;  /* contrib. from LL src pixel */
-l_int32    v10;  /* contrib from UR src pixel */
-l_int32    v11;  /* contrib from LR src pixel */
-l_int32    vin;  /* contrib from all full interior src pixels */
-l_int32    vmid;  /* contrib from side parts that are full in 1 direction */
+l_int32    i, j, k, wm2, hm2, nbytes;
+l_int32    yu, yl;  /* UL and LR rows in src image, to 1/16 of a pixel */
+l_int32    yup, yuf, ylp, ylf, dely, areay;
+l_int32    xup, xuf, xlp, xlf, delx, area;
 l_int32    val;
-l_uint32  *lines, *lined;
+l_int32   *tabx;
+l_uint32   sum;
+l_uint32  *lines, *lined, *vsum, *hsum;
 l_float32  scx, scy;
 
+    PROCNAME("scaleGrayAreaMapLow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -1449,7 +1621,21 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
-        /* Iterate over the destination pixels */
+        /* vsum holds the weighted column sums in the byte order of
+         * the src line; hsum holds them accumulated in pixel order */
+    nbytes = 4 * wpls;
+    tabx = scaleAreaMapMakeTabx(scx, wd);
+    vsum = (l_uint32 *)LEPT_CALLOC(nbytes, sizeof(l_uint32));
+    hsum = (l_uint32 *)LEPT_CALLOC(ws + 1, sizeof(l_uint32));
+    if (!tabx || !vsum || !hsum) {
+        LEPT_FREE(tabx);
+        LEPT_FREE(vsum);
+        LEPT_FREE(hsum);
+        L_ERROR("buffers not made\n", procName);
+        return;
+    }
+
+        /* Iterate over the destination rows */
     for (i = 0; i < hd; i++) {
         yu = (l_int32)(scy * i);
         yl = (l_int32)(scy * (i + 1.0));
@@ -1460,17 +1646,30 @@ l_float32  scx, scy;
         dely = ylp - yup;
         lined = datad + i * wpld;
         lines = datas + yup * wpls;
+
+            /* If near the bottom, just use src pixel values */
+        if (ylp > hm2) {
+            for (j = 0; j < wd; j++)
+                SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, tabx[5 * j]));
+            continue;
+        }
+
+            /* Area summed over in the vertical direction, in subpixels */
+        areay = (16 - yuf) + 16 * (dely - 1) + ylf;
+        scaleAreaMapSumRowsLow(vsum, (l_uint8 *)lines, wpls, nbytes,
+                               dely, yuf, ylf);
+        for (k = 0; k < ws; k++)
+            hsum[k + 1] = hsum[k] + vsum[BYTE_INDEX(k)];
+
         for (j = 0; j < wd; j++) {
-            xu = (l_int32)(scx * j);
-            xl = (l_int32)(scx * (j + 1.0));
-            xup = xu >> 4;
-            xuf = xu & 0x0f;
-            xlp = xl >> 4;
-            xlf = xl & 0x0f;
+            xup = tabx[5 * j];
+            xuf = tabx[5 * j + 1];
+            xlp = tabx[5 * j + 2];
+            xlf = tabx[5 * j + 3];
             delx = xlp - xup;
 
                 /* If near the edge, just use a src pixel value */
-            if (xlp > wm2 || ylp > hm2) {
+            if (xlp > wm2) {
                 SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xup));
                 continue;
             }
@@ -1478,28 +1677,15 @@ l_float32  scx, scy;
                 /* Area summed over, in subpixels.  This varies
                  * due to the quantization, so we can't simply take
                  * the area to be a constant: area = scx * scy. */
-            area = ((16 - xuf) + 16 * (delx - 1) + xlf) *
-                   ((16 - yuf) + 16 * (dely - 1) + ylf);
-
-                /* Do area map summation */
-            v00 = (16 - xuf) * (16 - yuf) * GET_DATA_BYTE(lines, xup);
-            v10 = xlf * (16 - yuf) * GET_DATA_BYTE(lines, xlp);
-            v01 = (16 - xuf) * ylf * GET_DATA_BYTE(lines + dely * wpls, xup);
-            v11 = xlf * ylf * GET_DATA_BYTE(lines + dely * wpls, xlp);
-            for (vin = 0, k = 1; k < dely; k++) {  /* for full src pixels */
-                 for (m = 1; m < delx; m++) {
-                     vin += 256 * GET_DATA_BYTE(lines + k * wpls, xup + m);
-                 }
-            }
-            for (vmid = 0, k = 1; k < dely; k++)  /* for left side */
-                vmid += (16 - xuf) * 16 * GET_DATA_BYTE(lines + k * wpls, xup);
-            for (k = 1; k < dely; k++)  /* for right side */
-                vmid += xlf * 16 * GET_DATA_BYTE(lines + k * wpls, xlp);
-            for (m = 1; m < delx; m++)  /* for top side */
-                vmid += 16 * (16 - yuf) * GET_DATA_BYTE(lines, xup + m);
-            for (m = 1; m < delx; m++)  /* for bottom side */
-                vmid += 16 * ylf * GET_DATA_BYTE(lines + dely * wpls, xup + m);
-            val = (v00 + v01 + v10 + v11 + vin + vmid + 128) / area;
+            area = tabx[5 * j + 4] * areay;
+
+                /* Sum the partial columns on each side, and the
+                 * full columns between them */
+            sum = (16 - xuf) * vsum[BYTE_INDEX(xup)] +
+                  xlf * vsum[BYTE_INDEX(xlp)];
+            if (delx > 1)
+                sum += 16 * (hsum[xlp] - hsum[xup + 1]);
+            val = (l_int32)((sum + 128) / (l_uint32)area);
 #if  DEBUG_OVERFLOW
             if (val > 255) fprintf(stderr, "val overflow: %d\n", val);
 #endif  /* DEBUG_OVERFLOW */
@@ -1507,10 +1693,143 @@ l_float32  scx, scy;
         }
     }
 
+    LEPT_FREE(tabx);
+    LEPT_FREE(vsum);
+    LEPT_FREE(hsum);
     return;
 }
 
 
+/*!
+ * \brief   scaleAreaMapMakeTabx()
+ *
+ *      Input:  scx (horizontal scaling from dest to src, in subpixels)
+ *              wd (dest width)
+ *      Return: tabx, or NULL on error
+ *
+ *  Notes:
+ *      (1) For each dest column, tabx holds 5 entries: the UL src
+ *          column and its fraction, the LR src column and its
+ *          fraction, and the width summed over, in subpixels.
+ */
+static l_int32 *
+scaleAreaMapMakeTabx(l_float32  scx,
+                     l_int32    wd)
+{
+l_int32   j, xu, xl;
+l_int32  *tabx;
+
+    if ((tabx = (l_int32 *)LEPT_CALLOC(5 * wd, sizeof(l_int32))) == NULL)
+        return NULL;
+    for (j = 0; j < wd; j++) {
+        xu = (l_int32)(scx * j);
+        xl = (l_int32)(scx * (j + 1.0));
+        tabx[5 * j] = xu >> 4;
+        tabx[5 * j + 1] = xu & 0x0f;
+        tabx[5 * j + 2] = xl >> 4;
+        tabx[5 * j + 3] = xl & 0x0f;
+        tabx[5 * j + 4] = (16 - (xu & 0x0f)) +
+                          16 * ((xl >> 4) - (xu >> 4) - 1) + (xl & 0x0f);
+    }
+    return tabx;
+}
+
+
+/*!
+ * \brief   scaleAreaMapSumRowsLow()
+ *
+ *      Input:  vsum (weighted column sums, for each byte of the line)
+ *              bytes (first src line)
+ *              wpls (src words per line)
+ *              nbytes (bytes in each line)
+ *              dely, yuf, ylf (src rows covered, after the first one,
+ *                              and the fractions of the first and
+ *                              last rows, in subpixels)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The first row is weighted by 16 - yuf, the last by ylf
+ *          and those between by 16.  If the first and last rows are
+ *          the same, the weights add.
+ */
+static void
+scaleAreaMapSumRowsLow(l_uint32       *vsum,
+                       const l_uint8  *bytes,
+                       l_int32         wpls,
+                       l_int32         nbytes,
+                       l_int32         dely,
+                       l_int32         yuf,
+                       l_int32         ylf)
+{
+l_int32  k, weight;
+
+    memset(vsum, 0, nbytes * sizeof(l_uint32));
+    for (k = 0; k <= dely; k++) {
+        weight = (k == 0) ? 16 - yuf : 16;
+        if (k == dely)
+            weight = (k == 0) ? weight + ylf : ylf;
+        if (weight > 0)
+            scaleAreaMapAddRowLow(vsum, bytes + 4 * k * wpls, nbytes, weight);
+    }
+}
+
+
+/*!
+ * \brief   scaleAreaMapAddRowLow()
+ *
+ *      Input:  vsum (weighted column sums, for each byte of the line)
+ *              bytes (src line)
+ *              nbytes (bytes in the line)
+ *              weight (at most 32)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The weighted values fit in 16 bits, so NEON and SSE2 do
+ *          8 bytes at a time before widening them into the sums.
+ */
+static void
+scaleAreaMapAddRowLow(l_uint32       *vsum,
+                      const l_uint8  *bytes,
+                      l_int32         nbytes,
+                      l_int32         weight)
+{
+l_int32      k;
+#if defined(SCALE_USE_NEON)
+uint8x8_t    w8;
+uint16x8_t   prod;
+#elif defined(SCALE_USE_SSE2)
+__m128i      zero, w16, prod;
+#endif
+
+    k = 0;
+#if defined(SCALE_USE_NEON)
+    w8 = vdup_n_u8(weight);
+    for (; k + 8 <= nbytes; k += 8) {
+        prod = vmull_u8(vld1_u8(bytes + k), w8);
+        vst1q_u32(vsum + k, vaddw_u16(vld1q_u32(vsum + k),
+                                      vget_low_u16(prod)));
+        vst1q_u32(vsum + k + 4, vaddw_u16(vld1q_u32(vsum + k + 4),
+                                          vget_high_u16(prod)));
+    }
+#elif defined(SCALE_USE_SSE2)
+    zero = _mm_setzero_si128();
+    w16 = _mm_set1_epi16(weight);
+    for (; k + 8 <= nbytes; k += 8) {
+        prod = _mm_mullo_epi16(_mm_unpacklo_epi8(
+                   _mm_loadl_epi64((const __m128i *)(bytes + k)), zero), w16);
+        _mm_storeu_si128((__m128i *)(vsum + k),
+            _mm_add_epi32(_mm_loadu_si128((const __m128i *)(vsum + k)),
+                          _mm_unpacklo_epi16(prod, zero)));
+        _mm_storeu_si128((__m128i *)(vsum + k + 4),
+            _mm_add_epi32(_mm_loadu_si128((const __m128i *)(vsum + k + 4)),
+                          _mm_unpackhi_epi16(prod, zero)));
+    }
+#endif
+
+    for (; k < nbytes; k++)
+        vsum[k] += weight * bytes[k];
+}
+
 /*------------------------------------------------------------------*
  *                     2x area mapped downscaling                   *
  *------------------------------------------------------------------*/
@@ -1520,6 +1839,9 @@ l_float32  scx, scy;
  *  Notes:
  *        This function is called with either 8 bpp gray or 32 bpp RGB.
  *        The result is a 2x reduced dest.
+ *        With NEON or SSE2, 4 dest words are made at a time from
+ *        the 16 bytes of each of 2 src lines; the remaining pixels
+ *        are done one at a time.
  */
 void
 scaleAreaMapLow2(l_uint32  *datad,
@@ -1530,7 +1852,7 @@ scaleAreaMapLow2(l_uint32  *datad,
                  l_int32    d,
                  l_int32    wpls)
 {
-l_int32    i, j, val, rval, gval, bval;
+l_int32    i, j, jstart, val, rval, gval, bval;
 l_uint32  *lines, *lined;
 l_uint32   pixel;
 
@@ -1538,7 +1860,9 @@ l_uint32   pixel;
         for (i = 0; i < hd; i++) {
             lines = datas + 2 * i * wpls;
             lined = datad + i * wpld;
-            for (j = 0; j < wd; j++) {
+            jstart = 4 * scaleAreaMapGray2Low(lined, lines, lines + wpls,
+                                              wd / 4);
+            for (j = jstart; j < wd; j++) {
                     /* Average each dest pixel using 4 src pixels */
                 val = GET_DATA_BYTE(lines, 2 * j);
                 val += GET_DATA_BYTE(lines, 2 * j + 1);
@@ -1552,7 +1876,8 @@ l_uint32   pixel;
         for (i = 0; i < hd; i++) {
             lines = datas + 2 * i * wpls;
             lined = datad + i * wpld;
-            for (j = 0; j < wd; j++) {
+            jstart = scaleAreaMapColor2Low(lined, lines, lines + wpls, wd);
+            for (j = jstart; j < wd; j++) {
                     /* Average each of the color components from 4 src pixels */
                 pixel = *(lines + 2 * j);
                 rval = (pixel >> L_RED_SHIFT) & 0xff;
@@ -1579,6 +1904,159 @@ l_uint32   pixel;
 }
 
 
+/*!
+ * \brief   scaleAreaMapGray2Low()
+ *
+ *      Input:  lined (dest line)
+ *              lines1, lines2 (the 2 src lines)
+ *              nwords (number of full dest words)
+ *      Return: number of dest words made
+ *
+ *  Notes:
+ *      (1) Adjacent bytes of a src word are adjacent pixels in either
+ *          byte order, so their pair sums are in dest pixel order
+ *          within each half of a dest word.  On little-endian
+ *          machines, the two halves of each dest word are swapped.
+ *      (2) Without NEON or SSE2 this does nothing.
+ */
+static l_int32
+scaleAreaMapGray2Low(l_uint32        *lined,
+                     const l_uint32  *lines1,
+                     const l_uint32  *lines2,
+                     l_int32          nwords)
+{
+l_int32      k;
+#if defined(SCALE_USE_NEON)
+uint16x8_t   sum;
+uint8x8_t    val;
+#elif defined(SCALE_USE_SSE2)
+__m128i      mask, s1, s2, sum0, sum1;
+#endif
+
+    k = 0;
+#if defined(SCALE_USE_NEON)
+    for (; k + 2 <= nwords; k += 2) {
+        sum = vaddq_u16(vpaddlq_u8(vld1q_u8((const l_uint8 *)(lines1 + 2 * k))),
+                        vpaddlq_u8(vld1q_u8((const l_uint8 *)(lines2 + 2 * k))));
+        val = vshrn_n_u16(sum, 2);
+#ifndef L_BIG_ENDIAN
+        val = vreinterpret_u8_u16(vrev32_u16(vreinterpret_u16_u8(val)));
+#endif  /* L_BIG_ENDIAN */
+        vst1_u8((l_uint8 *)(lined + k), val);
+    }
+#elif defined(SCALE_USE_SSE2)
+    mask = _mm_set1_epi16(0xff);
+    for (; k + 4 <= nwords; k += 4) {
+        s1 = _mm_loadu_si128((const __m128i *)(lines1 + 2 * k));
+        s2 = _mm_loadu_si128((const __m128i *)(lines2 + 2 * k));
+        sum0 = _mm_add_epi16(
+                   _mm_add_epi16(_mm_and_si128(s1, mask), _mm_srli_epi16(s1, 8)),
+                   _mm_add_epi16(_mm_and_si128(s2, mask), _mm_srli_epi16(s2, 8)));
+        s1 = _mm_loadu_si128((const __m128i *)(lines1 + 2 * k + 4));
+        s2 = _mm_loadu_si128((const __m128i *)(lines2 + 2 * k + 4));
+        sum1 = _mm_add_epi16(
+                   _mm_add_epi16(_mm_and_si128(s1, mask), _mm_srli_epi16(s1, 8)),
+                   _mm_add_epi16(_mm_and_si128(s2, mask), _mm_srli_epi16(s2, 8)));
+        sum0 = _mm_srli_epi16(sum0, 2);
+        sum1 = _mm_srli_epi16(sum1, 2);
+#ifndef L_BIG_ENDIAN
+        sum0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sum0, 0x4e), 0x4e);
+        sum1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sum1, 0x4e), 0x4e);
+#endif  /* L_BIG_ENDIAN */
+        _mm_storeu_si128((__m128i *)(lined + k), _mm_packus_epi16(sum0, sum1));
+    }
+#endif
+
+    return k;
+}
+
+
+/*!
+ * \brief   scaleAreaMapColor2Low()
+ *
+ *      Input:  lined (dest line)
+ *              lines1, lines2 (the 2 src lines)
+ *              wd (dest width)
+ *      Return: number of dest pixels made
+ *
+ *  Notes:
+ *      (1) The components are averaged byte by byte, and the alpha
+ *          byte of the dest is cleared, as composeRGBPixel() does.
+ *      (2) Without NEON or SSE2 this does nothing.
+ */
+static l_int32
+scaleAreaMapColor2Low(l_uint32        *lined,
+                      const l_uint32  *lines1,
+                      const l_uint32  *lines2,
+                      l_int32          wd)
+{
+l_int32       k;
+#if defined(SCALE_USE_NEON)
+uint32x4x2_t  p1, p2;
+uint16x8_t    sumlo, sumhi;
+uint32x4_t    mask;
+#elif defined(SCALE_USE_SSE2)
+__m128i       zero, mask, a, b, even1, odd1, even2, odd2, sumlo, sumhi;
+#endif
+
+    k = 0;
+#if defined(SCALE_USE_NEON)
+    mask = vdupq_n_u32(~((l_uint32)0xff << L_ALPHA_SHIFT));
+    for (; k + 4 <= wd; k += 4) {
+        p1 = vld2q_u32(lines1 + 2 * k);
+        p2 = vld2q_u32(lines2 + 2 * k);
+        sumlo = vaddq_u16(
+            vaddl_u8(vget_low_u8(vreinterpretq_u8_u32(p1.val[0])),
+                     vget_low_u8(vreinterpretq_u8_u32(p1.val[1]))),
+            vaddl_u8(vget_low_u8(vreinterpretq_u8_u32(p2.val[0])),
+                     vget_low_u8(vreinterpretq_u8_u32(p2.val[1]))));
+        sumhi = vaddq_u16(
+            vaddl_u8(vget_high_u8(vreinterpretq_u8_u32(p1.val[0])),
+                     vget_high_u8(vreinterpretq_u8_u32(p1.val[1]))),
+            vaddl_u8(vget_high_u8(vreinterpretq_u8_u32(p2.val[0])),
+                     vget_high_u8(vreinterpretq_u8_u32(p2.val[1]))));
+        vst1q_u32(lined + k,
+                  vandq_u32(vreinterpretq_u32_u8(
+                                vcombine_u8(vshrn_n_u16(sumlo, 2),
+                                            vshrn_n_u16(sumhi, 2))),
+                            mask));
+    }
+#elif defined(SCALE_USE_SSE2)
+    zero = _mm_setzero_si128();
+    mask = _mm_set1_epi32(~((l_uint32)0xff << L_ALPHA_SHIFT));
+    for (; k + 4 <= wd; k += 4) {
+        a = _mm_loadu_si128((const __m128i *)(lines1 + 2 * k));
+        b = _mm_loadu_si128((const __m128i *)(lines1 + 2 * k + 4));
+        even1 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),
+                                                _mm_castsi128_ps(b), 0x88));
+        odd1 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),
+                                               _mm_castsi128_ps(b), 0xdd));
+        a = _mm_loadu_si128((const __m128i *)(lines2 + 2 * k));
+        b = _mm_loadu_si128((const __m128i *)(lines2 + 2 * k + 4));
+        even2 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),
+                                                _mm_castsi128_ps(b), 0x88));
+        odd2 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),
+                                               _mm_castsi128_ps(b), 0xdd));
+        sumlo = _mm_add_epi16(
+            _mm_add_epi16(_mm_unpacklo_epi8(even1, zero),
+                          _mm_unpacklo_epi8(odd1, zero)),
+            _mm_add_epi16(_mm_unpacklo_epi8(even2, zero),
+                          _mm_unpacklo_epi8(odd2, zero)));
+        sumhi = _mm_add_epi16(
+            _mm_add_epi16(_mm_unpackhi_epi8(even1, zero),
+                          _mm_unpackhi_epi8(odd1, zero)),
+            _mm_add_epi16(_mm_unpackhi_epi8(even2, zero),
+                          _mm_unpackhi_epi8(odd2, zero)));
+        _mm_storeu_si128((__m128i *)(lined + k),
+                         _mm_and_si128(_mm_packus_epi16(_mm_srli_epi16(sumlo, 2),
+                                                        _mm_srli_epi16(sumhi, 2)),
+                                       mask));
+    }
+#endif
+
+    return k;
+}
+
 /*------------------------------------------------------------------*
  *              Binary scaling by closest pixel sampling            *
  *------------------------------------------------------------------*/
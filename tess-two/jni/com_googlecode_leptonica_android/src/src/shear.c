@@ -47,7 +47,11 @@
  *           PIX      *pixHShearLI()
  *           PIX      *pixVShearLI()
  *
- *    Static helper
+ *    Bands of columns moved by a vertical shear
+ *           l_int32  *makeVShearBands()
+ *
+ *    Static helpers
+ *      static l_int32    vShearBandsLow()
  *      static l_float32  normalizeAngleForShear()
  * </pre>
  */
@@ -59,6 +63,8 @@
     /* Shear angle must not get too close to -pi/2 or pi/2 */
 static const l_float32   MIN_DIFF_FROM_HALF_PI = 0.04;
 
+static l_int32 vShearBandsLow(l_int32 w, l_int32 xloc, l_float32 radang,
+                              l_int32 *bands);
 static l_float32 normalizeAngleForShear(l_float32 radang, l_float32 mindif);
 
 
@@ -224,6 +230,8 @@ l_float32  tanangle, invangle;
  *      (8) The angle is brought into the range [-pi, -pi].  It is
  *          not permitted to be within MIN_DIFF_FROM_HALF_PI radians
  *          from either -pi/2 or pi/2.
+ *      (9) The bands of columns and their shifts are given by
+ *          makeVShearBands().
  * </pre>
  */
 PIX *
@@ -233,9 +241,9 @@ pixVShear(PIX       *pixd,
           l_float32  radang,
           l_int32    incolor)
 {
-l_int32    sign, w, h;
-l_int32    x, xincr, initxincr, vshift;
-l_float32  tanangle, invangle;
+l_int32    i, w, h, nbands;
+l_int32    x, xincr, vshift;
+l_int32   *bands;
 
     PROCNAME("pixVShear");
 
@@ -268,38 +276,19 @@ l_float32  tanangle, invangle;
     pixSetBlackOrWhite(pixd, incolor);
 
     pixGetDimensions(pixs, &w, &h, NULL);
-    sign = L_SIGN(radang);
-    tanangle = tan(radang);
-    invangle = L_ABS(1. / tanangle);
-    initxincr = (l_int32)(invangle / 2.);
-    xincr = (l_int32)invangle;
-    pixRasterop(pixd, xloc - initxincr, 0, 2 * initxincr, h, PIX_SRC,
-                pixs, xloc - initxincr, 0);
-
-    for (vshift = 1, x = xloc + initxincr; x < w; vshift++) {
-        xincr = (l_int32)(invangle * (vshift + 0.5) + 0.5) - (x - xloc);
-        if (w - x < xincr)  /* reduce for last one if req'd */
-            xincr = w - x;
-        pixRasterop(pixd, x, sign*vshift, xincr, h, PIX_SRC, pixs, x, 0);
+    if ((bands = makeVShearBands(w, xloc, radang, &nbands)) == NULL)
+        return (PIX *)ERROR_PTR("bands not made", procName, pixd);
+    for (i = 0; i < nbands; i++) {
+        x = bands[3 * i];
+        xincr = bands[3 * i + 1];
+        vshift = bands[3 * i + 2];
+        pixRasterop(pixd, x, vshift, xincr, h, PIX_SRC, pixs, x, 0);
 #if DEBUG
         fprintf(stderr, "x = %d, vshift = %d, xincr = %d\n", x, vshift, xincr);
 #endif /* DEBUG */
-        x += xincr;
-    }
-
-    for (vshift = -1, x = xloc - initxincr; x > 0; vshift--) {
-        xincr = (x - xloc) - (l_int32)(invangle * (vshift - 0.5) + 0.5);
-        if (x < xincr)  /* reduce for last one if req'd */
-            xincr = x;
-        pixRasterop(pixd, x - xincr, sign*vshift, xincr, h, PIX_SRC,
-            pixs, x - xincr, 0);
-#if DEBUG
-        fprintf(stderr, "x = %d, vshift = %d, xincr = %d\n",
-                x - xincr, vshift, xincr);
-#endif /* DEBUG */
-        x -= xincr;
     }
 
+    LEPT_FREE(bands);
     return pixd;
 }
 
@@ -813,6 +802,129 @@ PIX       *pix, *pixd;
 }
 
 
+/*-------------------------------------------------------------------------*
+ *               Bands of columns moved by a vertical shear                *
+ *-------------------------------------------------------------------------*/
+/*!
+ * \brief   makeVShearBands()
+ *
+ * \param[in]    w width of the image
+ * \param[in]    xloc location of vertical line, measured from origin
+ * \param[in]    radang angle in radians
+ * \param[out]   pnbands number of bands
+ * \return  bands array of 3 * nbands values, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Band i holds the columns x, ..., x + xincr - 1, which are
+ *          moved down by vshift rows, where x = bands[3 * i],
+ *          xincr = bands[3 * i + 1] and vshift = bands[3 * i + 2].
+ *          The first band may extend past the sides of the image,
+ *          so the bands must be clipped by the caller.
+ *      (2) These are the bands that pixVShear() moves.  They are
+ *          also used to find the line sums of a shear without making
+ *          the sheared image; see skew.c.
+ *      (3) The angle is normalized as in pixVShear().  If there is
+ *          no rotation, the single band is all the columns, unshifted.
+ * </pre>
+ */
+l_int32 *
+makeVShearBands(l_int32    w,
+                l_int32    xloc,
+                l_float32  radang,
+                l_int32   *pnbands)
+{
+l_int32   nbands;
+l_int32  *bands;
+
+    PROCNAME("makeVShearBands");
+
+    if (!pnbands)
+        return (l_int32 *)ERROR_PTR("&nbands not defined", procName, NULL);
+    *pnbands = 0;
+    if (w <= 0)
+        return (l_int32 *)ERROR_PTR("w must be > 0", procName, NULL);
+
+    radang = normalizeAngleForShear(radang, MIN_DIFF_FROM_HALF_PI);
+    nbands = vShearBandsLow(w, xloc, radang, NULL);
+    if ((bands = (l_int32 *)LEPT_CALLOC(3 * nbands, sizeof(l_int32))) == NULL)
+        return (l_int32 *)ERROR_PTR("bands not made", procName, NULL);
+    vShearBandsLow(w, xloc, radang, bands);
+    *pnbands = nbands;
+    return bands;
+}
+
+
+/*!
+ * \brief   vShearBandsLow()
+ *
+ * \param[in]    w width of the image
+ * \param[in]    xloc location of vertical line, measured from origin
+ * \param[in]    radang normalized angle in radians
+ * \param[in]    bands [optional] array of 3 values for each band;
+ *                     use NULL to only count the bands
+ * \return  number of bands
+ */
+static l_int32
+vShearBandsLow(l_int32    w,
+               l_int32    xloc,
+               l_float32  radang,
+               l_int32   *bands)
+{
+l_int32    sign, n;
+l_int32    x, xincr, initxincr, vshift;
+l_float32  tanangle, invangle;
+
+    if (radang == 0.0 || tan(radang) == 0.0) {
+        if (bands) {
+            bands[0] = 0;
+            bands[1] = w;
+            bands[2] = 0;
+        }
+        return 1;
+    }
+
+    sign = L_SIGN(radang);
+    tanangle = tan(radang);
+    invangle = L_ABS(1. / tanangle);
+    initxincr = (l_int32)(invangle / 2.);
+    if (bands) {
+        bands[0] = xloc - initxincr;
+        bands[1] = 2 * initxincr;
+        bands[2] = 0;
+    }
+    n = 1;
+
+    for (vshift = 1, x = xloc + initxincr; x < w; vshift++) {
+        xincr = (l_int32)(invangle * (vshift + 0.5) + 0.5) - (x - xloc);
+        if (w - x < xincr)  /* reduce for last one if req'd */
+            xincr = w - x;
+        if (bands) {
+            bands[3 * n] = x;
+            bands[3 * n + 1] = xincr;
+            bands[3 * n + 2] = sign * vshift;
+        }
+        n++;
+        x += xincr;
+    }
+
+    for (vshift = -1, x = xloc - initxincr; x > 0; vshift--) {
+        xincr = (x - xloc) - (l_int32)(invangle * (vshift - 0.5) + 0.5);
+        if (x < xincr)  /* reduce for last one if req'd */
+            xincr = x;
+        if (bands) {
+            bands[3 * n] = x - xincr;
+            bands[3 * n + 1] = xincr;
+            bands[3 * n + 2] = sign * vshift;
+        }
+        n++;
+        x -= xincr;
+    }
+
+    return n;
+}
+
+
 /*-------------------------------------------------------------------------*
  *                           Angle normalization                           *
  *-------------------------------------------------------------------------*/
@@ -51,6 +51,21 @@
  *      Measures of variance of row sums
  *          l_int32    pixFindNormalizedSquareSum()
  *
+ *      Scoring sheared images without shearing them
+ *          static SKEW_COLUMNS  *skewColumnsCreate()
+ *          static void           skewColumnsDestroy()
+ *          static l_int32        skewScoreAngles()
+ *          static void           skewScoreTask()
+ *          static l_int32        skewShearRowSums()
+ *          static void           skewAddBand()
+ *          static void           skewAddBandLow()
+ *          static l_float32      skewDiffSquareSum()
+ *          static void           skewRowSumsLow()
+ *          static l_uint32       skewPopcount()
+ *
+ *      Threads used for skew detection
+ *          void       l_skewSetNumThreads()
+ *
  *
  *      ==============================================================
  *      Page skew detection
@@ -91,11 +106,32 @@
  *      significantly over the page.  Local skew determination
  *      is not very important except for locating lines of
  *      handwritten text that may be mixed with printed text.
+ *
+ *      The sheared images are never made.  A vertical shear moves
+ *      bands of columns up or down by whole rows, so the line sums
+ *      of the sheared image are sums, over the bands, of the pixel
+ *      counts of each band in the shifted source rows.  The counts
+ *      of every source row, for every run of whole words, are found
+ *      once per image; after that, scoring an angle costs one pass
+ *      over the rows for each band, which is vectorized with NEON
+ *      or SSE2 where available.  The bands are the same ones that
+ *      pixVShear() uses, so the scores are identical to those of
+ *      the sheared images.  The angles of the sweep, and the pair
+ *      of angles tried at each step of the binary search, can be
+ *      scored on several threads; see l_skewSetNumThreads().
  * </pre>
  */
 
+#include <string.h>
 #include <math.h>
 #include "allheaders.h"
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define  SKEW_USE_NEON  1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define  SKEW_USE_SSE2  1
+#endif
 
     /* Default sweep angle parameters for pixFindSkew() */
 static const l_float32  DEFAULT_SWEEP_RANGE = 7.;    /* degrees */
@@ -128,6 +164,57 @@ static const l_float32  MINSCORE_THRESHOLD_CONSTANT = 0.000002;
     /* Default binarization threshold value */
 static const l_int32  DEFAULT_BINARY_THRESHOLD = 130;
 
+    /* Number of threads used for skew detection, or 0 for the number
+     * of processors online; default is 1 */
+static l_int32  var_SKEW_THREADS = 1;
+
+/*!
+ * \brief   The struct SkewColumns holds the pixel counts of a 1 bpp image
+ *  that are needed to find the line sums of any vertical shear of it.
+ *  Both arrays are stored by word column, so that the rows of a column
+ *  are adjacent in memory.
+ */
+struct SkewColumns
+{
+    l_int32    w;       /*!< image width                                   */
+    l_int32    h;       /*!< image height                                  */
+    l_int32    wpl;     /*!< words in each row                             */
+    l_int32   *pre;     /*!< pre[j * h + i]: ON pixels in words 0 ... j - 1
+                             of row i; wpl + 1 columns                     */
+    l_uint32  *words;   /*!< words[j * h + i]: word j of row i, with the
+                             pad bits cleared                              */
+};
+typedef struct SkewColumns  SKEW_COLUMNS;
+
+    /* Angles to be scored by skewScoreAngles() */
+struct SkewScores
+{
+    SKEW_COLUMNS  *sc;
+    l_float32     *radangs;   /*!< shear angles, in radians               */
+    l_int32        xloc;      /*!< shear pivot column                     */
+    l_float32     *scores;    /*!< differential square sum of each angle  */
+    l_int32       *taskerr;   /*!< set for each angle not scored          */
+};
+
+static SKEW_COLUMNS *skewColumnsCreate(PIX *pixs);
+static void skewColumnsDestroy(SKEW_COLUMNS **psc);
+static l_int32 skewScoreAngles(SKEW_COLUMNS *sc, l_float32 *radangs,
+                               l_int32 n, l_int32 pivot, l_float32 *scores);
+static void skewScoreTask(void *data, l_int32 index);
+static l_int32 skewShearRowSums(SKEW_COLUMNS *sc, l_float32 radang,
+                                l_int32 xloc, l_int32 *sums);
+static void skewAddBand(SKEW_COLUMNS *sc, l_int32 x0, l_int32 x1,
+                        l_int32 shift, l_int32 *sums);
+static void skewAddBandLow(l_int32 *sums, const l_int32 *pre0,
+                           const l_int32 *pre1, const l_uint32 *words0,
+                           const l_uint32 *words1, l_uint32 mask0,
+                           l_uint32 mask1, l_int32 n);
+static l_float32 skewDiffSquareSum(const l_int32 *sums, l_int32 w,
+                                   l_int32 h);
+static void skewRowSumsLow(const l_uint32 *data, l_int32 w, l_int32 h,
+                           l_int32 wpl, l_int32 *sums);
+static l_uint32 skewPopcount(l_uint32 word);
+
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_PRINT_SCORES     0
 #define  DEBUG_PRINT_SWEEP      0
@@ -373,11 +460,13 @@ pixFindSkewSweep(PIX        *pixs,
                  l_float32   sweeprange,
                  l_float32   sweepdelta)
 {
-l_int32    ret, bzero, i, nangles;
-l_float32  deg2rad, theta;
-l_float32  sum, maxscore, maxangle;
-NUMA      *natheta, *nascore;
-PIX       *pix, *pixt;
+l_int32        ret, bzero, i, nangles;
+l_float32      deg2rad, theta;
+l_float32      sum, maxscore, maxangle;
+l_float32     *radangs, *scores;
+NUMA          *natheta, *nascore;
+PIX           *pix;
+SKEW_COLUMNS  *sc;
 
     PROCNAME("pixFindSkewSweep");
 
@@ -413,25 +502,30 @@ PIX       *pix, *pixt;
     nangles = (l_int32)((2. * sweeprange) / sweepdelta + 1);
     natheta = numaCreate(nangles);
     nascore = numaCreate(nangles);
-    pixt = pixCreateTemplate(pix);
+    radangs = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
+    scores = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
+    sc = (pix) ? skewColumnsCreate(pix) : NULL;
 
-    if (!pix || !pixt) {
-        ret = ERROR_INT("pix and pixt not both made", procName, 1);
+    if (!pix || !sc) {
+        ret = ERROR_INT("pix and sc not both made", procName, 1);
+        goto cleanup;
+    }
+    if (!natheta || !nascore || !radangs || !scores) {
+        ret = ERROR_INT("angle and score arrays not all made", procName, 1);
         goto cleanup;
     }
-    if (!natheta || !nascore) {
-        ret = ERROR_INT("natheta and nascore not both made", procName, 1);
+
+        /* Score the shears of pix about the UL corner */
+    for (i = 0; i < nangles; i++)
+        radangs[i] = deg2rad * (-sweeprange + i * sweepdelta);
+    if (skewScoreAngles(sc, radangs, nangles, L_SHEAR_ABOUT_CORNER, scores)) {
+        ret = ERROR_INT("scores not made", procName, 1);
         goto cleanup;
     }
 
     for (i = 0; i < nangles; i++) {
         theta = -sweeprange + i * sweepdelta;   /* degrees */
-
-            /* Shear pix about the UL corner and put the result in pixt */
-        pixVShearCorner(pixt, pix, deg2rad * theta, L_BRING_IN_WHITE);
-
-            /* Get score */
-        pixFindDifferentialSquareSum(pixt, &sum);
+        sum = scores[i];
 
 #if  DEBUG_PRINT_SCORES
         L_INFO("sum(%7.2f) = %7.0f\n", procName, theta, sum);
@@ -475,7 +569,9 @@ PIX       *pix, *pixt;
 
 cleanup:
     pixDestroy(&pix);
-    pixDestroy(&pixt);
+    skewColumnsDestroy(&sc);
+    LEPT_FREE(radangs);
+    LEPT_FREE(scores);
     numaDestroy(&nascore);
     numaDestroy(&natheta);
     return ret;
@@ -626,17 +722,20 @@ pixFindSkewSweepAndSearchScorePivot(PIX        *pixs,
                                     l_float32   minbsdelta,
                                     l_int32     pivot)
 {
-l_int32    ret, bzero, i, nangles, n, ratio, maxindex, minloc;
-l_int32    width, height;
-l_float32  deg2rad, theta, delta;
-l_float32  sum, maxscore, maxangle;
-l_float32  centerangle, leftcenterangle, rightcenterangle;
-l_float32  lefttemp, righttemp;
-l_float32  bsearchscore[5];
-l_float32  minscore, minthresh;
-l_float32  rangeleft;
-NUMA      *natheta, *nascore;
-PIX       *pixsw, *pixsch, *pixt1, *pixt2;
+l_int32        ret, bzero, i, nangles, n, ratio, maxindex, minloc;
+l_int32        width, height;
+l_float32      deg2rad, theta, delta;
+l_float32      sum, maxscore, maxangle;
+l_float32      centerangle, leftcenterangle, rightcenterangle;
+l_float32      lefttemp, righttemp;
+l_float32      bsearchscore[5];
+l_float32      minscore, minthresh;
+l_float32      rangeleft;
+l_float32      bsradangs[3], bsscores[3];
+l_float32     *radangs, *scores;
+NUMA          *natheta, *nascore;
+PIX           *pixsw, *pixsch;
+SKEW_COLUMNS  *scsw, *scsch;
 
     PROCNAME("pixFindSkewSweepAndSearchScorePivot");
 
@@ -688,42 +787,45 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
             pixsw = pixReduceRankBinaryCascade(pixsch, 1, 2, 2, 0);
     }
 
-    pixt1 = pixCreateTemplate(pixsw);
-    if (ratio == 1)
-        pixt2 = pixClone(pixt1);
-    else
-        pixt2 = pixCreateTemplate(pixsch);
+        /* Find the pixel counts needed to score shears of both images */
+    scsw = scsch = NULL;
+    if (pixsw)
+        scsw = skewColumnsCreate(pixsw);
+    if (pixsch)
+        scsch = (ratio == 1) ? NULL : skewColumnsCreate(pixsch);
 
     nangles = (l_int32)((2. * sweeprange) / sweepdelta + 1);
     natheta = numaCreate(nangles);
     nascore = numaCreate(nangles);
+    radangs = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
+    scores = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
 
     if (!pixsch || !pixsw) {
         ret = ERROR_INT("pixsch and pixsw not both made", procName, 1);
         goto cleanup;
     }
-    if (!pixt1 || !pixt2) {
-        ret = ERROR_INT("pixt1 and pixt2 not both made", procName, 1);
+    if (!scsw || (ratio != 1 && !scsch)) {
+        ret = ERROR_INT("scsw and scsch not both made", procName, 1);
         goto cleanup;
     }
-    if (!natheta || !nascore) {
-        ret = ERROR_INT("natheta and nascore not both made", procName, 1);
+    if (!natheta || !nascore || !radangs || !scores) {
+        ret = ERROR_INT("angle and score arrays not all made", procName, 1);
         goto cleanup;
     }
+    if (ratio == 1)
+        scsch = scsw;
 
         /* Do sweep */
     rangeleft = sweepcenter - sweeprange;
+    for (i = 0; i < nangles; i++)
+        radangs[i] = deg2rad * (rangeleft + i * sweepdelta);
+    if (skewScoreAngles(scsw, radangs, nangles, pivot, scores)) {
+        ret = ERROR_INT("sweep scores not made", procName, 1);
+        goto cleanup;
+    }
     for (i = 0; i < nangles; i++) {
         theta = rangeleft + i * sweepdelta;   /* degrees */
-
-            /* Shear pix and put the result in pixt1 */
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt1, pixsw, deg2rad * theta, L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt1, pixsw, deg2rad * theta, L_BRING_IN_WHITE);
-
-            /* Get score */
-        pixFindDifferentialSquareSum(pixt1, &sum);
+        sum = scores[i];
 
 #if  DEBUG_PRINT_SCORES
         L_INFO("sum(%7.2f) = %7.0f\n", procName, theta, sum);
@@ -771,25 +873,16 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
         /* Do binary search to find skew angle.
          * First, set up initial three points. */
     centerangle = maxangle;
-    if (pivot == L_SHEAR_ABOUT_CORNER) {
-        pixVShearCorner(pixt2, pixsch, deg2rad * centerangle, L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[2]);
-        pixVShearCorner(pixt2, pixsch, deg2rad * (centerangle - sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[0]);
-        pixVShearCorner(pixt2, pixsch, deg2rad * (centerangle + sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[4]);
-    } else {
-        pixVShearCenter(pixt2, pixsch, deg2rad * centerangle, L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[2]);
-        pixVShearCenter(pixt2, pixsch, deg2rad * (centerangle - sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[0]);
-        pixVShearCenter(pixt2, pixsch, deg2rad * (centerangle + sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[4]);
+    bsradangs[0] = deg2rad * centerangle;
+    bsradangs[1] = deg2rad * (centerangle - sweepdelta);
+    bsradangs[2] = deg2rad * (centerangle + sweepdelta);
+    if (skewScoreAngles(scsch, bsradangs, 3, pivot, bsscores)) {
+        ret = ERROR_INT("search scores not made", procName, 1);
+        goto cleanup;
     }
+    bsearchscore[2] = bsscores[0];
+    bsearchscore[0] = bsscores[1];
+    bsearchscore[4] = bsscores[2];
 
     numaAddNumber(nascore, bsearchscore[2]);
     numaAddNumber(natheta, centerangle);
@@ -802,27 +895,19 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
     delta = 0.5 * sweepdelta;
     while (delta >= minbsdelta)
     {
-            /* Get the left intermediate score */
+            /* Get the left and right intermediate scores */
         leftcenterangle = centerangle - delta;
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt2, pixsch, deg2rad * leftcenterangle,
-                            L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt2, pixsch, deg2rad * leftcenterangle,
-                            L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[1]);
+        rightcenterangle = centerangle + delta;
+        bsradangs[0] = deg2rad * leftcenterangle;
+        bsradangs[1] = deg2rad * rightcenterangle;
+        if (skewScoreAngles(scsch, bsradangs, 2, pivot, bsscores)) {
+            ret = ERROR_INT("search scores not made", procName, 1);
+            goto cleanup;
+        }
+        bsearchscore[1] = bsscores[0];
+        bsearchscore[3] = bsscores[1];
         numaAddNumber(nascore, bsearchscore[1]);
         numaAddNumber(natheta, leftcenterangle);
-
-            /* Get the right intermediate score */
-        rightcenterangle = centerangle + delta;
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt2, pixsch, deg2rad * rightcenterangle,
-                            L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt2, pixsch, deg2rad * rightcenterangle,
-                            L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[3]);
         numaAddNumber(nascore, bsearchscore[3]);
         numaAddNumber(natheta, rightcenterangle);
 
@@ -916,8 +1001,11 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
 cleanup:
     pixDestroy(&pixsw);
     pixDestroy(&pixsch);
-    pixDestroy(&pixt1);
-    pixDestroy(&pixt2);
+    if (scsch != scsw)
+        skewColumnsDestroy(&scsch);
+    skewColumnsDestroy(&scsw);
+    LEPT_FREE(radangs);
+    LEPT_FREE(scores);
     numaDestroy(&nascore);
     numaDestroy(&natheta);
     return ret;
@@ -1061,45 +1149,26 @@ l_int32
 pixFindDifferentialSquareSum(PIX        *pixs,
                              l_float32  *psum)
 {
-l_int32    i, n;
-l_int32    w, h, skiph, skip, nskip;
-l_float32  val1, val2, diff, sum;
-NUMA      *na;
+l_int32   w, h;
+l_int32  *sums;
 
     PROCNAME("pixFindDifferentialSquareSum");
 
     if (!psum)
         return ERROR_INT("&sum not defined", procName, 1);
     *psum = 0.0;
-    if (!pixs)
-        return ERROR_INT("pixs not defined", procName, 1);
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return ERROR_INT("pixs not defined or not 1 bpp", procName, 1);
 
-        /* Generate a number array consisting of the sum
+        /* Generate an array consisting of the sum
          * of pixels in each row of pixs */
-    if ((na = pixCountPixelsByRow(pixs, NULL)) == NULL)
-        return ERROR_INT("na not made", procName, 1);
-
-        /* Compute the number of rows at top and bottom to omit.
-         * We omit these to avoid getting a spurious signal from
-         * the top and bottom of a (nearly) all black image. */
-    w = pixGetWidth(pixs);
-    h = pixGetHeight(pixs);
-    skiph = (l_int32)(0.05 * w);  /* skip for max shear of 0.025 radians */
-    skip = L_MIN(h / 10, skiph);  /* don't remove more than 10% of image */
-    nskip = L_MAX(skip / 2, 1);  /* at top & bot; skip at least one line */
+    pixGetDimensions(pixs, &w, &h, NULL);
+    if ((sums = (l_int32 *)LEPT_CALLOC(h, sizeof(l_int32))) == NULL)
+        return ERROR_INT("sums not made", procName, 1);
+    skewRowSumsLow(pixGetData(pixs), w, h, pixGetWpl(pixs), sums);
 
-        /* Sum the squares of differential row sums, on the
-         * allowed rows.  Note that nskip must be >= 1. */
-    n = numaGetCount(na);
-    sum = 0.0;
-    for (i = nskip; i < n - nskip; i++) {
-        numaGetFValue(na, i - 1, &val1);
-        numaGetFValue(na, i, &val2);
-        diff = val2 - val1;
-        sum += diff * diff;
-    }
-    numaDestroy(&na);
-    *psum = sum;
+    *psum = skewDiffSquareSum(sums, w, h);
+    LEPT_FREE(sums);
     return 0;
 }
 
@@ -1194,3 +1263,476 @@ PIX       *pixt;
 
     return empty;
 }
+
+
+/*----------------------------------------------------------------*
+ *          Scoring sheared images without shearing them          *
+ *----------------------------------------------------------------*/
+/*!
+ * \brief   skewColumnsCreate()
+ *
+ * \param[in]    pixs 1 bpp
+ * \return  sc, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This transposes the words of pixs, with the pad bits cleared,
+ *          and finds for each row the running count of ON pixels in
+ *          its whole words.  The ON pixels of row i in columns
+ *          [x0, x1) are then
+ *              pre[j1][i] - pre[j0][i] - (ON bits of word j0 before x0)
+ *                                      + (ON bits of word j1 before x1)
+ *          where j0 = x0 / 32 and j1 = x1 / 32.
+ * </pre>
+ */
+static SKEW_COLUMNS *
+skewColumnsCreate(PIX  *pixs)
+{
+l_int32        i, j, w, h, wpl;
+l_int32       *pre;
+l_uint32       word, lastmask;
+l_uint32      *data, *line, *words;
+SKEW_COLUMNS  *sc;
+
+    PROCNAME("skewColumnsCreate");
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    wpl = pixGetWpl(pixs);
+    if ((sc = (SKEW_COLUMNS *)LEPT_CALLOC(1, sizeof(SKEW_COLUMNS))) == NULL)
+        return (SKEW_COLUMNS *)ERROR_PTR("sc not made", procName, NULL);
+    sc->w = w;
+    sc->h = h;
+    sc->wpl = wpl;
+    sc->pre = (l_int32 *)LEPT_CALLOC((size_t)(wpl + 1) * h, sizeof(l_int32));
+    sc->words = (l_uint32 *)LEPT_CALLOC((size_t)wpl * h, sizeof(l_uint32));
+    if (!sc->pre || !sc->words) {
+        skewColumnsDestroy(&sc);
+        return (SKEW_COLUMNS *)ERROR_PTR("columns not made", procName, NULL);
+    }
+
+    data = pixGetData(pixs);
+    pre = sc->pre;
+    words = sc->words;
+    lastmask = (w & 31) ? (0xffffffff << (32 - (w & 31))) : 0xffffffff;
+    for (i = 0; i < h; i++) {
+        line = data + i * wpl;
+        for (j = 0; j < wpl; j++) {
+            word = line[j];
+            if (j == wpl - 1)
+                word &= lastmask;
+            words[j * h + i] = word;
+            pre[(j + 1) * h + i] = pre[j * h + i] + skewPopcount(word);
+        }
+    }
+    return sc;
+}
+
+
+/*!
+ * \brief   skewColumnsDestroy()
+ *
+ * \param[in,out]   psc will be set to null before returning
+ * \return  void
+ */
+static void
+skewColumnsDestroy(SKEW_COLUMNS  **psc)
+{
+SKEW_COLUMNS  *sc;
+
+    if (!psc || (sc = *psc) == NULL)
+        return;
+    LEPT_FREE(sc->pre);
+    LEPT_FREE(sc->words);
+    LEPT_FREE(sc);
+    *psc = NULL;
+}
+
+
+/*!
+ * \brief   skewScoreAngles()
+ *
+ * \param[in]    sc columns of the image to be sheared
+ * \param[in]    radangs array of n shear angles, in radians
+ * \param[in]    n number of angles
+ * \param[in]    pivot L_SHEAR_ABOUT_CORNER, L_SHEAR_ABOUT_CENTER
+ * \param[out]   scores array of n scores
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) scores[k] is what pixFindDifferentialSquareSum() gives for the
+ *          image sheared by radangs[k] with pixVShearCorner() or
+ *          pixVShearCenter(), bringing in white.
+ *      (2) The angles are scored on as many threads as set with
+ *          l_skewSetNumThreads().
+ * </pre>
+ */
+static l_int32
+skewScoreAngles(SKEW_COLUMNS  *sc,
+                l_float32     *radangs,
+                l_int32        n,
+                l_int32        pivot,
+                l_float32     *scores)
+{
+l_int32            i, error;
+struct SkewScores  ss;
+
+    PROCNAME("skewScoreAngles");
+
+    if ((ss.taskerr = (l_int32 *)LEPT_CALLOC(n, sizeof(l_int32))) == NULL)
+        return ERROR_INT("taskerr not made", procName, 1);
+    ss.sc = sc;
+    ss.radangs = radangs;
+    ss.xloc = (pivot == L_SHEAR_ABOUT_CORNER) ? 0 : sc->w / 2;
+    ss.scores = scores;
+    l_runTasks(skewScoreTask, &ss, n, var_SKEW_THREADS);
+
+    for (i = 0, error = 0; i < n; i++)
+        error |= ss.taskerr[i];
+    LEPT_FREE(ss.taskerr);
+    return error;
+}
+
+
+/*!
+ * \brief   skewScoreTask()
+ *
+ * \param[in]    data struct SkewScores
+ * \param[in]    index of the angle to score
+ * \return  void
+ */
+static void
+skewScoreTask(void     *data,
+              l_int32   index)
+{
+l_int32            *sums;
+struct SkewScores  *ss;
+
+    ss = (struct SkewScores *)data;
+    ss->scores[index] = 0.0;
+    if ((sums = (l_int32 *)LEPT_CALLOC(ss->sc->h, sizeof(l_int32))) == NULL) {
+        ss->taskerr[index] = 1;
+        return;
+    }
+    if (skewShearRowSums(ss->sc, ss->radangs[index], ss->xloc, sums))
+        ss->taskerr[index] = 1;
+    else
+        ss->scores[index] = skewDiffSquareSum(sums, ss->sc->w, ss->sc->h);
+    LEPT_FREE(sums);
+}
+
+
+/*!
+ * \brief   skewShearRowSums()
+ *
+ * \param[in]    sc columns of the image
+ * \param[in]    radang shear angle, in radians
+ * \param[in]    xloc column about which the shear is done
+ * \param[out]   sums array of h line sums of the sheared image
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The bands of columns and their shifts are those moved by
+ *          pixVShear(), from makeVShearBands().
+ * </pre>
+ */
+static l_int32
+skewShearRowSums(SKEW_COLUMNS  *sc,
+                 l_float32      radang,
+                 l_int32        xloc,
+                 l_int32       *sums)
+{
+l_int32   i, nbands;
+l_int32  *bands;
+
+    memset(sums, 0, sc->h * sizeof(l_int32));
+    if ((bands = makeVShearBands(sc->w, xloc, radang, &nbands)) == NULL)
+        return 1;
+    for (i = 0; i < nbands; i++) {
+        skewAddBand(sc, bands[3 * i], bands[3 * i] + bands[3 * i + 1],
+                    bands[3 * i + 2], sums);
+    }
+    LEPT_FREE(bands);
+    return 0;
+}
+
+
+/*!
+ * \brief   skewAddBand()
+ *
+ * \param[in]    sc columns of the image
+ * \param[in]    x0, x1 band of columns [x0, x1); clipped to the image
+ * \param[in]    shift number of rows the band is moved down
+ * \param[in,out]  sums line sums, to which the band is added
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Pixels moved out of the image are dropped, as with
+ *          pixRasterop().
+ * </pre>
+ */
+static void
+skewAddBand(SKEW_COLUMNS  *sc,
+            l_int32        x0,
+            l_int32        x1,
+            l_int32        shift,
+            l_int32       *sums)
+{
+l_int32    h, i0, i1, j0, j1;
+l_uint32   mask0, mask1;
+l_uint32  *words1;
+
+    h = sc->h;
+    x0 = L_MAX(0, x0);
+    x1 = L_MIN(sc->w, x1);
+    i0 = L_MAX(0, -shift);
+    i1 = L_MIN(h, h - shift);
+    if (x0 >= x1 || i0 >= i1)
+        return;
+
+    j0 = x0 >> 5;
+    j1 = x1 >> 5;
+    mask0 = (x0 & 31) ? ~(0xffffffff >> (x0 & 31)) : 0;
+    mask1 = (x1 & 31) ? ~(0xffffffff >> (x1 & 31)) : 0;
+    words1 = (mask1) ? sc->words + j1 * h : sc->words + j0 * h;
+    skewAddBandLow(sums + i0 + shift, sc->pre + j0 * h + i0,
+                   sc->pre + j1 * h + i0, sc->words + j0 * h + i0,
+                   words1 + i0, mask0, mask1, i1 - i0);
+}
+
+
+/*!
+ * \brief   skewAddBandLow()
+ *
+ * \param[in,out]  sums n line sums
+ * \param[in]    pre0, pre1 running counts of the first and last word
+ *                          columns of the band, for n rows
+ * \param[in]    words0, words1 the words of these columns
+ * \param[in]    mask0 bits of words0 before the band
+ * \param[in]    mask1 bits of words1 in the band
+ * \param[in]    n number of rows
+ * \return  void
+ */
+static void
+skewAddBandLow(l_int32         *sums,
+               const l_int32   *pre0,
+               const l_int32   *pre1,
+               const l_uint32  *words0,
+               const l_uint32  *words1,
+               l_uint32         mask0,
+               l_uint32         mask1,
+               l_int32          n)
+{
+l_int32  i;
+
+    i = 0;
+#if SKEW_USE_NEON
+    {
+    uint32x4_t  m0, m1, c0, c1;
+    int32x4_t   s;
+    m0 = vdupq_n_u32(mask0);
+    m1 = vdupq_n_u32(mask1);
+    for (; i + 4 <= n; i += 4) {
+        c0 = vandq_u32(vld1q_u32(words0 + i), m0);
+        c1 = vandq_u32(vld1q_u32(words1 + i), m1);
+        c0 = vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u32(c0))));
+        c1 = vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u32(c1))));
+        s = vsubq_s32(vld1q_s32(pre1 + i), vld1q_s32(pre0 + i));
+        s = vaddq_s32(s, vreinterpretq_s32_u32(vsubq_u32(c1, c0)));
+        vst1q_s32(sums + i, vaddq_s32(vld1q_s32(sums + i), s));
+    }
+    }
+#elif SKEW_USE_SSE2
+    {
+    __m128i  m0, m1, k1, k2, k4, k6, c0, c1, s;
+    m0 = _mm_set1_epi32((int)mask0);
+    m1 = _mm_set1_epi32((int)mask1);
+    k1 = _mm_set1_epi32(0x55555555);
+    k2 = _mm_set1_epi32(0x33333333);
+    k4 = _mm_set1_epi32(0x0f0f0f0f);
+    k6 = _mm_set1_epi32(0x3f);
+    for (; i + 4 <= n; i += 4) {
+        c0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(words0 + i)), m0);
+        c1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(words1 + i)), m1);
+        c0 = _mm_sub_epi32(c0, _mm_and_si128(_mm_srli_epi32(c0, 1), k1));
+        c1 = _mm_sub_epi32(c1, _mm_and_si128(_mm_srli_epi32(c1, 1), k1));
+        c0 = _mm_add_epi32(_mm_and_si128(c0, k2),
+                           _mm_and_si128(_mm_srli_epi32(c0, 2), k2));
+        c1 = _mm_add_epi32(_mm_and_si128(c1, k2),
+                           _mm_and_si128(_mm_srli_epi32(c1, 2), k2));
+        c0 = _mm_and_si128(_mm_add_epi32(c0, _mm_srli_epi32(c0, 4)), k4);
+        c1 = _mm_and_si128(_mm_add_epi32(c1, _mm_srli_epi32(c1, 4)), k4);
+        c0 = _mm_add_epi32(c0, _mm_srli_epi32(c0, 8));
+        c1 = _mm_add_epi32(c1, _mm_srli_epi32(c1, 8));
+        c0 = _mm_and_si128(_mm_add_epi32(c0, _mm_srli_epi32(c0, 16)), k6);
+        c1 = _mm_and_si128(_mm_add_epi32(c1, _mm_srli_epi32(c1, 16)), k6);
+        s = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(pre1 + i)),
+                          _mm_loadu_si128((const __m128i *)(pre0 + i)));
+        s = _mm_add_epi32(s, _mm_sub_epi32(c1, c0));
+        s = _mm_add_epi32(s, _mm_loadu_si128((const __m128i *)(sums + i)));
+        _mm_storeu_si128((__m128i *)(sums + i), s);
+    }
+    }
+#endif  /* SKEW_USE_NEON */
+
+    for (; i < n; i++) {
+        sums[i] += pre1[i] - pre0[i] -
+                   (l_int32)skewPopcount(words0[i] & mask0) +
+                   (l_int32)skewPopcount(words1[i] & mask1);
+    }
+}
+
+
+/*!
+ * \brief   skewDiffSquareSum()
+ *
+ * \param[in]    sums h line sums
+ * \param[in]    w, h size of the image
+ * \return  sum of the squares of differences of line sums
+ *
+ * <pre>
+ * Notes:
+ *      (1) See pixFindDifferentialSquareSum().  The lines skipped at the
+ *          top and bottom, and the order of summation, must be kept.
+ * </pre>
+ */
+static l_float32
+skewDiffSquareSum(const l_int32  *sums,
+                  l_int32         w,
+                  l_int32         h)
+{
+l_int32    i, skiph, skip, nskip;
+l_float32  val1, val2, diff, sum;
+
+        /* Compute the number of rows at top and bottom to omit.
+         * We omit these to avoid getting a spurious signal from
+         * the top and bottom of a (nearly) all black image. */
+    skiph = (l_int32)(0.05 * w);  /* skip for max shear of 0.025 radians */
+    skip = L_MIN(h / 10, skiph);  /* don't remove more than 10% of image */
+    nskip = L_MAX(skip / 2, 1);  /* at top & bot; skip at least one line */
+
+        /* Sum the squares of differential row sums, on the
+         * allowed rows.  Note that nskip must be >= 1. */
+    sum = 0.0;
+    for (i = nskip; i < h - nskip; i++) {
+        val1 = (l_float32)sums[i - 1];
+        val2 = (l_float32)sums[i];
+        diff = val2 - val1;
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+
+/*!
+ * \brief   skewRowSumsLow()
+ *
+ * \param[in]    data of a 1 bpp image
+ * \param[in]    w, h, wpl of the image
+ * \param[out]   sums array of h counts of ON pixels in each row
+ * \return  void
+ */
+static void
+skewRowSumsLow(const l_uint32  *data,
+               l_int32          w,
+               l_int32          h,
+               l_int32          wpl,
+               l_int32         *sums)
+{
+l_int32          i, j, fullwords, endbits, sum;
+l_uint32         endmask;
+const l_uint32  *line;
+
+    fullwords = w >> 5;
+    endbits = w & 31;
+    endmask = (endbits == 0) ? 0 : (0xffffffff << (32 - endbits));
+    for (i = 0; i < h; i++) {
+        line = data + i * wpl;
+        j = 0;
+        sum = 0;
+#if SKEW_USE_NEON
+        {
+        uint32x4_t  acc;
+        uint64x2_t  acc2;
+        acc = vdupq_n_u32(0);
+        for (; j + 4 <= fullwords; j += 4) {
+            acc = vaddq_u32(acc, vpaddlq_u16(vpaddlq_u8(
+                      vcntq_u8(vreinterpretq_u8_u32(vld1q_u32(line + j))))));
+        }
+        acc2 = vpaddlq_u32(acc);
+        sum = (l_int32)(vgetq_lane_u64(acc2, 0) + vgetq_lane_u64(acc2, 1));
+        }
+#elif SKEW_USE_SSE2
+        {
+        __m128i  c, acc, k1, k2, k4, zero;
+        k1 = _mm_set1_epi8(0x55);
+        k2 = _mm_set1_epi8(0x33);
+        k4 = _mm_set1_epi8(0x0f);
+        zero = _mm_setzero_si128();
+        acc = zero;
+        for (; j + 4 <= fullwords; j += 4) {
+            c = _mm_loadu_si128((const __m128i *)(line + j));
+            c = _mm_sub_epi8(c, _mm_and_si128(_mm_srli_epi16(c, 1), k1));
+            c = _mm_add_epi8(_mm_and_si128(c, k2),
+                             _mm_and_si128(_mm_srli_epi16(c, 2), k2));
+            c = _mm_and_si128(_mm_add_epi8(c, _mm_srli_epi16(c, 4)), k4);
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(c, zero));
+        }
+        sum = _mm_cvtsi128_si32(acc) +
+              _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+        }
+#endif  /* SKEW_USE_NEON */
+        for (; j < fullwords; j++)
+            sum += skewPopcount(line[j]);
+        if (endbits)
+            sum += skewPopcount(line[j] & endmask);
+        sums[i] = sum;
+    }
+}
+
+
+/*!
+ * \brief   skewPopcount()
+ *
+ * \param[in]    word
+ * \return  number of ON bits in word
+ */
+static l_uint32
+skewPopcount(l_uint32  word)
+{
+    word = word - ((word >> 1) & 0x55555555);
+    word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+    word = (word + (word >> 4)) & 0x0f0f0f0f;
+    return (word * 0x01010101) >> 24;
+}
+
+
+/*----------------------------------------------------------------*
+ *                 Threads used for skew detection                *
+ *----------------------------------------------------------------*/
+/*!
+ * \brief   l_skewSetNumThreads()
+ *
+ * \param[in]    nthreads max number of threads; use 0 for the number
+ *                        of processors online
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This sets the number of threads used to score the angles of
+ *          the sweep, and the two angles of each step of the binary
+ *          search, in pixFindSkew() and the other angle-finding
+ *          functions.  The default is 1, which does all the work on
+ *          the calling thread.
+ *      (2) The angles are scored with l_runTasks(), so this has no
+ *          effect unless leptonica is built with HAVE_PTHREAD.
+ *      (3) The results do not depend on the number of threads.
+ * </pre>
+ */
+void
+l_skewSetNumThreads(l_int32  nthreads)
+{
+    var_SKEW_THREADS = L_MAX(0, nthreads);
+}
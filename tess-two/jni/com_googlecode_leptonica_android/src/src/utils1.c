@@ -81,6 +81,10 @@
  *           l_float32  stopWallTimer()
  *           void       l_getFormattedDate()
  *
+ *       Running tasks on several threads
+ *           void       l_runTasks()
+ *           static void  *runTasksWorker()
+ *
  *  For all issues with cross-platform development, see utils2.c.
  * </pre>
  */
@@ -97,6 +101,10 @@
 #include <time.h>
 #include "allheaders.h"
 #include <math.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif  /* HAVE_PTHREAD */
 
     /* Global for controlling message output at runtime */
 LEPT_DLL l_int32  LeptMsgSeverity = DEFAULT_SEVERITY;
@@ -1138,3 +1146,110 @@ struct tm  *tptr;
     sprintf(buf + 14, "%c%02d'%02d'", sep, relh, relm);
     return stringNew(buf);
 }
+
+
+/*---------------------------------------------------------------------*
+ *                  Running tasks on several threads                   *
+ *---------------------------------------------------------------------*/
+#ifdef HAVE_PTHREAD
+    /* Runs the tasks first, first + stride, ... of a l_runTasks() */
+struct L_TaskWorker {
+    L_TASK_FUNC   func;
+    void         *data;
+    l_int32       first;
+    l_int32       ntasks;
+    l_int32       stride;
+};
+
+static void *
+runTasksWorker(void  *arg)
+{
+l_int32               k;
+struct L_TaskWorker  *tw;
+
+    tw = (struct L_TaskWorker *)arg;
+    for (k = tw->first; k < tw->ntasks; k += tw->stride)
+        tw->func(tw->data, k);
+    return NULL;
+}
+#endif  /* HAVE_PTHREAD */
+
+
+/*!
+ * \brief   l_runTasks()
+ *
+ * \param[in]    func task to run for each index
+ * \param[in]    data passed to each task
+ * \param[in]    ntasks number of tasks, with indices 0 ... ntasks - 1
+ * \param[in]    nthreads max number of threads, including this one;
+ *                        use 0 for the number of processors online
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The tasks are dealt out to the threads in turn.  Each task
+ *          must only write to its own outputs, so that the results do
+ *          not depend on the number of threads.
+ *      (2) This returns when all the tasks are done.  If a thread
+ *          cannot be started, its tasks are run on this one, and if
+ *          the thread bookkeeping cannot be allocated, all of them are.
+ *      (3) Without HAVE_PTHREAD, the tasks are run in order on this
+ *          thread.
+ * </pre>
+ */
+void
+l_runTasks(L_TASK_FUNC   func,
+           void         *data,
+           l_int32       ntasks,
+           l_int32       nthreads)
+{
+l_int32               k;
+#ifdef HAVE_PTHREAD
+l_int32               t;
+l_int32              *started;
+pthread_t            *threads;
+struct L_TaskWorker  *workers;
+
+#ifdef _SC_NPROCESSORS_ONLN
+    if (nthreads <= 0)
+        nthreads = (l_int32)sysconf(_SC_NPROCESSORS_ONLN);
+#endif  /* _SC_NPROCESSORS_ONLN */
+    nthreads = L_MIN(nthreads, ntasks);
+    if (nthreads > 1) {
+        threads = (pthread_t *)LEPT_CALLOC(nthreads, sizeof(pthread_t));
+        workers = (struct L_TaskWorker *)LEPT_CALLOC(nthreads,
+                                                 sizeof(struct L_TaskWorker));
+        started = (l_int32 *)LEPT_CALLOC(nthreads, sizeof(l_int32));
+        if (threads && workers && started) {
+            for (t = 0; t < nthreads; t++) {
+                workers[t].func = func;
+                workers[t].data = data;
+                workers[t].first = t;
+                workers[t].ntasks = ntasks;
+                workers[t].stride = nthreads;
+            }
+            for (t = 1; t < nthreads; t++) {
+                started[t] = pthread_create(&threads[t], NULL, runTasksWorker,
+                                            &workers[t]) == 0;
+            }
+            runTasksWorker(&workers[0]);
+            for (t = 1; t < nthreads; t++) {
+                if (started[t])
+                    pthread_join(threads[t], NULL);
+                else
+                    runTasksWorker(&workers[t]);
+            }
+            LEPT_FREE(threads);
+            LEPT_FREE(workers);
+            LEPT_FREE(started);
+            return;
+        }
+        LEPT_FREE(threads);
+        LEPT_FREE(workers);
+        LEPT_FREE(started);
+    }
+#endif  /* HAVE_PTHREAD */
+
+    for (k = 0; k < ntasks; k++)
+        func(data, k);
+}
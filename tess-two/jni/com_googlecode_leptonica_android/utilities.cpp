@@ -101,6 +101,12 @@ jlong Java_com_googlecode_leptonica_android_Binarize_nativeSauvolaBinarizeTiled(
   return jlong(pixd);
 }
 
+void Java_com_googlecode_leptonica_android_Binarize_nativeSetNumThreads(JNIEnv *env,
+                                                                        jclass clazz,
+                                                                        jint numThreads) {
+  l_binarizeSetNumThreads((l_int32) numThreads);
+}
+
 /********
  * Clip *
  ********/
@@ -218,6 +224,36 @@ jlong Java_com_googlecode_leptonica_android_MorphApp_nativePixFastTophat(JNIEnv
   return jlong(pixd);
 }
 
+jlong Java_com_googlecode_leptonica_android_MorphApp_nativePixMorphBrick(JNIEnv *env, jclass clazz,
+                                                                         jlong nativePix, jint hsize,
+                                                                         jint vsize, jint type) {
+  PIX *pixs = (PIX *) nativePix;
+  PIX *pixd = NULL;
+
+  switch (type) {
+    case L_MORPH_DILATE:
+      pixd = pixDilateBrick(NULL, pixs, (l_int32) hsize, (l_int32) vsize);
+      break;
+    case L_MORPH_ERODE:
+      pixd = pixErodeBrick(NULL, pixs, (l_int32) hsize, (l_int32) vsize);
+      break;
+    case L_MORPH_OPEN:
+      pixd = pixOpenBrick(NULL, pixs, (l_int32) hsize, (l_int32) vsize);
+      break;
+    case L_MORPH_CLOSE:
+      pixd = pixCloseBrick(NULL, pixs, (l_int32) hsize, (l_int32) vsize);
+      break;
+  }
+
+  return jlong(pixd);
+}
+
+void Java_com_googlecode_leptonica_android_MorphApp_nativeSetNumThreads(JNIEnv *env,
+                                                                        jclass clazz,
+                                                                        jint numThreads) {
+  l_morphSetNumThreads((l_int32) numThreads);
+}
+
 /*********
  * Scale *
  *********/
@@ -265,6 +301,12 @@ jfloat Java_com_googlecode_leptonica_android_Skew_nativeFindSkew(JNIEnv *env, jc
   return (jfloat) 0;
 }
 
+void Java_com_googlecode_leptonica_android_Skew_nativeSetNumThreads(JNIEnv *env,
+                                                                    jclass clazz,
+                                                                    jint numThreads) {
+  l_skewSetNumThreads((l_int32) numThreads);
+}
+
 /**********
  * Rotate *
  **********/
@@ -302,6 +344,12 @@ jlong Java_com_googlecode_leptonica_android_Rotate_nativeRotateOrth(JNIEnv *env,
   return jlong(pixd);
 }
 
+void Java_com_googlecode_leptonica_android_Rotate_nativeSetNumThreads(JNIEnv *env,
+                                                                      jclass clazz,
+                                                                      jint numThreads) {
+  l_rotateSetNumThreads((l_int32) numThreads);
+}
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -15,6 +15,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "common.h"
 #include "resultiterator.h"
 #include "allheaders.h"
@@ -101,6 +102,77 @@ jboolean Java_com_googlecode_tesseract_android_ResultIterator_nativeIsAtFinalEle
   return (jboolean) (resultIterator->IsAtFinalElement(enumLevel, enumElement) ? JNI_TRUE : JNI_FALSE);
 }
 
+// Number of ints stored for each element by nativeGetResults. Must match
+// ResultIterator.RESULT_INTS.
+#define RESULT_INTS 8
+
+jobjectArray Java_com_googlecode_tesseract_android_ResultIterator_nativeGetResults(JNIEnv *env,
+    jclass clazz, jlong nativeResultIterator, jint level) {
+  ResultIterator *resultIterator = (ResultIterator *) nativeResultIterator;
+  PageIteratorLevel enumLevel = (PageIteratorLevel) level;
+
+  // Walk a copy so that the caller's position is left untouched.
+  ResultIterator it(*resultIterator);
+  it.Begin();
+
+  GenericVector<jint> values;
+  GenericVector<char> text;
+  if (!it.Empty(enumLevel)) {
+    do {
+      if (it.Empty(enumLevel))
+        continue;
+
+      int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+      it.BoundingBox(enumLevel, &x1, &y1, &x2, &y2);
+
+      // Flag the higher levels this element starts, e.g. a new line.
+      jint flags = 0;
+      for (int i = RIL_BLOCK; i < enumLevel; ++i) {
+        if (it.IsAtBeginningOf((PageIteratorLevel) i))
+          flags |= 1 << i;
+      }
+
+      jint textStart = text.size();
+      char *utf8 = it.GetUTF8Text(enumLevel);
+      if (utf8 != NULL) {
+        for (const char *c = utf8; *c != '\0'; ++c)
+          text.push_back(*c);
+        delete[] utf8;
+      }
+
+      float confidence = it.Confidence(enumLevel);
+      jint confidenceBits;
+      memcpy(&confidenceBits, &confidence, sizeof(confidenceBits));
+
+      values.push_back(x1);
+      values.push_back(y1);
+      values.push_back(x2);
+      values.push_back(y2);
+      values.push_back(confidenceBits);
+      values.push_back(textStart);
+      values.push_back(text.size() - textStart);
+      values.push_back(flags);
+    } while (it.Next(enumLevel));
+  }
+
+  jintArray jvalues = env->NewIntArray(values.size());
+  jbyteArray jtext = env->NewByteArray(text.size());
+  if (jvalues == NULL || jtext == NULL) {
+    LOGE("Could not allocate result arrays!");
+    return NULL;
+  }
+  if (values.size() > 0)
+    env->SetIntArrayRegion(jvalues, 0, values.size(), &values[0]);
+  if (text.size() > 0)
+    env->SetByteArrayRegion(jtext, 0, text.size(), (const jbyte *) &text[0]);
+
+  jobjectArray ret = env->NewObjectArray(2, env->FindClass("java/lang/Object"), NULL);
+  env->SetObjectArrayElement(ret, 0, jvalues);
+  env->SetObjectArrayElement(ret, 1, jtext);
+
+  return ret;
+}
+
 void Java_com_googlecode_tesseract_android_ResultIterator_nativeDelete(JNIEnv *env, jclass clazz,
     jlong nativeResultIterator) {
   ResultIterator *resultIterator = (ResultIterator *) nativeResultIterator;
@@ -70,6 +70,7 @@
 #include "tessbox.h"
 #include "makerow.h"
 #include "otsuthr.h"
+#include "ocrclass.h"
 #include "osdetect.h"
 #include "params.h"
 #include "renderer.h"
@@ -106,6 +107,23 @@ const int kMaxIntSize = 22;
 const int kMinCredibleResolution = 70;
 /** Maximum believable resolution.  */
 const int kMaxCredibleResolution = 2400;
+/**
+ * Minimum width/height ratio of a text detector region for RecognizeRegions
+ * to recognize it as a single line rather than as a single block.
+ */
+const double kMinRegionLineAspect = 3.0;
+
+/** Orders regions by decreasing confidence, keeping ties in input order. */
+struct RegionOrder {
+  float conf;
+  int index;
+
+  bool operator<(const RegionOrder& other) const {
+    if (conf != other.conf)
+      return conf > other.conf;
+    return index < other.index;
+  }
+};
 
 TessBaseAPI::TessBaseAPI()
   : tesseract_(NULL),
@@ -125,9 +143,12 @@ TessBaseAPI::TessBaseAPI()
     last_oem_requested_(OEM_DEFAULT),
     recognition_done_(false),
     truth_cb_(NULL),
+    text_outputs_page_(-1),
     rect_left_(0), rect_top_(0), rect_width_(0), rect_height_(0),
     image_width_(0), image_height_(0) {
     unknown_title_ = "";
+    for (int f = 0; f < TEXT_OUTPUT_COUNT; ++f)
+      text_outputs_[f] = NULL;
 }
 
 TessBaseAPI::~TessBaseAPI() {
@@ -511,6 +532,41 @@ void TessBaseAPI::ClearAdaptiveClassifier() {
   tesseract_->ResetDocumentDictionary();
 }
 
+/**
+ * Saves what the adaptive classifier has learned so far to filename, so
+ * that a later job on similar documents can start from it with
+ * LoadAdaptiveClassifier. The document dictionary is not saved.
+ * Returns false on error.
+ */
+bool TessBaseAPI::SaveAdaptiveClassifier(const char* filename) {
+  if (tesseract_ == NULL || filename == NULL)
+    return false;
+  // Opened for reading too, as the templates are checksummed once written.
+  FILE* fp = fopen(filename, "w+b");
+  if (fp == NULL)
+    return false;
+  bool result = tesseract_->SaveAdaptiveClassifier(fp);
+  if (fclose(fp) != 0)
+    result = false;
+  return result;
+}
+
+/**
+ * Replaces the adaptive classifier with one saved by
+ * SaveAdaptiveClassifier. The file must have been written with the same
+ * languages and traineddata. Returns false on error.
+ */
+bool TessBaseAPI::LoadAdaptiveClassifier(const char* filename) {
+  if (tesseract_ == NULL || filename == NULL)
+    return false;
+  FILE* fp = fopen(filename, "rb");
+  if (fp == NULL)
+    return false;
+  bool result = tesseract_->LoadAdaptiveClassifier(fp);
+  fclose(fp);
+  return result;
+}
+
 /**
  * Provide an image for Tesseract to recognize. Format is as
  * TesseractRect above. Copies the image buffer and converts to Pix.
@@ -829,8 +885,11 @@ PageIterator* TessBaseAPI::AnalyseLayout(bool merge_similar_words) {
 int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
   if (tesseract_ == NULL)
     return -1;
+  OCR_STATS* stats = monitor != NULL ? monitor->stats : NULL;
+  if (stats != NULL) stats->StartStage(OCR_STAGE_LAYOUT);
   if (FindLines() != 0)
     return -1;
+  if (stats != NULL) stats->EndStage(OCR_STAGE_LAYOUT);
   delete page_res_;
   if (block_list_->empty()) {
     page_res_ = new PAGE_RES(false, block_list_,
@@ -893,15 +952,132 @@ int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
     bool wait_for_text = true;
     GetBoolVariable("paragraph_text_based", &wait_for_text);
     if (!wait_for_text) DetectParagraphs(false);
+    tesseract_->SetOcrStats(stats);
+    if (tesseract_->tessedit_page_budget_ms > 0) {
+      tesseract_->SetPageBudget(OCR_STATS::NowUsecs() +
+                                tesseract_->tessedit_page_budget_ms * 1000LL);
+    }
     if (tesseract_->recog_all_words(page_res_, monitor, NULL, NULL, 0)) {
       if (wait_for_text) DetectParagraphs(true);
     } else {
       result = -1;
     }
+    tesseract_->SetPageBudget(0);
+    tesseract_->SetOcrStats(NULL);
   }
   return result;
 }
 
+/**
+ * Recognizes the text regions found by a text detector, in order of
+ * decreasing confidence, each from its part of a single thresholded image.
+ * See the header for details.
+ */
+int TessBaseAPI::RecognizeRegions(Boxa* regions, const float* region_confs,
+                                  int max_regions, int budget_ms,
+                                  ETEXT_DESC* monitor,
+                                  GenericVector<STRING>* texts,
+                                  GenericVector<int>* text_confs) {
+  if (tesseract_ == NULL || regions == NULL || texts == NULL ||
+      text_confs == NULL)
+    return -1;
+  if (thresholder_ == NULL || thresholder_->IsEmpty()) {
+    tprintf("Please call SetImage before attempting recognition.");
+    return -1;
+  }
+  int num_regions = boxaGetCount(regions);
+  texts->init_to_size(num_regions, STRING());
+  text_confs->init_to_size(num_regions, -1);
+
+  // Threshold the whole image once. The regions share the binary and grey
+  // images and the resolution estimate.
+  int left, top, width, height, image_width, image_height;
+  thresholder_->GetImageSizes(&left, &top, &width, &height,
+                              &image_width, &image_height);
+  SetRectangle(0, 0, image_width, image_height);
+  Pix* page_binary = NULL;
+  Threshold(&page_binary);
+  Pix* page_grey = tesseract_->pix_grey() != NULL ?
+      pixClone(tesseract_->pix_grey()) : NULL;
+  int resolution = tesseract_->source_resolution();
+
+  GenericVector<RegionOrder> order;
+  for (int i = 0; i < num_regions; ++i) {
+    RegionOrder region = { region_confs != NULL ? region_confs[i] : 0.0f, i };
+    order.push_back(region);
+  }
+  order.sort();
+
+  int pageseg_mode = tesseract_->tessedit_pageseg_mode;
+  int page_budget_ms = tesseract_->tessedit_page_budget_ms;
+  inT64 deadline = budget_ms > 0 ?
+      OCR_STATS::NowUsecs() + budget_ms * 1000LL : 0;
+  int recognized = 0;
+  for (int i = 0; i < num_regions; ++i) {
+    if (max_regions > 0 && recognized >= max_regions)
+      break;
+    if (monitor != NULL && monitor->cancel != NULL &&
+        (*monitor->cancel)(monitor->cancel_this, recognized))
+      break;
+    if (deadline > 0) {
+      int remaining_ms =
+          static_cast<int>((deadline - OCR_STATS::NowUsecs()) / 1000);
+      if (remaining_ms <= 0)
+        break;
+      if (page_budget_ms > 0 && page_budget_ms < remaining_ms)
+        remaining_ms = page_budget_ms;
+      tesseract_->tessedit_page_budget_ms.set_value(remaining_ms);
+    }
+    int index = order[i].index;
+    Box* region = boxaGetBox(regions, index, L_CLONE);
+    Box* box = region != NULL ?
+        boxClipToRectangle(region, image_width, image_height) : NULL;
+    boxDestroy(&region);
+    if (box == NULL)
+      continue;
+    int x, y, w, h;
+    boxGetGeometry(box, &x, &y, &w, &h);
+    if (w < 1 || h < 1) {
+      boxDestroy(&box);
+      continue;
+    }
+
+    SetRectangle(x, y, w, h);
+    *tesseract_->mutable_pix_binary() = pixClipRectangle(page_binary, box,
+                                                         NULL);
+    if (page_grey != NULL)
+      tesseract_->set_pix_grey(pixClipRectangle(page_grey, box, NULL));
+    boxDestroy(&box);
+    tesseract_->set_source_resolution(resolution);
+    thresholder_->GetImageSizes(&rect_left_, &rect_top_,
+                                &rect_width_, &rect_height_,
+                                &image_width_, &image_height_);
+    tesseract_->tessedit_pageseg_mode.set_value(
+        w >= kMinRegionLineAspect * h ? PSM_SINGLE_LINE : PSM_SINGLE_BLOCK);
+
+    if (Recognize(monitor) == 0) {
+      if (recognition_done_) {
+        char* text = GetUTF8Text();
+        if (text != NULL) {
+          (*texts)[index] = text;
+          delete [] text;
+        }
+        (*text_confs)[index] = MeanTextConf();
+      } else {
+        (*text_confs)[index] = 0;  // No text found in the region.
+      }
+    }
+    ++recognized;
+  }
+
+  tesseract_->tessedit_pageseg_mode.set_value(pageseg_mode);
+  tesseract_->tessedit_page_budget_ms.set_value(page_budget_ms);
+  pixDestroy(&page_binary);
+  pixDestroy(&page_grey);
+  SetRectangle(left, top, width, height);
+  return recognized;
+}
+
 /** Tests the chopper by exhaustively running chop_one_blob. */
 int TessBaseAPI::RecognizeForChopTest(ETEXT_DESC* monitor) {
   if (tesseract_ == NULL)
@@ -1236,7 +1412,10 @@ bool TessBaseAPI::ProcessPage(Pix* pix, int page_index, const char* filename,
   }
 
   if (renderer && !failed) {
+    // Make every output the renderer chain needs in one pass.
+    PrepareTextOutputs(renderer->imagenum() + 1, renderer->TextFormats());
     failed = !renderer->AddImage(this);
+    ClearTextOutputs();
   }
 
   PERF_COUNT_END
@@ -1290,19 +1469,27 @@ MutableIterator* TessBaseAPI::GetMutableIterator() {
                              rect_left_, rect_top_, rect_width_, rect_height_);
 }
 
+/** Appends the text of each paragraph, even one starting with an empty word. */
+static void AppendParagraphText(ResultIterator *it, STRING *text) {
+  do {
+    if (it->Empty(RIL_PARA)) continue;
+    char *para_text = it->GetUTF8Text(RIL_PARA);
+    *text += para_text;
+    delete []para_text;
+  } while (it->Next(RIL_PARA));
+}
+
 /** Make a text string from the internal data structures. */
 char* TessBaseAPI::GetUTF8Text() {
   if (tesseract_ == NULL ||
       (!recognition_done_ && Recognize(NULL) < 0))
     return NULL;
+  char* prepared = CopyTextOutput(TEXT_OUTPUT_UTF8, -1);
+  if (prepared != NULL)
+    return prepared;
   STRING text("");
   ResultIterator *it = GetIterator();
-  do {
-    if (it->Empty(RIL_PARA)) continue;
-    char *para_text = it->GetUTF8Text(RIL_PARA);
-    text += para_text;
-    delete []para_text;
-  } while (it->Next(RIL_PARA));
+  AppendParagraphText(it, &text);
   char* result = new char[text.length() + 1];
   strncpy(result, text.string(), text.length() + 1);
   delete it;
@@ -1441,50 +1628,131 @@ char* TessBaseAPI::GetHOCRText(int page_number) {
 char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
   if (tesseract_ == NULL || (page_res_ == NULL && Recognize(monitor) < 0))
     return NULL;
+  char* prepared = CopyTextOutput(TEXT_OUTPUT_HOCR, page_number);
+  if (prepared != NULL)
+    return prepared;
 
+  STRING hocr_str("");
+  WalkTextOutputs(page_number, NULL, &hocr_str, NULL);
+
+  char *ret = new char[hocr_str.length() + 1];
+  strcpy(ret, hocr_str.string());
+  return ret;
+}
+
+/**
+ * Make a TSV-formatted string from the internal data structures.
+ * page_number is 0-based but will appear in the output as 1-based.
+ */
+char* TessBaseAPI::GetTSVText(int page_number) {
+  if (tesseract_ == NULL || (page_res_ == NULL && Recognize(NULL) < 0))
+    return NULL;
+  char* prepared = CopyTextOutput(TEXT_OUTPUT_TSV, page_number);
+  if (prepared != NULL)
+    return prepared;
+
+  STRING tsv_str("");
+  WalkTextOutputs(page_number, NULL, NULL, &tsv_str);
+
+  char* ret = new char[tsv_str.length() + 1];
+  strcpy(ret, tsv_str.string());
+  return ret;
+}
+
+/**
+ * Estimated output bytes per recognized blob, used to size the hOCR and TSV
+ * buffers up front. A word costs about 100 bytes of hOCR markup and 40 of
+ * TSV columns, and TextLength counts a word of n symbols as n + 2 blobs.
+ */
+const int kHOcrBytesPerBlob = 24;
+const int kTsvBytesPerBlob = 10;
+
+/**
+ * Walks the results once, word by word, appending to each of text, hocr and
+ * tsv that is not NULL. The hOCR and TSV markup share the block/paragraph/
+ * line bookkeeping and the symbol loop; the text is appended a paragraph at
+ * a time as the walk enters it, exactly as GetUTF8Text does.
+ * Image name/input_file_ can be set by SetInputName before calling
+ * GetHOCRText.
+ * STL removed from original patch submission and refactored by rays.
+ */
+void TessBaseAPI::WalkTextOutputs(int page_number, STRING* text,
+                                  STRING* hocr, STRING* tsv) {
   int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
-  int page_id = page_number + 1;  // hOCR uses 1-based page numbers.
+  int page_id = page_number + 1;  // hOCR and TSV use 1-based page numbers.
   bool para_is_ltr = true;        // Default direction is LTR
   const char* paragraph_lang = NULL;
   bool font_info = false;
   GetBoolVariable("hocr_font_info", &font_info);
+  int page_num = page_id, block_num = 0, par_num = 0, line_num = 0,
+      word_num = 0;
 
-  STRING hocr_str("");
+  int blob_count = 0;
+  int text_length = TextLength(&blob_count);
+  if (text != NULL)
+    text->ensure(text->length() + text_length);
+  if (hocr != NULL)
+    hocr->ensure(hocr->length() + text_length +
+                 blob_count * kHOcrBytesPerBlob);
+  if (tsv != NULL)
+    tsv->ensure(tsv->length() + text_length + blob_count * kTsvBytesPerBlob);
 
-  if (input_file_ == NULL)
-      SetInputName(NULL);
+  if (text != NULL) {
+    ResultIterator *text_it = GetIterator();
+    AppendParagraphText(text_it, text);
+    delete text_it;
+  }
+  if (hocr == NULL && tsv == NULL)
+    return;
+
+  if (hocr != NULL) {
+    if (input_file_ == NULL)
+        SetInputName(NULL);
 
 #ifdef _WIN32
-  // convert input name from ANSI encoding to utf-8
-  int str16_len =
-      MultiByteToWideChar(CP_ACP, 0, input_file_->string(), -1, NULL, 0);
-  wchar_t *uni16_str = new WCHAR[str16_len];
-  str16_len = MultiByteToWideChar(CP_ACP, 0, input_file_->string(), -1,
-                                  uni16_str, str16_len);
-  int utf8_len = WideCharToMultiByte(CP_UTF8, 0, uni16_str, str16_len, NULL, 0,
-                                     NULL, NULL);
-  char *utf8_str = new char[utf8_len];
-  WideCharToMultiByte(CP_UTF8, 0, uni16_str, str16_len, utf8_str,
-                      utf8_len, NULL, NULL);
-  *input_file_ = utf8_str;
-  delete[] uni16_str;
-  delete[] utf8_str;
+    // convert input name from ANSI encoding to utf-8
+    int str16_len =
+        MultiByteToWideChar(CP_ACP, 0, input_file_->string(), -1, NULL, 0);
+    wchar_t *uni16_str = new WCHAR[str16_len];
+    str16_len = MultiByteToWideChar(CP_ACP, 0, input_file_->string(), -1,
+                                    uni16_str, str16_len);
+    int utf8_len = WideCharToMultiByte(CP_UTF8, 0, uni16_str, str16_len, NULL,
+                                       0, NULL, NULL);
+    char *utf8_str = new char[utf8_len];
+    WideCharToMultiByte(CP_UTF8, 0, uni16_str, str16_len, utf8_str,
+                        utf8_len, NULL, NULL);
+    *input_file_ = utf8_str;
+    delete[] uni16_str;
+    delete[] utf8_str;
 #endif
 
-  hocr_str += "  <div class='ocr_page'";
-  AddIdTohOCR(&hocr_str, "page", page_id, -1);
-  hocr_str += " title='image \"";
-  if (input_file_) {
-    hocr_str += HOcrEscape(input_file_->string());
-  } else {
-    hocr_str += "unknown";
+    *hocr += "  <div class='ocr_page'";
+    AddIdTohOCR(hocr, "page", page_id, -1);
+    *hocr += " title='image \"";
+    if (input_file_) {
+      *hocr += HOcrEscape(input_file_->string());
+    } else {
+      *hocr += "unknown";
+    }
+    hocr->add_str_int("\"; bbox ", rect_left_);
+    hocr->add_str_int(" ", rect_top_);
+    hocr->add_str_int(" ", rect_width_);
+    hocr->add_str_int(" ", rect_height_);
+    hocr->add_str_int("; ppageno ", page_number);
+    *hocr += "'>\n";
+  }
+  if (tsv != NULL) {
+    tsv->add_str_int("1\t", page_num);  // level 1 - page
+    tsv->add_str_int("\t", block_num);
+    tsv->add_str_int("\t", par_num);
+    tsv->add_str_int("\t", line_num);
+    tsv->add_str_int("\t", word_num);
+    tsv->add_str_int("\t", rect_left_);
+    tsv->add_str_int("\t", rect_top_);
+    tsv->add_str_int("\t", rect_width_);
+    tsv->add_str_int("\t", rect_height_);
+    *tsv += "\t-1\t\n";
   }
-  hocr_str.add_str_int("\"; bbox ", rect_left_);
-  hocr_str.add_str_int(" ", rect_top_);
-  hocr_str.add_str_int(" ", rect_width_);
-  hocr_str.add_str_int(" ", rect_height_);
-  hocr_str.add_str_int("; ppageno ", page_number);
-  hocr_str += "'>\n";
 
   ResultIterator *res_it = GetIterator();
   while (!res_it->Empty(RIL_BLOCK)) {
@@ -1496,34 +1764,72 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
     // Open any new block/paragraph/textline.
     if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
       para_is_ltr = true;  // reset to default direction
-      hocr_str += "   <div class='ocr_carea'";
-      AddIdTohOCR(&hocr_str, "block", page_id, bcnt);
-      AddBoxTohOCR(res_it, RIL_BLOCK, &hocr_str);
+      block_num++, par_num = 0, line_num = 0, word_num = 0;
+      if (hocr != NULL) {
+        *hocr += "   <div class='ocr_carea'";
+        AddIdTohOCR(hocr, "block", page_id, bcnt);
+        AddBoxTohOCR(res_it, RIL_BLOCK, hocr);
+      }
+      if (tsv != NULL) {
+        tsv->add_str_int("2\t", page_num);  // level 2 - block
+        tsv->add_str_int("\t", block_num);
+        tsv->add_str_int("\t", par_num);
+        tsv->add_str_int("\t", line_num);
+        tsv->add_str_int("\t", word_num);
+        AddBoxToTSV(res_it, RIL_BLOCK, tsv);
+        *tsv += "\t-1\t\n";  // end of row for block
+      }
     }
     if (res_it->IsAtBeginningOf(RIL_PARA)) {
-      hocr_str += "\n    <p class='ocr_par'";
-      para_is_ltr = res_it->ParagraphIsLtr();
-      if (!para_is_ltr) {
-        hocr_str += " dir='rtl'";
+      par_num++, line_num = 0, word_num = 0;
+      if (hocr != NULL) {
+        *hocr += "\n    <p class='ocr_par'";
+        para_is_ltr = res_it->ParagraphIsLtr();
+        if (!para_is_ltr) {
+          *hocr += " dir='rtl'";
+        }
+        AddIdTohOCR(hocr, "par", page_id, pcnt);
+        paragraph_lang = res_it->WordRecognitionLanguage();
+        if (paragraph_lang) {
+          *hocr += " lang='";
+          *hocr += paragraph_lang;
+          *hocr += "'";
+        }
+        AddBoxTohOCR(res_it, RIL_PARA, hocr);
       }
-      AddIdTohOCR(&hocr_str, "par", page_id, pcnt);
-      paragraph_lang = res_it->WordRecognitionLanguage();
-      if (paragraph_lang) {
-        hocr_str += " lang='";
-        hocr_str += paragraph_lang;
-        hocr_str += "'";
+      if (tsv != NULL) {
+        tsv->add_str_int("3\t", page_num);  // level 3 - paragraph
+        tsv->add_str_int("\t", block_num);
+        tsv->add_str_int("\t", par_num);
+        tsv->add_str_int("\t", line_num);
+        tsv->add_str_int("\t", word_num);
+        AddBoxToTSV(res_it, RIL_PARA, tsv);
+        *tsv += "\t-1\t\n";  // end of row for para
       }
-      AddBoxTohOCR(res_it, RIL_PARA, &hocr_str);
     }
     if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
-      hocr_str += "\n     <span class='ocr_line'";
-      AddIdTohOCR(&hocr_str, "line", page_id, lcnt);
-      AddBoxTohOCR(res_it, RIL_TEXTLINE, &hocr_str);
+      line_num++, word_num = 0;
+      if (hocr != NULL) {
+        *hocr += "\n     <span class='ocr_line'";
+        AddIdTohOCR(hocr, "line", page_id, lcnt);
+        AddBoxTohOCR(res_it, RIL_TEXTLINE, hocr);
+      }
+      if (tsv != NULL) {
+        tsv->add_str_int("4\t", page_num);  // level 4 - line
+        tsv->add_str_int("\t", block_num);
+        tsv->add_str_int("\t", par_num);
+        tsv->add_str_int("\t", line_num);
+        tsv->add_str_int("\t", word_num);
+        AddBoxToTSV(res_it, RIL_TEXTLINE, tsv);
+        *tsv += "\t-1\t\n";  // end of row for line
+      }
     }
 
+    bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
+    bool last_word_in_para = res_it->IsAtFinalElement(RIL_PARA, RIL_WORD);
+    bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
+
     // Now, process the word...
-    hocr_str += "<span class='ocrx_word'";
-    AddIdTohOCR(&hocr_str, "word", page_id, wcnt);
     int left, top, right, bottom;
     bool bold, italic, underlined, monospace, serif, smallcaps;
     int pointsize, font_id;
@@ -1532,184 +1838,185 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
     font_name = res_it->WordFontAttributes(&bold, &italic, &underlined,
                                            &monospace, &serif, &smallcaps,
                                            &pointsize, &font_id);
-    hocr_str.add_str_int(" title='bbox ", left);
-    hocr_str.add_str_int(" ", top);
-    hocr_str.add_str_int(" ", right);
-    hocr_str.add_str_int(" ", bottom);
-    hocr_str.add_str_int("; x_wconf ", res_it->Confidence(RIL_WORD));
-    if (font_info) {
-      if (font_name) {
-        hocr_str += "; x_font ";
-        hocr_str += HOcrEscape(font_name);
+    int conf = res_it->Confidence(RIL_WORD);
+    word_num++;
+    if (hocr != NULL) {
+      *hocr += "<span class='ocrx_word'";
+      AddIdTohOCR(hocr, "word", page_id, wcnt);
+      hocr->add_str_int(" title='bbox ", left);
+      hocr->add_str_int(" ", top);
+      hocr->add_str_int(" ", right);
+      hocr->add_str_int(" ", bottom);
+      hocr->add_str_int("; x_wconf ", conf);
+      if (font_info) {
+        if (font_name) {
+          *hocr += "; x_font ";
+          *hocr += HOcrEscape(font_name);
+        }
+        hocr->add_str_int("; x_fsize ", pointsize);
       }
-      hocr_str.add_str_int("; x_fsize ", pointsize);
-    }
-    hocr_str += "'";
-    const char* lang = res_it->WordRecognitionLanguage();
-    if (lang && (!paragraph_lang || strcmp(lang, paragraph_lang))) {
-      hocr_str += " lang='";
-      hocr_str += lang;
-      hocr_str += "'";
+      *hocr += "'";
+      const char* lang = res_it->WordRecognitionLanguage();
+      if (lang && (!paragraph_lang || strcmp(lang, paragraph_lang))) {
+        *hocr += " lang='";
+        *hocr += lang;
+        *hocr += "'";
+      }
+      switch (res_it->WordDirection()) {
+        // Only emit direction if different from current paragraph direction
+        case DIR_LEFT_TO_RIGHT:
+          if (!para_is_ltr) *hocr += " dir='ltr'";
+          break;
+        case DIR_RIGHT_TO_LEFT:
+          if (para_is_ltr) *hocr += " dir='rtl'";
+          break;
+        case DIR_MIX:
+        case DIR_NEUTRAL:
+        default:  // Do nothing.
+          break;
+      }
+      *hocr += ">";
+      if (bold) *hocr += "<strong>";
+      if (italic) *hocr += "<em>";
     }
-    switch (res_it->WordDirection()) {
-      // Only emit direction if different from current paragraph direction
-      case DIR_LEFT_TO_RIGHT:
-        if (!para_is_ltr) hocr_str += " dir='ltr'";
-        break;
-      case DIR_RIGHT_TO_LEFT:
-        if (para_is_ltr) hocr_str += " dir='rtl'";
-        break;
-      case DIR_MIX:
-      case DIR_NEUTRAL:
-      default:  // Do nothing.
-        break;
+    if (tsv != NULL) {
+      tsv->add_str_int("5\t", page_num);  // level 5 - word
+      tsv->add_str_int("\t", block_num);
+      tsv->add_str_int("\t", par_num);
+      tsv->add_str_int("\t", line_num);
+      tsv->add_str_int("\t", word_num);
+      tsv->add_str_int("\t", left);
+      tsv->add_str_int("\t", top);
+      tsv->add_str_int("\t", right - left);
+      tsv->add_str_int("\t", bottom - top);
+      tsv->add_str_int("\t", conf);
+      *tsv += "\t";
     }
-    hocr_str += ">";
-    bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
-    bool last_word_in_para = res_it->IsAtFinalElement(RIL_PARA, RIL_WORD);
-    bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
-    if (bold) hocr_str += "<strong>";
-    if (italic) hocr_str += "<em>";
     do {
       const char *grapheme = res_it->GetUTF8Text(RIL_SYMBOL);
       if (grapheme && grapheme[0] != 0) {
-        hocr_str += HOcrEscape(grapheme);
+        if (hocr != NULL)
+          *hocr += HOcrEscape(grapheme);
+        if (tsv != NULL)
+          *tsv += grapheme;
       }
       delete []grapheme;
       res_it->Next(RIL_SYMBOL);
     } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    if (italic) hocr_str += "</em>";
-    if (bold) hocr_str += "</strong>";
-    hocr_str += "</span> ";
+    if (hocr != NULL) {
+      if (italic) *hocr += "</em>";
+      if (bold) *hocr += "</strong>";
+      *hocr += "</span> ";
+    }
+    if (tsv != NULL)
+      *tsv += "\n";  // end of row
     wcnt++;
     // Close any ending block/paragraph/textline.
     if (last_word_in_line) {
-      hocr_str += "\n     </span>";
+      if (hocr != NULL)
+        *hocr += "\n     </span>";
       lcnt++;
     }
     if (last_word_in_para) {
-      hocr_str += "\n    </p>\n";
+      if (hocr != NULL)
+        *hocr += "\n    </p>\n";
       pcnt++;
       para_is_ltr = true;  // back to default direction
     }
     if (last_word_in_block) {
-      hocr_str += "   </div>\n";
+      if (hocr != NULL)
+        *hocr += "   </div>\n";
       bcnt++;
     }
   }
-  hocr_str += "  </div>\n";
-
-  char *ret = new char[hocr_str.length() + 1];
-  strcpy(ret, hocr_str.string());
+  if (hocr != NULL)
+    *hocr += "  </div>\n";
   delete res_it;
-  return ret;
 }
 
 /**
- * Make a TSV-formatted string from the internal data structures.
- * page_number is 0-based but will appear in the output as 1-based.
+ * Makes any combination of the text outputs in one call. The hOCR and TSV
+ * outputs share a single walk of the words. The text is made a paragraph at
+ * a time, as GetUTF8Text() does, because the word walk skips empty words
+ * and with them the start of any paragraph that begins with one. The box
+ * and UNLV outputs keep their own walks: the box file is in strict
+ * left-to-right order with no bidi marks, and UNLV works on the raw PAGE_RES
+ * words, so neither can be read off the reading-order walk without changing
+ * its output.
  */
-char* TessBaseAPI::GetTSVText(int page_number) {
-  if (tesseract_ == NULL || (page_res_ == NULL && Recognize(NULL) < 0))
-    return NULL;
-
-  int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
-  int page_id = page_number + 1;  // we use 1-based page numbers.
-
-  STRING tsv_str("");
-
-  int page_num = page_id, block_num = 0, par_num = 0, line_num = 0,
-      word_num = 0;
-
-  tsv_str.add_str_int("1\t", page_num);  // level 1 - page
-  tsv_str.add_str_int("\t", block_num);
-  tsv_str.add_str_int("\t", par_num);
-  tsv_str.add_str_int("\t", line_num);
-  tsv_str.add_str_int("\t", word_num);
-  tsv_str.add_str_int("\t", rect_left_);
-  tsv_str.add_str_int("\t", rect_top_);
-  tsv_str.add_str_int("\t", rect_width_);
-  tsv_str.add_str_int("\t", rect_height_);
-  tsv_str += "\t-1\t\n";
-
-  ResultIterator* res_it = GetIterator();
-  while (!res_it->Empty(RIL_BLOCK)) {
-    if (res_it->Empty(RIL_WORD)) {
-      res_it->Next(RIL_WORD);
-      continue;
-    }
+bool TessBaseAPI::GetTextOutputs(ETEXT_DESC* monitor, int page_number,
+                                 int formats,
+                                 char* outputs[TEXT_OUTPUT_COUNT]) {
+  for (int f = 0; f < TEXT_OUTPUT_COUNT; ++f)
+    outputs[f] = NULL;
+  // hOCR and TSV can be made from the layout alone, like GetHOCRText.
+  const int kRecognizedFormats = (1 << TEXT_OUTPUT_UTF8) |
+      (1 << TEXT_OUTPUT_BOX) | (1 << TEXT_OUTPUT_UNLV);
+  if (tesseract_ == NULL)
+    return false;
+  if ((page_res_ == NULL ||
+       (!recognition_done_ && (formats & kRecognizedFormats) != 0)) &&
+      Recognize(monitor) < 0)
+    return false;
 
-    // Add rows for any new block/paragraph/textline.
-    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
-      block_num++, par_num = 0, line_num = 0, word_num = 0;
-      tsv_str.add_str_int("2\t", page_num);  // level 2 - block
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_BLOCK, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for block
-    }
-    if (res_it->IsAtBeginningOf(RIL_PARA)) {
-      par_num++, line_num = 0, word_num = 0;
-      tsv_str.add_str_int("3\t", page_num);  // level 3 - paragraph
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_PARA, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for para
-    }
-    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
-      line_num++, word_num = 0;
-      tsv_str.add_str_int("4\t", page_num);  // level 4 - line
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_TEXTLINE, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for line
-    }
+  STRING text("");
+  STRING hocr("");
+  STRING tsv("");
+  bool want_text = (formats & (1 << TEXT_OUTPUT_UTF8)) != 0;
+  bool want_hocr = (formats & (1 << TEXT_OUTPUT_HOCR)) != 0;
+  bool want_tsv = (formats & (1 << TEXT_OUTPUT_TSV)) != 0;
+  if (want_text || want_hocr || want_tsv) {
+    WalkTextOutputs(page_number, want_text ? &text : NULL,
+                    want_hocr ? &hocr : NULL, want_tsv ? &tsv : NULL);
+  }
+  STRING* walked[] = { &text, &hocr, &tsv };
+  bool wanted[] = { want_text, want_hocr, want_tsv };
+  for (int f = TEXT_OUTPUT_UTF8; f <= TEXT_OUTPUT_TSV; ++f) {
+    if (!wanted[f]) continue;
+    outputs[f] = new char[walked[f]->length() + 1];
+    strcpy(outputs[f], walked[f]->string());
+  }
+  if (formats & (1 << TEXT_OUTPUT_BOX))
+    outputs[TEXT_OUTPUT_BOX] = GetBoxText(page_number);
+  if (formats & (1 << TEXT_OUTPUT_UNLV))
+    outputs[TEXT_OUTPUT_UNLV] = GetUNLVText();
+  return true;
+}
 
-    // Now, process the word...
-    int left, top, right, bottom;
-    bool bold, italic, underlined, monospace, serif, smallcaps;
-    int pointsize, font_id;
-    const char* font_name;
-    res_it->BoundingBox(RIL_WORD, &left, &top, &right, &bottom);
-    font_name =
-        res_it->WordFontAttributes(&bold, &italic, &underlined, &monospace,
-                                   &serif, &smallcaps, &pointsize, &font_id);
-    word_num++;
-    tsv_str.add_str_int("5\t", page_num);  // level 5 - word
-    tsv_str.add_str_int("\t", block_num);
-    tsv_str.add_str_int("\t", par_num);
-    tsv_str.add_str_int("\t", line_num);
-    tsv_str.add_str_int("\t", word_num);
-    tsv_str.add_str_int("\t", left);
-    tsv_str.add_str_int("\t", top);
-    tsv_str.add_str_int("\t", right - left);
-    tsv_str.add_str_int("\t", bottom - top);
-    tsv_str.add_str_int("\t", res_it->Confidence(RIL_WORD));
-    tsv_str += "\t";
-
-    // Increment counts if at end of block/paragraph/textline.
-    if (res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD)) lcnt++;
-    if (res_it->IsAtFinalElement(RIL_PARA, RIL_WORD)) pcnt++;
-    if (res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD)) bcnt++;
+/**
+ * Makes the given formats for page_number ahead of time, so that each
+ * renderer of a chain gets a copy instead of walking the results again.
+ */
+void TessBaseAPI::PrepareTextOutputs(int page_number, int formats) {
+  ClearTextOutputs();
+  if ((formats & (formats - 1)) == 0)
+    return;  // A single format gains nothing from being made ahead of time.
+  if (GetTextOutputs(NULL, page_number, formats, text_outputs_))
+    text_outputs_page_ = page_number;
+}
 
-    do {
-      tsv_str += res_it->GetUTF8Text(RIL_SYMBOL);
-      res_it->Next(RIL_SYMBOL);
-    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    tsv_str += "\n";  // end of row
-    wcnt++;
+/** Discards the outputs made by PrepareTextOutputs. */
+void TessBaseAPI::ClearTextOutputs() {
+  for (int f = 0; f < TEXT_OUTPUT_COUNT; ++f) {
+    delete [] text_outputs_[f];
+    text_outputs_[f] = NULL;
   }
+  text_outputs_page_ = -1;
+}
 
-  char* ret = new char[tsv_str.length() + 1];
-  strcpy(ret, tsv_str.string());
-  delete res_it;
-  return ret;
+/**
+ * Returns a copy of the prepared output for format, or NULL if there is
+ * none for page_number. A negative page_number matches any page.
+ */
+char* TessBaseAPI::CopyTextOutput(TextOutputFormat format,
+                                  int page_number) const {
+  const char* prepared = text_outputs_[format];
+  if (prepared == NULL ||
+      (page_number >= 0 && page_number != text_outputs_page_))
+    return NULL;
+  char* result = new char[strlen(prepared) + 1];
+  strcpy(result, prepared);
+  return result;
 }
 
 /** The 5 numbers output for each box (the usual 4 and a page number.) */
@@ -1745,6 +2052,9 @@ char* TessBaseAPI::GetBoxText(int page_number) {
   if (tesseract_ == NULL ||
       (!recognition_done_ && Recognize(NULL) < 0))
     return NULL;
+  char* prepared = CopyTextOutput(TEXT_OUTPUT_BOX, page_number);
+  if (prepared != NULL)
+    return prepared;
   int blob_count;
   int utf8_length = TextLength(&blob_count);
   int total_length = blob_count * kBytesPerBoxFileLine + utf8_length +
@@ -1800,6 +2110,9 @@ char* TessBaseAPI::GetUNLVText() {
   if (tesseract_ == NULL ||
       (!recognition_done_ && Recognize(NULL) < 0))
     return NULL;
+  char* prepared = CopyTextOutput(TEXT_OUTPUT_UNLV, -1);
+  if (prepared != NULL)
+    return prepared;
   bool tilde_crunch_written = false;
   bool last_char_was_newline = true;
   bool last_char_was_tilde = false;
@@ -2357,6 +2670,7 @@ void TessBaseAPI::ClearResults() {
   if (tesseract_ != NULL) {
     tesseract_->Clear();
   }
+  ClearTextOutputs();
   if (page_res_ != NULL) {
     delete page_res_;
     page_res_ = NULL;
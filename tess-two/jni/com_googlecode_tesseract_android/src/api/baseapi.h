@@ -96,6 +96,19 @@ typedef void (Wordrec::*FillLatticeFunc)(const MATRIX &ratings,
 typedef TessCallback4<const UNICHARSET &, int, PageIterator *, Pix *>
     TruthCallback;
 
+/**
+ * Text outputs that GetTextOutputs can make in a single pass over the
+ * results. Requests are bitmasks of (1 << TextOutputFormat) values.
+ */
+enum TextOutputFormat {
+  TEXT_OUTPUT_UTF8,   ///< As GetUTF8Text.
+  TEXT_OUTPUT_HOCR,   ///< As GetHOCRText.
+  TEXT_OUTPUT_TSV,    ///< As GetTSVText.
+  TEXT_OUTPUT_BOX,    ///< As GetBoxText.
+  TEXT_OUTPUT_UNLV,   ///< As GetUNLVText.
+  TEXT_OUTPUT_COUNT
+};
+
 /**
  * Base class for all tesseract APIs.
  * Specific classes can add ability to work on different inputs or produce
@@ -324,6 +337,21 @@ class TESS_API TessBaseAPI {
    */
   void ClearAdaptiveClassifier();
 
+  /**
+   * Saves what the adaptive classifier has learned so far to filename, so
+   * that a later job on similar documents can start from it with
+   * LoadAdaptiveClassifier. The document dictionary is not saved.
+   * Returns false on error.
+   */
+  bool SaveAdaptiveClassifier(const char* filename);
+
+  /**
+   * Replaces the adaptive classifier with one saved by
+   * SaveAdaptiveClassifier. The file must have been written with the same
+   * languages and traineddata. Returns false on error.
+   */
+  bool LoadAdaptiveClassifier(const char* filename);
+
   /**
    * @defgroup AdvancedAPI Advanced API
    * The following methods break TesseractRect into pieces, so you can
@@ -504,6 +532,28 @@ class TESS_API TessBaseAPI {
    */
   int Recognize(ETEXT_DESC* monitor);
 
+  /**
+   * Recognizes the text regions found by a text detector, such as the text
+   * areas of HydrogenTextDetector, instead of analysing the layout of the
+   * whole image from SetImage. The image is thresholded once, and each
+   * region is recognized from its part of the thresholded image, as a single
+   * line if it is much wider than it is high, or else as a single block.
+   * Regions are recognized in order of decreasing region_confs, which may be
+   * NULL to keep the order of regions. Recognition stops after max_regions
+   * regions if max_regions > 0, and after budget_ms milliseconds if
+   * budget_ms > 0; a region that is started is held to the remaining budget
+   * as by tessedit_page_budget_ms.
+   * texts and text_confs are resized to the number of regions and receive
+   * the UTF8 text and mean confidence of each region, or an empty string
+   * and -1 for the regions that were not recognized.
+   * monitor can be used to cancel the recognition. Returns the number of
+   * regions recognized, or -1 on error. The rectangle is restored afterwards.
+   */
+  int RecognizeRegions(Boxa* regions, const float* region_confs,
+                       int max_regions, int budget_ms, ETEXT_DESC* monitor,
+                       GenericVector<STRING>* texts,
+                       GenericVector<int>* text_confs);
+
   /**
    * Methods to retrieve information after SetAndThresholdImage(),
    * Recognize() or TesseractRect(). (Recognize is called implicitly if needed.)
@@ -618,6 +668,20 @@ class TESS_API TessBaseAPI {
    */
   char* GetUNLVText();
 
+  /**
+   * Makes any combination of the text outputs above in one call, sharing a
+   * single walk of the results between the hOCR and TSV outputs.
+   * formats is a bitmask of (1 << TextOutputFormat) values.
+   * On success outputs[f] is set, for every requested format f, to the
+   * string the matching Get*Text call would return, and to NULL for every
+   * other format. Each string must be freed with the delete [] operator.
+   * page_number is 0-based, as for GetHOCRText and GetBoxText.
+   * monitor can be used to cancel the recognition and receive progress
+   * callbacks. Returns false if recognition failed.
+   */
+  bool GetTextOutputs(ETEXT_DESC* monitor, int page_number, int formats,
+                      char* outputs[TEXT_OUTPUT_COUNT]);
+
   /**
    * Detect the orientation of the input image and apparent script (alphabet).
    * orient_deg is the detected clockwise rotation of the input image in degrees (0, 90, 180, 270)
@@ -822,6 +886,31 @@ class TESS_API TessBaseAPI {
    */
   TESS_LOCAL int TextLength(int* blob_count);
 
+  /**
+   * Append to whichever of text, hocr and tsv are not NULL the page output
+   * of GetUTF8Text, GetHOCRText and GetTSVText respectively. The text is
+   * made paragraph by paragraph; hocr and tsv share one walk of the words.
+   */
+  TESS_LOCAL void WalkTextOutputs(int page_number, STRING* text,
+                                  STRING* hocr, STRING* tsv);
+
+  /**
+   * Make the given formats for page_number ahead of time, so that the
+   * Get*Text calls of a renderer chain return copies of them instead of
+   * each walking the results again. Does nothing for fewer than two formats.
+   */
+  TESS_LOCAL void PrepareTextOutputs(int page_number, int formats);
+
+  /** Discard the outputs made by PrepareTextOutputs. */
+  TESS_LOCAL void ClearTextOutputs();
+
+  /**
+   * Return a new[]'d copy of the prepared output for format if there is one
+   * for page_number, otherwise NULL. page_number < 0 matches any page.
+   */
+  TESS_LOCAL char* CopyTextOutput(TextOutputFormat format,
+                                  int page_number) const;
+
   /** @defgroup ocropusAddOns ocropus add-ons */
   /* @{ */
 
@@ -876,6 +965,9 @@ class TESS_API TessBaseAPI {
   OcrEngineMode last_oem_requested_;  ///< Last ocr language mode requested.
   bool          recognition_done_;   ///< page_res_ contains recognition data.
   TruthCallback *truth_cb_;           /// fxn for setting truth_* in WERD_RES
+  /** Outputs made by PrepareTextOutputs, indexed by TextOutputFormat. */
+  char*         text_outputs_[TEXT_OUTPUT_COUNT];
+  int           text_outputs_page_;  ///< Page of text_outputs_.
 
   /**
    * @defgroup ThresholderParams Thresholder Parameters
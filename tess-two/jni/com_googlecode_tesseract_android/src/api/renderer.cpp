@@ -87,6 +87,14 @@ bool TessResultRenderer::AddImage(TessBaseAPI* api) {
   return ok;
 }
 
+int TessResultRenderer::TextFormats() const {
+  int formats = TextFormatsHandler();
+  if (next_) {
+    formats |= next_->TextFormats();
+  }
+  return formats;
+}
+
 bool TessResultRenderer::EndDocument() {
   if (!happy_) return false;
   bool ok = EndDocumentHandler();
@@ -113,6 +121,10 @@ bool TessResultRenderer::EndDocumentHandler() {
   return happy_;
 }
 
+int TessResultRenderer::TextFormatsHandler() const {
+  return 0;
+}
+
 
 /**********************************************************************
  * UTF8 Text Renderer interface implementation
@@ -121,6 +133,10 @@ TessTextRenderer::TessTextRenderer(const char *outputbase)
     : TessResultRenderer(outputbase, "txt") {
 }
 
+int TessTextRenderer::TextFormatsHandler() const {
+  return 1 << TEXT_OUTPUT_UTF8;
+}
+
 bool TessTextRenderer::AddImageHandler(TessBaseAPI* api) {
   char* utf8 = api->GetUTF8Text();
   if (utf8 == NULL) {
@@ -185,6 +201,10 @@ bool TessHOcrRenderer::EndDocumentHandler() {
   return true;
 }
 
+int TessHOcrRenderer::TextFormatsHandler() const {
+  return 1 << TEXT_OUTPUT_HOCR;
+}
+
 bool TessHOcrRenderer::AddImageHandler(TessBaseAPI* api) {
   char* hocr = api->GetHOCRText(imagenum());
   if (hocr == NULL) return false;
@@ -218,6 +238,10 @@ bool TessTsvRenderer::BeginDocumentHandler() {
 
 bool TessTsvRenderer::EndDocumentHandler() { return true; }
 
+int TessTsvRenderer::TextFormatsHandler() const {
+  return 1 << TEXT_OUTPUT_TSV;
+}
+
 bool TessTsvRenderer::AddImageHandler(TessBaseAPI* api) {
   char* tsv = api->GetTSVText(imagenum());
   if (tsv == NULL) return false;
@@ -235,6 +259,10 @@ TessUnlvRenderer::TessUnlvRenderer(const char *outputbase)
     : TessResultRenderer(outputbase, "unlv") {
 }
 
+int TessUnlvRenderer::TextFormatsHandler() const {
+  return 1 << TEXT_OUTPUT_UNLV;
+}
+
 bool TessUnlvRenderer::AddImageHandler(TessBaseAPI* api) {
   char* unlv = api->GetUNLVText();
   if (unlv == NULL) return false;
@@ -252,6 +280,10 @@ TessBoxTextRenderer::TessBoxTextRenderer(const char *outputbase)
     : TessResultRenderer(outputbase, "box") {
 }
 
+int TessBoxTextRenderer::TextFormatsHandler() const {
+  return 1 << TEXT_OUTPUT_BOX;
+}
+
 bool TessBoxTextRenderer::AddImageHandler(TessBaseAPI* api) {
   char* text = api->GetBoxText(imagenum());
   if (text == NULL) return false;
@@ -90,6 +90,13 @@ class TESS_API TessResultRenderer {
      */
     int imagenum() const { return imagenum_; }
 
+    /**
+     * Returns the TessBaseAPI text outputs read by this renderer and the
+     * ones chained after it, as a bitmask of (1 << TextOutputFormat) values,
+     * so that the api can make them all in one pass before AddImage.
+     */
+    int TextFormats() const;
+
   protected:
     /**
      * Called by concrete classes.
@@ -113,6 +120,9 @@ class TESS_API TessResultRenderer {
     // Hook for specialized handling in EndDocument()
     virtual bool EndDocumentHandler();
 
+    // The text outputs read by AddImageHandler, as for TextFormats().
+    virtual int TextFormatsHandler() const;
+
     // Renderers can call this to append '\0' terminated strings into
     // the output string returned by GetOutput.
     // This method will grow the output buffer if needed.
@@ -143,6 +153,7 @@ class TESS_API TessTextRenderer : public TessResultRenderer {
 
  protected:
   virtual bool AddImageHandler(TessBaseAPI* api);
+  virtual int TextFormatsHandler() const;
 };
 
 /**
@@ -157,6 +168,7 @@ class TESS_API TessHOcrRenderer : public TessResultRenderer {
   virtual bool BeginDocumentHandler();
   virtual bool AddImageHandler(TessBaseAPI* api);
   virtual bool EndDocumentHandler();
+  virtual int TextFormatsHandler() const;
 
  private:
   bool font_info_;  // whether to print font information
@@ -174,6 +186,7 @@ class TESS_API TessTsvRenderer : public TessResultRenderer {
   virtual bool BeginDocumentHandler();
   virtual bool AddImageHandler(TessBaseAPI* api);
   virtual bool EndDocumentHandler();
+  virtual int TextFormatsHandler() const;
 
  private:
   bool font_info_;              // whether to print font information
@@ -225,6 +238,7 @@ class TESS_API TessUnlvRenderer : public TessResultRenderer {
 
  protected:
   virtual bool AddImageHandler(TessBaseAPI* api);
+  virtual int TextFormatsHandler() const;
 };
 
 /**
@@ -236,6 +250,7 @@ class TESS_API TessBoxTextRenderer : public TessResultRenderer {
 
  protected:
   virtual bool AddImageHandler(TessBaseAPI* api);
+  virtual int TextFormatsHandler() const;
 };
 
 /**
@@ -151,6 +151,11 @@ void Tesseract::SetupAllWordsPassN(int pass_n,
   PAGE_RES_IT page_res_it(page_res);
   for (page_res_it.restart_page(); page_res_it.word() != NULL;
        page_res_it.forward()) {
+    if (pass_n == 2 && tessedit_skip_confident_pass2 &&
+        page_res_it.block()->skip_pass2) {
+      OCR_STATS_INC(ocr_stats(), OCR_COUNTER_PASS2_WORDS_KEPT);
+      continue;
+    }
     if (target_word_box == NULL ||
         ProcessTargetWord(page_res_it.word()->word->bounding_box(),
                           *target_word_box, word_config, 1)) {
@@ -200,6 +205,44 @@ void Tesseract::SetupWordPassN(int pass_n, WordData* word) {
   }
 }
 
+// Sets skip_pass2 on the blocks that pass 2 is unlikely to change.
+// Pass 2 re-classifies the words with the templates adapted on the whole
+// page in pass 1, which rarely changes a block whose words were already
+// confident unless many templates were adapted after pass 1 left it.
+void Tesseract::SelectPass2Blocks(PAGE_RES* page_res) {
+  int num_templates = NumTemplatesAdded();
+  BLOCK_RES_IT block_it(&page_res->block_res_list);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    BLOCK_RES* block = block_it.data();
+    int num_words = 0;
+    int num_weak = 0;
+    ROW_RES_IT row_it(&block->row_res_list);
+    for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward()) {
+      WERD_RES_IT word_it(&row_it.data()->word_res_list);
+      for (word_it.mark_cycle_pt(); !word_it.cycled_list();
+           word_it.forward()) {
+        const WERD_RES* word = word_it.data();
+        if (word->part_of_combo || word->tess_failed ||
+            word->best_choice == NULL)
+          continue;
+        ++num_words;
+        if (word->best_choice->certainty() < tessedit_pass2_weak_certainty)
+          ++num_weak;
+      }
+    }
+    block->skip_pass2 =
+        num_words > 0 &&
+        num_weak <= num_words * tessedit_pass2_max_weak_fraction &&
+        num_templates - block->pass1_templates <=
+            tessedit_pass2_max_new_templates;
+    if (block->skip_pass2) {
+      OCR_STATS_INC(ocr_stats(), OCR_COUNTER_PASS2_BLOCKS_KEPT);
+    } else if (num_words > 0) {
+      OCR_STATS_INC(ocr_stats(), OCR_COUNTER_PASS2_BLOCKS_RUN);
+    }
+  }
+}
+
 // Runs word recognition on all the words.
 bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
                                    PAGE_RES_IT* pr_it,
@@ -241,6 +284,11 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
       // If all are failed, skip it. Image words are skipped by this test.
       if (s > word->lang_words.size()) continue;
     }
+    if (pass_n == 2 && PageBudgetExceeded()) {
+      // Out of time for this page, so the word keeps its pass 1 result.
+      OCR_STATS_INC(ocr_stats(), OCR_COUNTER_PASS2_WORDS_SKIPPED);
+      continue;
+    }
     // Sync pr_it with the wth WordData.
     while (pr_it->word() != NULL && pr_it->word() != word->word)
       pr_it->forward();
@@ -252,6 +300,8 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
     }
 
     classify_word_and_language(pass_n, pr_it, word);
+    if (pass_n == 1)
+      pr_it->block()->pass1_templates = NumTemplatesAdded();
     if (tessedit_dump_choices || debug_noise_removal) {
       tprintf("Pass%d: %s [%s]\n", pass_n,
               word->word->best_choice->unichar_string().string(),
@@ -338,6 +388,7 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
 
     most_recently_used_ = this;
     // Run pass 1 word recognition.
+    if (ocr_stats() != NULL) ocr_stats()->StartStage(OCR_STAGE_PASS1);
     if (!RecogAllWordsPassN(1, monitor, &page_res_it, &words)) return false;
     // Pass 1 post-processing.
     for (page_res_it.restart_page(); page_res_it.word() != NULL;
@@ -359,6 +410,8 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
             page_res_it.word()->blamer_bundle->misadaption_debug());
       }
     }
+    if (tessedit_skip_confident_pass2) SelectPass2Blocks(page_res);
+    if (ocr_stats() != NULL) ocr_stats()->EndStage(OCR_STAGE_PASS1);
   }
 
   if (dopasses == 1) return true;
@@ -374,7 +427,9 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     }
     most_recently_used_ = this;
     // Run pass 2 word recognition.
+    if (ocr_stats() != NULL) ocr_stats()->StartStage(OCR_STAGE_PASS2);
     if (!RecogAllWordsPassN(2, monitor, &page_res_it, &words)) return false;
+    if (ocr_stats() != NULL) ocr_stats()->EndStage(OCR_STAGE_PASS2);
   }
 
   // The next passes can only be run if tesseract has been used, as cube
@@ -385,15 +440,20 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     set_global_loc_code(LOC_FUZZY_SPACE);
 
     if (!tessedit_test_adaption && tessedit_fix_fuzzy_spaces
-        && !tessedit_word_for_word && !right_to_left())
+        && !tessedit_word_for_word && !right_to_left()) {
+      if (ocr_stats() != NULL) ocr_stats()->StartStage(OCR_STAGE_FIX_SPACES);
       fix_fuzzy_spaces(monitor, stats_.word_count, page_res);
+      if (ocr_stats() != NULL) ocr_stats()->EndStage(OCR_STAGE_FIX_SPACES);
+    }
 
     // ****************** Pass 4 *******************
     if (tessedit_enable_dict_correction) dictionary_correction_pass(page_res);
     if (tessedit_enable_bigram_correction) bigram_correction_pass(page_res);
 
     // ****************** Pass 5,6 *******************
+    if (ocr_stats() != NULL) ocr_stats()->StartStage(OCR_STAGE_REJECTION);
     rejection_passes(page_res, monitor, target_word_box, word_config);
+    if (ocr_stats() != NULL) ocr_stats()->EndStage(OCR_STAGE_REJECTION);
 
 #ifndef NO_CUBE_BUILD
     // ****************** Pass 7 *******************
@@ -415,6 +475,7 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
 
   // Write results pass.
   set_global_loc_code(LOC_WRITE_RESULTS);
+  if (ocr_stats() != NULL) ocr_stats()->StartStage(OCR_STAGE_FINISH);
   // This is now redundant, but retained commented so show how to obtain
   // bounding boxes and style information.
 
@@ -435,6 +496,7 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
       page_res_it.DeleteCurrentWord();
   }
 
+  if (ocr_stats() != NULL) ocr_stats()->EndStage(OCR_STAGE_FINISH);
   if (monitor != NULL) {
     monitor->progress = 100;
   }
@@ -91,6 +91,25 @@ Tesseract::Tesseract()
                     this->params()),
       BOOL_MEMBER(tessedit_ambigs_training, false,
                   "Perform training for ambiguities", this->params()),
+      INT_MEMBER(tessedit_page_budget_ms, 0,
+                 "Max msecs of word recognition per page, after which words"
+                 " get no chopping or segmentation search and pass 2 is"
+                 " skipped. 0 for no limit",
+                 this->params()),
+      BOOL_MEMBER(tessedit_skip_confident_pass2, false,
+                  "Skip pass 2 on blocks with few weak words in pass 1 and"
+                  " few templates adapted after them",
+                  this->params()),
+      double_MEMBER(tessedit_pass2_weak_certainty, -2.5,
+                    "Words with a pass 1 certainty below this are weak",
+                    this->params()),
+      double_MEMBER(tessedit_pass2_max_weak_fraction, 0.05,
+                    "Max fraction of weak words in a block that skips pass 2",
+                    this->params()),
+      INT_MEMBER(tessedit_pass2_max_new_templates, 8,
+                 "Max templates adapted after a block in pass 1 for it to"
+                 " skip pass 2",
+                 this->params()),
       INT_MEMBER(pageseg_devanagari_split_strategy,
                  tesseract::ShiroRekhaSplitter::NO_SPLIT,
                  "Whether to use the top-line splitting process for Devanagari "
@@ -651,6 +670,7 @@ void Tesseract::Clear() {
   reskew_ = FCOORD(1.0f, 0.0f);
   splitter_.Clear();
   scaled_factor_ = -1;
+  ClearPageCaches();
   for (int i = 0; i < sub_langs_.size(); ++i)
     sub_langs_[i]->Clear();
 }
@@ -668,6 +688,32 @@ void Tesseract::ResetAdaptiveClassifier() {
   }
 }
 
+// Saves the adapted templates of this and all subclassifiers to fp.
+bool Tesseract::SaveAdaptiveClassifier(FILE* fp) {
+  inT32 num_langs = sub_langs_.size() + 1;
+  if (fwrite(&num_langs, sizeof(num_langs), 1, fp) != 1) return false;
+  if (!WriteAdaptiveClassifier(fp)) return false;
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    if (!sub_langs_[i]->WriteAdaptiveClassifier(fp)) return false;
+  }
+  return true;
+}
+
+// Loads adapted templates saved by SaveAdaptiveClassifier with the same
+// languages. Returns false if they don't match this classifier. Languages
+// loaded before a mismatch is found keep the templates they read.
+bool Tesseract::LoadAdaptiveClassifier(FILE* fp) {
+  inT32 num_langs;
+  if (fread(&num_langs, sizeof(num_langs), 1, fp) != 1 ||
+      num_langs != sub_langs_.size() + 1)
+    return false;
+  if (!ReadAdaptiveClassifier(fp)) return false;
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    if (!sub_langs_[i]->ReadAdaptiveClassifier(fp)) return false;
+  }
+  return true;
+}
+
 // Clear the document dictionary for this and all subclassifiers.
 void Tesseract::ResetDocumentDictionary() {
   getDict().ResetDocumentDictionary();
@@ -177,6 +177,11 @@ class Tesseract : public Wordrec {
   void Clear();
   // Clear all memory of adaption for this and all subclassifiers.
   void ResetAdaptiveClassifier();
+  // Saves the adapted templates of this and all subclassifiers to fp.
+  bool SaveAdaptiveClassifier(FILE* fp);
+  // Loads adapted templates saved by SaveAdaptiveClassifier with the same
+  // languages. Returns false if they don't match this classifier.
+  bool LoadAdaptiveClassifier(FILE* fp);
   // Clear the document dictionary for this and all subclassifiers.
   void ResetDocumentDictionary();
 
@@ -258,6 +263,31 @@ class Tesseract : public Wordrec {
   Tesseract* get_sub_lang(int index) const {
     return sub_langs_[index];
   }
+  // Sets the instrumentation sink on this and all the sub-languages.
+  void SetOcrStats(OCR_STATS* stats) {
+    set_ocr_stats(stats);
+    for (int i = 0; i < sub_langs_.size(); ++i)
+      sub_langs_[i]->set_ocr_stats(stats);
+  }
+  // Sets the time in OCR_STATS::NowUsecs after which words of this page are
+  // no longer improved, or 0 for no limit. See tessedit_page_budget_ms.
+  void SetPageBudget(inT64 end_usecs) {
+    page_budget_end_usecs_ = end_usecs;
+    for (int i = 0; i < sub_langs_.size(); ++i)
+      sub_langs_[i]->page_budget_end_usecs_ = end_usecs;
+  }
+  // Returns true if the page budget set by SetPageBudget has run out.
+  bool PageBudgetExceeded() const {
+    return page_budget_end_usecs_ > 0 &&
+           OCR_STATS::NowUsecs() >= page_budget_end_usecs_;
+  }
+  // Returns the number of templates adapted by this and all sub-languages.
+  int NumTemplatesAdded() const {
+    int num_added = num_templates_added();
+    for (int i = 0; i < sub_langs_.size(); ++i)
+      num_added += sub_langs_[i]->num_templates_added();
+    return num_added;
+  }
   // Returns true if any language uses Tesseract (as opposed to cube).
   bool AnyTessLang() const {
     if (tessedit_ocr_engine_mode != OEM_CUBE_ONLY) return true;
@@ -308,6 +338,8 @@ class Tesseract : public Wordrec {
                           GenericVector<WordData>* words);
   // Sets up the single word ready for whichever engine is to be run.
   void SetupWordPassN(int pass_n, WordData* word);
+  // Sets skip_pass2 on the blocks that pass 2 is unlikely to change.
+  void SelectPass2Blocks(PAGE_RES* page_res);
   // Runs word recognition on all the words.
   bool RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
                           PAGE_RES_IT* pr_it,
@@ -805,6 +837,20 @@ class Tesseract : public Wordrec {
                "List of chars to override tessedit_char_blacklist");
   BOOL_VAR_H(tessedit_ambigs_training, false,
              "Perform training for ambiguities");
+  INT_VAR_H(tessedit_page_budget_ms, 0,
+            "Max msecs of word recognition per page, after which words get"
+            " no chopping or segmentation search and pass 2 is skipped."
+            " 0 for no limit");
+  BOOL_VAR_H(tessedit_skip_confident_pass2, false,
+             "Skip pass 2 on blocks with few weak words in pass 1 and few"
+             " templates adapted after them");
+  double_VAR_H(tessedit_pass2_weak_certainty, -2.5,
+               "Words with a pass 1 certainty below this are weak");
+  double_VAR_H(tessedit_pass2_max_weak_fraction, 0.05,
+               "Max fraction of weak words in a block that skips pass 2");
+  INT_VAR_H(tessedit_pass2_max_new_templates, 8,
+            "Max templates adapted after a block in pass 1 for it to skip"
+            " pass 2");
   INT_VAR_H(pageseg_devanagari_split_strategy,
             tesseract::ShiroRekhaSplitter::NO_SPLIT,
             "Whether to use the top-line splitting process for Devanagari "
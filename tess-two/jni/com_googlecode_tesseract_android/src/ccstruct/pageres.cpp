@@ -93,6 +93,8 @@ BLOCK_RES::BLOCK_RES(bool merge_similar_words, BLOCK *the_block) {
   bold = FALSE;
   italic = FALSE;
   row_count = 0;
+  pass1_templates = 0;
+  skip_pass2 = FALSE;
 
   block = the_block;
 
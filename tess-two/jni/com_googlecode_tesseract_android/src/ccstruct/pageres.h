@@ -106,6 +106,9 @@ class BLOCK_RES:public ELIST_LINK {
   //      processed
   BOOL8 bold;                  // all bold
   BOOL8 italic;                // all italic
+  // Count of adapted templates when pass 1 finished the block.
+  inT32 pass1_templates;
+  BOOL8 skip_pass2;            // pass 2 not expected to change results
 
   ROW_RES_LIST row_res_list;
 
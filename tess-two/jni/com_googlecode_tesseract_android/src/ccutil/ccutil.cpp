@@ -15,6 +15,7 @@
 namespace tesseract {
 CCUtil::CCUtil() :
   params_(),
+  ocr_stats_(NULL),
   STRING_INIT_MEMBER(m_data_sub_dir,
                      "tessdata/", "Directory for data files", &params_),
 #ifdef _WIN32
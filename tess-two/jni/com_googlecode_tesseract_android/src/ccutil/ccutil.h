@@ -31,6 +31,8 @@
 #include <semaphore.h>
 #endif
 
+class OCR_STATS;
+
 namespace tesseract {
 
 class CCUtilMutex {
@@ -62,6 +64,11 @@ class TESS_API CCUtil {
                  );
   ParamsVectors *params() { return &params_; }
 
+  // Instrumentation sink for the recognition in progress, or NULL.
+  // Not owned. See OCR_STATS in ocrclass.h.
+  OCR_STATS* ocr_stats() const { return ocr_stats_; }
+  void set_ocr_stats(OCR_STATS* stats) { ocr_stats_ = stats; }
+
   STRING datadir;        // dir for data files
   STRING imagebasename;  // name of image
   STRING lang;
@@ -74,6 +81,7 @@ class TESS_API CCUtil {
 
  private:
   ParamsVectors params_;
+  OCR_STATS* ocr_stats_;
 
  public:
   // Member parameters.
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////
+// File:        objectpool.cpp
+// Description: Free-list allocator for small, short-lived objects.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "objectpool.h"
+
+#include "errcode.h"
+
+namespace tesseract {
+
+ObjectPool::ObjectPool(size_t object_size)
+  : free_list_(NULL), num_in_use_(0) {
+  // Round the object up to whole headers, so the next block stays aligned
+  // and a free block has room for the free list link.
+  size_t num_headers =
+      (object_size + sizeof(BlockHeader) - 1) / sizeof(BlockHeader);
+  if (num_headers == 0) num_headers = 1;
+  block_size_ = (num_headers + 1) * sizeof(BlockHeader);
+}
+
+ObjectPool::~ObjectPool() {
+  for (int c = 0; c < chunks_.size(); ++c)
+    delete [] chunks_[c];
+}
+
+// Returns a block of object_size bytes, which must equal size.
+void* ObjectPool::Alloc(size_t size) {
+  ASSERT_HOST(size + sizeof(BlockHeader) <= block_size_);
+  if (free_list_ == NULL) AddChunk();
+  BlockHeader* header = free_list_;
+  free_list_ = header[1].next_free;
+  header->pool = this;
+  ++num_in_use_;
+  return header + 1;
+}
+
+// Returns a block made by Alloc to the pool that made it.
+void ObjectPool::Free(void* ptr) {
+  if (ptr == NULL) return;
+  BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+  ObjectPool* pool = header->pool;
+  header[1].next_free = pool->free_list_;
+  pool->free_list_ = header;
+  --pool->num_in_use_;
+}
+
+// Adds a chunk of blocks to the free list.
+void ObjectPool::AddChunk() {
+  char* chunk = new char[block_size_ * kBlocksPerChunk];
+  chunks_.push_back(chunk);
+  for (int b = kBlocksPerChunk - 1; b >= 0; --b) {
+    BlockHeader* header =
+        reinterpret_cast<BlockHeader*>(chunk + b * block_size_);
+    header[1].next_free = free_list_;
+    free_list_ = header;
+  }
+}
+
+}  // namespace tesseract
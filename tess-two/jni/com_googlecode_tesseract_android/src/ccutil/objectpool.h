@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////
+// File:        objectpool.h
+// Description: Free-list allocator for small, short-lived objects.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_OBJECTPOOL_H_
+#define TESSERACT_CCUTIL_OBJECTPOOL_H_
+
+#include <stddef.h>
+#include "genericvector.h"
+#include "host.h"
+
+namespace tesseract {
+
+// Hands out fixed-size blocks of memory for objects of one type that are
+// made and destroyed in large numbers, such as the states of the
+// segmentation search. Blocks are carved from large chunks and go back on a
+// free list when released, so once the pool has grown to the size of the
+// largest word, making and destroying objects does no heap allocation.
+//
+// A class uses a pool by declaring
+//   void* operator new(size_t size, ObjectPool* pool) {
+//     return pool->Alloc(size);
+//   }
+//   void operator delete(void* ptr) { ObjectPool::Free(ptr); }
+//   void operator delete(void* ptr, ObjectPool*) { ObjectPool::Free(ptr); }
+// Each block remembers its pool, so plain delete, including that done by
+// the list zappers, returns the block to the right pool.
+//
+// A pool is not thread-safe, and all of its objects must be deleted before
+// the pool itself.
+class ObjectPool {
+ public:
+  explicit ObjectPool(size_t object_size);
+  ~ObjectPool();
+
+  // Returns a block of object_size bytes, which must equal size.
+  void* Alloc(size_t size);
+  // Returns a block made by Alloc to the pool that made it.
+  static void Free(void* ptr);
+
+  // Number of blocks handed out and not yet freed.
+  int num_in_use() const { return num_in_use_; }
+
+ private:
+  // Header in front of each block. The union keeps the object that follows
+  // aligned for any type it may hold.
+  union BlockHeader {
+    ObjectPool* pool;          // In the header: the pool that owns the block.
+    BlockHeader* next_free;    // In the object space of a free block.
+    double align_double;
+    inT64 align_int;
+  };
+  // Number of blocks carved from each chunk.
+  static const int kBlocksPerChunk = 256;
+
+  // Adds a chunk of blocks to the free list.
+  void AddChunk();
+
+  // Size of each block, including its header.
+  size_t block_size_;
+  // Memory owned by the pool.
+  GenericVector<char*> chunks_;
+  // First free block. Free blocks are chained through their object space.
+  BlockHeader* free_list_;
+  int num_in_use_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_OBJECTPOOL_H_
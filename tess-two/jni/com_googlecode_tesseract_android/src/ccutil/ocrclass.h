@@ -92,6 +92,108 @@ typedef struct {                  /*single character */
   uinT8 formatting;              /*char formatting (0) */
 } EANYCODE_CHAR;                 /*single character */
 
+/**********************************************************************
+ * OCR_STATS
+ * Optional instrumentation for a single call to the recognizer.
+ * If ETEXT_DESC::stats is not null, the engine records the wall-clock
+ * start and end of each stage (microseconds, from gettimeofday) and
+ * increments the hot-path counters below. A stage that was not entered
+ * has a start time of 0; a stage that was cancelled part way through
+ * has a start time but an end time of 0.
+ * If stage_callback is not null it is called at the start and at the
+ * end of every stage with the counter values accumulated so far.
+ * When stats is null the cost is one pointer test per counted event,
+ * and defining DISABLE_OCR_STATS removes the counting code altogether.
+ * Counts are not synchronized, so with tessedit_parallelize they are
+ * approximate.
+ **********************************************************************/
+enum OCR_STAGE {
+  OCR_STAGE_LAYOUT,              // thresholding and page segmentation
+  OCR_STAGE_PASS1,               // word recognition, first pass
+  OCR_STAGE_PASS2,               // word recognition, adapted templates
+  OCR_STAGE_FIX_SPACES,          // fuzzy space fixing
+  OCR_STAGE_REJECTION,           // rejection passes
+  OCR_STAGE_FINISH,              // result output and cleanup
+  OCR_STAGE_COUNT
+};
+
+enum OCR_COUNTER {
+  OCR_COUNTER_BLOBS_CLASSIFIED,     // calls to the adaptive classifier
+  OCR_COUNTER_CHOPS_TRIED,          // blob chop attempts
+  OCR_COUNTER_PAIN_POINTS,          // segsearch pain points classified
+  OCR_COUNTER_DAWG_LOOKUPS,         // letter_is_okay calls
+  OCR_COUNTER_TEMPLATES_ADDED,      // adapted classes and configs created
+  OCR_COUNTER_STATIC_CACHE_HITS,    // static classifications reused
+  OCR_COUNTER_WORDS_OVER_BUDGET,    // words cut short by the work budget
+  OCR_COUNTER_PASS2_WORDS_SKIPPED,  // words left at pass 1 by page budget
+  OCR_COUNTER_FEATURE_CACHE_HITS,   // blob feature extractions reused
+  OCR_COUNTER_PASS2_BLOCKS_RUN,     // blocks given a second pass
+  OCR_COUNTER_PASS2_BLOCKS_KEPT,    // blocks left at pass 1 as confident
+  OCR_COUNTER_PASS2_WORDS_KEPT,     // words left at pass 1 as confident
+  OCR_COUNTER_COUNT
+};
+
+typedef void (*STAGE_FUNC)(void* stage_this, int stage, bool started,
+                           inT64 usecs, const inT64* counters);
+
+class OCR_STATS {
+ public:
+  inT64 counters[OCR_COUNTER_COUNT];
+  inT64 stage_start[OCR_STAGE_COUNT];  // usecs, 0 if not run
+  inT64 stage_end[OCR_STAGE_COUNT];    // usecs, 0 if not finished
+  STAGE_FUNC stage_callback;           // called at each stage boundary
+  void* stage_this;                    // this or other data for callback
+
+  OCR_STATS() : stage_callback(NULL), stage_this(NULL) {
+    Clear();
+  }
+
+  // Resets the timestamps and counters, but not the callback.
+  void Clear() {
+    for (int i = 0; i < OCR_COUNTER_COUNT; ++i) counters[i] = 0;
+    for (int i = 0; i < OCR_STAGE_COUNT; ++i) {
+      stage_start[i] = 0;
+      stage_end[i] = 0;
+    }
+  }
+
+  void StartStage(OCR_STAGE stage) {
+    stage_start[stage] = NowUsecs();
+    stage_end[stage] = 0;
+    if (stage_callback != NULL)
+      (*stage_callback)(stage_this, stage, true, stage_start[stage], counters);
+  }
+
+  void EndStage(OCR_STAGE stage) {
+    stage_end[stage] = NowUsecs();
+    if (stage_callback != NULL)
+      (*stage_callback)(stage_this, stage, false, stage_end[stage], counters);
+  }
+
+  // Returns the duration of the stage in usecs, or 0 if it did not finish.
+  inT64 StageUsecs(OCR_STAGE stage) const {
+    if (stage_start[stage] == 0 || stage_end[stage] == 0) return 0;
+    return stage_end[stage] - stage_start[stage];
+  }
+
+  static inT64 NowUsecs() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return static_cast<inT64>(now.tv_sec) * 1000000 + now.tv_usec;
+  }
+};
+
+// Increments a counter of an OCR_STATS pointer that may be null.
+#ifdef DISABLE_OCR_STATS
+#define OCR_STATS_INC(stats, counter)
+#else
+#define OCR_STATS_INC(stats, counter) \
+  do { \
+    OCR_STATS* ocr_stats_tmp = (stats); \
+    if (ocr_stats_tmp != NULL) ++ocr_stats_tmp->counters[counter]; \
+  } while (0)
+#endif
+
 /**********************************************************************
  * ETEXT_DESC
  * Description of the output of the OCR engine.
@@ -123,13 +225,14 @@ class ETEXT_DESC {             // output header
   PROGRESS_FUNC progress_callback;//called whenever progress increases
   void* cancel_this;           // this or other data for cancel
   void* progress_this;         // this or other data for progress
+  OCR_STATS* stats;            // instrumentation sink, may be NULL
   struct timeval end_time;     // time to stop. expected to be set only by call
                                // to set_deadline_msecs()
   EANYCODE_CHAR text[1];       // character data
 
   ETEXT_DESC() : count(0), progress(0), more_to_come(0), ocr_alive(0),
                    err_code(0), cancel(NULL), progress_callback(NULL),
-                   cancel_this(NULL), progress_this(NULL) {
+                   cancel_this(NULL), progress_this(NULL), stats(NULL) {
     end_time.tv_sec = 0;
     end_time.tv_usec = 0;
   }
@@ -44,6 +44,7 @@
 #include "mfoutline.h"
 #include "ndminx.h"
 #include "normfeat.h"
+#include "ocrclass.h"
 #include "normmatch.h"
 #include "outfeat.h"
 #include "pageres.h"
@@ -65,6 +66,29 @@
 
 #define ADAPT_TEMPLATE_SUFFIX ".a"
 
+// Marks the start of the adapted templates written by
+// Classify::WriteAdaptiveClassifier.
+const inT32 kAdaptiveClassifierMagic = 0x54414443;  // "TADC"
+
+// Computes the FNV-1a hash of the next length bytes of fp. Returns false if
+// fewer than length bytes could be read.
+static bool ChecksumAdaptedTemplates(FILE* fp, long length, uinT32* checksum) {
+  uinT8 buffer[4096];
+  uinT32 hash = 2166136261U;
+  while (length > 0) {
+    size_t count = length < static_cast<long>(sizeof(buffer)) ?
+        static_cast<size_t>(length) : sizeof(buffer);
+    if (fread(buffer, 1, count, fp) != count) return false;
+    for (size_t i = 0; i < count; ++i) {
+      hash ^= buffer[i];
+      hash *= 16777619U;
+    }
+    length -= count;
+  }
+  *checksum = hash;
+  return true;
+}
+
 #define MAX_MATCHES         10
 #define UNLIKELY_NUM_FEAT 200
 #define NO_DEBUG      0
@@ -184,6 +208,7 @@ namespace tesseract {
  */
 void Classify::AdaptiveClassifier(TBLOB *Blob, BLOB_CHOICE_LIST *Choices) {
   assert(Choices != NULL);
+  OCR_STATS_INC(ocr_stats(), OCR_COUNTER_BLOBS_CLASSIFIED);
   ADAPT_RESULTS *Results = new ADAPT_RESULTS;
   Results->Initialize();
 
@@ -647,6 +672,75 @@ void Classify::StartBackupAdaptiveClassifier() {
   BackupAdaptedTemplates = NewAdaptedTemplates(true);
 }
 
+// Writes the adapted templates to fp, so that ReadAdaptiveClassifier can
+// warm up a later job on similar documents with them. The header records
+// the length and checksum of the templates, so fp must be open for reading
+// as well as writing. Returns false if there are no adapted templates or
+// the write failed.
+bool Classify::WriteAdaptiveClassifier(FILE* fp) {
+  if (AdaptedTemplates == NULL) return false;
+  inT32 header[4] = { kAdaptiveClassifierMagic, unicharset.size(), 0, 0 };
+  long header_pos = ftell(fp);
+  if (header_pos < 0 || fwrite(header, sizeof(header), 1, fp) != 1)
+    return false;
+  long start_pos = header_pos + static_cast<long>(sizeof(header));
+  WriteAdaptedTemplates(fp, AdaptedTemplates);
+  long end_pos = ftell(fp);
+  if (ferror(fp) || end_pos < 0) return false;
+  uinT32 checksum;
+  if (fseek(fp, start_pos, SEEK_SET) != 0 ||
+      !ChecksumAdaptedTemplates(fp, end_pos - start_pos, &checksum))
+    return false;
+  header[2] = end_pos - start_pos;
+  header[3] = static_cast<inT32>(checksum);
+  return fseek(fp, header_pos, SEEK_SET) == 0 &&
+      fwrite(header, sizeof(header), 1, fp) == 1 &&
+      fseek(fp, end_pos, SEEK_SET) == 0;
+}
+
+// Replaces the adapted templates with those written by
+// WriteAdaptiveClassifier with the same language data. The length and
+// checksum in the header are checked before the templates are parsed, as
+// the template readers trust the counts they read. Returns false and keeps
+// the current templates if fp holds anything else.
+bool Classify::ReadAdaptiveClassifier(FILE* fp) {
+  if (!classify_enable_adaptive_matcher || AdaptedTemplates == NULL)
+    return false;
+  inT32 header[4];
+  if (fread(header, sizeof(header), 1, fp) != 1 ||
+      header[0] != kAdaptiveClassifierMagic ||
+      header[1] != unicharset.size()) {
+    tprintf("Adapted templates are not for this language data\n");
+    return false;
+  }
+  long start_pos = ftell(fp);
+  uinT32 checksum;
+  if (start_pos < 0 || header[2] <= 0 ||
+      !ChecksumAdaptedTemplates(fp, header[2], &checksum) ||
+      checksum != static_cast<uinT32>(header[3]) ||
+      fseek(fp, start_pos, SEEK_SET) != 0) {
+    tprintf("Adapted templates are truncated or corrupt\n");
+    return false;
+  }
+  ADAPT_TEMPLATES templates = ReadAdaptedTemplates(fp);
+  if (ferror(fp) || ftell(fp) != start_pos + header[2] ||
+      templates->Templates->NumClasses != unicharset.size()) {
+    tprintf("Failed to read adapted templates\n");
+    free_adapted_templates(templates);
+    return false;
+  }
+  free_adapted_templates(AdaptedTemplates);
+  AdaptedTemplates = templates;
+  if (BackupAdaptedTemplates != NULL)
+    free_adapted_templates(BackupAdaptedTemplates);
+  BackupAdaptedTemplates = NULL;
+  NumAdaptationsFailed = 0;
+  for (int i = 0; i < AdaptedTemplates->Templates->NumClasses; i++) {
+    BaselineCutoffs[i] = CharNormCutoffs[i];
+  }
+  return true;
+}
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine prepares the adaptive
@@ -738,6 +832,8 @@ void Classify::InitAdaptedClass(TBLOB *Blob,
 
   Config = NewTempConfig(NumFeatures - 1, FontinfoId);
   TempConfigFor(Class, 0) = Config;
+  ++num_templates_added_;
+  OCR_STATS_INC(ocr_stats(), OCR_COUNTER_TEMPLATES_ADDED);
 
   /* this is a kludge to construct cutoffs for adapted templates */
   if (Templates == AdaptedTemplates)
@@ -1358,12 +1454,26 @@ int Classify::CharNormClassifier(TBLOB *blob,
   // This is the length that is used for scaling ratings vs certainty.
   adapt_results->BlobLength =
       IntCastRounded(sample.outline_length() / kStandardFeatureLength);
+  // The static results depend only on the sample, so a blob that was already
+  // classified on this page, eg in pass 1, gets them from the cache and only
+  // the adaptive results are new.
+  const GenericVector<UnicharRating>* cached_results =
+      classify_cache_static_results ? static_result_cache_.Find(sample) : NULL;
   GenericVector<UnicharRating> unichar_results;
-  static_classifier_->UnicharClassifySample(sample, blob->denorm().pix(), 0,
-                                            -1, &unichar_results);
+  if (cached_results != NULL) {
+    OCR_STATS_INC(ocr_stats(), OCR_COUNTER_STATIC_CACHE_HITS);
+  } else {
+    static_classifier_->UnicharClassifySample(sample, blob->denorm().pix(), 0,
+                                              -1, &unichar_results);
+    if (classify_cache_static_results) {
+      static_result_cache_.Add(sample, unichar_results,
+                               classify_static_cache_size);
+    }
+    cached_results = &unichar_results;
+  }
   // Convert results to the format used internally by AdaptiveClassifier.
-  for (int r = 0; r < unichar_results.size(); ++r) {
-    AddNewResult(unichar_results[r], adapt_results);
+  for (int r = 0; r < cached_results->size(); ++r) {
+    AddNewResult((*cached_results)[r], adapt_results);
   }
   return sample.num_features();
 }                                /* CharNormClassifier */
@@ -1586,8 +1696,8 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
   INT_FX_RESULT_STRUCT fx_info;
   GenericVector<INT_FEATURE_STRUCT> bl_features;
   TrainingSample* sample =
-      BlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
-                           &bl_features);
+      CachedBlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
+                                 &bl_features);
   if (sample == NULL) return;
 
   if (AdaptedTemplates->NumPermClasses < matcher_permanent_classes_min ||
@@ -1647,8 +1757,8 @@ UNICHAR_ID *Classify::GetAmbiguities(TBLOB *Blob,
   INT_FX_RESULT_STRUCT fx_info;
   GenericVector<INT_FEATURE_STRUCT> bl_features;
   TrainingSample* sample =
-      BlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
-                           &bl_features);
+      CachedBlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
+                                 &bl_features);
   if (sample == NULL) {
     delete Results;
     return NULL;
@@ -1855,6 +1965,8 @@ int Classify::MakeNewTemporaryConfig(ADAPT_TEMPLATES Templates,
   Config = NewTempConfig(MaxProtoId, FontinfoId);
   TempConfigFor(Class, ConfigId) = Config;
   copy_all_bits(TempProtoMask, Config->Protos, Config->ProtoVectorSize);
+  ++num_templates_added_;
+  OCR_STATS_INC(ocr_stats(), OCR_COUNTER_TEMPLATES_ADDED);
 
   if (classify_learning_debug_level >= 1)
     cprintf("Making new temp config %d fontinfo id %d"
@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////
+// File:        blobfeaturecache.cpp
+// Description: Per-page cache of the features extracted from blobs.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "blobfeaturecache.h"
+
+#include <string.h>
+#include "blobs.h"
+#include "coutln.h"
+#include "normalis.h"
+
+namespace tesseract {
+
+// Points mapped from the source image by the normalization of the blob to
+// identify it in the key. Three points pin down the affine transforms that
+// DENORM chains are made of.
+static const float kProbePoints[3][2] = {
+  { 0.0f, 0.0f }, { 1024.0f, 0.0f }, { 0.0f, 1024.0f }
+};
+
+// Accumulates the two hashes of a Key over the bytes of the values added.
+class KeyHasher {
+ public:
+  KeyHasher() : hash1_(14695981039346656037ULL), hash2_(0), num_bytes_(0) {}
+
+  template <typename T>
+  void Add(const T& value) {
+    const uinT8* bytes = reinterpret_cast<const uinT8*>(&value);
+    for (size_t i = 0; i < sizeof(value); ++i) {
+      hash1_ ^= bytes[i];
+      hash1_ *= 1099511628211ULL;
+      hash2_ = (hash2_ + bytes[i] + 1) * 0x9E3779B97F4A7C15ULL;
+      hash2_ ^= hash2_ >> 29;
+    }
+    num_bytes_ += sizeof(value);
+  }
+
+  uinT64 hash1() const { return hash1_; }
+  uinT64 hash2() const { return hash2_; }
+  int num_bytes() const { return num_bytes_; }
+
+ private:
+  uinT64 hash1_;
+  uinT64 hash2_;
+  int num_bytes_;
+};
+
+BlobFeatureCache::BlobFeatureCache()
+    : key_valid_(false), hits_(0), misses_(0) {
+  for (int b = 0; b < kNumBuckets; ++b)
+    buckets_[b] = -1;
+}
+
+BlobFeatureCache::~BlobFeatureCache() {
+}
+
+// Copies the features of blob into fx_info, bl_features and cn_features
+// and returns true if the blob has been seen before.
+bool BlobFeatureCache::Find(const TBLOB& blob, bool nonlinear_norm,
+                            INT_FX_RESULT_STRUCT* fx_info,
+                            GenericVector<INT_FEATURE_STRUCT>* bl_features,
+                            GenericVector<INT_FEATURE_STRUCT>* cn_features) {
+  MakeKey(blob, nonlinear_norm, &key_);
+  int index = FindEntry(key_);
+  if (index < 0) {
+    key_valid_ = true;
+    ++misses_;
+    return false;
+  }
+  key_valid_ = false;
+  ++hits_;
+  const Entry* entry = entries_[index];
+  *fx_info = entry->fx_info;
+  *bl_features = entry->bl_features;
+  *cn_features = entry->cn_features;
+  return true;
+}
+
+// Adds the features of the blob given to the last call of Find, which
+// must have returned false. Does nothing once max_size blobs are held.
+void BlobFeatureCache::Add(const INT_FX_RESULT_STRUCT& fx_info,
+                           const GenericVector<INT_FEATURE_STRUCT>& bl_features,
+                           const GenericVector<INT_FEATURE_STRUCT>& cn_features,
+                           int max_size) {
+  if (entries_.size() >= max_size || !key_valid_) return;
+  Entry* entry = new Entry;
+  entry->key = key_;
+  entry->fx_info = fx_info;
+  entry->bl_features = bl_features;
+  entry->cn_features = cn_features;
+  int bucket = key_.hash1 & (kNumBuckets - 1);
+  entry->next = buckets_[bucket];
+  buckets_[bucket] = entries_.size();
+  entries_.push_back(entry);
+  // Stop the same key being added twice.
+  key_valid_ = false;
+}
+
+// Drops all entries, eg for a new page.
+void BlobFeatureCache::Clear() {
+  entries_.truncate(0);
+  for (int b = 0; b < kNumBuckets; ++b)
+    buckets_[b] = -1;
+  key_valid_ = false;
+  hits_ = 0;
+  misses_ = 0;
+}
+
+// Hashes the inputs of Classify::ExtractFeatures into key: the
+// normalization of the blob, and for each edge point its position, flags and
+// the steps of the source outline it covers.
+void BlobFeatureCache::MakeKey(const TBLOB& blob, bool nonlinear_norm,
+                               Key* key) {
+  KeyHasher hasher;
+  int num_points = 0;
+  hasher.Add(nonlinear_norm);
+  for (int p = 0; p < 3; ++p) {
+    FCOORD probe(kProbePoints[p][0], kProbePoints[p][1]);
+    blob.denorm().NormTransform(NULL, probe, &probe);
+    hasher.Add(probe.x());
+    hasher.Add(probe.y());
+  }
+  for (const TESSLINE* ol = blob.outlines; ol != NULL; ol = ol->next) {
+    hasher.Add(ol->is_hole);
+    const EDGEPT* pt = ol->loop;
+    if (pt == NULL) continue;
+    do {
+      hasher.Add(pt->pos.x);
+      hasher.Add(pt->pos.y);
+      for (int f = 0; f < EDGEPTFLAGS; ++f)
+        hasher.Add(pt->flags[f]);
+      const C_OUTLINE* src_outline = pt->src_outline;
+      hasher.Add(src_outline);
+      if (src_outline != NULL) {
+        // The outline is identified by its start and length as well as its
+        // address, in case a new outline reuses the memory of a deleted one.
+        hasher.Add(src_outline->start_pos().x());
+        hasher.Add(src_outline->start_pos().y());
+        hasher.Add(src_outline->pathlength());
+        hasher.Add(pt->start_step);
+        hasher.Add(pt->step_count);
+      }
+      ++num_points;
+      pt = pt->next;
+    } while (pt != ol->loop);
+    // Mark the end of the outline.
+    hasher.Add(MAX_INT32);
+  }
+  key->hash1 = hasher.hash1();
+  key->hash2 = hasher.hash2();
+  key->num_bytes = hasher.num_bytes();
+  key->num_points = num_points;
+  TBOX box = blob.bounding_box();
+  key->box[0] = box.left();
+  key->box[1] = box.bottom();
+  key->box[2] = box.right();
+  key->box[3] = box.top();
+}
+
+// Returns the index of the entry matching key, or -1.
+int BlobFeatureCache::FindEntry(const Key& key) const {
+  for (int index = buckets_[key.hash1 & (kNumBuckets - 1)]; index >= 0;
+       index = entries_[index]->next) {
+    if (entries_[index]->key == key)
+      return index;
+  }
+  return -1;
+}
+
+}  // namespace tesseract
@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////
+// File:        blobfeaturecache.h
+// Description: Per-page cache of the features extracted from blobs.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CLASSIFY_BLOBFEATURECACHE_H_
+#define TESSERACT_CLASSIFY_BLOBFEATURECACHE_H_
+
+#include <string.h>
+#include "genericvector.h"
+#include "host.h"
+#include "intfx.h"
+#include "intproto.h"
+
+struct TBLOB;
+
+namespace tesseract {
+
+// Holds the int features and fx_info extracted from the blobs classified on
+// the current page. The same blob is classified again in pass 2, by the
+// diacritic checks and whenever a word is set up for recognition again, and
+// each time the TBLOB is a fresh copy, so the features can only be found by
+// content. Entries are keyed by everything Classify::ExtractFeatures reads:
+// the edge points and their source outline steps, and the normalization
+// that maps the source outlines to the blob. These are not stored: each
+// entry keeps two independent 64-bit hashes of them, the number of bytes and
+// edge points hashed and the bounding box of the blob, so an entry takes a
+// few dozen bytes beyond its features, and a false hit needs both hashes to
+// collide on an outline with the same size and point count.
+class BlobFeatureCache {
+ public:
+  BlobFeatureCache();
+  ~BlobFeatureCache();
+
+  // Copies the features of blob into fx_info, bl_features and cn_features
+  // and returns true if the blob has been seen before.
+  bool Find(const TBLOB& blob, bool nonlinear_norm,
+            INT_FX_RESULT_STRUCT* fx_info,
+            GenericVector<INT_FEATURE_STRUCT>* bl_features,
+            GenericVector<INT_FEATURE_STRUCT>* cn_features);
+  // Adds the features of the blob given to the last call of Find, which
+  // must have returned false. Does nothing once max_size blobs are held.
+  void Add(const INT_FX_RESULT_STRUCT& fx_info,
+           const GenericVector<INT_FEATURE_STRUCT>& bl_features,
+           const GenericVector<INT_FEATURE_STRUCT>& cn_features,
+           int max_size);
+  // Drops all entries, eg for a new page.
+  void Clear();
+
+  int size() const { return entries_.size(); }
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+
+ private:
+  // Number of hash buckets. Must be a power of 2.
+  static const int kNumBuckets = 4096;
+
+  // Identifies the feature extraction inputs of a blob.
+  struct Key {
+    uinT64 hash1;      // FNV-1a hash of the inputs.
+    uinT64 hash2;      // Hash of the inputs by a different multiplicative mix.
+    int num_bytes;     // Number of bytes hashed.
+    int num_points;    // Number of edge points in the outlines.
+    inT16 box[4];      // Bounding box of the blob: left, bottom, right, top.
+
+    bool operator==(const Key& other) const {
+      return hash1 == other.hash1 && hash2 == other.hash2 &&
+          num_bytes == other.num_bytes && num_points == other.num_points &&
+          memcmp(box, other.box, sizeof(box)) == 0;
+    }
+  };
+
+  struct Entry {
+    Key key;                    // The blob the features were made from.
+    int next;                   // Index of the next entry in the bucket or -1.
+    INT_FX_RESULT_STRUCT fx_info;
+    GenericVector<INT_FEATURE_STRUCT> bl_features;
+    GenericVector<INT_FEATURE_STRUCT> cn_features;
+  };
+
+  // Hashes the feature extraction inputs of blob into key.
+  static void MakeKey(const TBLOB& blob, bool nonlinear_norm, Key* key);
+  // Returns the index of the entry matching key, or -1.
+  int FindEntry(const Key& key) const;
+
+  // Index of the first entry in each bucket, or -1.
+  int buckets_[kNumBuckets];
+  PointerVector<Entry> entries_;
+  // Key of the blob given to the last Find, if it has not been added yet.
+  Key key_;
+  bool key_valid_;
+  int hits_;
+  int misses_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CLASSIFY_BLOBFEATURECACHE_H_
@@ -150,6 +150,17 @@ Classify::Classify()
                  "Class Pruner CutoffStrength:         ", this->params()),
       INT_MEMBER(classify_integer_matcher_multiplier, 10,
                  "Integer Matcher Multiplier  0-255:   ", this->params()),
+      BOOL_MEMBER(classify_cache_static_results, true,
+                  "Reuse static classifier results for blobs already"
+                  " classified on the page", this->params()),
+      INT_MEMBER(classify_static_cache_size, 10000,
+                 "Max blobs to keep static classifier results for per page",
+                 this->params()),
+      BOOL_MEMBER(classify_cache_blob_features, true,
+                  "Reuse the features of blobs already classified on the page",
+                  this->params()),
+      INT_MEMBER(classify_feature_cache_size, 10000,
+                 "Max blobs to keep features for per page", this->params()),
       EnableLearning(true),
       INT_MEMBER(il1_adaption_test, 0,
                  "Don't adapt to i/I at beginning of word", this->params()),
@@ -180,6 +191,7 @@ Classify::Classify()
   NormProtos = NULL;
 
   NumAdaptationsFailed = 0;
+  num_templates_added_ = 0;
 
   learn_debug_win_ = NULL;
   learn_fragmented_word_debug_win_ = NULL;
@@ -204,6 +216,7 @@ Classify::~Classify() {
 void Classify::SetStaticClassifier(ShapeClassifier* static_classifier) {
   delete static_classifier_;
   static_classifier_ = static_classifier;
+  ClearPageCaches();
 }
 
 // Moved from speckle.cpp
@@ -20,6 +20,7 @@
 #define TESSERACT_CLASSIFY_CLASSIFY_H__
 
 #include "adaptive.h"
+#include "blobfeaturecache.h"
 #include "ccstruct.h"
 #include "classify.h"
 #include "dict.h"
@@ -31,6 +32,7 @@
 #include "normalis.h"
 #include "ratngs.h"
 #include "ocrfeatures.h"
+#include "staticresultcache.h"
 #include "unicity_table.h"
 
 class ScrollView;
@@ -74,6 +76,14 @@ class Classify : public CCStruct {
   // to CharNormClassifier.
   void SetStaticClassifier(ShapeClassifier* static_classifier);
 
+  // Forgets the features and static classifier results remembered for the
+  // current page. Must be called whenever the blobs of a new page are to be
+  // classified.
+  void ClearPageCaches() {
+    blob_feature_cache_.Clear();
+    static_result_cache_.Clear();
+  }
+
   // Adds a noise classification result that is a bit worse than the worst
   // current result, or the worst possible result if no current results.
   void AddLargeSpeckleTo(int blob_length, BLOB_CHOICE_LIST *choices);
@@ -265,6 +275,16 @@ class Classify : public CCStruct {
   void ResetAdaptiveClassifierInternal();
   void SwitchAdaptiveClassifier();
   void StartBackupAdaptiveClassifier();
+  // Writes the adapted templates to fp, so that ReadAdaptiveClassifier can
+  // warm up a later job on similar documents with them. fp must be open for
+  // reading as well as writing, to checksum what was written. Returns false
+  // if there are no adapted templates or the write failed.
+  bool WriteAdaptiveClassifier(FILE* fp);
+  // Replaces the adapted templates with those written by
+  // WriteAdaptiveClassifier with the same language data. Returns false and
+  // keeps the current templates if fp holds anything else, including a
+  // truncated or corrupt file.
+  bool ReadAdaptiveClassifier(FILE* fp);
 
   int GetCharNormFeature(const INT_FX_RESULT_STRUCT& fx_info,
                          INT_TEMPLATES templates,
@@ -285,6 +305,8 @@ class Classify : public CCStruct {
   bool AdaptiveClassifierIsEmpty() const {
     return AdaptedTemplates->NumPermClasses == 0;
   }
+  // Returns the number of adapted configs made since this was constructed.
+  int num_templates_added() const { return num_templates_added_; }
   bool LooksLikeGarbage(TBLOB *blob);
   void RefreshDebugWindow(ScrollView **win, const char *msg,
                           int y_offset, const TBOX &wbox);
@@ -329,6 +351,11 @@ class Classify : public CCStruct {
                               GenericVector<INT_FEATURE_STRUCT>* cn_features,
                               INT_FX_RESULT_STRUCT* results,
                               GenericVector<int>* outline_cn_counts);
+  // As BlobToTrainingSample, but reuses the features of a blob with the
+  // same outlines and normalization classified earlier on the page.
+  TrainingSample* CachedBlobToTrainingSample(
+      const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
+      GenericVector<INT_FEATURE_STRUCT>* bl_features);
   /* float2int.cpp ************************************************************/
   void ClearCharNormArray(uinT8* char_norm_array);
   void ComputeIntCharNormArray(const FEATURE_STRUCT& norm_feature,
@@ -467,6 +494,15 @@ class Classify : public CCStruct {
             "Class Pruner CutoffStrength:         ");
   INT_VAR_H(classify_integer_matcher_multiplier, 10,
             "Integer Matcher Multiplier  0-255:   ");
+  BOOL_VAR_H(classify_cache_static_results, true,
+             "Reuse static classifier results for blobs already classified"
+             " on the page");
+  INT_VAR_H(classify_static_cache_size, 10000,
+            "Max blobs to keep static classifier results for per page");
+  BOOL_VAR_H(classify_cache_blob_features, true,
+             "Reuse the features of blobs already classified on the page");
+  INT_VAR_H(classify_feature_cache_size, 10000,
+            "Max blobs to keep features for per page");
 
   // Use class variables to hold onto built-in templates and adapted templates.
   INT_TEMPLATES PreTrainedTemplates;
@@ -515,9 +551,18 @@ class Classify : public CCStruct {
   Dict dict_;
   // The currently active static classifier.
   ShapeClassifier* static_classifier_;
+  // Results of static_classifier_ for the samples of the current page.
+  StaticResultCache static_result_cache_;
+  // Features of the blobs of the current page.
+  BlobFeatureCache blob_feature_cache_;
+  // Scratch cn features for CachedBlobToTrainingSample, kept to avoid
+  // reallocating them for every blob.
+  GenericVector<INT_FEATURE_STRUCT> cn_features_;
 
   /* variables used to hold performance statistics */
   int NumAdaptationsFailed;
+  // Adapted configs made so far, used to judge whether pass 2 can benefit.
+  int num_templates_added_;
 
   // Training data gathered here for all the images in a document.
   STRING tr_file_data_;
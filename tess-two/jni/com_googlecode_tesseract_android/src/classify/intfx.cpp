@@ -31,6 +31,7 @@
 #include "linlsq.h"
 #include "ndminx.h"
 #include "normalis.h"
+#include "ocrclass.h"
 #include "statistc.h"
 #include "trainingsample.h"
 
@@ -73,23 +74,18 @@ FCOORD FeatureDirection(uinT8 theta) {
 
 namespace tesseract {
 
-// Generates a TrainingSample from a TBLOB. Extracts features and sets
-// the bounding box, so classifiers that operate on the image can work.
-// TODO(rays) Make BlobToTrainingSample a member of Classify now that
-// the FlexFx and FeatureDescription code have been removed and LearnBlob
-// is now a member of Classify.
-TrainingSample* BlobToTrainingSample(
-    const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
-    GenericVector<INT_FEATURE_STRUCT>* bl_features) {
-  GenericVector<INT_FEATURE_STRUCT> cn_features;
-  Classify::ExtractFeatures(blob, nonlinear_norm, bl_features,
-                            &cn_features, fx_info, NULL);
+// Makes a TrainingSample from the cn_features already extracted from blob,
+// and sets the bounding box, so classifiers that operate on the image can
+// work. Returns NULL if there are no features.
+static TrainingSample* FeaturesToTrainingSample(
+    const TBLOB& blob, const INT_FX_RESULT_STRUCT& fx_info,
+    const GenericVector<INT_FEATURE_STRUCT>& cn_features) {
   // TODO(rays) Use blob->PreciseBoundingBox() instead.
   TBOX box = blob.bounding_box();
   TrainingSample* sample = NULL;
-  int num_features = fx_info->NumCN;
+  int num_features = fx_info.NumCN;
   if (num_features > 0) {
-    sample = TrainingSample::CopyFromFeatures(*fx_info, box, &cn_features[0],
+    sample = TrainingSample::CopyFromFeatures(fx_info, box, &cn_features[0],
                                               num_features);
   }
   if (sample != NULL) {
@@ -108,6 +104,41 @@ TrainingSample* BlobToTrainingSample(
   return sample;
 }
 
+// Generates a TrainingSample from a TBLOB. Extracts features and sets
+// the bounding box, so classifiers that operate on the image can work.
+// TODO(rays) Make BlobToTrainingSample a member of Classify now that
+// the FlexFx and FeatureDescription code have been removed and LearnBlob
+// is now a member of Classify.
+TrainingSample* BlobToTrainingSample(
+    const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
+    GenericVector<INT_FEATURE_STRUCT>* bl_features) {
+  GenericVector<INT_FEATURE_STRUCT> cn_features;
+  Classify::ExtractFeatures(blob, nonlinear_norm, bl_features,
+                            &cn_features, fx_info, NULL);
+  return FeaturesToTrainingSample(blob, *fx_info, cn_features);
+}
+
+// As BlobToTrainingSample, but takes the features from blob_feature_cache_
+// if the blob has been classified before on this page.
+TrainingSample* Classify::CachedBlobToTrainingSample(
+    const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
+    GenericVector<INT_FEATURE_STRUCT>* bl_features) {
+  if (!classify_cache_blob_features)
+    return BlobToTrainingSample(blob, nonlinear_norm, fx_info, bl_features);
+  if (blob_feature_cache_.Find(blob, nonlinear_norm, fx_info, bl_features,
+                               &cn_features_)) {
+    OCR_STATS_INC(ocr_stats(), OCR_COUNTER_FEATURE_CACHE_HITS);
+  } else {
+    bl_features->truncate(0);
+    cn_features_.truncate(0);
+    ExtractFeatures(blob, nonlinear_norm, bl_features, &cn_features_, fx_info,
+                    NULL);
+    blob_feature_cache_.Add(*fx_info, *bl_features, cn_features_,
+                            classify_feature_cache_size);
+  }
+  return FeaturesToTrainingSample(blob, *fx_info, cn_features_);
+}
+
 // Computes the DENORMS for bl(baseline) and cn(character) normalization
 // during feature extraction. The input denorm describes the current state
 // of the blob, which is usually a baseline-normalized word.
@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////
+// File:        staticresultcache.cpp
+// Description: Per-page cache of static classifier results.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "staticresultcache.h"
+
+#include <string.h>
+#include "picofeat.h"
+#include "trainingsample.h"
+
+namespace tesseract {
+
+StaticResultCache::StaticResultCache() : hits_(0), misses_(0) {
+  for (int b = 0; b < kNumBuckets; ++b)
+    buckets_[b] = -1;
+}
+
+StaticResultCache::~StaticResultCache() {
+}
+
+// Returns the cached results for sample, or NULL if it has not been seen.
+const GenericVector<UnicharRating>* StaticResultCache::Find(
+    const TrainingSample& sample) {
+  uinT32 hash = MakeKey(sample, &key_);
+  int index = FindEntry(hash, key_);
+  if (index < 0) {
+    ++misses_;
+    return NULL;
+  }
+  ++hits_;
+  return &entries_[index]->results;
+}
+
+// Adds the results for sample. Does nothing once max_size samples are held.
+void StaticResultCache::Add(const TrainingSample& sample,
+                            const GenericVector<UnicharRating>& results,
+                            int max_size) {
+  if (entries_.size() >= max_size) return;
+  Entry* entry = new Entry;
+  entry->hash = MakeKey(sample, &entry->key);
+  if (FindEntry(entry->hash, entry->key) >= 0) {
+    delete entry;
+    return;
+  }
+  entry->results = results;
+  int bucket = entry->hash & (kNumBuckets - 1);
+  entry->next = buckets_[bucket];
+  buckets_[bucket] = entries_.size();
+  entries_.push_back(entry);
+}
+
+// Drops all entries, eg for a new page.
+void StaticResultCache::Clear() {
+  entries_.truncate(0);
+  for (int b = 0; b < kNumBuckets; ++b)
+    buckets_[b] = -1;
+  hits_ = 0;
+  misses_ = 0;
+}
+
+// Serializes the inputs of the static classifier (see
+// Classify::CharNormTrainingSample) into key and returns an FNV-1a hash of
+// them: the int features, the char norm feature and the vertical extent.
+uinT32 StaticResultCache::MakeKey(const TrainingSample& sample,
+                                  GenericVector<uinT8>* key) {
+  int num_features = sample.num_features();
+  key->truncate(0);
+  key->reserve(sizeof(num_features) + num_features * 3 +
+               kNumCNParams * sizeof(float) + 2 * sizeof(int));
+  const uinT8* bytes = reinterpret_cast<const uinT8*>(&num_features);
+  for (size_t i = 0; i < sizeof(num_features); ++i)
+    key->push_back(bytes[i]);
+  const INT_FEATURE_STRUCT* features = sample.features();
+  for (int f = 0; f < num_features; ++f) {
+    key->push_back(features[f].X);
+    key->push_back(features[f].Y);
+    key->push_back(features[f].Theta);
+  }
+  for (int p = 0; p < kNumCNParams; ++p) {
+    float param = sample.cn_feature(p);
+    bytes = reinterpret_cast<const uinT8*>(&param);
+    for (size_t i = 0; i < sizeof(param); ++i)
+      key->push_back(bytes[i]);
+  }
+  int extent[2] = { sample.geo_feature(GeoBottom),
+                    sample.geo_feature(GeoTop) };
+  bytes = reinterpret_cast<const uinT8*>(extent);
+  for (size_t i = 0; i < sizeof(extent); ++i)
+    key->push_back(bytes[i]);
+
+  uinT32 hash = 2166136261u;
+  for (int i = 0; i < key->size(); ++i) {
+    hash ^= (*key)[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Returns the index of the entry matching key, or -1.
+int StaticResultCache::FindEntry(uinT32 hash,
+                                 const GenericVector<uinT8>& key) const {
+  for (int index = buckets_[hash & (kNumBuckets - 1)]; index >= 0;
+       index = entries_[index]->next) {
+    const Entry* entry = entries_[index];
+    if (entry->hash == hash && entry->key.size() == key.size() &&
+        memcmp(&entry->key[0], &key[0], key.size()) == 0)
+      return index;
+  }
+  return -1;
+}
+
+}  // namespace tesseract
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////
+// File:        staticresultcache.h
+// Description: Per-page cache of static classifier results.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CLASSIFY_STATICRESULTCACHE_H_
+#define TESSERACT_CLASSIFY_STATICRESULTCACHE_H_
+
+#include "genericvector.h"
+#include "host.h"
+#include "shapetable.h"
+
+namespace tesseract {
+
+class TrainingSample;
+
+// Holds the results of the static classifier for the samples classified
+// on the current page. The static classifier depends on nothing but the
+// features of the sample and the pre-trained templates, so a blob that is
+// classified again -- in pass 2, after a re-chop, or as a repeat of the
+// same glyph -- can reuse the results instead of running the class pruner
+// and integer matcher again.
+// Entries are keyed by the exact features the static classifier reads, so
+// a hit always gives the same results classification would have given.
+class StaticResultCache {
+ public:
+  StaticResultCache();
+  ~StaticResultCache();
+
+  // Returns the cached results for sample, or NULL if it has not been seen.
+  const GenericVector<UnicharRating>* Find(const TrainingSample& sample);
+  // Adds the results for sample. Does nothing once max_size samples are held.
+  void Add(const TrainingSample& sample,
+           const GenericVector<UnicharRating>& results, int max_size);
+  // Drops all entries, eg for a new page.
+  void Clear();
+
+  int size() const { return entries_.size(); }
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+
+ private:
+  // Number of hash buckets. Must be a power of 2.
+  static const int kNumBuckets = 4096;
+
+  struct Entry {
+    uinT32 hash;
+    int next;                   // Index of the next entry in the bucket or -1.
+    GenericVector<uinT8> key;   // The features the results were made from.
+    GenericVector<UnicharRating> results;
+  };
+
+  // Serializes the classifier inputs of sample into key and returns its hash.
+  static uinT32 MakeKey(const TrainingSample& sample,
+                        GenericVector<uinT8>* key);
+  // Returns the index of the entry matching key, or -1.
+  int FindEntry(uinT32 hash, const GenericVector<uinT8>& key) const;
+
+  // Index of the first entry in each bucket, or -1.
+  int buckets_[kNumBuckets];
+  PointerVector<Entry> entries_;
+  // Scratch key, kept to avoid reallocating it on every lookup.
+  GenericVector<uinT8> key_;
+  int hits_;
+  int misses_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CLASSIFY_STATICRESULTCACHE_H_
@@ -19,6 +19,7 @@
 #include <stdio.h>
 
 #include "dict.h"
+#include "ocrclass.h"
 #include "unicodes.h"
 
 #ifdef _MSC_VER
@@ -169,7 +170,16 @@ Dict::Dict(CCUtil *ccutil)
                  " This limit is especially useful when user patterns"
                  " are specified, since overly generic patterns can result in"
                  " dawg search exploring an overly large number of options.",
-                 getCCUtil()->params()) {
+                 getCCUtil()->params()),
+      INT_MEMBER(max_permuter_breadth, 0,
+                 "Maximum number of character choices to try at each"
+                 " position during permutation, 0 for no limit.",
+                 getCCUtil()->params()),
+      double_MEMBER(stopper_skip_ambigs_certainty, 0.0,
+                    "Dictionary words with a certainty above this (negative)"
+                    " value are not searched for dangerous ambiguities."
+                    " 0 to search all words.",
+                    getCCUtil()->params()) {
   dang_ambigs_table_ = NULL;
   replace_ambigs_table_ = NULL;
   reject_offset_ = 0.0;
@@ -351,6 +361,7 @@ int Dict::def_letter_is_okay(void* void_dawg_args,
                              UNICHAR_ID unichar_id,
                              bool word_end) const {
   DawgArgs *dawg_args = reinterpret_cast<DawgArgs*>(void_dawg_args);
+  OCR_STATS_INC(getCCUtil()->ocr_stats(), OCR_COUNTER_DAWG_LOOKUPS);
 
   if (dawg_debug_level >= 3) {
     tprintf("def_letter_is_okay: current unichar=%s word_end=%d"
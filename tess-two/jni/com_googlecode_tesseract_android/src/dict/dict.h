@@ -643,6 +643,11 @@ class Dict {
               " This limit is especially useful when user patterns"
               " are specified, since overly generic patterns can result in"
               " dawg search exploring an overly large number of options.");
+  INT_VAR_H(max_permuter_breadth, 0, "Maximum number of character choices"
+            " to try at each position during permutation, 0 for no limit.");
+  double_VAR_H(stopper_skip_ambigs_certainty, 0.0, "Dictionary words with"
+               " a certainty above this (negative) value are not searched"
+               " for dangerous ambiguities. 0 to search all words.");
 };
 }  // namespace tesseract
 
@@ -199,7 +199,8 @@ WERD_CHOICE *Dict::dawg_permute_and_select(
  * permute_choices
  *
  * Call append_choices() for each BLOB_CHOICE in BLOB_CHOICE_LIST
- * with the given char_choice_index in char_choices.
+ * with the given char_choice_index in char_choices, or for the first
+ * max_permuter_breadth of them if that is set.
  */
 void Dict::permute_choices(
     const char *debug,
@@ -221,8 +222,13 @@ void Dict::permute_choices(
   if (char_choice_index < char_choices.length()) {
     BLOB_CHOICE_IT blob_choice_it;
     blob_choice_it.set_to_list(char_choices.get(char_choice_index));
+    int breadth = 0;
     for (blob_choice_it.mark_cycle_pt(); !blob_choice_it.cycled_list();
          blob_choice_it.forward()) {
+      if (max_permuter_breadth > 0 && ++breadth > max_permuter_breadth) {
+        if (debug) tprintf("permute_choices(): max_permuter_breadth reached\n");
+        break;
+      }
       (*attempts_left)--;
       append_choices(debug, char_choices, *(blob_choice_it.data()),
                      char_choice_index, prev_char_frag_info, word,
@@ -181,6 +181,17 @@ bool Dict::NoDangerousAmbig(WERD_CHOICE *best_choice,
     bool replace = (fix_replaceable && pass == 0);
     const UnicharAmbigsVector &table = replace ?
       getUnicharAmbigs().replace_ambigs() : getUnicharAmbigs().dang_ambigs();
+    if (!replace && stopper_skip_ambigs_certainty < 0.0 &&
+        valid_word_permuter(best_choice->permuter(), false) &&
+        best_choice->certainty() > stopper_skip_ambigs_certainty) {
+      // A confident dictionary word: accept it without permuting its
+      // ambiguities.
+      if (stopper_debug_level > 2) {
+        tprintf("Skipping dangerous ambigs, certainty=%g\n",
+                best_choice->certainty());
+      }
+      break;
+    }
     if (!replace) {
       // Initialize ambig_blob_choices with lists containing a single
       // unichar id for the correspoding position in best_choice.
@@ -40,6 +40,7 @@
 #include "freelist.h"
 #include "globals.h"
 #include "render.h"
+#include "ocrclass.h"
 #include "pageres.h"
 #include "seam.h"
 #include "stopper.h"
@@ -170,6 +171,7 @@ namespace tesseract {
 SEAM *Wordrec::attempt_blob_chop(TWERD *word, TBLOB *blob, inT32 blob_number,
                                  bool italic_blob,
                                  const GenericVector<SEAM*>& seams) {
+  OCR_STATS_INC(ocr_stats(), OCR_COUNTER_CHOPS_TRIED);
   if (repair_unchopped_blobs)
     preserve_outline_tree (blob->outlines);
   TBLOB *other_blob = TBLOB::ShallowCopy(*blob);       /* Make new blob */
@@ -392,6 +394,7 @@ SEAM* Wordrec::chop_one_blob(const GenericVector<TBOX>& boxes,
  * enough.  The results are returned in the WERD_RES.
  */
 void Wordrec::chop_word_main(WERD_RES *word) {
+  StartWordBudget();
   int num_blobs = word->chopped_word->NumBlobs();
   if (word->ratings == NULL) {
     word->ratings = new MATRIX(num_blobs, wordrec_max_join_chunks);
@@ -462,6 +465,7 @@ void Wordrec::improve_by_chopping(float rating_cert_scale,
                                   GenericVector<SegSearchPending>* pending) {
   int blob_number;
   do {  // improvement loop.
+    if (WordBudgetExceeded()) break;
     // Make a simple vector of BLOB_CHOICEs to make it easy to pick which
     // one to chop.
     GenericVector<BLOB_CHOICE*> blob_choices;
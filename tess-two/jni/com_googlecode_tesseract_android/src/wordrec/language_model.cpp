@@ -121,7 +121,10 @@ LanguageModel::LanguageModel(const UnicityTable<FontInfo> *fontinfo_table,
                      dict->getCCUtil()->params()),
   fontinfo_table_(fontinfo_table), dict_(dict),
   fixed_pitch_(false), max_char_wh_ratio_(0.0),
-  acceptable_choice_found_(false) {
+  acceptable_choice_found_(false),
+  vse_pool_(sizeof(ViterbiStateEntry)),
+  dawg_info_pool_(sizeof(LanguageModelDawgInfo)),
+  ngram_info_pool_(sizeof(LanguageModelNgramInfo)) {
   ASSERT_HOST(dict_ != NULL);
   dawg_args_ = new DawgArgs(NULL, new DawgPositionVector(), NO_PERM);
   very_beginning_active_dawgs_ = new DawgPositionVector();
@@ -203,27 +206,39 @@ static void ScanParentsForCaseMix(const UNICHARSET& unicharset,
 }
 
 /**
- * Helper returns true if the given choice has a better case variant before
- * it in the choice_list that is not distinguishable by size.
+ * Helper fills cell_choices with the non-fragment choices in choices, in
+ * order, marking those that have a better case variant earlier in the list
+ * that is not distinguishable by size.
  */
-static bool HasBetterCaseVariant(const UNICHARSET& unicharset,
-                                 const BLOB_CHOICE* choice,
-                                 BLOB_CHOICE_LIST* choices) {
-  UNICHAR_ID choice_id = choice->unichar_id();
-  UNICHAR_ID other_case = unicharset.get_other_case(choice_id);
-  if (other_case == choice_id || other_case == INVALID_UNICHAR_ID)
-    return false;  // Not upper or lower or not in unicharset.
-  if (unicharset.SizesDistinct(choice_id, other_case))
-    return false;  // Can be separated by size.
+static void FlattenCellChoices(const UNICHARSET& unicharset,
+                               BLOB_CHOICE_LIST* choices,
+                               GenericVector<LMCellChoice>* cell_choices) {
+  cell_choices->truncate(0);
   BLOB_CHOICE_IT bc_it(choices);
   for (bc_it.mark_cycle_pt(); !bc_it.cycled_list(); bc_it.forward()) {
-    BLOB_CHOICE* better_choice = bc_it.data();
-    if (better_choice->unichar_id() == other_case)
-      return true;  // Found an earlier instance of other_case.
-    else if (better_choice == choice)
-      return false;  // Reached the original choice.
+    BLOB_CHOICE* choice = bc_it.data();
+    UNICHAR_ID choice_id = choice->unichar_id();
+    if (unicharset.get_fragment(choice_id)) continue;
+    LMCellChoice cell_choice;
+    cell_choice.choice = choice;
+    cell_choice.unichar_id = choice_id;
+    cell_choice.first = bc_it.at_first();
+    cell_choice.has_better_case_variant = false;
+    UNICHAR_ID other_case = unicharset.get_other_case(choice_id);
+    // Only upper or lower in the unicharset that can't be separated by size.
+    // The other case is never a fragment, so only the earlier entries of
+    // cell_choices need to be searched.
+    if (other_case != choice_id && other_case != INVALID_UNICHAR_ID &&
+        !unicharset.SizesDistinct(choice_id, other_case)) {
+      for (int i = 0; i < cell_choices->size(); ++i) {
+        if ((*cell_choices)[i].unichar_id == other_case) {
+          cell_choice.has_better_case_variant = true;
+          break;
+        }
+      }
+    }
+    cell_choices->push_back(cell_choice);
   }
-  return false;  // Should never happen, but just in case.
 }
 
 /**
@@ -299,20 +314,18 @@ bool LanguageModel::UpdateState(
 
   // Call AddViterbiStateEntry() for each parent+child ViterbiStateEntry.
   ViterbiStateEntry_IT vit;
-  BLOB_CHOICE_IT c_it(curr_list);
-  for (c_it.mark_cycle_pt(); !c_it.cycled_list(); c_it.forward()) {
-    BLOB_CHOICE* choice = c_it.data();
+  FlattenCellChoices(unicharset, curr_list, &cell_choices_);
+  for (int c = 0; c < cell_choices_.size(); ++c) {
+    const LMCellChoice& cell_choice = cell_choices_[c];
+    BLOB_CHOICE* choice = cell_choice.choice;
     // TODO(antonova): make sure commenting this out if ok for ngram
     // model scoring (I think this was introduced to fix ngram model quirks).
     // Skip NULL unichars unless it is the only choice.
     //if (!curr_list->singleton() && c_it.data()->unichar_id() == 0) continue;
-    UNICHAR_ID unichar_id = choice->unichar_id();
-    if (unicharset.get_fragment(unichar_id)) {
-      continue;  // Skip fragments.
-    }
+    // Fragments were skipped by FlattenCellChoices.
     // Set top choice flags.
     LanguageModelFlagsType blob_choice_flags = kXhtConsistentFlag;
-    if (c_it.at_first() || !new_changed)
+    if (cell_choice.first || !new_changed)
       blob_choice_flags |= kSmallestRatingFlag;
     if (first_lower == choice) blob_choice_flags |= kLowerCaseFlag;
     if (first_upper == choice) blob_choice_flags |= kUpperCaseFlag;
@@ -330,7 +343,7 @@ bool LanguageModel::UpdateState(
       // increases the chances of choosing IPoc simply because it doesn't
       // include such a transition. iPoc will beat iPOC and ipoc because
       // the other words are baseline/x-height inconsistent.
-      if (HasBetterCaseVariant(unicharset, choice, curr_list))
+      if (cell_choice.has_better_case_variant)
         continue;
       // Upper counts as lower at the beginning of a word.
       if (blob_choice_flags & kUpperCaseFlag)
@@ -347,7 +360,7 @@ bool LanguageModel::UpdateState(
       ViterbiStateEntry* parent_vse = NULL;
       LanguageModelFlagsType top_choice_flags;
       while ((parent_vse = GetNextParentVSE(just_classified, has_alnum_mix,
-                                            c_it.data(), blob_choice_flags,
+                                            choice, blob_choice_flags,
                                             unicharset, word_res, &vit,
                                             &top_choice_flags)) != NULL) {
         // Skip pruned entries and do not look at prunable entries if already
@@ -361,14 +374,14 @@ bool LanguageModel::UpdateState(
         // string of alnum), and there is a better case variant that is not
         // distinguished by size, skip this blob choice/parent, as with the
         // initial blob treatment above.
-        if (!parent_vse->HasAlnumChoice(unicharset) &&
-            HasBetterCaseVariant(unicharset, choice, curr_list))
+        if (cell_choice.has_better_case_variant &&
+            !parent_vse->HasAlnumChoice(unicharset))
           continue;
-        // Create a new ViterbiStateEntry if BLOB_CHOICE in c_it.data()
-        // looks good according to the Dawgs or character ngram model.
+        // Create a new ViterbiStateEntry if choice looks good according to
+        // the Dawgs or character ngram model.
         new_changed |= AddViterbiStateEntry(
             top_choice_flags, denom, word_end, curr_col, curr_row,
-            c_it.data(), curr_state, parent_vse, pain_points,
+            choice, curr_state, parent_vse, pain_points,
             word_res, best_choice_bundle, blamer_bundle);
       }
     }
@@ -660,7 +673,7 @@ bool LanguageModel::AddViterbiStateEntry(
   }
 
   // Create the new ViterbiStateEntry compute the adjusted cost of the path.
-  ViterbiStateEntry *new_vse = new ViterbiStateEntry(
+  ViterbiStateEntry *new_vse = new(&vse_pool_) ViterbiStateEntry(
       parent_vse, b, 0.0, outline_length,
       consistency_info, associate_stats, top_choice_flags, dawg_info,
       ngram_info, (language_model_debug_level > 0) ?
@@ -803,8 +816,8 @@ LanguageModelDawgInfo *LanguageModel::GenerateDawgInfo(
   // Deal with hyphenated words.
   if (word_end && dict_->has_hyphen_end(b.unichar_id(), curr_col == 0)) {
     if (language_model_debug_level > 0) tprintf("Hyphenated word found\n");
-    return new LanguageModelDawgInfo(dawg_args_->active_dawgs,
-                                     COMPOUND_PERM);
+    return new(&dawg_info_pool_) LanguageModelDawgInfo(
+        dawg_args_->active_dawgs, COMPOUND_PERM);
   }
 
   // Deal with compound words.
@@ -836,7 +849,8 @@ LanguageModelDawgInfo *LanguageModel::GenerateDawgInfo(
     if (!has_word_ending) return NULL;
 
     if (language_model_debug_level > 0) tprintf("Compound word found\n");
-    return new LanguageModelDawgInfo(beginning_active_dawgs_, COMPOUND_PERM);
+    return new(&dawg_info_pool_) LanguageModelDawgInfo(beginning_active_dawgs_,
+                                                       COMPOUND_PERM);
   }  // done dealing with compound words
 
   LanguageModelDawgInfo *dawg_info = NULL;
@@ -865,8 +879,8 @@ LanguageModelDawgInfo *LanguageModel::GenerateDawgInfo(
   }
   dawg_args_->active_dawgs = NULL;
   if (dawg_args_->permuter != NO_PERM) {
-    dawg_info = new LanguageModelDawgInfo(dawg_args_->updated_dawgs,
-                                          dawg_args_->permuter);
+    dawg_info = new(&dawg_info_pool_) LanguageModelDawgInfo(
+        dawg_args_->updated_dawgs, dawg_args_->permuter);
   } else if (language_model_debug_level > 3) {
     tprintf("Letter %s not OK!\n",
             dict_->getUnicharset().id_to_unichar(b.unichar_id()));
@@ -923,9 +937,10 @@ LanguageModelNgramInfo *LanguageModel::GenerateNgramInfo(
   if (parent_vse != NULL && parent_vse->ngram_info->pruned) pruned = true;
 
   // Construct and return the new LanguageModelNgramInfo.
-  LanguageModelNgramInfo *ngram_info = new LanguageModelNgramInfo(
-      pcontext_ptr, pcontext_unichar_step_len, pruned, ngram_cost,
-      ngram_and_classifier_cost);
+  LanguageModelNgramInfo *ngram_info =
+      new(&ngram_info_pool_) LanguageModelNgramInfo(
+          pcontext_ptr, pcontext_unichar_step_len, pruned, ngram_cost,
+          ngram_and_classifier_cost);
   ngram_info->context += unichar;
   ngram_info->context_unichar_step_len += unichar_step_len;
   assert(ngram_info->context_unichar_step_len <= language_model_ngram_order);
@@ -359,6 +359,9 @@ class LanguageModel {
  protected:
   // Member Variables.
 
+  // The choices of the ratings cell being scored by UpdateState. Kept here to
+  // avoid reallocating it on every call.
+  GenericVector<LMCellChoice> cell_choices_;
   // Temporary DawgArgs struct that is re-used across different words to
   // avoid dynamic memory re-allocation (should be cleared before each use).
   DawgArgs *dawg_args_;
@@ -411,6 +414,14 @@ class LanguageModel {
 
   // Params models containing weights for for computing ViterbiStateEntry costs.
   ParamsModel params_model_;
+
+  // Storage for the ViterbiStateEntry, LanguageModelDawgInfo and
+  // LanguageModelNgramInfo of the segmentation search. They are all deleted
+  // when the BestChoiceBundle of a word goes, so every word reuses the memory
+  // of the one before.
+  ObjectPool vse_pool_;
+  ObjectPool dawg_info_pool_;
+  ObjectPool ngram_info_pool_;
 };
 
 }  // namespace tesseract
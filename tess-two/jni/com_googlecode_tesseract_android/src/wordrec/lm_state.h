@@ -27,6 +27,7 @@
 #include "dawg.h"
 #include "lm_consistency.h"
 #include "matrix.h"
+#include "objectpool.h"
 #include "ratngs.h"
 #include "stopper.h"
 #include "strngs.h"
@@ -65,6 +66,12 @@ struct LanguageModelDawgInfo {
   ~LanguageModelDawgInfo() {
     delete active_dawgs;
   }
+  // Allocated from a pool owned by LanguageModel, see ObjectPool.
+  void* operator new(size_t size, ObjectPool* pool) {
+    return pool->Alloc(size);
+  }
+  void operator delete(void* ptr) { ObjectPool::Free(ptr); }
+  void operator delete(void* ptr, ObjectPool*) { ObjectPool::Free(ptr); }
   DawgPositionVector *active_dawgs;
   PermuterType permuter;
 };
@@ -75,6 +82,12 @@ struct LanguageModelNgramInfo {
   LanguageModelNgramInfo(const char *c, int l, bool p, float nc, float ncc)
     : context(c), context_unichar_step_len(l), pruned(p), ngram_cost(nc),
       ngram_and_classifier_cost(ncc) {}
+  // Allocated from a pool owned by LanguageModel, see ObjectPool.
+  void* operator new(size_t size, ObjectPool* pool) {
+    return pool->Alloc(size);
+  }
+  void operator delete(void* ptr) { ObjectPool::Free(ptr); }
+  void operator delete(void* ptr, ObjectPool*) { ObjectPool::Free(ptr); }
   STRING context;  //< context string
   /// Length of the context measured by advancing using UNICHAR::utf8_step()
   /// (should be at most the order of the character ngram model used).
@@ -125,6 +138,12 @@ struct ViterbiStateEntry : public ELIST_LINK {
     delete ngram_info;
     delete debug_str;
   }
+  // Allocated from a pool owned by LanguageModel, see ObjectPool.
+  void* operator new(size_t size, ObjectPool* pool) {
+    return pool->Alloc(size);
+  }
+  void operator delete(void* ptr) { ObjectPool::Free(ptr); }
+  void operator delete(void* ptr, ObjectPool*) { ObjectPool::Free(ptr); }
   /// Comparator function for sorting ViterbiStateEntry_LISTs in
   /// non-increasing order of costs.
   static int Compare(const void *e1, const void *e2) {
@@ -193,6 +212,20 @@ struct ViterbiStateEntry : public ELIST_LINK {
 
 ELISTIZEH(ViterbiStateEntry);
 
+/// Flat copy of a BLOB_CHOICE in the ratings cell being scored by
+/// LanguageModel::UpdateState, so that the loop over the parent
+/// ViterbiStateEntries reads contiguous memory instead of walking the
+/// BLOB_CHOICE_LIST again for every parent.
+struct LMCellChoice {
+  BLOB_CHOICE *choice;
+  UNICHAR_ID unichar_id;
+  /// True if the choice is the first in the list.
+  bool first;
+  /// True if a case variant of the choice that is not distinguishable by size
+  /// comes earlier in the list.
+  bool has_better_case_variant;
+};
+
 /// Struct to store information maintained by various language model components.
 struct LanguageModelState {
   LanguageModelState() :
@@ -22,6 +22,7 @@
 #include "associate.h"
 #include "language_model.h"
 #include "matrix.h"
+#include "ocrclass.h"
 #include "params.h"
 #include "lm_pain_points.h"
 #include "ratngs.h"
@@ -70,6 +71,8 @@ void Wordrec::SegSearch(WERD_RES* word_res,
       (!SegSearchDone(num_futile_classifications) ||
           (blamer_bundle != NULL &&
               blamer_bundle->GuidedSegsearchStillGoing()))) {
+    // Out of budget: keep the best choice found so far.
+    if (WordBudgetExceeded()) break;
     // Get the next valid "pain point".
     bool found_nothing = true;
     LMPainPointsType pp_type;
@@ -270,6 +273,8 @@ void Wordrec::ProcessSegSearchPainPoint(
             pain_point.col, pain_point.row);
   }
   ASSERT_HOST(pain_points != NULL);
+  OCR_STATS_INC(ocr_stats(), OCR_COUNTER_PAIN_POINTS);
+  ++word_budget_classifications_;
   MATRIX *ratings = word_res->ratings;
   // Classify blob [pain_point.col pain_point.row]
   if (!pain_point.Valid(*ratings)) {
@@ -19,6 +19,7 @@
 #include "wordrec.h"
 
 #include "language_model.h"
+#include "ocrclass.h"
 #include "params.h"
 
 
@@ -113,8 +114,18 @@ Wordrec::Wordrec() :
   BOOL_MEMBER(save_alt_choices, true,
               "Save alternative paths found during chopping"
               " and segmentation search",
-              params()) {
+              params()),
+  INT_MEMBER(wordrec_word_budget_ms, 0,
+             "Max msecs of chopping and segmentation search per word,"
+             " 0 for no limit", params()),
+  INT_MEMBER(wordrec_word_budget_classifications, 0,
+             "Max classifications by chopping and segmentation search per"
+             " word, 0 for no limit", params()) {
   prev_word_best_choice_ = NULL;
+  page_budget_end_usecs_ = 0;
+  word_budget_end_usecs_ = 0;
+  word_budget_classifications_ = 0;
+  word_budget_exceeded_ = false;
   language_model_ = new LanguageModel(&get_fontinfo_table(),
                                       &(getDict()));
   fill_lattice_ = NULL;
@@ -124,4 +135,32 @@ Wordrec::~Wordrec() {
   delete language_model_;
 }
 
+// Starts the work budget of the next word to be chopped and searched.
+void Wordrec::StartWordBudget() {
+  word_budget_end_usecs_ = page_budget_end_usecs_;
+  if (wordrec_word_budget_ms > 0) {
+    inT64 word_end = OCR_STATS::NowUsecs() + wordrec_word_budget_ms * 1000LL;
+    if (word_budget_end_usecs_ == 0 || word_end < word_budget_end_usecs_)
+      word_budget_end_usecs_ = word_end;
+  }
+  word_budget_classifications_ = 0;
+  word_budget_exceeded_ = false;
+}
+
+// Returns true once the current word has used up its budget.
+bool Wordrec::WordBudgetExceeded() {
+  if (word_budget_exceeded_) return true;
+  if ((wordrec_word_budget_classifications > 0 &&
+       word_budget_classifications_ >= wordrec_word_budget_classifications) ||
+      (word_budget_end_usecs_ != 0 &&
+       OCR_STATS::NowUsecs() >= word_budget_end_usecs_)) {
+    word_budget_exceeded_ = true;
+    OCR_STATS_INC(ocr_stats(), OCR_COUNTER_WORDS_OVER_BUDGET);
+    if (segsearch_debug_level > 0 || chop_debug)
+      tprintf("Word budget exceeded after %d classifications\n",
+              word_budget_classifications_);
+  }
+  return word_budget_exceeded_;
+}
+
 }  // namespace tesseract
@@ -176,6 +176,12 @@ class Wordrec : public Classify {
   BOOL_VAR_H(save_alt_choices, true,
              "Save alternative paths found during chopping "
              "and segmentation search");
+  INT_VAR_H(wordrec_word_budget_ms, 0,
+            "Max msecs of chopping and segmentation search per word,"
+            " 0 for no limit");
+  INT_VAR_H(wordrec_word_budget_classifications, 0,
+            "Max classifications by chopping and segmentation search per"
+            " word, 0 for no limit");
 
   // methods from wordrec/*.cpp ***********************************************
   Wordrec();
@@ -190,6 +196,15 @@ class Wordrec : public Classify {
   void FillLattice(const MATRIX &ratings, const WERD_CHOICE_LIST &best_choices,
                    const UNICHARSET &unicharset, BlamerBundle *blamer_bundle);
 
+  // Starts the work budget of the next word to be chopped and searched.
+  // See wordrec_word_budget_ms and wordrec_word_budget_classifications.
+  // The budget never runs past page_budget_end_usecs_.
+  void StartWordBudget();
+  // Returns true once the current word has used up its budget, after which
+  // chopping and segmentation search stop and the word keeps the best choice
+  // found so far. Counts the word as degraded the first time it returns true.
+  bool WordBudgetExceeded();
+
   // Calls fill_lattice_ member function
   // (assumes that fill_lattice_ is not NULL).
   void CallFillLattice(const MATRIX &ratings,
@@ -421,6 +436,13 @@ class Wordrec : public Classify {
                                  const WERD_CHOICE_LIST &best_choices,
                                  const UNICHARSET &unicharset,
                                  BlamerBundle *blamer_bundle);
+  // Time in OCR_STATS::NowUsecs after which no word gets any chopping or
+  // segmentation search, or 0 for no limit. Set for the page by Tesseract.
+  inT64 page_budget_end_usecs_;
+  // Work budget of the current word, see StartWordBudget.
+  inT64 word_budget_end_usecs_;    // 0 for no time limit.
+  int word_budget_classifications_;  // Classifications made so far.
+  bool word_budget_exceeded_;
 
  protected:
   inline bool SegSearchDone(int num_futile_classifications) {
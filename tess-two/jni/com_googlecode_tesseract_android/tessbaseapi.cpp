@@ -17,14 +17,191 @@
 
 #include <stdio.h>
 #include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <string.h>
+#include <time.h>
 #include "android/bitmap.h"
 #include "common.h"
 #include "baseapi.h"
+#include "genericvector.h"
 #include "ocrclass.h"
+#include "strngs.h"
 #include "allheaders.h"
 #include "renderer.h"
 
 static jmethodID method_onProgressValues;
+static jmethodID method_onJobFinished;
+
+// Number of ints stored for each event in the progress event buffer. The
+// layout matches the arguments of TessBaseAPI.onProgressValues().
+#define PROGRESS_EVENT_INTS 9
+
+static l_int64 monotonicMillis() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (l_int64) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// States of an asynchronous job. The first five match TessBaseAPI.JobStatus.
+// The state of a job is kept in one word together with its id, so that a
+// request made with a stale id can never affect a job that reuses the slot.
+enum {
+  JOB_QUEUED = 0,
+  JOB_RUNNING = 1,
+  JOB_DONE = 2,
+  JOB_CANCELLED = 3,
+  JOB_FAILED = 4,
+  JOB_RESERVED = 5,   // Being filled in by submit.
+  JOB_TAKEN = 6       // Result handed to Java, waiting to be freed.
+};
+#define JOB_STATE_BITS 3
+#define JOB_STATE_MASK ((1 << JOB_STATE_BITS) - 1)
+
+struct async_job_t {
+  l_int64 tag;        // (id << JOB_STATE_BITS) | state, or 0 when free.
+  l_int64 cancelId;   // Set to the id to cancel the job while it runs.
+  l_int32 refs;       // Held by the queue and by the owner of the result.
+  PIX *pix;
+  l_int32 left;
+  l_int32 top;
+  l_int32 width;
+  l_int32 height;
+  l_int32 pageSegMode;
+  l_int32 formats;
+  char *outputs[tesseract::TEXT_OUTPUT_COUNT];
+  l_int32 meanConfidence;
+};
+
+// Cell of the bounded multi-producer multi-consumer ring of queued jobs.
+// sequence tells producers and consumers whose turn the cell is.
+struct async_cell_t {
+  l_int64 sequence;
+  l_int32 job;
+};
+
+struct async_queue_t;
+
+struct async_worker_t {
+  async_queue_t *queue;
+  tesseract::TessBaseAPI *engine;
+  bool ownsEngine;
+  pthread_t thread;
+  async_job_t *job;   // The job being recognized.
+  l_int64 jobId;
+};
+
+// Asynchronous jobs of a TessBaseAPI. Submitting, cancelling and polling
+// only use atomic operations on the job slots and the ring, so they never
+// wait for the engine workers. Workers sleep on a semaphore while the ring
+// is empty.
+struct async_queue_t {
+  JavaVM *vm;
+  jobject listener;   // The TessBaseAPI to call back, or NULL to poll.
+  l_int32 capacity;   // Number of slots and of ring cells, a power of 2.
+  async_job_t *jobs;
+  async_cell_t *cells;
+  l_int64 enqueuePos;
+  l_int64 dequeuePos;
+  l_int64 nextId;
+  bool stopping;
+  sem_t available;
+  async_worker_t *workers;
+  l_int32 numWorkers;
+};
+
+static bool pushJob(async_queue_t *queue, l_int32 index) {
+  l_int64 pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+  for (;;) {
+    async_cell_t *cell = &queue->cells[pos & (queue->capacity - 1)];
+    l_int64 diff = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - pos;
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&queue->enqueuePos, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        cell->job = index;
+        __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+        return true;
+      }
+    } else if (diff < 0) {
+      return false;   // Full.
+    } else {
+      pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+static l_int32 popJob(async_queue_t *queue) {
+  l_int64 pos = __atomic_load_n(&queue->dequeuePos, __ATOMIC_RELAXED);
+  for (;;) {
+    async_cell_t *cell = &queue->cells[pos & (queue->capacity - 1)];
+    l_int64 diff = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - (pos + 1);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&queue->dequeuePos, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        l_int32 index = cell->job;
+        __atomic_store_n(&cell->sequence, pos + queue->capacity, __ATOMIC_RELEASE);
+        return index;
+      }
+    } else if (diff < 0) {
+      return -1;   // Empty.
+    } else {
+      pos = __atomic_load_n(&queue->dequeuePos, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+// Returns the slot of the job with the given id and its current tag, or NULL.
+static async_job_t *findJob(async_queue_t *queue, l_int64 id, l_int64 *tag) {
+  if (id <= 0)
+    return NULL;
+  for (l_int32 i = 0; i < queue->capacity; i++) {
+    async_job_t *job = &queue->jobs[i];
+    *tag = __atomic_load_n(&job->tag, __ATOMIC_ACQUIRE);
+    if ((*tag >> JOB_STATE_BITS) == id)
+      return job;
+  }
+  return NULL;
+}
+
+// Moves the job from the given tag to a new state. Fails if anyone else
+// changed the job since the tag was read.
+static bool setJobState(async_job_t *job, l_int64 *tag, l_int32 state) {
+  l_int64 newTag = (*tag & ~(l_int64) JOB_STATE_MASK) | state;
+  if (!__atomic_compare_exchange_n(&job->tag, tag, newTag, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    return false;
+  *tag = newTag;
+  return true;
+}
+
+// Drops one reference to the job, and frees its slot with the last one.
+static void releaseJob(async_job_t *job) {
+  if (__atomic_sub_fetch(&job->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    return;
+  for (int i = 0; i < tesseract::TEXT_OUTPUT_COUNT; i++) {
+    delete[] job->outputs[i];
+    job->outputs[i] = NULL;
+  }
+  pixDestroy(&job->pix);
+  __atomic_store_n(&job->tag, 0, __ATOMIC_RELEASE);
+}
+
+// Copies the outputs of the job to a String[] indexed by output format.
+static jobjectArray jobOutputs(JNIEnv *env, async_job_t *job) {
+  jclass stringClass = env->FindClass("java/lang/String");
+  jobjectArray result = env->NewObjectArray(tesseract::TEXT_OUTPUT_COUNT, stringClass, NULL);
+  env->DeleteLocalRef(stringClass);
+
+  for (int i = 0; i < tesseract::TEXT_OUTPUT_COUNT && result != NULL; i++) {
+    if (job->outputs[i] == NULL)
+      continue;
+    jstring text = env->NewStringUTF(job->outputs[i]);
+    env->SetObjectArrayElement(result, i, text);
+    env->DeleteLocalRef(text);
+  }
+  return result;
+}
 
 struct native_data_t {
   tesseract::TessBaseAPI api;
@@ -39,6 +216,37 @@ struct native_data_t {
   JNIEnv *cachedEnv;
   jobject* cachedObject;
 
+  // Set while a recognition call that reports progress is running.
+  bool recognizing;
+
+  // Ring buffer of progress events, shared with Java through a direct
+  // ByteBuffer. When present, progress is written here instead of being
+  // delivered with one JNI upcall per event.
+  jint *progressEvents;
+  l_int32 progressEventCapacity;
+  l_int64 progressEventsWritten;
+  // Buffers replaced by setProgressEventCapacity. Java may still be reading
+  // one through a ByteBuffer, so they are only freed by End.
+  GenericVector<jint *> retiredProgressEvents;
+  l_int32 progressIntervalMillis;
+  l_int64 lastProgressMillis;
+  // Last event dropped by the progress interval, delivered when the
+  // recognition call ends so that the final progress is never lost.
+  jint pendingProgress[PROGRESS_EVENT_INTS];
+  bool hasPendingProgress;
+
+  // Arguments of the last successful Init, for the extra engines of jobs.
+  STRING initDatapath;
+  STRING initLanguage;
+  l_int32 initOem;
+  // Variables set since the last End, in order, to give the same settings
+  // to the extra engines of jobs.
+  GenericVector<STRING> variableNames;
+  GenericVector<STRING> variableValues;
+
+  // Asynchronous jobs, or NULL until they are started.
+  async_queue_t *jobs;
+
   bool isStateValid() {
     if (cancel_ocr == false && cachedEnv != NULL && cachedObject != NULL) {
       return true;
@@ -57,6 +265,9 @@ struct native_data_t {
     cachedEnv = env;
     cachedObject = object;
     lastProgress = 0;
+    lastProgressMillis = 0;
+    hasPendingProgress = false;
+    __atomic_store_n(&recognizing, true, __ATOMIC_RELEASE);
   }
 
   void resetStateVariables() {
@@ -64,9 +275,62 @@ struct native_data_t {
     cachedEnv = NULL;
     cachedObject = NULL;
     lastProgress = 0;
+    lastProgressMillis = 0;
+    hasPendingProgress = false;
     boxSetGeometry(currentTextBox, 0, 0, 0, 0);
   }
 
+  // Ends a recognition call started with initStateVariables, delivering
+  // the last progress event if the progress interval dropped it.
+  void endRecognition() {
+    if (hasPendingProgress && isStateValid())
+      deliverProgress(pendingProgress);
+    resetStateVariables();
+    __atomic_store_n(&recognizing, false, __ATOMIC_RELEASE);
+  }
+
+  // Returns false, changing nothing, while recognition is running.
+  bool setProgressEventCapacity(l_int32 capacity) {
+    if (__atomic_load_n(&recognizing, __ATOMIC_ACQUIRE))
+      return false;
+    if (progressEvents != NULL)
+      retiredProgressEvents.push_back(progressEvents);
+    progressEvents = NULL;
+    progressEventCapacity = 0;
+    __atomic_store_n(&progressEventsWritten, 0, __ATOMIC_RELEASE);
+    if (capacity > 0) {
+      progressEvents = (jint *) calloc(capacity * PROGRESS_EVENT_INTS, sizeof(jint));
+      if (progressEvents != NULL)
+        progressEventCapacity = capacity;
+    }
+    return true;
+  }
+
+  void freeRetiredProgressEvents() {
+    for (int i = 0; i < retiredProgressEvents.size(); i++)
+      free(retiredProgressEvents[i]);
+    retiredProgressEvents.clear();
+  }
+
+  void deliverProgress(const jint *values) {
+    if (progressEvents != NULL) {
+      addProgressEvent(values);
+    } else {
+      cachedEnv->CallVoidMethod(*cachedObject, method_onProgressValues, values[0],
+              values[1], values[2], values[3], values[4],
+              values[5], values[6], values[7], values[8]);
+    }
+  }
+
+  // Single producer: the slot is filled before the count is published, so
+  // at most the event at index progressEventsWritten is ever incomplete.
+  void addProgressEvent(const jint *values) {
+    l_int64 index = progressEventsWritten;
+    jint *slot = progressEvents + (index % progressEventCapacity) * PROGRESS_EVENT_INTS;
+    memcpy(slot, values, PROGRESS_EVENT_INTS * sizeof(jint));
+    __atomic_store_n(&progressEventsWritten, index + 1, __ATOMIC_RELEASE);
+  }
+
   native_data_t() {
     currentTextBox = boxCreate(0, 0, 0, 0);
     lastProgress = 0;
@@ -76,10 +340,21 @@ struct native_data_t {
     cachedEnv = NULL;
     cachedObject = NULL;
     cancel_ocr = false;
+    progressEvents = NULL;
+    progressEventCapacity = 0;
+    progressEventsWritten = 0;
+    progressIntervalMillis = 0;
+    lastProgressMillis = 0;
+    hasPendingProgress = false;
+    recognizing = false;
+    initOem = tesseract::OEM_DEFAULT;
+    jobs = NULL;
   }
 
   ~native_data_t() {
 	  boxDestroy(&currentTextBox);
+	  free(progressEvents);
+	  freeRetiredProgressEvents();
   }
 };
 
@@ -101,15 +376,182 @@ bool progressJavaCallback(void* progress_this, int progress, int left, int right
     if (progress > nat->lastProgress || left != 0 || right != 0 || top != 0 || bottom != 0) {
       int x, y, width, height;
       boxGetGeometry(nat->currentTextBox, &x, &y, &width, &height);
-      nat->cachedEnv->CallVoidMethod(*(nat->cachedObject), method_onProgressValues, progress,
+      jint values[PROGRESS_EVENT_INTS] = { progress,
               (jint) left, (jint) right, (jint) top, (jint) bottom,
-              (jint) x, (jint) (x + width), (jint) (y + height), (jint) y);
+              (jint) x, (jint) (x + width), (jint) (y + height), (jint) y };
+      // Reports sooner than the interval after the previous one are held
+      // back; the last of them is delivered by endRecognition.
+      l_int64 now = nat->progressIntervalMillis > 0 ? monotonicMillis() : 0;
+      if (nat->progressIntervalMillis > 0 && nat->lastProgressMillis != 0 &&
+          now - nat->lastProgressMillis < nat->progressIntervalMillis) {
+        memcpy(nat->pendingProgress, values, sizeof(values));
+        nat->hasPendingProgress = true;
+      } else {
+        nat->lastProgressMillis = now;
+        nat->hasPendingProgress = false;
+        nat->deliverProgress(values);
+      }
       nat->lastProgress = progress;
     }
   }
   return true;
 }
 
+/**
+ * Callback for Tesseract's monitor to cancel an asynchronous job.
+ */
+bool jobCancelFunc(void* cancel_this, int words) {
+  async_worker_t *worker = (async_worker_t*)cancel_this;
+  return __atomic_load_n(&worker->job->cancelId, __ATOMIC_ACQUIRE) == worker->jobId ||
+      __atomic_load_n(&worker->queue->stopping, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Recognizes a job with the engine of the worker and publishes its result.
+ */
+static void runJob(async_worker_t *worker, async_job_t *job, l_int64 *tag) {
+  tesseract::TessBaseAPI *engine = worker->engine;
+  worker->job = job;
+  worker->jobId = *tag >> JOB_STATE_BITS;
+
+  ETEXT_DESC monitor;
+  monitor.cancel = jobCancelFunc;
+  monitor.cancel_this = worker;
+
+  engine->SetImage(job->pix);
+  if (job->width > 0 && job->height > 0)
+    engine->SetRectangle(job->left, job->top, job->width, job->height);
+  engine->SetPageSegMode((tesseract::PageSegMode) job->pageSegMode);
+
+  bool success = engine->GetTextOutputs(&monitor, 0, job->formats, job->outputs);
+  if (success)
+    job->meanConfidence = engine->MeanTextConf();
+  engine->Clear();
+
+  l_int32 state = JOB_DONE;
+  if (jobCancelFunc(worker, 0))
+    state = JOB_CANCELLED;
+  else if (!success)
+    state = JOB_FAILED;
+
+  // Nothing else changes a running job, so this always succeeds.
+  setJobState(job, tag, state);
+}
+
+/**
+ * Hands a finished job to the Java listener, which takes over the result.
+ */
+static void deliverJob(JNIEnv *env, async_queue_t *queue, async_job_t *job, l_int64 tag) {
+  l_int32 state = tag & JOB_STATE_MASK;
+  if (state != JOB_DONE && state != JOB_CANCELLED && state != JOB_FAILED)
+    return;
+  if (!setJobState(job, &tag, JOB_TAKEN))
+    return;
+
+  jobjectArray outputs = (state == JOB_DONE) ? jobOutputs(env, job) : NULL;
+  env->CallVoidMethod(queue->listener, method_onJobFinished, (jlong) (tag >> JOB_STATE_BITS),
+          (jint) state, outputs, (jint) job->meanConfidence);
+  if (env->ExceptionCheck()) {
+    LOGE("Job listener threw an exception!");
+    env->ExceptionClear();
+  }
+  if (outputs != NULL)
+    env->DeleteLocalRef(outputs);
+
+  releaseJob(job);
+}
+
+static void *jobWorkerMain(void *arg) {
+  async_worker_t *worker = (async_worker_t*) arg;
+  async_queue_t *queue = worker->queue;
+
+  JNIEnv *env = NULL;
+  if (queue->listener != NULL && queue->vm->AttachCurrentThread(&env, NULL) != JNI_OK) {
+    LOGE("Could not attach job worker to the VM!");
+    env = NULL;
+  }
+
+  for (;;) {
+    while (sem_wait(&queue->available) != 0)
+      ;
+
+    // Every post but the ones to stop follows a push. That push may wait on
+    // an earlier one that is not done yet, so retry until the job shows up.
+    l_int32 index;
+    while ((index = popJob(queue)) < 0 &&
+           !__atomic_load_n(&queue->stopping, __ATOMIC_ACQUIRE))
+      sched_yield();
+    if (index < 0)
+      break;
+
+    async_job_t *job = &queue->jobs[index];
+    l_int64 tag = __atomic_load_n(&job->tag, __ATOMIC_ACQUIRE);
+    if ((tag & JOB_STATE_MASK) == JOB_QUEUED) {
+      // Jobs still queued when stopping are cancelled, not recognized. A
+      // failed state change means the job was cancelled or taken meanwhile.
+      if (__atomic_load_n(&queue->stopping, __ATOMIC_ACQUIRE))
+        setJobState(job, &tag, JOB_CANCELLED);
+      else if (setJobState(job, &tag, JOB_RUNNING))
+        runJob(worker, job, &tag);
+    }
+
+    if (env != NULL)
+      deliverJob(env, queue, job, tag);
+
+    // Drop the reference of the queue.
+    releaseJob(job);
+  }
+
+  if (env != NULL)
+    queue->vm->DetachCurrentThread();
+
+  return NULL;
+}
+
+/**
+ * Stops the asynchronous jobs of nat, cancelling the queued and running ones,
+ * and frees the results that were never collected. Returns false without
+ * stopping anything when called on a job worker, e.g. from a JobListener,
+ * as the worker would wait for itself to finish.
+ */
+static bool stopJobs(JNIEnv *env, native_data_t *nat) {
+  async_queue_t *queue = nat->jobs;
+  if (queue == NULL)
+    return true;
+
+  for (l_int32 i = 0; i < queue->numWorkers; i++) {
+    if (pthread_equal(queue->workers[i].thread, pthread_self())) {
+      LOGE("Jobs cannot be stopped from a job worker!");
+      return false;
+    }
+  }
+
+  __atomic_store_n(&queue->stopping, true, __ATOMIC_RELEASE);
+  for (l_int32 i = 0; i < queue->numWorkers; i++)
+    sem_post(&queue->available);
+  for (l_int32 i = 0; i < queue->numWorkers; i++) {
+    pthread_join(queue->workers[i].thread, NULL);
+    if (queue->workers[i].ownsEngine)
+      delete queue->workers[i].engine;
+  }
+
+  // Only the references of unclaimed results remain.
+  for (l_int32 i = 0; i < queue->capacity; i++) {
+    if (queue->jobs[i].tag != 0)
+      releaseJob(&queue->jobs[i]);
+  }
+
+  if (queue->listener != NULL)
+    env->DeleteGlobalRef(queue->listener);
+  sem_destroy(&queue->available);
+  delete[] queue->workers;
+  delete[] queue->cells;
+  delete[] queue->jobs;
+  delete queue;
+  nat->jobs = NULL;
+  return true;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -129,6 +571,7 @@ void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeClassInit(JNIEnv* e
                                                                        jclass clazz) {
 
   method_onProgressValues = env->GetMethodID(clazz, "onProgressValues", "(IIIIIIIII)V");
+  method_onJobFinished = env->GetMethodID(clazz, "onJobFinished", "(JI[Ljava/lang/String;I)V");
 }
 
 jlong Java_com_googlecode_tesseract_android_TessBaseAPI_nativeConstruct(JNIEnv* env,
@@ -162,6 +605,9 @@ jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeInit(JNIEnv *en
     res = JNI_FALSE;
   } else {
     LOGI("Initialized Tesseract API with language=%s", c_lang);
+    nat->initDatapath = c_dir;
+    nat->initLanguage = c_lang;
+    nat->initOem = tesseract::OEM_DEFAULT;
   }
 
   env->ReleaseStringUTFChars(dir, c_dir);
@@ -189,6 +635,9 @@ jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeInitOem(JNIEnv
     res = JNI_FALSE;
   } else {
     LOGI("Initialized Tesseract API with language=%s", c_lang);
+    nat->initDatapath = c_dir;
+    nat->initLanguage = c_lang;
+    nat->initOem = mode;
   }
 
   env->ReleaseStringUTFChars(dir, c_dir);
@@ -301,11 +750,55 @@ jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetUTF8Text(JNIE
   jstring result = env->NewStringUTF(text);
 
   free(text);
-  nat->resetStateVariables();
+  nat->endRecognition();
 
   return result;
 }
 
+jobject Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetProgressEventBuffer(JNIEnv *env,
+                                                                                    jobject thiz,
+                                                                                    jlong mNativeData,
+                                                                                    jint capacity) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  if (!nat->setProgressEventCapacity(capacity)) {
+    env->ThrowNew(env->FindClass("java/lang/IllegalStateException"),
+                  "Progress event buffer changed during recognition");
+    return NULL;
+  }
+
+  if (nat->progressEvents == NULL) {
+    if (capacity > 0)
+      LOGE("Could not allocate progress event buffer of %d events!", capacity);
+    return NULL;
+  }
+
+  return env->NewDirectByteBuffer(nat->progressEvents,
+          (jlong) nat->progressEventCapacity * PROGRESS_EVENT_INTS * sizeof(jint));
+}
+
+jlong Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetProgressEventCount(JNIEnv *env,
+                                                                                   jobject thiz,
+                                                                                   jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  // Order the caller's reads of the shared buffer against this load.
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  return (jlong) __atomic_load_n(&nat->progressEventsWritten, __ATOMIC_ACQUIRE);
+}
+
+void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetProgressInterval(JNIEnv *env,
+                                                                                jobject thiz,
+                                                                                jlong mNativeData,
+                                                                                jint millis) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  nat->progressIntervalMillis = millis;
+}
+
 void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeStop(JNIEnv *env, 
                                                                   jobject thiz,
                                                                   jlong mNativeData) {
@@ -368,6 +861,10 @@ jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetVariable(JNI
   const char *c_value = env->GetStringUTFChars(value, NULL);
 
   jboolean set = nat->api.SetVariable(c_var, c_value) ? JNI_TRUE : JNI_FALSE;
+  if (set) {
+    nat->variableNames.push_back(STRING(c_var));
+    nat->variableValues.push_back(STRING(c_value));
+  }
 
   env->ReleaseStringUTFChars(var, c_var);
   env->ReleaseStringUTFChars(value, c_value);
@@ -397,13 +894,50 @@ void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeClear(JNIEnv *env,
   nat->pix = NULL;
 }
 
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSaveAdaptiveClassifier(JNIEnv *env,
+                                                                                        jobject thiz,
+                                                                                        jlong mNativeData,
+                                                                                        jstring path) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  const char *c_path = env->GetStringUTFChars(path, NULL);
+
+  jboolean saved = nat->api.SaveAdaptiveClassifier(c_path) ? JNI_TRUE : JNI_FALSE;
+
+  env->ReleaseStringUTFChars(path, c_path);
+
+  return saved;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeLoadAdaptiveClassifier(JNIEnv *env,
+                                                                                        jobject thiz,
+                                                                                        jlong mNativeData,
+                                                                                        jstring path) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  const char *c_path = env->GetStringUTFChars(path, NULL);
+
+  jboolean loaded = nat->api.LoadAdaptiveClassifier(c_path) ? JNI_TRUE : JNI_FALSE;
+
+  env->ReleaseStringUTFChars(path, c_path);
+
+  return loaded;
+}
+
 void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeEnd(JNIEnv *env,
                                                                  jobject thiz,
                                                                  jlong mNativeData) {
 
   native_data_t *nat = (native_data_t*) mNativeData;
 
+  if (!stopJobs(env, nat))
+    return;
   nat->api.End();
+  nat->variableNames.clear();
+  nat->variableValues.clear();
+  nat->freeRetiredProgressEvents();
 
   // Since Tesseract doesn't take ownership of the memory, we keep a pointer in the native
   // code struct. We need to free that pointer when we release our instance of Tesseract or
@@ -557,11 +1091,330 @@ jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetHOCRText(JNIE
   jstring result = env->NewStringUTF(text);
 
   free(text);
-  nat->resetStateVariables();
+  nat->endRecognition();
+
+  return result;
+}
+
+jobjectArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetTextOutputs(JNIEnv *env,
+                                                                                   jobject thiz,
+                                                                                   jlong mNativeData,
+                                                                                   jint page,
+                                                                                   jint formats) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  nat->initStateVariables(env, &thiz);
+
+  ETEXT_DESC monitor;
+  monitor.progress_callback = progressJavaCallback;
+  monitor.cancel = cancelFunc;
+  monitor.cancel_this = nat;
+  monitor.progress_this = nat;
+
+  char *outputs[tesseract::TEXT_OUTPUT_COUNT];
+  jobjectArray result = NULL;
+
+  if (nat->api.GetTextOutputs(&monitor, page, formats, outputs)) {
+    jclass stringClass = env->FindClass("java/lang/String");
+    result = env->NewObjectArray(tesseract::TEXT_OUTPUT_COUNT, stringClass, NULL);
+
+    for (int i = 0; i < tesseract::TEXT_OUTPUT_COUNT; i++) {
+      if (outputs[i] == NULL)
+        continue;
+      if (result != NULL) {
+        jstring text = env->NewStringUTF(outputs[i]);
+        env->SetObjectArrayElement(result, i, text);
+        env->DeleteLocalRef(text);
+      }
+      delete[] outputs[i];
+    }
+  }
+
+  nat->endRecognition();
+
+  return result;
+}
+
+jobjectArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeRecognizeRegions(JNIEnv *env,
+                                                                                      jobject thiz,
+                                                                                      jlong mNativeData,
+                                                                                      jlong nativePixa,
+                                                                                      jfloatArray regionConfs,
+                                                                                      jint maxRegions,
+                                                                                      jint budgetMillis,
+                                                                                      jintArray textConfs) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  PIXA *pixa = (PIXA *) nativePixa;
+  BOXA *boxa = pixaGetBoxa(pixa, L_CLONE);
+
+  if (boxa == NULL) {
+    LOGE("Could not get region boxes!");
+    return NULL;
+  }
+
+  int count = boxaGetCount(boxa);
+  jfloat *confs = NULL;
+  if (regionConfs != NULL) {
+    if (env->GetArrayLength(regionConfs) < count) {
+      LOGE("Fewer region confidences than regions!");
+      boxaDestroy(&boxa);
+      return NULL;
+    }
+    confs = env->GetFloatArrayElements(regionConfs, NULL);
+  }
+
+  nat->initStateVariables(env, &thiz);
+
+  ETEXT_DESC monitor;
+  monitor.progress_callback = progressJavaCallback;
+  monitor.cancel = cancelFunc;
+  monitor.cancel_this = nat;
+  monitor.progress_this = nat;
+
+  GenericVector<STRING> texts;
+  GenericVector<int> confidences;
+  jobjectArray result = NULL;
+
+  if (nat->api.RecognizeRegions(boxa, confs, maxRegions, budgetMillis, &monitor,
+                                &texts, &confidences) >= 0) {
+    jclass stringClass = env->FindClass("java/lang/String");
+    result = env->NewObjectArray(count, stringClass, NULL);
+
+    for (int i = 0; i < count && result != NULL; i++) {
+      if (confidences[i] < 0)
+        continue;
+      jstring text = env->NewStringUTF(texts[i].string());
+      env->SetObjectArrayElement(result, i, text);
+      env->DeleteLocalRef(text);
+    }
+    if (count > 0 && textConfs != NULL && env->GetArrayLength(textConfs) >= count)
+      env->SetIntArrayRegion(textConfs, 0, count, &confidences[0]);
+  }
+
+  nat->endRecognition();
+
+  if (confs != NULL)
+    env->ReleaseFloatArrayElements(regionConfs, confs, JNI_ABORT);
+  boxaDestroy(&boxa);
+
+  return result;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeStartJobs(JNIEnv *env,
+                                                                        jobject thiz,
+                                                                        jlong mNativeData,
+                                                                        jint capacity,
+                                                                        jint numEngines,
+                                                                        jboolean notify) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  if (nat->jobs != NULL)
+    return JNI_FALSE;
+
+  async_queue_t *queue = new async_queue_t;
+  queue->capacity = 1;
+  while (queue->capacity < capacity)
+    queue->capacity <<= 1;
+  queue->jobs = new async_job_t[queue->capacity];
+  queue->cells = new async_cell_t[queue->capacity];
+  for (l_int32 i = 0; i < queue->capacity; i++) {
+    memset(&queue->jobs[i], 0, sizeof(async_job_t));
+    queue->cells[i].sequence = i;
+    queue->cells[i].job = -1;
+  }
+  queue->enqueuePos = 0;
+  queue->dequeuePos = 0;
+  queue->nextId = 0;
+  queue->stopping = false;
+  queue->listener = NULL;
+  env->GetJavaVM(&queue->vm);
+  if (notify)
+    queue->listener = env->NewGlobalRef(thiz);
+  sem_init(&queue->available, 0, 0);
+
+  // The first engine is the API itself, the others are initialized like it,
+  // with the variables it was given replayed during their Init.
+  queue->workers = new async_worker_t[numEngines];
+  queue->numWorkers = 0;
+  for (l_int32 i = 0; i < numEngines; i++) {
+    async_worker_t *worker = &queue->workers[queue->numWorkers];
+    worker->queue = queue;
+    worker->job = NULL;
+    worker->jobId = 0;
+    worker->ownsEngine = i > 0;
+    if (worker->ownsEngine) {
+      worker->engine = new tesseract::TessBaseAPI;
+      if (worker->engine->Init(nat->initDatapath.string(), nat->initLanguage.string(),
+                               (tesseract::OcrEngineMode) nat->initOem, NULL, 0,
+                               &nat->variableNames, &nat->variableValues, false)) {
+        LOGE("Could not initialize job engine %d!", i);
+        delete worker->engine;
+        break;
+      }
+    } else {
+      worker->engine = &nat->api;
+    }
+    if (pthread_create(&worker->thread, NULL, jobWorkerMain, worker) != 0) {
+      LOGE("Could not start job worker %d!", i);
+      if (worker->ownsEngine)
+        delete worker->engine;
+      break;
+    }
+    queue->numWorkers++;
+  }
+
+  nat->jobs = queue;
+  if (queue->numWorkers == 0) {
+    stopJobs(env, nat);
+    return JNI_FALSE;
+  }
+
+  return JNI_TRUE;
+}
+
+jlong Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSubmitJob(JNIEnv *env,
+                                                                     jobject thiz,
+                                                                     jlong mNativeData,
+                                                                     jlong nativePix,
+                                                                     jint left,
+                                                                     jint top,
+                                                                     jint width,
+                                                                     jint height,
+                                                                     jint pageSegMode,
+                                                                     jint formats) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  async_queue_t *queue = nat->jobs;
+
+  if (queue == NULL || __atomic_load_n(&queue->stopping, __ATOMIC_ACQUIRE))
+    return 0;
+
+  // Claim a free slot, starting at a different one for each job.
+  l_int64 id = __atomic_add_fetch(&queue->nextId, 1, __ATOMIC_RELAXED);
+  async_job_t *job = NULL;
+  for (l_int32 i = 0; i < queue->capacity && job == NULL; i++) {
+    async_job_t *slot = &queue->jobs[(id + i) & (queue->capacity - 1)];
+    l_int64 expected = 0;
+    if (__atomic_compare_exchange_n(&slot->tag, &expected,
+                                    (id << JOB_STATE_BITS) | JOB_RESERVED, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      job = slot;
+  }
+  if (job == NULL)
+    return 0;
+
+  job->pix = pixClone((PIX *) nativePix);
+  job->left = left;
+  job->top = top;
+  job->width = width;
+  job->height = height;
+  job->pageSegMode = pageSegMode;
+  job->formats = formats;
+  job->meanConfidence = 0;
+  __atomic_store_n(&job->cancelId, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&job->refs, 2, __ATOMIC_RELAXED);
+  __atomic_store_n(&job->tag, (id << JOB_STATE_BITS) | JOB_QUEUED, __ATOMIC_RELEASE);
+
+  // A slot is only freed once the ring let go of it, so there is always room.
+  pushJob(queue, (l_int32) (job - queue->jobs));
+  sem_post(&queue->available);
+
+  return (jlong) id;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeCancelJob(JNIEnv *env,
+                                                                        jobject thiz,
+                                                                        jlong mNativeData,
+                                                                        jlong jobId) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  if (nat->jobs == NULL)
+    return JNI_FALSE;
+
+  l_int64 tag;
+  async_job_t *job = findJob(nat->jobs, jobId, &tag);
+  while (job != NULL && (tag >> JOB_STATE_BITS) == jobId) {
+    switch (tag & JOB_STATE_MASK) {
+      case JOB_QUEUED:
+        // Retry with the new tag if a worker picked the job up meanwhile.
+        if (setJobState(job, &tag, JOB_CANCELLED))
+          return JNI_TRUE;
+        break;
+      case JOB_RUNNING:
+        // Stop it at the next check of the monitor.
+        __atomic_store_n(&job->cancelId, jobId, __ATOMIC_RELEASE);
+        return JNI_TRUE;
+      default:
+        return JNI_FALSE;
+    }
+  }
+  return JNI_FALSE;
+}
+
+jint Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetJobStatus(JNIEnv *env,
+                                                                       jobject thiz,
+                                                                       jlong mNativeData,
+                                                                       jlong jobId) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  if (nat->jobs == NULL)
+    return -1;
+
+  l_int64 tag;
+  if (findJob(nat->jobs, jobId, &tag) == NULL)
+    return -1;
+
+  l_int32 state = tag & JOB_STATE_MASK;
+  if (state == JOB_RESERVED)
+    return JOB_QUEUED;
+  if (state == JOB_TAKEN)
+    return -1;
+  return state;
+}
+
+jobjectArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeTakeJobResult(JNIEnv *env,
+                                                                                jobject thiz,
+                                                                                jlong mNativeData,
+                                                                                jlong jobId,
+                                                                                jintArray statusAndConfidence) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  jint values[2] = { -1, 0 };
+  jobjectArray result = NULL;
+
+  l_int64 tag;
+  async_job_t *job = (nat->jobs != NULL) ? findJob(nat->jobs, jobId, &tag) : NULL;
+  if (job != NULL) {
+    l_int32 state = tag & JOB_STATE_MASK;
+    if (state == JOB_DONE || state == JOB_CANCELLED || state == JOB_FAILED) {
+      if (setJobState(job, &tag, JOB_TAKEN)) {
+        if (state == JOB_DONE)
+          result = jobOutputs(env, job);
+        values[0] = state;
+        values[1] = job->meanConfidence;
+        releaseJob(job);
+      }
+    } else if (state == JOB_QUEUED || state == JOB_RUNNING || state == JOB_RESERVED) {
+      values[0] = (state == JOB_RESERVED) ? JOB_QUEUED : state;
+    }
+  }
+
+  env->SetIntArrayRegion(statusAndConfidence, 0, 2, values);
 
   return result;
 }
 
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeStopJobs(JNIEnv *env,
+                                                                       jobject thiz,
+                                                                       jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  return stopJobs(env, nat) ? JNI_TRUE : JNI_FALSE;
+}
+
 jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetBoxText(JNIEnv *env,
                                                                            jobject thiz,
                                                                            jlong mNativeData,
@@ -203,6 +203,19 @@ public class Binarize {
         return new Pix(nativePix);        
     }
 
+    /**
+     * Sets the number of threads used to binarize the tiles of
+     * otsuAdaptiveThreshold() and sauvolaBinarizeTiled(), and bands of rows
+     * of an untiled Sauvola binarization. The default is 1. The results do
+     * not depend on the number of threads.
+     *
+     * @param numThreads Max number of threads; use 0 for the number of
+     *            processors online.
+     */
+    public static void setNumThreads(int numThreads) {
+        nativeSetNumThreads(numThreads);
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
@@ -212,4 +225,6 @@ public class Binarize {
 
     private static native long nativeSauvolaBinarizeTiled(
             long nativePix, int whsize, float factor, int nx, int ny);
+
+    private static native void nativeSetNumThreads(int numThreads);
 }
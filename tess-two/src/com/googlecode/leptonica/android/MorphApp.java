@@ -40,6 +40,15 @@ public class MorphApp {
     public static final int L_TOPHAT_WHITE = 0;
     public static final int L_TOPHAT_BLACK = 1;
 
+    // Brick morphological operation flags
+    @Retention(SOURCE)
+    @IntDef({L_MORPH_DILATE, L_MORPH_ERODE, L_MORPH_OPEN, L_MORPH_CLOSE})
+    public @interface MorphType {}
+    public static final int L_MORPH_DILATE = 1;
+    public static final int L_MORPH_ERODE = 2;
+    public static final int L_MORPH_OPEN = 3;
+    public static final int L_MORPH_CLOSE = 4;
+
     public static final int DEFAULT_WIDTH = 7;
 
     public static final int DEFAULT_HEIGHT = 7;
@@ -154,6 +163,55 @@ public class MorphApp {
         return new Pix(nativePix); 
     }
 
+    /**
+     * Performs a dilation, erosion, opening or closing with a brick Sel.
+     * <p>
+     * Notes:
+     * <ol>
+     * <li> Sel is a brick of hsize x vsize hits, with its origin at
+     * (hsize / 2, vsize / 2).
+     * <li> The horizontal and vertical parts of the Sel are applied
+     * separately, on the threads set by {@link #setNumThreads(int)}.
+     * </ol>
+     *
+     * @param pixs Source pix (1bpp)
+     * @param hsize width of Sel; any integer &gt;= 1
+     * @param vsize height of Sel; any integer &gt;= 1
+     * @param type L_MORPH_DILATE, L_MORPH_ERODE, L_MORPH_OPEN or L_MORPH_CLOSE
+     * @return a new Pix image
+     */
+    public static Pix pixMorphBrick(Pix pixs, int hsize, int vsize, @MorphType int type) {
+        if (pixs == null)
+            throw new IllegalArgumentException("Source pix must be non-null");
+        if (pixs.getDepth() != 1)
+            throw new IllegalArgumentException("Source pix depth must be 1bpp");
+        if (hsize < 1 || vsize < 1)
+            throw new IllegalArgumentException("hsize or vsize < 1");
+        if (type < L_MORPH_DILATE || type > L_MORPH_CLOSE)
+            throw new IllegalArgumentException("Type must be L_MORPH_DILATE, L_MORPH_ERODE, "
+                    + "L_MORPH_OPEN or L_MORPH_CLOSE");
+
+        long nativePix = nativePixMorphBrick(pixs.getNativePix(), hsize, vsize, type);
+
+        if (nativePix == 0)
+            throw new RuntimeException("Failed to perform pixMorphBrick on image");
+
+        return new Pix(nativePix);
+    }
+
+    /**
+     * Sets the number of threads used by brick dilations, erosions, openings
+     * and closings of 1bpp and 8bpp images, as used by pixMorphBrick(),
+     * pixTophat() and pixFastTophat(). The default is 1. The results do not depend on the
+     * number of threads.
+     *
+     * @param numThreads Max number of threads; use 0 for the number of
+     *            processors online.
+     */
+    public static void setNumThreads(int numThreads) {
+        nativeSetNumThreads(numThreads);
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
@@ -161,4 +219,8 @@ public class MorphApp {
     private static native long nativePixTophat(long nativePix, int hsize, int vsize, int type);
 
     private static native long nativePixFastTophat(long nativePix, int xsize, int ysize, int type);
+
+    private static native long nativePixMorphBrick(long nativePix, int hsize, int vsize, int type);
+
+    private static native void nativeSetNumThreads(int numThreads);
 }
@@ -117,6 +117,18 @@ public class Rotate {
         return new Pix(nativePix);
     }
 
+    /**
+     * Sets the number of threads used for rotation by area mapping and by
+     * sampling in rotate(). The default is 1. The results do not depend on
+     * the number of threads.
+     *
+     * @param numThreads Max number of threads; use 0 for the number of
+     *            processors online.
+     */
+    public static void setNumThreads(int numThreads) {
+        nativeSetNumThreads(numThreads);
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
@@ -125,4 +137,6 @@ public class Rotate {
 
     private static native long nativeRotate(long nativePix, float degrees, boolean quality,
             boolean resize);
+
+    private static native void nativeSetNumThreads(int numThreads);
 }
@@ -91,6 +91,18 @@ public class Skew {
                 sweepReduction, searchReduction, searchMinDelta);
     }
 
+    /**
+     * Sets the number of threads used to score the angles of the sweep, and
+     * the pair of angles of each binary search step, in findSkew(). The
+     * default is 1. The results do not depend on the number of threads.
+     *
+     * @param numThreads Max number of threads; use 0 for the number of
+     *            processors online.
+     */
+    public static void setNumThreads(int numThreads) {
+        nativeSetNumThreads(numThreads);
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
@@ -98,4 +110,6 @@ public class Skew {
     private static native float nativeFindSkew(long nativePix, float sweepRange, float sweepDelta,
             int sweepReduction, int searchReduction, float searchMinDelta);
 
+    private static native void nativeSetNumThreads(int numThreads);
+
 }
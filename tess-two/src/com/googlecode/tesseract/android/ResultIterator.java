@@ -16,9 +16,11 @@
 
 package com.googlecode.tesseract.android;
 
+import java.nio.charset.Charset;
 import java.util.ArrayList;
 import java.util.List;
 
+import android.graphics.Rect;
 import android.util.Log;
 import android.util.Pair;
 
@@ -39,9 +41,75 @@ public class ResultIterator extends PageIterator {
         System.loadLibrary("tess");
     }
 
+    /** Number of ints stored for each element by nativeGetResults. */
+    private static final int RESULT_INTS = 8;
+
+    private static final Charset UTF_8 = Charset.forName("UTF-8");
+
     /** Pointer to native result iterator. */
     private final long mNativeResultIterator;
 
+    /**
+     * Text, bounding boxes and confidences for every element of a page at one
+     * {@link PageIteratorLevel}, as returned by {@link #getResults(int)}.
+     */
+    public static class Results {
+        private final int[] mValues;
+        private final byte[] mText;
+
+        private Results(int[] values, byte[] text) {
+            mValues = values;
+            mText = text;
+        }
+
+        /**
+         * @return the number of elements
+         */
+        public int size() {
+            return mValues.length / RESULT_INTS;
+        }
+
+        /**
+         * @param index the element index
+         * @return the recognized text of the element
+         */
+        public String getUTF8Text(int index) {
+            final int offset = index * RESULT_INTS;
+            return new String(mText, mValues[offset + 5], mValues[offset + 6], UTF_8);
+        }
+
+        /**
+         * @param index the element index
+         * @return the mean confidence of the element, as a percentage
+         */
+        public float getConfidence(int index) {
+            return Float.intBitsToFloat(mValues[index * RESULT_INTS + 4]);
+        }
+
+        /**
+         * @param index the element index
+         * @return the bounding rectangle of the element. See
+         *         {@link PageIterator#getBoundingBox(int)}.
+         */
+        public Rect getBoundingRect(int index) {
+            final int offset = index * RESULT_INTS;
+            return new Rect(mValues[offset], mValues[offset + 1],
+                    mValues[offset + 2], mValues[offset + 3]);
+        }
+
+        /**
+         * Returns whether the element starts a new object at a higher level,
+         * e.g. whether a word is the first word of a text line.
+         *
+         * @param index the element index
+         * @param level the page iterator level. See {@link PageIteratorLevel}.
+         * @return {@code true} if the element starts an object at the level
+         */
+        public boolean isAtBeginningOf(int index, @PageIteratorLevel.Level int level) {
+            return (mValues[index * RESULT_INTS + 7] & (1 << level)) != 0;
+        }
+    }
+
     /* package */ResultIterator(long nativeResultIterator) {
         super(nativeResultIterator);
 
@@ -138,6 +206,23 @@ public class ResultIterator extends PageIterator {
         return pairedResults;
     }
 
+    /**
+     * Returns the text, bounding box and confidence of every element at the
+     * given level on the page, in iteration order, using a single native
+     * call. Empty elements are skipped. The position of this iterator is not
+     * changed.
+     *
+     * @param level the page iterator level. See {@link PageIteratorLevel}.
+     * @return the results for all elements at the given level
+     */
+    public Results getResults(@PageIteratorLevel.Level int level) {
+        Object[] results = nativeGetResults(mNativeResultIterator, level);
+        if (results == null)
+            return new Results(new int[0], new byte[0]);
+
+        return new Results((int[]) results[0], (byte[]) results[1]);
+    }
+
     /**
      * Deletes the iterator after use
      */
@@ -151,5 +236,6 @@ public class ResultIterator extends PageIterator {
     private static native float nativeConfidence(long nativeResultIterator, int level);
     private static native boolean nativeIsAtBeginningOf(long nativeResultIterator, int level);
     private static native boolean nativeIsAtFinalElement(long nativeResultIterator, int level, int element);
+    private static native Object[] nativeGetResults(long nativeResultIterator, int level);
     private static native void nativeDelete(long nativeResultIterator);
 }
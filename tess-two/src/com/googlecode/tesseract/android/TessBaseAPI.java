@@ -28,6 +28,11 @@ import com.googlecode.leptonica.android.ReadFile;
 
 import java.io.File;
 import java.lang.annotation.Retention;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.IntBuffer;
+import java.util.ArrayList;
+import java.util.List;
 
 import static java.lang.annotation.RetentionPolicy.SOURCE;
 
@@ -167,8 +172,147 @@ public class TessBaseAPI {
         public static final int RIL_SYMBOL = 4;
     }
 
+    /**
+     * Text output formats that {@link #getTextOutputs(int, int...)} can
+     * produce together from a single pass over the recognition results.
+     */
+    public static final class TextOutputFormat {
+        @Retention(SOURCE)
+        @IntDef({UTF8, HOCR, TSV, BOX, UNLV})
+        public @interface Format {}
+
+        /** Plain text, as returned by {@link #getUTF8Text()}. */
+        public static final int UTF8 = 0;
+
+        /** hOCR markup, as returned by {@link #getHOCRText(int)}. */
+        public static final int HOCR = 1;
+
+        /** Tab-separated word boxes and confidences. */
+        public static final int TSV = 2;
+
+        /** Box file text, as returned by {@link #getBoxText(int)}. */
+        public static final int BOX = 3;
+
+        /** UNLV format Latin-1 text. */
+        public static final int UNLV = 4;
+    }
+
+    /** Status of a job submitted with {@link #submitJob(Pix, Rect, int, int...)}. */
+    public static final class JobStatus {
+        @Retention(SOURCE)
+        @IntDef({UNKNOWN, QUEUED, RUNNING, DONE, CANCELLED, FAILED})
+        public @interface Status {}
+
+        /** No such job, or its result has already been taken. */
+        public static final int UNKNOWN = -1;
+
+        /** Waiting for an engine. */
+        public static final int QUEUED = 0;
+
+        /** Being recognized. */
+        public static final int RUNNING = 1;
+
+        /** Recognized; the result holds the requested outputs. */
+        public static final int DONE = 2;
+
+        /** Cancelled before it finished. */
+        public static final int CANCELLED = 3;
+
+        /** Recognition failed. */
+        public static final int FAILED = 4;
+    }
+
+    /**
+     * Interface that may be implemented to receive the results of jobs as
+     * soon as they finish, instead of polling for them.
+     */
+    public interface JobListener {
+        /**
+         * Called on the thread of the engine that ran the job, so it should
+         * return quickly.
+         * <p>
+         * Must not call {@link TessBaseAPI#stopJobs()} or
+         * {@link TessBaseAPI#end()}, which wait for the engine threads to
+         * finish and throw an <code>IllegalStateException</code> when called
+         * from one. Stop the jobs from another thread instead.
+         *
+         * @param result the result of the job
+         */
+        void onJobFinished(JobResult result);
+    }
+
+    /**
+     * Result of a job submitted with {@link #submitJob(Pix, Rect, int, int...)}.
+     */
+    public static class JobResult {
+        private final long jobId;
+        private final int status;
+        private final String[] outputs;
+        private final int meanConfidence;
+
+        public JobResult(long jobId, @JobStatus.Status int status, String[] outputs,
+                int meanConfidence) {
+            this.jobId = jobId;
+            this.status = status;
+            this.outputs = outputs;
+            this.meanConfidence = meanConfidence;
+        }
+
+        /**
+         * Return the id returned when the job was submitted.
+         *
+         * @return the job id
+         */
+        public long getJobId() {
+            return jobId;
+        }
+
+        /**
+         * Return how the job ended.
+         *
+         * @return {@link JobStatus#DONE}, {@link JobStatus#CANCELLED} or
+         *         {@link JobStatus#FAILED}
+         */
+        public @JobStatus.Status int getStatus() {
+            return status;
+        }
+
+        /**
+         * Return one of the outputs requested when the job was submitted.
+         *
+         * @param format the {@link TextOutputFormat} of the output
+         * @return the output, or <code>null</code> if it was not requested
+         *         or the job did not finish
+         */
+        public String getOutput(@TextOutputFormat.Format int format) {
+            return outputs != null ? outputs[format] : null;
+        }
+
+        /**
+         * Return the mean confidence of the recognized text.
+         *
+         * @return a value between 0 and 100
+         */
+        public int getMeanConfidence() {
+            return meanConfidence;
+        }
+    }
+
     private ProgressNotifier progressNotifier;
 
+    private volatile JobListener mJobListener;
+
+    /** Number of ints stored for each event in the progress event buffer. */
+    private static final int PROGRESS_EVENT_INTS = 9;
+
+    /** Progress events shared with native code, or null when not in use. */
+    private IntBuffer mProgressEvents;
+
+    private int mProgressEventCapacity;
+
+    /** Number of progress events consumed by {@link #pollProgressValues()}. */
+    private long mProgressEventsRead;
+
     private boolean mRecycled;
 
     /**
@@ -230,6 +374,60 @@ public class TessBaseAPI {
         }
     }
 
+    /**
+     * Text recognized in one of the regions passed to
+     * {@link #recognizeRegions(Pixa, float[], int, int)}.
+     */
+    public static class RegionText {
+        private final int index;
+        private final Rect rect;
+        private final String text;
+        private final int confidence;
+
+        public RegionText(int index, Rect rect, String text, int confidence) {
+            this.index = index;
+            this.rect = rect;
+            this.text = text;
+            this.confidence = confidence;
+        }
+
+        /**
+         * Return the index of the region in the regions that were passed in.
+         *
+         * @return the region index
+         */
+        public int getIndex() {
+            return index;
+        }
+
+        /**
+         * Return the bounds of the region in the image.
+         *
+         * @return an {@link android.graphics.Rect} bounding box
+         */
+        public Rect getRect() {
+            return rect;
+        }
+
+        /**
+         * Return the text recognized in the region.
+         *
+         * @return the recognized text, trimmed
+         */
+        public String getText() {
+            return text;
+        }
+
+        /**
+         * Return the mean confidence of the text in the region.
+         *
+         * @return a value between 0 and 100
+         */
+        public int getConfidence() {
+            return confidence;
+        }
+    }
+
     /**
      * Constructs an instance of TessBaseAPI.
      * <p>
@@ -389,16 +587,58 @@ public class TessBaseAPI {
         nativeClear(mNativeData);
     }
 
+    /**
+     * Saves what the adaptive classifier has learned from the pages
+     * recognized so far to a file, so that a later job on similar documents
+     * can start from it instead of from scratch.
+     * <p>
+     * Note: Must be called after init() and before clear(), which forgets
+     * the adaptive data.
+     *
+     * @param path file to write the adaptive data to
+     * @return false if the adaptive data could not be written
+     */
+    public boolean saveAdaptiveClassifier(String path) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeSaveAdaptiveClassifier(mNativeData, path);
+    }
+
+    /**
+     * Replaces the adaptive classifier with one saved by
+     * saveAdaptiveClassifier(). The file must have been saved with the same
+     * languages and traineddata files.
+     * <p>
+     * Note: Must be called after init(), and after any call to clear(),
+     * which forgets the adaptive data.
+     *
+     * @param path file to read the adaptive data from
+     * @return false if the file could not be read, is truncated or corrupt,
+     *         or does not match the loaded languages
+     */
+    public boolean loadAdaptiveClassifier(String path) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeLoadAdaptiveClassifier(mNativeData, path);
+    }
+
     /**
      * Closes down tesseract and free up all memory. End() is equivalent to
      * destructing and reconstructing your TessBaseAPI.
      * <p>
      * Once End() has been used, none of the other API functions may be used
      * other than Init and anything declared above it in the class definition.
+     * <p>
+     * Must not be called from a {@link JobListener}.
      */
     public void end() {
         if (!mRecycled) {
+            if (!nativeStopJobs(mNativeData))
+                throw new IllegalStateException("end() called from a job listener");
             nativeEnd(mNativeData);
+            mJobListener = null;
 
             mRecycled = true;
         }
@@ -825,6 +1065,84 @@ public class TessBaseAPI {
         return nativeGetBoxText(mNativeData, page);
     }
 
+    /**
+     * Returns several text outputs for the current page at once. The hOCR
+     * and TSV outputs share a single walk of the results, and recognition is
+     * run only once, so this is cheaper than calling the individual getters
+     * one after the other.
+     * Interruptible by {@link #stop()}.
+     *
+     * @param page is 0-based, as for {@link #getHOCRText(int)} and
+     *             {@link #getBoxText(int)}
+     * @param formats the {@link TextOutputFormat} values to produce
+     * @return the outputs in the same order as <code>formats</code>, or
+     *         <code>null</code> if recognition failed
+     */
+    @WorkerThread
+    public String[] getTextOutputs(int page, @TextOutputFormat.Format int... formats) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        int mask = 0;
+        for (int format : formats)
+            mask |= 1 << format;
+
+        String[] outputs = nativeGetTextOutputs(mNativeData, page, mask);
+        if (outputs == null)
+            return null;
+
+        String[] results = new String[formats.length];
+        for (int i = 0; i < formats.length; i++)
+            results[i] = outputs[formats[i]];
+        return results;
+    }
+
+    /**
+     * Recognizes the text regions found by a text detector, such as
+     * <code>HydrogenTextDetector.getTextAreas()</code>, in the image set by
+     * {@link #setImage(Pix)} instead of analysing the layout of the whole
+     * image. The image is thresholded once, and the regions are recognized
+     * in order of decreasing confidence, each as a single line or block.
+     * Interruptible by {@link #stop()}.
+     *
+     * @param regions the regions to recognize, in image coordinates
+     * @param regionConfidences the confidence of each region, such as
+     *                          <code>HydrogenTextDetector.getTextConfs()</code>,
+     *                          or <code>null</code> to keep the order of
+     *                          <code>regions</code>
+     * @param maxRegions the largest number of regions to recognize, or 0 for
+     *                   no limit
+     * @param budgetMillis the time after which no more regions are
+     *                     recognized, or 0 for no limit
+     * @return the text of the regions that were recognized, in the order of
+     *         <code>regions</code>, or <code>null</code> if recognition failed
+     */
+    @WorkerThread
+    public List<RegionText> recognizeRegions(Pixa regions, float[] regionConfidences,
+            int maxRegions, int budgetMillis) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        int count = regions.size();
+        if (regionConfidences != null && regionConfidences.length < count)
+            throw new IllegalArgumentException("Fewer confidences than regions");
+
+        int[] confidences = new int[count];
+        String[] texts = nativeRecognizeRegions(mNativeData, regions.getNativePixa(),
+                regionConfidences, maxRegions, budgetMillis, confidences);
+        if (texts == null)
+            return null;
+
+        List<RegionText> results = new ArrayList<>();
+        for (int i = 0; i < count; i++) {
+            if (texts[i] != null) {
+                results.add(new RegionText(i, regions.getBoxRect(i), texts[i].trim(),
+                        confidences[i]));
+            }
+        }
+        return results;
+    }
+
     /**
      * Returns the version identifier as a string.
      *
@@ -834,6 +1152,100 @@ public class TessBaseAPI {
         return nativeGetVersion(mNativeData);
     }
 
+    /**
+     * Sets the minimum time between two progress reports. Progress updates
+     * arriving sooner than this after the previous report are dropped,
+     * except that the last update of each recognition call is always
+     * reported when the call ends.
+     *
+     * @param millis minimum interval in milliseconds, or 0 to report every
+     *            update
+     */
+    public void setProgressInterval(int millis) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        nativeSetProgressInterval(mNativeData, Math.max(0, millis));
+    }
+
+    /**
+     * Makes native code store progress updates in a buffer shared with Java
+     * instead of calling the {@link ProgressNotifier} for each update. The
+     * caller retrieves the updates with {@link #pollProgressValues()} at its
+     * own rate, typically from a different thread than the one running
+     * recognition. When more than <code>capacity</code> updates arrive
+     * between two polls, the oldest are lost.
+     * <p>
+     * Must not be called while recognition is in progress. The memory of
+     * a replaced buffer is kept until {@link #end()}, so a poll running at
+     * the same time on another thread still reads valid memory.
+     *
+     * @param capacity number of updates to retain, or 0 to go back to
+     *            delivering updates through the ProgressNotifier
+     * @return <code>true</code> on success
+     * @throws IllegalStateException if recognition is in progress
+     */
+    public boolean setProgressEventBuffer(int capacity) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        ByteBuffer buffer = nativeSetProgressEventBuffer(mNativeData,
+                Math.max(0, capacity));
+        mProgressEvents = null;
+        mProgressEventCapacity = 0;
+        mProgressEventsRead = 0;
+        if (buffer == null)
+            return capacity <= 0;
+
+        mProgressEvents = buffer.order(ByteOrder.nativeOrder()).asIntBuffer();
+        mProgressEventCapacity = capacity;
+        return true;
+    }
+
+    /**
+     * Returns the progress updates stored since the previous call, oldest
+     * first. Requires {@link #setProgressEventBuffer(int)}. Safe to call
+     * while recognition is running on another thread.
+     *
+     * @return a list of progress values, empty if none are available
+     */
+    public List<ProgressValues> pollProgressValues() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        final List<ProgressValues> values = new ArrayList<>();
+        final IntBuffer events = mProgressEvents;
+        if (events == null)
+            return values;
+
+        final int capacity = mProgressEventCapacity;
+        final long written = nativeGetProgressEventCount(mNativeData);
+        final long first = Math.max(mProgressEventsRead, written - capacity);
+        final List<int[]> copied = new ArrayList<>();
+        for (long index = first; index < written; index++) {
+            final int offset = (int) (index % capacity) * PROGRESS_EVENT_INTS;
+            final int[] event = new int[PROGRESS_EVENT_INTS];
+            for (int i = 0; i < PROGRESS_EVENT_INTS; i++) {
+                event[i] = events.get(offset + i);
+            }
+            copied.add(event);
+        }
+
+        // Native code may have overwritten slots while we were copying them,
+        // and may be writing the slot after the last published event.
+        final long firstValid = nativeGetProgressEventCount(mNativeData) + 1 - capacity;
+        for (int i = 0; i < copied.size(); i++) {
+            if (first + i >= firstValid) {
+                final int[] e = copied.get(i);
+                values.add(createProgressValues(e[0], e[1], e[2], e[3], e[4],
+                        e[5], e[6], e[7], e[8]));
+            }
+        }
+        mProgressEventsRead = written;
+
+        return values;
+    }
+
     /**
      * Cancel recognition started by {@link #getHOCRText(int)}.
      */
@@ -844,6 +1256,148 @@ public class TessBaseAPI {
         nativeStop(mNativeData);
     }
 
+    /**
+     * Starts recognizing jobs in the background. Jobs are queued without
+     * locks and served by <code>numEngines</code> worker threads, each with
+     * its own engine. The first engine is this instance itself, so it must
+     * not be used for anything else until {@link #stopJobs()}. The others
+     * are initialized with the same data path, language and engine mode as
+     * the last call to <code>init</code>, and with the variables given to
+     * {@link #setVariable(String, String)}.
+     *
+     * @param capacity the number of jobs that may be queued or waiting to
+     *                 be collected at once, rounded up to a power of 2
+     * @param numEngines the number of jobs to recognize at the same time
+     * @param listener the listener to give results to as soon as they are
+     *                 ready, or <code>null</code> to poll them with
+     *                 {@link #takeJobResult(long)}
+     * @return <code>true</code> if at least one engine was started, or
+     *         <code>false</code> if none was or jobs are already started,
+     *         in which case the current listener is kept
+     */
+    public boolean startJobs(int capacity, int numEngines, JobListener listener) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (capacity < 1 || numEngines < 1)
+            throw new IllegalArgumentException("Capacity and engines must be positive");
+
+        if (!nativeStartJobs(mNativeData, capacity, numEngines, listener != null))
+            return false;
+
+        // Only replace the listener once started, so that a failed call leaves
+        // the listener of jobs already running alone.
+        mJobListener = listener;
+        return true;
+    }
+
+    /**
+     * Queues an image for recognition on one of the engines started by
+     * {@link #startJobs(int, int, JobListener)}. Returns immediately.
+     *
+     * @param pix the image to recognize, which may be recycled once this
+     *            returns
+     * @param rect the part of the image to recognize, or <code>null</code>
+     *             for all of it
+     * @param pageSegMode the {@link PageSegMode} to recognize it with
+     * @param formats the {@link TextOutputFormat} values to produce
+     * @return the id of the job, or 0 if the queue is full or not started
+     */
+    public long submitJob(Pix pix, Rect rect, @PageSegMode.Mode int pageSegMode,
+            @TextOutputFormat.Format int... formats) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        int mask = 0;
+        for (int format : formats)
+            mask |= 1 << format;
+
+        if (rect == null)
+            return nativeSubmitJob(mNativeData, pix.getNativePix(), 0, 0, 0, 0, pageSegMode, mask);
+        return nativeSubmitJob(mNativeData, pix.getNativePix(), rect.left, rect.top,
+                rect.width(), rect.height(), pageSegMode, mask);
+    }
+
+    /**
+     * Cancels a job. A queued job is never recognized, and a running one
+     * stops at the next word.
+     *
+     * @param jobId the id returned by {@link #submitJob(Pix, Rect, int, int...)}
+     * @return <code>true</code> if the job was queued or running
+     */
+    public boolean cancelJob(long jobId) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeCancelJob(mNativeData, jobId);
+    }
+
+    /**
+     * Returns the status of a job.
+     *
+     * @param jobId the id returned by {@link #submitJob(Pix, Rect, int, int...)}
+     * @return the {@link JobStatus} of the job
+     */
+    public @JobStatus.Status int getJobStatus(long jobId) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeGetJobStatus(mNativeData, jobId);
+    }
+
+    /**
+     * Collects the result of a finished job, when no {@link JobListener} was
+     * given. Each result can only be taken once.
+     *
+     * @param jobId the id returned by {@link #submitJob(Pix, Rect, int, int...)}
+     * @return the result, or <code>null</code> if the job has not finished
+     *         or is unknown
+     */
+    public JobResult takeJobResult(long jobId) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        int[] statusAndConfidence = new int[2];
+        String[] outputs = nativeTakeJobResult(mNativeData, jobId, statusAndConfidence);
+
+        int status = statusAndConfidence[0];
+        if (status != JobStatus.DONE && status != JobStatus.CANCELLED
+                && status != JobStatus.FAILED)
+            return null;
+        return new JobResult(jobId, status, outputs, statusAndConfidence[1]);
+    }
+
+    /**
+     * Stops the engines started by {@link #startJobs(int, int, JobListener)}.
+     * Queued and running jobs are cancelled, and results that were not
+     * collected are dropped. Also done by {@link #end()}.
+     * <p>
+     * Must not be called while another thread submits jobs, nor from a
+     * {@link JobListener}.
+     */
+    public void stopJobs() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        if (!nativeStopJobs(mNativeData))
+            throw new IllegalStateException("stopJobs() called from a job listener");
+        mJobListener = null;
+    }
+
+    /**
+     * Called from native code on an engine thread when a job finishes.
+     *
+     * @param jobId Id of the job
+     * @param status How the job ended
+     * @param outputs Outputs indexed by text output format, or null
+     * @param meanConfidence Mean confidence of the recognized text
+     */
+    protected void onJobFinished(long jobId, int status, String[] outputs, int meanConfidence) {
+        JobListener listener = mJobListener;
+        if (listener != null) {
+            listener.onJobFinished(new JobResult(jobId, status, outputs, meanConfidence));
+        }
+    }
+
     /**
      * Called from native code to update progress of ongoing recognition passes.
      *
@@ -862,14 +1416,21 @@ public class TessBaseAPI {
             final int textLeft, final int textRight, final int textTop, final int textBottom) {
 
         if (progressNotifier != null) {
-            Rect wordRect = new Rect(left, textTop - top, right, textTop - bottom);
-            Rect textRect = new Rect(textLeft, textBottom, textRight, textTop);
-
-            ProgressValues pv = new ProgressValues(percent, wordRect, textRect);
+            ProgressValues pv = createProgressValues(percent, left, right, top,
+                    bottom, textLeft, textRight, textTop, textBottom);
             progressNotifier.onProgressValues(pv);
         }
     }
 
+    private ProgressValues createProgressValues(int percent, int left,
+            int right, int top, int bottom,
+            int textLeft, int textRight, int textTop, int textBottom) {
+        Rect wordRect = new Rect(left, textTop - top, right, textTop - bottom);
+        Rect textRect = new Rect(textLeft, textBottom, textRight, textTop);
+
+        return new ProgressValues(percent, wordRect, textRect);
+    }
+
     /**
      * Starts a new document. This clears the contents of the output data.
      * 
@@ -953,6 +1514,10 @@ public class TessBaseAPI {
 
     private native void nativeClear(long mNativeData);
 
+    private native boolean nativeSaveAdaptiveClassifier(long mNativeData, String path);
+
+    private native boolean nativeLoadAdaptiveClassifier(long mNativeData, String path);
+
     private native void nativeSetImageBytes(
             long mNativeData,   byte[] imagedata, int width, int height, int bpp, int bpl);
 
@@ -993,6 +1558,11 @@ public class TessBaseAPI {
 
     private native String nativeGetHOCRText(long mNativeData, int page_number);
 
+    private native String[] nativeGetTextOutputs(long mNativeData, int page, int formats);
+
+    private native String[] nativeRecognizeRegions(long mNativeData, long nativePixa,
+            float[] regionConfs, int maxRegions, int budgetMillis, int[] textConfs);
+
     private native void nativeSetInputName(long mNativeData, String name);
 
     private native void nativeSetOutputName(long mNativeData, String name);
@@ -1003,6 +1573,27 @@ public class TessBaseAPI {
 
     private native void nativeStop(long mNativeData);
 
+    private native ByteBuffer nativeSetProgressEventBuffer(long mNativeData, int capacity);
+
+    private native long nativeGetProgressEventCount(long mNativeData);
+
+    private native void nativeSetProgressInterval(long mNativeData, int millis);
+
+    private native boolean nativeStartJobs(long mNativeData, int capacity, int numEngines,
+            boolean notify);
+
+    private native long nativeSubmitJob(long mNativeData, long nativePix, int left, int top,
+            int width, int height, int pageSegMode, int formats);
+
+    private native boolean nativeCancelJob(long mNativeData, long jobId);
+
+    private native int nativeGetJobStatus(long mNativeData, long jobId);
+
+    private native String[] nativeTakeJobResult(long mNativeData, long jobId,
+            int[] statusAndConfidence);
+
+    private native boolean nativeStopJobs(long mNativeData);
+
     private native boolean nativeBeginDocument(long rendererPointer, String title);
 
     private native boolean nativeEndDocument(long rendererPointer);